@@ -1,5 +1,12 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <exception>
 #include <functional>
+#include <limits>
 #include <optional>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -8,25 +15,44 @@
 
 #include <napi.h>
 
+#include <libethereum/AccessListCreator.h>
+#include <libethereum/CallBatch.h>
 #include <libethereum/ChainParams.h>
+#include <libethereum/CodeCache.h>
 #include <libethereum/Executive.h>
 #include <libethereum/LastBlockHashesFace.h>
+#include <libethereum/LogFilter.h>
+#include <libethereum/LogIndex.h>
 #include <libethereum/State.h>
+#include <libethereum/StateDumper.h>
+#include <libethereum/StatePruner.h>
+#include <libethereum/StatelessExecution.h>
+#include <libethereum/Tracers.h>
 #include <libethereum/Transaction.h>
+#include <libethereum/TrieNodeImporter.h>
 #include <libethereum/TransactionReceipt.h>
 
 #include <libethcore/LogEntry.h>
+#include <libethcore/PrecompiledCache.h>
 #include <libethcore/SealEngine.h>
 #include <libethcore/TransactionBase.h>
 
+#include <libevm/ExecutionBudget.h>
+#include <libevm/VMTracer.h>
+
+#include <libdevcore/Arena.h>
+#include <libdevcore/CommitPipeline.h>
 #include <libdevcore/DBFactory.h>
 #include <libdevcore/Log.h>
 #include <libdevcore/OverlayDB.h>
 #include <libdevcore/RLP.h>
+#include <libdevcore/Witness.h>
 
 #include <libethashseal/Ethash.h>
 #include <libethashseal/GenesisInfo.h>
 
+#include <exposed.h>
+
 using namespace dev;
 using namespace dev::db;
 using namespace dev::eth;
@@ -79,69 +105,64 @@ Napi::Value toNapiValue(Napi::Env env, const h256s &_hs)
     return hs;
 }
 
-Napi::Value toNapiValue(Napi::Env env, const TransactionException &te)
+/**
+ * Get the error message of a transaction exception.
+ * @param te - Transaction exception, not None
+ * @return Error message
+ */
+const char *toErrorMessage(TransactionException te)
 {
-    if (te == TransactionException::None)
-    {
-        return env.Undefined();
-    }
-
-    auto error = Napi::Object::New(env);
     switch (te)
     {
     case TransactionException::BadRLP:
-        error.Set("error", Napi::String::New(env, "bad RLP"));
-        break;
+        return "bad RLP";
     case TransactionException::InvalidFormat:
-        error.Set("error", Napi::String::New(env, "invalid format"));
-        break;
+        return "invalid format";
     case TransactionException::OutOfGasIntrinsic:
-        error.Set("error", Napi::String::New(env, "out of gas intrinsic"));
-        break;
+        return "out of gas intrinsic";
     case TransactionException::InvalidSignature:
-        error.Set("error", Napi::String::New(env, "invalid signature"));
-        break;
+        return "invalid signature";
     case TransactionException::InvalidNonce:
-        error.Set("error", Napi::String::New(env, "invalid nonce"));
-        break;
+        return "invalid nonce";
     case TransactionException::NotEnoughCash:
-        error.Set("error", Napi::String::New(env, "not enough cash"));
-        break;
+        return "not enough cash";
     case TransactionException::OutOfGasBase:
-        error.Set("error", Napi::String::New(env, "out of gas base"));
-        break;
+        return "out of gas base";
     case TransactionException::BlockGasLimitReached:
-        error.Set("error", Napi::String::New(env, "block gas limit reached"));
-        break;
+        return "block gas limit reached";
     case TransactionException::BadInstruction:
-        error.Set("error", Napi::String::New(env, "bad instruction"));
-        break;
+        return "bad instruction";
     case TransactionException::BadJumpDestination:
-        error.Set("error", Napi::String::New(env, "bad jump destination"));
-        break;
+        return "bad jump destination";
     case TransactionException::OutOfGas:
-        error.Set("error", Napi::String::New(env, "out of gas"));
-        break;
+        return "out of gas";
     case TransactionException::OutOfStack:
-        error.Set("error", Napi::String::New(env, "out of stack"));
-        break;
+        return "out of stack";
     case TransactionException::StackUnderflow:
-        error.Set("error", Napi::String::New(env, "stack under flow"));
-        break;
+        return "stack under flow";
     case TransactionException::RevertInstruction:
-        error.Set("error", Napi::String::New(env, "revert instruction"));
-        break;
+        return "revert instruction";
     case TransactionException::InvalidZeroSignatureFormat:
-        error.Set("error", Napi::String::New(env, "invalid zero signature format"));
-        break;
+        return "invalid zero signature format";
     case TransactionException::AddressAlreadyUsed:
-        error.Set("error", Napi::String::New(env, "address already used"));
-        break;
+        return "address already used";
+    case TransactionException::ExecutionBudgetExceeded:
+        return "execution budget exceeded";
     case TransactionException::Unknown:
     default:
-        error.Set("error", Napi::String::New(env, "unknown"));
-        break;
+        return "unknown";
+    }
+}
+
+Napi::Value toNapiValue(Napi::Env env, const TransactionException &te)
+{
+    if (te == TransactionException::None)
+    {
+        return env.Undefined();
     }
+
+    auto error = Napi::Object::New(env);
+    error.Set("error", Napi::String::New(env, toErrorMessage(te)));
     return error;
 }
 
@@ -156,6 +177,102 @@ Napi::Value toNapiValue(Napi::Env env, const ExecutionResult &er)
     return result;
 }
 
+/**
+ * Results of many calls packed into one buffer, in little endian:
+ * - uint32 number of calls
+ * - a 20 bytes record per call: uint32 offset of the output, uint32 size of the output,
+ *   uint32 size of the error message right after the output, 0 if the call succeeded,
+ *   uint64 gas used
+ * - the outputs and error messages
+ */
+struct PackedCallResults
+{
+    bytes data;
+};
+
+/**
+ * Pack the results of many calls.
+ * @param results - Execution results
+ * @return Packed results, the gas used is capped at 2^64 - 1
+ */
+PackedCallResults packCallResults(const std::vector<ExecutionResult> &results)
+{
+    const std::size_t recordSize = 20;
+    std::size_t size = 4 + results.size() * recordSize;
+    for (const auto &result : results)
+    {
+        size += result.output.size();
+        if (result.excepted != TransactionException::None)
+        {
+            size += std::strlen(toErrorMessage(result.excepted));
+        }
+    }
+    if (size > std::numeric_limits<uint32_t>::max())
+    {
+        throw std::runtime_error("call results too large");
+    }
+
+    PackedCallResults packed;
+    packed.data.resize(size);
+    auto put = [&](std::size_t pos, uint64_t value, std::size_t bytes) {
+        for (std::size_t i = 0; i < bytes; i++)
+        {
+            packed.data[pos + i] = static_cast<byte>(value >> (8 * i));
+        }
+    };
+
+    put(0, results.size(), 4);
+    std::size_t offset = 4 + results.size() * recordSize;
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        const auto &result = results[i];
+        const char *error = result.excepted != TransactionException::None ? toErrorMessage(result.excepted) : "";
+        const std::size_t errorSize = std::strlen(error);
+        const std::size_t record = 4 + i * recordSize;
+        put(record, offset, 4);
+        put(record + 4, result.output.size(), 4);
+        put(record + 8, errorSize, 4);
+        const u256 gasUsed = std::min<u256>(result.gasUsed, std::numeric_limits<uint64_t>::max());
+        put(record + 12, static_cast<uint64_t>(gasUsed), 8);
+
+        std::copy(result.output.begin(), result.output.end(), packed.data.begin() + offset);
+        offset += result.output.size();
+        std::copy(error, error + errorSize, packed.data.begin() + offset);
+        offset += errorSize;
+    }
+    return packed;
+}
+
+Napi::Value toNapiValue(Napi::Env env, const PackedCallResults &_packed)
+{
+    return Buffer::Copy(env, _packed.data.data(), _packed.data.size());
+}
+
+Napi::Value toNapiValue(Napi::Env env, const CreatedAccessList &_created)
+{
+    auto accessList = Napi::Array::New(env, _created.accessList.size());
+    for (std::size_t i = 0; i < _created.accessList.size(); i++)
+    {
+        const auto &keys = _created.accessList[i].second;
+        auto storageKeys = Napi::Array::New(env, keys.size());
+        for (std::size_t j = 0; j < keys.size(); j++)
+        {
+            storageKeys.Set(j, toNapiValue(env, h256(keys[j])));
+        }
+        auto item = Napi::Array::New(env, 2);
+        item.Set((uint32_t)0, toNapiValue(env, _created.accessList[i].first));
+        item.Set((uint32_t)1, storageKeys);
+        accessList.Set(i, item);
+    }
+
+    auto result = Napi::Object::New(env);
+    result.Set("accessList", accessList);
+    result.Set("gasUsed", toNapiValue(env, _created.gasUsed));
+    result.Set("excepted", toNapiValue(env, _created.excepted));
+    result.Set("runs", Napi::Number::New(env, _created.runs));
+    return result;
+}
+
 Napi::Value toNapiValue(Napi::Env env, const LogEntry &_log)
 {
     auto log = Napi::Object::New(env);
@@ -175,6 +292,22 @@ Napi::Value toNapiValue(Napi::Env env, const LogEntries &_logs)
     return logs;
 }
 
+Napi::Value toNapiValue(Napi::Env env, const LocalisedLogEntries &_logs)
+{
+    auto logs = Napi::Array::New(env, _logs.size());
+    for (std::size_t i = 0; i < _logs.size(); i++)
+    {
+        auto log = toNapiValue(env, static_cast<const LogEntry &>(_logs[i])).As<Napi::Object>();
+        log.Set("blockNumber", Napi::Number::New(env, _logs[i].blockNumber));
+        log.Set("blockHash", toNapiValue(env, _logs[i].blockHash));
+        log.Set("transactionHash", toNapiValue(env, _logs[i].transactionHash));
+        log.Set("transactionIndex", Napi::Number::New(env, _logs[i].transactionIndex));
+        log.Set("logIndex", Napi::Number::New(env, _logs[i].logIndex));
+        logs.Set(i, log);
+    }
+    return logs;
+}
+
 Napi::Value toNapiValue(Napi::Env env, const TransactionReceipt &_receipt)
 {
     auto receipt = Napi::Object::New(env);
@@ -192,6 +325,107 @@ Napi::Value toNapiValue(Napi::Env env, const TransactionReceipt &_receipt)
     return receipt;
 }
 
+Napi::Value toNapiValue(Napi::Env env, const StateDumpBatch &_batch)
+{
+    auto accounts = Napi::Array::New(env, _batch.accounts.size());
+    for (std::size_t i = 0; i < _batch.accounts.size(); i++)
+    {
+        const auto &_account = _batch.accounts[i];
+        auto account = Napi::Object::New(env);
+        account.Set("hashedAddress", toNapiValue(env, _account.hashedAddress));
+        account.Set("account", toNapiValue(env, _account.account));
+        auto storage = Napi::Array::New(env, _account.storage.size());
+        for (std::size_t j = 0; j < _account.storage.size(); j++)
+        {
+            auto slot = Napi::Array::New(env, 2);
+            slot.Set((uint32_t)0, toNapiValue(env, _account.storage[j].first));
+            slot.Set((uint32_t)1, toNapiValue(env, _account.storage[j].second));
+            storage.Set(j, slot);
+        }
+        account.Set("storage", storage);
+        account.Set("storageComplete", Napi::Boolean::New(env, _account.storageComplete));
+        accounts.Set(i, account);
+    }
+
+    auto batch = Napi::Object::New(env);
+    batch.Set("accounts", accounts);
+    if (_batch.finished)
+    {
+        batch.Set("next", env.Undefined());
+        return batch;
+    }
+
+    // a finished range is null, a range inside the storage of an account has the slot to resume from
+    auto next = Napi::Array::New(env, _batch.next.size());
+    for (std::size_t i = 0; i < _batch.next.size(); i++)
+    {
+        const auto &_range = _batch.next[i];
+        if (_range.finished)
+        {
+            next.Set(i, env.Null());
+            continue;
+        }
+        auto range = Napi::Object::New(env);
+        range.Set("account", toNapiValue(env, _range.account));
+        if (_range.inStorage)
+        {
+            range.Set("slot", toNapiValue(env, _range.slot));
+        }
+        next.Set(i, range);
+    }
+    batch.Set("next", next);
+    return batch;
+}
+
+Napi::Value toNapiValue(Napi::Env env, const StatePrunerStats &_stats)
+{
+    auto stats = Napi::Object::New(env);
+    stats.Set("cycles", Napi::Number::New(env, _stats.cycles));
+    stats.Set("marked", Napi::Number::New(env, _stats.marked));
+    stats.Set("swept", Napi::Number::New(env, _stats.swept));
+    stats.Set("totalSwept", Napi::Number::New(env, _stats.totalSwept));
+    stats.Set("lastCycleMs", Napi::Number::New(env, _stats.lastCycleMs));
+    stats.Set("running", Napi::Boolean::New(env, _stats.running));
+    return stats;
+}
+
+Napi::Value toNapiValue(Napi::Env env, const SizedLruCacheStats &_stats)
+{
+    auto stats = Napi::Object::New(env);
+    stats.Set("hits", Napi::Number::New(env, _stats.hits));
+    stats.Set("misses", Napi::Number::New(env, _stats.misses));
+    stats.Set("evictions", Napi::Number::New(env, _stats.evictions));
+    stats.Set("entries", Napi::Number::New(env, _stats.entries));
+    stats.Set("size", Napi::Number::New(env, _stats.size));
+    stats.Set("capacity", Napi::Number::New(env, _stats.capacity));
+    return stats;
+}
+
+Napi::Value toNapiValue(Napi::Env env, const ArenaStats &_stats)
+{
+    auto stats = Napi::Object::New(env);
+    stats.Set("allocations", Napi::Number::New(env, _stats.allocations));
+    stats.Set("bytes", Napi::Number::New(env, _stats.bytes));
+    stats.Set("chunkAllocations", Napi::Number::New(env, _stats.chunkAllocations));
+    stats.Set("resets", Napi::Number::New(env, _stats.resets));
+    return stats;
+}
+
+Napi::Value toNapiValue(Napi::Env env, const TrieNodeImportResult &_result)
+{
+    auto rejected = Napi::Array::New(env, _result.rejected.size());
+    for (std::size_t i = 0; i < _result.rejected.size(); i++)
+    {
+        rejected.Set(i, Napi::Number::New(env, _result.rejected[i]));
+    }
+
+    auto result = Napi::Object::New(env);
+    result.Set("imported", Napi::Number::New(env, _result.imported));
+    result.Set("rejected", rejected);
+    result.Set("missing", toNapiValue(env, _result.missing));
+    return result;
+}
+
 std::string toString(const Napi::Value &value)
 {
     if (!value.IsString())
@@ -380,6 +614,42 @@ uint32_t toUint32(const Napi::Value &value, std::optional<uint32_t> defaultValue
     }
 }
 
+/**
+ * Parse a block number of the log index.
+ * Logs carry 32 bit block numbers, so larger numbers are rejected rather than truncated.
+ * @param value - Number or BigInt
+ * @return Block number
+ */
+uint64_t toBlockNumber(const Napi::Value &value)
+{
+    const uint64_t max = std::numeric_limits<BlockNumber>::max();
+    if (value.IsNumber())
+    {
+        const double number = value.As<Napi::Number>().DoubleValue();
+        if (number >= 0 && number <= max && std::floor(number) == number)
+        {
+            return static_cast<uint64_t>(number);
+        }
+    }
+    else if (value.IsBigInt())
+    {
+        bool lossless = false;
+        const uint64_t number = value.As<Napi::BigInt>().Uint64Value(&lossless);
+        if (lossless && number <= max)
+        {
+            return number;
+        }
+    }
+    else
+    {
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return 0;
+    }
+
+    Napi::RangeError::New(value.Env(), "block number out of range").ThrowAsJavaScriptException();
+    return 0;
+}
+
 void *toExternalPointer(const Napi::Value &value)
 {
     if (!value.IsExternal())
@@ -391,6 +661,16 @@ void *toExternalPointer(const Napi::Value &value)
     return value.As<External>().Data();
 }
 
+leveldown::ExposedSnapshot *toExposedSnapshot(const Napi::Value &value)
+{
+    if (value.IsUndefined() || value.IsNull())
+    {
+        return nullptr;
+    }
+
+    return static_cast<leveldown::ExposedSnapshot *>(toExternalPointer(value));
+}
+
 h256s toH256s(const Napi::Value &value)
 {
     h256s hashes;
@@ -411,15 +691,21 @@ h256s toH256s(const Napi::Value &value)
     return hashes;
 }
 
-bool toBool(const Napi::Value &value)
+bool toBool(const Napi::Value &value, std::optional<bool> defaultValue = {})
 {
-    if (!value.IsBoolean())
+    if (value.IsBoolean())
+    {
+        return value.As<Napi::Boolean>().Value();
+    }
+    else if ((value.IsUndefined() || value.IsNull()) && defaultValue.has_value())
+    {
+        return *defaultValue;
+    }
+    else
     {
         Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
         return false;
     }
-
-    return value.As<Napi::Boolean>().Value();
 }
 
 LastBlockHashesLoader toLoader(const Napi::Value &value)
@@ -515,6 +801,26 @@ Transaction toTx(const Napi::Value &input)
     }
 }
 
+std::vector<Transaction> toTxs(const Napi::Value &value)
+{
+    std::vector<Transaction> txs;
+
+    if (!value.IsArray())
+    {
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return txs;
+    }
+
+    auto array = value.As<Napi::Array>();
+    txs.reserve(array.Length());
+    for (std::size_t i = 0; i < array.Length(); i++)
+    {
+        txs.push_back(toTx(array.Get(i)));
+    }
+
+    return txs;
+}
+
 BlockHeader toHeader(const Napi::Value &value)
 {
     if (value.IsBuffer())
@@ -583,105 +889,604 @@ Message toMessage(const Napi::Value &value)
     return msg;
 }
 
-class LastBlockHashes : public LastBlockHashesFace
+StateDumpOptions toStateDumpOptions(const Napi::Value &value)
 {
-  public:
-    LastBlockHashes(LastBlockHashesLoader loader) : m_loader(loader)
+    StateDumpOptions options;
+
+    if (value.IsUndefined() || value.IsNull())
     {
+        return options;
     }
-
-    virtual h256s precedingHashes(h256 const &_mostRecentHash) const final
+    else if (!value.IsObject())
     {
-        return m_loader();
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return options;
     }
 
-    virtual void clear() final
+    auto obj = value.As<Napi::Object>();
+    options.ranges = toUint32(obj.Get("ranges"), options.ranges);
+    options.threads = toUint32(obj.Get("threads"), options.threads);
+    options.batchSize = toUint32(obj.Get("batchSize"), (uint32_t)options.batchSize);
+    options.includeStorage = toBool(obj.Get("includeStorage"), options.includeStorage);
+    options.storageBatchSize = toUint32(obj.Get("storageBatchSize"), (uint32_t)options.storageBatchSize);
+    return options;
+}
+
+StateDumpCursor toStateDumpCursor(const Napi::Value &value)
+{
+    StateDumpCursor cursor;
+
+    if (value.IsUndefined() || value.IsNull())
     {
-        // do nothing...
+        return cursor;
+    }
+    else if (!value.IsArray())
+    {
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return cursor;
     }
 
-  private:
-    LastBlockHashesLoader m_loader;
-};
+    auto array = value.As<Napi::Array>();
+    for (std::size_t i = 0; i < array.Length(); i++)
+    {
+        auto rangeValue = array.Get(i);
+        StateDumpRangeCursor range;
+        if (rangeValue.IsNull())
+        {
+            range.finished = true;
+        }
+        else if (rangeValue.IsObject())
+        {
+            auto obj = rangeValue.As<Napi::Object>();
+            range.account = toH256(obj.Get("account"));
+            auto slot = obj.Get("slot");
+            if (!slot.IsUndefined() && !slot.IsNull())
+            {
+                range.slot = toH256(slot);
+                range.inStorage = true;
+            }
+        }
+        else
+        {
+            Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+            return cursor;
+        }
+        cursor.push_back(range);
+    }
 
-// global chain params cache
-std::unordered_map<Network, ChainParams> g_chainParams;
+    return cursor;
+}
 
-/**
- * Load chain params for network
- * @param network - Network id
- * @return Chain params
- */
-ChainParams &loadChainParam(Network network)
+std::vector<bytesConstRef> toBytesConstRefs(const Napi::Value &value)
 {
-    auto itr = g_chainParams.find(network);
-    if (itr != g_chainParams.end())
+    std::vector<bytesConstRef> refs;
+
+    if (!value.IsArray())
     {
-        return itr->second;
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return refs;
     }
 
-    auto [insertedItr, tookPlace] =
-        g_chainParams.insert(std::make_pair(network, ChainParams(genesisInfo(network), genesisStateRoot(network))));
-    return insertedItr->second;
+    auto array = value.As<Napi::Array>();
+
+    for (std::size_t i = 0; i < array.Length(); i++)
+    {
+        refs.emplace_back(toBytesConstRef(array.Get(i)));
+    }
+
+    return refs;
 }
 
-/**
- * C++ implementation of EVM binding.
- */
-class EVMBinding
+std::pair<TrieNodeImportOptions, h256s> toTrieNodeImportOptions(const Napi::Value &value)
 {
-  public:
-    /**
-     * Construct a new EVMBinding object.
-     * @param db - Level db object
-     * @param network - Network id
-     */
-    EVMBinding(void *db, Network network)
-        : m_db(DBFactory::create(db)), m_params(loadChainParam(network)), m_engine(m_params.createSealEngine())
+    TrieNodeImportOptions options;
+    h256s expected;
+
+    if (value.IsUndefined() || value.IsNull())
     {
+        return std::make_pair(options, expected);
     }
-
-    /**
-     * Get chain id.
-     * @return Chain id
-     */
-    int chainID()
+    else if (!value.IsObject())
     {
-        return m_params.chainID;
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return std::make_pair(options, expected);
     }
 
-    /**
-     * Force set hardfork by name
-     * @param hardfork - Hardfork name
-     */
-    void setHardfork(const std::string &hardfork)
+    auto obj = value.As<Napi::Object>();
+    auto expectedValue = obj.Get("expected");
+    if (!expectedValue.IsUndefined() && !expectedValue.IsNull())
+        expected = toH256s(expectedValue);
+    options.accounts = toBool(obj.Get("accounts"), options.accounts);
+    options.threads = toUint32(obj.Get("threads"), options.threads);
+    options.batchSize = toUint32(obj.Get("batchSize"), (uint32_t)options.batchSize);
+    return std::make_pair(options, expected);
+}
+
+Durability toDurability(const Napi::Value &value)
+{
+    auto durability = toString(value);
+    if (durability == "acknowledged")
     {
-        m_engine->setEvmSchedule(hardfork);
+        return Durability::Acknowledged;
     }
-
-    /**
-     * Reset hardfork
-     */
-    void resetHardfork()
+    else if (durability == "written")
     {
-        m_engine->resetEvmSchedule();
+        return Durability::Written;
     }
-
-    /**
-     * Initialize genesis state.
-     * @param info - Genesis information
-     * @return State root hash
-     */
-    h256 genesis(const GenesisInfo &info)
+    else if (durability == "synced")
     {
-        if (m_state.get() != nullptr)
-        {
-            throw std::runtime_error("state already exists");
-        }
-
-        createStateIfNotExsits(&info);
-
-        return m_state->rootHash();
+        return Durability::Synced;
+    }
+    else
+    {
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return Durability::Written;
+    }
+}
+
+struct TraceOptions
+{
+    std::string tracer = "structLogs";
+    StructLogOptions structLogs;
+    uint32_t chunkSize = 64 * 1024;
+    uint32_t maxBuffered = 64 * 1024 * 1024; // bytes kept while JS can't be called
+};
+
+TraceOptions toTraceOptions(const Napi::Value &value)
+{
+    TraceOptions options;
+
+    if (value.IsUndefined() || value.IsNull())
+    {
+        return options;
+    }
+    else if (!value.IsObject())
+    {
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return options;
+    }
+
+    auto obj = value.As<Napi::Object>();
+    auto tracer = obj.Get("tracer");
+    if (!tracer.IsUndefined() && !tracer.IsNull())
+    {
+        options.tracer = toString(tracer);
+    }
+    options.structLogs.enableMemory = toBool(obj.Get("enableMemory"), options.structLogs.enableMemory);
+    options.structLogs.disableStack = toBool(obj.Get("disableStack"), options.structLogs.disableStack);
+    options.structLogs.disableStorage = toBool(obj.Get("disableStorage"), options.structLogs.disableStorage);
+    options.chunkSize = toUint32(obj.Get("chunkSize"), options.chunkSize);
+    options.maxBuffered = toUint32(obj.Get("maxBuffered"), options.maxBuffered);
+    return options;
+}
+
+/**
+ * Wall-clock and instruction limits of a call, zero leaves a limit out.
+ */
+struct CallBudget
+{
+    uint32_t timeout = 0; // milliseconds
+    uint64_t steps = 0;
+
+    ExecutionLimits limits() const
+    {
+        return {std::chrono::milliseconds(timeout), steps};
+    }
+};
+
+CallBudget toCallBudget(const Napi::Value &value, const CallBudget &defaults = {})
+{
+    CallBudget budget = defaults;
+
+    if (value.IsUndefined() || value.IsNull())
+    {
+        return budget;
+    }
+    else if (!value.IsObject())
+    {
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return budget;
+    }
+
+    auto obj = value.As<Napi::Object>();
+    budget.timeout = toUint32(obj.Get("timeout"), budget.timeout);
+    budget.steps = static_cast<uint64_t>(
+        std::min<u256>(toU256(obj.Get("steps"), u256(budget.steps)), std::numeric_limits<uint64_t>::max()));
+    return budget;
+}
+
+std::vector<TransactionLogs> toTransactionLogs(const Napi::Value &value)
+{
+    std::vector<TransactionLogs> transactions;
+
+    if (!value.IsArray())
+    {
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return transactions;
+    }
+
+    auto array = value.As<Napi::Array>();
+    for (std::size_t i = 0; i < array.Length(); i++)
+    {
+        auto element = array.Get(i);
+        if (!element.IsObject() || !element.As<Napi::Object>().Get("logs").IsArray())
+        {
+            Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+            return transactions;
+        }
+
+        auto obj = element.As<Napi::Object>();
+        auto logs = obj.Get("logs").As<Napi::Array>();
+        TransactionLogs transaction{toH256(obj.Get("transactionHash")), LogEntries{}};
+        for (std::size_t j = 0; j < logs.Length(); j++)
+        {
+            if (!logs.Get(j).IsObject())
+            {
+                Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+                return transactions;
+            }
+
+            auto log = logs.Get(j).As<Napi::Object>();
+            transaction.logs.emplace_back(toAddress(log.Get("address")), toH256s(log.Get("topics")),
+                                          toBytes(log.Get("data"), bytes{}));
+        }
+        transactions.push_back(std::move(transaction));
+    }
+    return transactions;
+}
+
+LogFilter toLogFilter(const Napi::Value &value)
+{
+    LogFilter filter;
+
+    if (value.IsUndefined() || value.IsNull())
+    {
+        return filter;
+    }
+    else if (!value.IsObject())
+    {
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return filter;
+    }
+
+    auto obj = value.As<Napi::Object>();
+    auto address = obj.Get("address");
+    if (address.IsArray())
+    {
+        auto addresses = address.As<Napi::Array>();
+        for (std::size_t i = 0; i < addresses.Length(); i++)
+        {
+            filter.address(toAddress(addresses.Get(i)));
+        }
+    }
+    else if (!address.IsUndefined() && !address.IsNull())
+    {
+        filter.address(toAddress(address));
+    }
+
+    auto topics = obj.Get("topics");
+    if (topics.IsArray())
+    {
+        // every position matches one of its topics, null matches any topic
+        auto positions = topics.As<Napi::Array>();
+        for (uint32_t i = 0; i < positions.Length() && i < 4; i++)
+        {
+            auto position = positions.Get(i);
+            if (position.IsArray())
+            {
+                for (const auto &topic : toH256s(position))
+                {
+                    filter.topic(i, topic);
+                }
+            }
+            else if (!position.IsUndefined() && !position.IsNull())
+            {
+                filter.topic(i, toH256(position));
+            }
+        }
+    }
+    else if (!topics.IsUndefined() && !topics.IsNull())
+    {
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+    }
+    return filter;
+}
+
+StatePrunerOptions toStatePrunerOptions(const Napi::Value &value)
+{
+    StatePrunerOptions options;
+
+    if (value.IsUndefined() || value.IsNull())
+    {
+        return options;
+    }
+    else if (!value.IsObject())
+    {
+        Napi::TypeError::New(value.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+        return options;
+    }
+
+    auto obj = value.As<Napi::Object>();
+    options.retainedRoots = toUint32(obj.Get("retainedRoots"), options.retainedRoots);
+    options.interval = toUint32(obj.Get("interval"), options.interval);
+    options.maxOpsPerSecond = toUint32(obj.Get("maxOpsPerSecond"), options.maxOpsPerSecond);
+    options.batchSize = toUint32(obj.Get("batchSize"), options.batchSize);
+    options.markFilterBytes = toUint32(obj.Get("markFilterBytes"), options.markFilterBytes);
+    return options;
+}
+
+/**
+ * Holds the level db snapshot of an exposed snapshot while a call reads it,
+ * it must be created and destroyed on the main thread.
+ */
+class SnapshotPin
+{
+  public:
+    /**
+     * Pin an exposed snapshot.
+     * @param exposed - Exposed snapshot, null to read the latest state
+     */
+    explicit SnapshotPin(leveldown::ExposedSnapshot *exposed) : m_exposed(exposed), m_snapshot(nullptr)
+    {
+        if (m_exposed != nullptr)
+        {
+            m_snapshot = m_exposed->Pin();
+            if (m_snapshot == nullptr)
+            {
+                throw std::runtime_error("snapshot is not exposed anymore");
+            }
+        }
+    }
+
+    ~SnapshotPin()
+    {
+        if (m_snapshot != nullptr)
+        {
+            m_exposed->Unpin();
+        }
+    }
+
+    SnapshotPin(const SnapshotPin &) = delete;
+    SnapshotPin &operator=(const SnapshotPin &) = delete;
+
+    /**
+     * Get the level db snapshot.
+     * @return Level db snapshot, null to read the latest state
+     */
+    const void *get() const
+    {
+        return m_snapshot;
+    }
+
+  private:
+    leveldown::ExposedSnapshot *m_exposed;
+    const leveldb::Snapshot *m_snapshot;
+};
+
+/**
+ * Keeps the level db open while a worker reads or writes it. It must be created
+ * and destroyed on the main thread.
+ */
+class DatabaseWork
+{
+  public:
+    /**
+     * Start working.
+     * @param db - Exposed level db
+     */
+    explicit DatabaseWork(leveldown::ExposedDB *db) : m_db(db)
+    {
+        if (!m_db->DeferClose())
+        {
+            throw std::runtime_error("database is not open");
+        }
+        m_db->Ref();
+    }
+
+    virtual ~DatabaseWork()
+    {
+        m_db->AllowClose();
+        m_db->Unref();
+    }
+
+    DatabaseWork(const DatabaseWork &) = delete;
+    DatabaseWork &operator=(const DatabaseWork &) = delete;
+
+  protected:
+    leveldown::ExposedDB *m_db;
+};
+
+/**
+ * Keeps the level db open while a worker reads it, at an exposed snapshot or at
+ * a snapshot taken when the read starts. It must be created and destroyed on
+ * the main thread.
+ */
+class DatabaseRead : public DatabaseWork
+{
+  public:
+    /**
+     * Start reading.
+     * @param db - Exposed level db
+     * @param exposed - Exposed snapshot to read at, null to take a snapshot
+     */
+    DatabaseRead(leveldown::ExposedDB *db, leveldown::ExposedSnapshot *exposed)
+        : DatabaseWork(db), m_pin(std::make_unique<SnapshotPin>(exposed)), m_snapshot(nullptr)
+    {
+        if (exposed == nullptr)
+        {
+            m_snapshot = m_db->GetSnapshot();
+        }
+    }
+
+    ~DatabaseRead() override
+    {
+        // the snapshots are released before the database may close
+        m_pin.reset();
+        if (m_snapshot != nullptr)
+        {
+            m_db->ReleaseSnapshot(m_snapshot);
+        }
+    }
+
+    /**
+     * Get the level db snapshot to read at.
+     * @return Level db snapshot
+     */
+    const void *snapshot() const
+    {
+        return m_snapshot != nullptr ? m_snapshot : m_pin->get();
+    }
+
+  private:
+    std::unique_ptr<SnapshotPin> m_pin;
+    const leveldb::Snapshot *m_snapshot;
+};
+
+class LastBlockHashes : public LastBlockHashesFace
+{
+  public:
+    LastBlockHashes(LastBlockHashesLoader loader) : m_loader(loader)
+    {
+    }
+
+    virtual h256s precedingHashes(h256 const &_mostRecentHash) const final
+    {
+        return m_loader();
+    }
+
+    virtual void clear() final
+    {
+        // do nothing...
+    }
+
+  private:
+    LastBlockHashesLoader m_loader;
+};
+
+// global chain params cache
+std::unordered_map<Network, ChainParams> g_chainParams;
+
+/**
+ * Load chain params for network
+ * @param network - Network id
+ * @return Chain params
+ */
+ChainParams &loadChainParam(Network network)
+{
+    auto itr = g_chainParams.find(network);
+    if (itr != g_chainParams.end())
+    {
+        return itr->second;
+    }
+
+    auto [insertedItr, tookPlace] =
+        g_chainParams.insert(std::make_pair(network, ChainParams(genesisInfo(network), genesisStateRoot(network))));
+    return insertedItr->second;
+}
+
+/**
+ * C++ implementation of EVM binding.
+ */
+class EVMBinding
+{
+  public:
+    /**
+     * Construct a new EVMBinding object.
+     * @param db - Exposed level db
+     * @param network - Network id
+     */
+    EVMBinding(leveldown::ExposedDB *db, Network network)
+        : m_exposed(db), m_leveldb(static_cast<leveldb::DB *>(db)), m_db(DBFactory::create(m_leveldb)),
+          m_params(loadChainParam(network)), m_engine(m_params.createSealEngine())
+    {
+        m_exposed->Ref();
+        m_exposed->AddCloseHook(&EVMBinding::onClose, this);
+
+        // report every committed node to the pruner, if any
+        m_db.setCommitObserver([this](const h256s &hashes) {
+            if (m_pruner.get() != nullptr)
+            {
+                m_pruner->noteWritten(hashes);
+            }
+        });
+    }
+
+    ~EVMBinding()
+    {
+        m_exposed->RemoveCloseHook(&EVMBinding::onClose, this);
+        stopPruner();
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+            // the pipeline logged the write error
+        }
+        m_exposed->Unref();
+    }
+
+    /**
+     * Get chain id.
+     * @return Chain id
+     */
+    int chainID()
+    {
+        return m_params.chainID;
+    }
+
+    /**
+     * Force set hardfork by name
+     * @param hardfork - Hardfork name
+     */
+    void setHardfork(const std::string &hardfork)
+    {
+        m_engine->setEvmSchedule(hardfork);
+        m_hardfork = hardfork;
+    }
+
+    /**
+     * Reset hardfork
+     */
+    void resetHardfork()
+    {
+        m_engine->resetEvmSchedule();
+        m_hardfork.clear();
+    }
+
+    /**
+     * Set the default budget of calls, stateless executions, access lists and traces.
+     * @param budget - Wall-clock and instruction limits, zero leaves a limit out
+     */
+    void setCallBudget(const CallBudget &budget)
+    {
+        m_callBudget = budget;
+    }
+
+    /**
+     * Get the default budget of calls.
+     * @return Wall-clock and instruction limits
+     */
+    const CallBudget &callBudget() const
+    {
+        return m_callBudget;
+    }
+
+    /**
+     * Initialize genesis state.
+     * @param info - Genesis information
+     * @return State root hash
+     */
+    h256 genesis(const GenesisInfo &info)
+    {
+        if (m_state.get() != nullptr)
+        {
+            throw std::runtime_error("state already exists");
+        }
+
+        createStateIfNotExsits(&info);
+
+        return m_state->rootHash();
     }
 
     /**
@@ -699,6 +1504,53 @@ class EVMBinding
         return run(stateRoot, header, tx, gasUsed, loader, Permanence::Committed);
     }
 
+    /**
+     * Start recording the trie nodes and code the following executions read from the database.
+     */
+    void startWitness()
+    {
+        createStateIfNotExsits();
+        m_state->db().setWitness(std::make_shared<Witness>());
+    }
+
+    /**
+     * Stop recording.
+     * @return The witness recorded since startWitness(), an empty one if nothing was recorded
+     */
+    bytes stopWitness()
+    {
+        if (m_state.get() == nullptr || m_state->db().witness().get() == nullptr)
+        {
+            return RLPStream(0).out();
+        }
+
+        auto witness = m_state->db().witness();
+        m_state->db().setWitness(nullptr);
+        return witness->rlp();
+    }
+
+    /**
+     * Execute transactions against a witness, the state database is not read.
+     * @param witness - Witness returned by stopWitness()
+     * @param stateRoot - Previous state root hash
+     * @param header - Block header
+     * @param txs - Transactions
+     * @param gasUsed - Gas used before the first transaction
+     * @param loader - A function used to load block hash
+     * @param budget - Wall-clock and instruction limits of every transaction
+     * @return New state root, execution result and transaction receipt of every transaction,
+     *         MissingWitnessNode is thrown as soon as a node is missing from the witness
+     */
+    std::vector<StatelessTransactionResult> runTxsStateless(bytesConstRef witness, const h256 &stateRoot,
+                                                            const BlockHeader &header,
+                                                            const std::vector<Transaction> &txs,
+                                                            const u256 &gasUsed, LastBlockHashes loader,
+                                                            const CallBudget &budget)
+    {
+        return executeStateless(witness, stateRoot, header, loader, gasUsed, m_params.chainID, *m_engine, txs,
+                                budget.limits());
+    }
+
     /**
      * Execute call.
      * @param stateRoot - Previous state root hash
@@ -706,15 +1558,181 @@ class EVMBinding
      * @param tx - Transaction
      * @param gasUsed - Gas used
      * @param loader - A function used to load block hash
-     * @return Contract output
+     * @param budget - Wall-clock and instruction limits of the call
+     * @param snapshot - Level db snapshot to read the state at, null to read the latest state
+     * @return Contract output, ExecutionBudgetExceeded is thrown once the budget is exhausted
      */
     auto runCall(const h256 &stateRoot, const BlockHeader &header, const Transaction &tx, const u256 &gasUsed,
-                 LastBlockHashes loader)
+                 LastBlockHashes loader, const CallBudget &budget, const void *snapshot = nullptr)
     {
-        auto [newStateRoot, result, receipt] = run(stateRoot, header, tx, gasUsed, loader, Permanence::Reverted);
+        ExecutionBudget executionBudget(budget.limits());
+        auto limit = budget.limits().unlimited() ? nullptr : &executionBudget;
+
+        if (snapshot == nullptr)
+        {
+            auto [newStateRoot, result, receipt] =
+                run(stateRoot, header, tx, gasUsed, loader, Permanence::Reverted, limit);
+            return result.output;
+        }
+
+        // execute on a separate state, nothing is written
+        State state(0, readDB(snapshot), BaseState::PreExisting);
+        EnvInfo envInfo(header, LastBlockHashes(loader), gasUsed, m_params.chainID);
+        state.setRoot(stateRoot);
+        auto [result, receipt] = state.execute(envInfo, *m_engine, tx, Permanence::Reverted, OnOpFunc(), nullptr, limit);
         return result.output;
     }
 
+    /**
+     * Prepare executing many calls against the same state.
+     * The returned task doesn't touch this binding, so it can run on a worker thread.
+     * @param stateRoot - Previous state root hash
+     * @param header - Block header
+     * @param txs - Transactions
+     * @param gasUsed - Gas used
+     * @param loader - A function used to load block hash
+     * @param threads - Number of threads to spread the calls over, 0 means one per hardware thread
+     * @param budget - Wall-clock and instruction limits of every call
+     * @param snapshot - Level db snapshot of startRead() to read the state at
+     * @return Task returning the packed execution results in the order of the transactions
+     */
+    std::function<PackedCallResults()> runCalls(const h256 &stateRoot, const BlockHeader &header,
+                                                std::vector<Transaction> txs, const u256 &gasUsed,
+                                                LastBlockHashesLoader loader, uint32_t threads,
+                                                const CallBudget &budget, const void *snapshot)
+    {
+        // the loader calls into js and the hardfork may be changed meanwhile,
+        // so the hashes are loaded and the seal engine is copied here
+        h256s hashes = loader();
+        std::shared_ptr<SealEngineFace> engine(m_params.createSealEngine());
+        if (!m_hardfork.empty())
+        {
+            engine->setEvmSchedule(m_hardfork);
+        }
+
+        return [db = readDB(snapshot), stateRoot, header, txs = std::move(txs), gasUsed, hashes, engine,
+                chainID = m_params.chainID, threads, limits = budget.limits()]() {
+            // every thread reads the hashes loaded up front
+            LastBlockHashes lastHashes([hashes]() { return hashes; });
+            EnvInfo envInfo(header, lastHashes, gasUsed, chainID);
+            return packCallResults(executeCalls(db, stateRoot, envInfo, *engine, txs, threads, limits));
+        };
+    }
+
+    /**
+     * Start reading the database on a worker thread.
+     * @param snapshot - Exposed snapshot to read at, null to read the latest state
+     * @return Read to keep until the worker is done
+     */
+    std::unique_ptr<DatabaseRead> startRead(leveldown::ExposedSnapshot *snapshot)
+    {
+        // a level db snapshot doesn't see the commits that are still queued
+        if (snapshot == nullptr)
+        {
+            flush();
+        }
+        return std::make_unique<DatabaseRead>(m_exposed, snapshot);
+    }
+
+    /**
+     * Start writing the database on a worker thread.
+     * @return Work to keep until the worker is done
+     */
+    std::unique_ptr<DatabaseWork> startWrite()
+    {
+        return std::make_unique<DatabaseWork>(m_exposed);
+    }
+
+    /**
+     * Prepare creating an access list for a transaction.
+     * The returned task doesn't touch this binding, so it can run on a worker thread
+     * while js keeps using the binding.
+     * @param stateRoot - Previous state root hash
+     * @param header - Block header
+     * @param tx - Transaction
+     * @param gasUsed - Gas used
+     * @param loader - A function used to load block hash
+     * @param budget - Wall-clock and instruction limits shared by the executions
+     * @param snapshot - Level db snapshot of startRead() to read the state at
+     * @return Task returning the access list and gas used with it
+     */
+    std::function<CreatedAccessList()> createAccessList(const h256 &stateRoot, const BlockHeader &header,
+                                                        const Transaction &tx, const u256 &gasUsed,
+                                                        LastBlockHashesLoader loader, const CallBudget &budget,
+                                                        const void *snapshot)
+    {
+        // the loader calls into js and the hardfork may be changed meanwhile,
+        // so the hashes are loaded and the seal engine is copied here
+        h256s hashes = loader();
+        std::shared_ptr<SealEngineFace> engine(m_params.createSealEngine());
+        if (!m_hardfork.empty())
+        {
+            engine->setEvmSchedule(m_hardfork);
+        }
+
+        // execute on a separate state, nothing is written
+        return [db = readDB(snapshot), stateRoot, header, tx, gasUsed, hashes, engine, chainID = m_params.chainID,
+                limits = budget.limits()]() {
+            State state(0, db, BaseState::PreExisting);
+            LastBlockHashes lastHashes([hashes]() { return hashes; });
+            EnvInfo envInfo(header, lastHashes, gasUsed, chainID);
+            return eth::createAccessList(state, stateRoot, envInfo, *engine, tx, limits);
+        };
+    }
+
+    /**
+     * Trace call.
+     * @param stateRoot - Previous state root hash
+     * @param header - Block header
+     * @param tx - Transaction
+     * @param gasUsed - Gas used
+     * @param loader - A function used to load block hash
+     * @param options - Trace options
+     * @param sink - Receives the trace in chunks
+     * @param budget - Budget of the call, the sink may cancel it to abort the call
+     * @param snapshot - Level db snapshot to read the state at, null to read the latest state
+     * @return ExecutionBudgetExceeded is thrown once the budget is exhausted or cancelled
+     */
+    void traceCall(const h256 &stateRoot, const BlockHeader &header, const Transaction &tx, const u256 &gasUsed,
+                   LastBlockHashes loader, const TraceOptions &options, TraceWriter::Sink sink,
+                   ExecutionBudget &budget, const void *snapshot = nullptr)
+    {
+        if (options.tracer != "structLogs" && options.tracer != "callTracer")
+        {
+            throw std::runtime_error("unknown tracer");
+        }
+
+        // execute on a separate state, nothing is written
+        State state(0, readDB(snapshot), BaseState::PreExisting);
+        EnvInfo envInfo(header, LastBlockHashes(loader), gasUsed, m_params.chainID);
+        state.setRoot(stateRoot);
+
+        TraceWriter writer(std::move(sink), std::max<uint32_t>(options.chunkSize, 1));
+        if (options.tracer == "callTracer")
+        {
+            CallTracer tracer(writer);
+            enterTransactionFrame(tracer, tx);
+            auto [result, receipt] = state.execute(envInfo, *m_engine, tx, Permanence::Reverted, OnOpFunc(), &tracer, &budget);
+            exitTransactionFrame(tracer, tx, result);
+            tracer.finish();
+        }
+        else
+        {
+            StructLogTracer tracer(writer, options.structLogs);
+            try
+            {
+                auto [result, receipt] = state.execute(envInfo, *m_engine, tx, Permanence::Reverted, OnOpFunc(), &tracer, &budget);
+                tracer.finish(result);
+            }
+            catch (const ExecutionBudgetExceeded &)
+            {
+                // a failing tracer cancels the budget, its error is the cause
+                tracer.rethrowError();
+                throw;
+            }
+        }
+    }
+
     /**
      * Execute message.
      * @param stateRoot - Previous state root hash
@@ -741,7 +1759,211 @@ class EVMBinding
         return std::make_tuple(m_state->rootHash(), std::move(result), std::move(logs));
     }
 
+    /**
+     * Prepare dumping a batch of accounts of a state.
+     * The returned task doesn't touch this binding, so it can run on a worker thread.
+     * @param stateRoot - State root hash
+     * @param cursor - Position of every range to start from, empty to start at the beginning
+     * @param options - Dump options
+     * @param snapshot - Level db snapshot of startRead() to read the state at
+     * @return Task returning the accounts of every range in order and the cursor of the next batch
+     */
+    std::function<StateDumpBatch()> dumpState(const h256 &stateRoot, StateDumpCursor cursor,
+                                              const StateDumpOptions &options, const void *snapshot)
+    {
+        return [db = readDB(snapshot), stateRoot, cursor = std::move(cursor), options]() {
+            StateDumper dumper(db, stateRoot, options);
+            return dumper.next(cursor);
+        };
+    }
+
+    /**
+     * Import trie nodes downloaded by state sync.
+     * @param nodes - RLP encoded trie nodes or code
+     * @param expected - Requested hashes, empty to accept any trie node
+     * @param options - Import options
+     * @return Task importing the nodes, returning the import result and the next frontier
+     */
+    std::function<TrieNodeImportResult()> importTrieNodes(std::vector<bytes> nodes, h256s expected,
+                                                          const TrieNodeImportOptions &options)
+    {
+        // the task runs on a worker thread, it reports to the pruner running now,
+        // which protects the nodes until the sync target is retained
+        TrieNodeImporter::WriteObserver observer;
+        if (m_pruner.get() != nullptr)
+        {
+            observer = [pruner = m_pruner](const h256s &hashes) { pruner->noteImported(hashes); };
+        }
+
+        std::shared_ptr<db::DatabaseFace> db = DBFactory::create(m_leveldb);
+        return [db, nodes = std::move(nodes), expected = std::move(expected), options, observer]() {
+            std::vector<bytesConstRef> refs;
+            for (const auto &node : nodes)
+            {
+                refs.emplace_back(&node);
+            }
+            TrieNodeImporter importer(db, options, observer);
+            return importer.import(refs, expected);
+        };
+    }
+
+    /**
+     * Set when a commit returns, commits are written by a background thread in order
+     * and stay readable until they are written.
+     * @param durability - Commit durability
+     */
+    void setDurability(Durability durability)
+    {
+        if (m_pipeline.get() == nullptr)
+        {
+            m_pipeline = std::make_shared<CommitPipeline>(m_db.database());
+        }
+
+        m_db.setCommitPipeline(m_pipeline, durability);
+        if (m_state.get() != nullptr)
+        {
+            m_state->db().setCommitPipeline(m_pipeline, durability);
+        }
+    }
+
+    /**
+     * Wait until every commit is written to the database.
+     * Throws the write error if a commit couldn't be written.
+     */
+    void flush()
+    {
+        if (m_pipeline.get() != nullptr)
+        {
+            m_pipeline->flush();
+        }
+    }
+
+    /**
+     * Start pruning unreachable state in background.
+     * @param options - Pruner options
+     */
+    void startPruner(const StatePrunerOptions &options)
+    {
+        if (m_pruner.get() != nullptr)
+        {
+            throw std::runtime_error("pruner already started");
+        }
+
+        m_pruner = std::make_shared<StatePruner>(DBFactory::create(m_leveldb), options);
+        m_pruner->start();
+    }
+
+    /**
+     * Stop pruning, closing the level db stops it too.
+     */
+    void stopPruner()
+    {
+        if (m_pruner.get() != nullptr)
+        {
+            m_pruner->stop();
+            m_pruner.reset();
+        }
+    }
+
+    /**
+     * Retain a state root, the oldest retained roots will be pruned.
+     * @param stateRoot - State root hash
+     */
+    void retainRoot(const h256 &stateRoot)
+    {
+        if (m_pruner.get() == nullptr)
+        {
+            throw std::runtime_error("pruner not started");
+        }
+
+        // the pruner reads the database directly, the root must be written first
+        flush();
+        m_pruner->retainRoot(stateRoot);
+    }
+
+    /**
+     * Get pruner statistics.
+     * @return Pruner statistics
+     */
+    StatePrunerStats prunerStats()
+    {
+        return m_pruner.get() != nullptr ? m_pruner->stats() : StatePrunerStats{};
+    }
+
+    /**
+     * Index the logs of a block.
+     * @param number - Block number
+     * @param blockHash - Block hash
+     * @param transactions - Transaction hashes and logs of the block
+     */
+    void indexBlock(uint64_t number, const h256 &blockHash, const std::vector<TransactionLogs> &transactions)
+    {
+        logIndex().indexBlock(number, blockHash, transactions);
+    }
+
+    /**
+     * Prepare finding the logs of indexed blocks.
+     * The returned task doesn't touch this binding, so it can run on a worker thread.
+     * @param from - First block number
+     * @param to - Last block number
+     * @param filter - Log filter
+     * @param snapshot - Level db snapshot of startRead() to read the index at
+     * @return Task returning the matching logs
+     */
+    std::function<LocalisedLogEntries()> filterLogs(uint64_t from, uint64_t to, LogFilter filter,
+                                                    const void *snapshot)
+    {
+        // the index of this binding isn't thread-safe, the task reads through its own,
+        // which rebuilds the sections that are not written yet
+        std::shared_ptr<db::DatabaseFace> db = DBFactory::create(m_leveldb, snapshot);
+        return [db, from, to, filter = std::move(filter)]() {
+            LogIndex index(db);
+            return index.filterLogs(from, to, filter);
+        };
+    }
+
   private:
+    /**
+     * Close hook of the level db, stops the pruner and writes the queued commits while it is open.
+     * @param arg - The EVMBinding
+     */
+    static void onClose(void *arg)
+    {
+        auto binding = static_cast<EVMBinding *>(arg);
+        binding->stopPruner();
+        try
+        {
+            binding->flush();
+        }
+        catch (...)
+        {
+            // the pipeline logged the write error and throws it again on the next commit
+        }
+    }
+
+    /**
+     * Get the log index, it is created on first use.
+     * @return Log index
+     */
+    LogIndex &logIndex()
+    {
+        if (m_logIndex.get() == nullptr)
+        {
+            m_logIndex = std::make_unique<LogIndex>(DBFactory::create(m_leveldb));
+        }
+        return *m_logIndex;
+    }
+
+    /**
+     * Get the database to read from.
+     * @param snapshot - Level db snapshot, null to read the latest state
+     * @return A database reading at the snapshot, or the shared database
+     */
+    OverlayDB readDB(const void *snapshot)
+    {
+        return snapshot != nullptr ? OverlayDB(DBFactory::create(m_leveldb, snapshot)) : m_db;
+    }
+
     /**
      * Create a state if it doesn't exsit.
      * @param info - Genesis info
@@ -783,26 +2005,97 @@ class EVMBinding
      */
     std::tuple<h256, ExecutionResult, TransactionReceipt> run(const h256 &stateRoot, const BlockHeader &header,
                                                               const Transaction &tx, const u256 &gasUsed,
-                                                              LastBlockHashes loader, Permanence permanence)
+                                                              LastBlockHashes loader, Permanence permanence,
+                                                              ExecutionBudget *budget = nullptr)
     {
         createStateIfNotExsits();
 
-        // create env info object
-        EnvInfo envInfo(header, LastBlockHashes(loader), gasUsed, m_params.chainID);
-        // reset state root
-        m_state->setRoot(stateRoot);
-        // execute transaction
-        auto [result, receipt] = m_state->execute(envInfo, *m_engine, tx, permanence);
-        // commit data to db
-        m_state->db().commit();
+        // create env info object
+        EnvInfo envInfo(header, LastBlockHashes(loader), gasUsed, m_params.chainID);
+        // reset state root
+        m_state->setRoot(stateRoot);
+        // execute transaction
+        auto [result, receipt] = m_state->execute(envInfo, *m_engine, tx, permanence, OnOpFunc(), nullptr, budget);
+        // commit data to db
+        m_state->db().commit();
+
+        return std::make_tuple(m_state->rootHash(), result, receipt);
+    }
+
+    leveldown::ExposedDB *m_exposed;
+    void *m_leveldb;
+    OverlayDB m_db;
+    ChainParams &m_params;
+    std::unique_ptr<SealEngineFace> m_engine;
+    std::string m_hardfork;
+    std::shared_ptr<State> m_state;
+    std::shared_ptr<CommitPipeline> m_pipeline;
+    std::shared_ptr<StatePruner> m_pruner;
+    std::unique_ptr<LogIndex> m_logIndex;
+    CallBudget m_callBudget;
+};
+
+/**
+ * Runs a task on a worker thread and settles a promise with its result.
+ */
+template <typename T> class PromiseWorker : public Napi::AsyncWorker
+{
+  public:
+    /**
+     * Construct a new PromiseWorker object.
+     * @param env - Napi env
+     * @param keep - Value the task uses, kept alive until the work is done
+     * @param work - Database work of the task, kept until the work is done
+     * @param task - Task run on the worker thread
+     */
+    PromiseWorker(Napi::Env env, Napi::Value keep, std::unique_ptr<DatabaseWork> work, std::function<T()> task)
+        : Napi::AsyncWorker(env), m_deferred(Napi::Promise::Deferred::New(env)), m_work(std::move(work)),
+          m_task(std::move(task))
+    {
+        if (!keep.IsUndefined() && !keep.IsNull())
+        {
+            m_keep = Napi::Persistent(keep);
+        }
+    }
+
+    Napi::Promise promise() const
+    {
+        return m_deferred.Promise();
+    }
+
+  protected:
+    void Execute() override
+    {
+        try
+        {
+            m_result = m_task();
+        }
+        catch (const std::exception &err)
+        {
+            SetError(err.what());
+        }
+        catch (...)
+        {
+            SetError("Unknown error");
+        }
+    }
+
+    void OnOK() override
+    {
+        m_deferred.Resolve(toNapiValue(Env(), m_result));
+    }
 
-        return std::make_tuple(m_state->rootHash(), result, receipt);
+    void OnError(const Napi::Error &err) override
+    {
+        m_deferred.Reject(err.Value());
     }
 
-    OverlayDB m_db;
-    ChainParams &m_params;
-    std::unique_ptr<SealEngineFace> m_engine;
-    std::shared_ptr<State> m_state;
+  private:
+    Napi::Promise::Deferred m_deferred;
+    Napi::Reference<Napi::Value> m_keep;
+    std::unique_ptr<DatabaseWork> m_work;
+    std::function<T()> m_task;
+    T m_result;
 };
 
 /**
@@ -819,10 +2112,27 @@ class JSEVMBinding : public Napi::ObjectWrap<JSEVMBinding>
                                               InstanceMethod("chainID", &JSEVMBinding::chainID),
                                               InstanceMethod("setHardfork", &JSEVMBinding::setHardfork),
                                               InstanceMethod("resetHardfork", &JSEVMBinding::resetHardfork),
+                                              InstanceMethod("setCallBudget", &JSEVMBinding::setCallBudget),
                                               InstanceMethod("genesis", &JSEVMBinding::genesis),
                                               InstanceMethod("runTx", &JSEVMBinding::runTx),
+                                              InstanceMethod("startWitness", &JSEVMBinding::startWitness),
+                                              InstanceMethod("stopWitness", &JSEVMBinding::stopWitness),
+                                              InstanceMethod("runTxsStateless", &JSEVMBinding::runTxsStateless),
                                               InstanceMethod("runCall", &JSEVMBinding::runCall),
+                                              InstanceMethod("runCalls", &JSEVMBinding::runCalls),
+                                              InstanceMethod("traceCall", &JSEVMBinding::traceCall),
+                                              InstanceMethod("createAccessList", &JSEVMBinding::createAccessList),
                                               InstanceMethod("runMessage", &JSEVMBinding::runMessage),
+                                              InstanceMethod("dumpState", &JSEVMBinding::dumpState),
+                                              InstanceMethod("importTrieNodes", &JSEVMBinding::importTrieNodes),
+                                              InstanceMethod("setDurability", &JSEVMBinding::setDurability),
+                                              InstanceMethod("flush", &JSEVMBinding::flush),
+                                              InstanceMethod("startPruner", &JSEVMBinding::startPruner),
+                                              InstanceMethod("stopPruner", &JSEVMBinding::stopPruner),
+                                              InstanceMethod("retainRoot", &JSEVMBinding::retainRoot),
+                                              InstanceMethod("prunerStats", &JSEVMBinding::prunerStats),
+                                              InstanceMethod("indexBlock", &JSEVMBinding::indexBlock),
+                                              InstanceMethod("filterLogs", &JSEVMBinding::filterLogs),
                                           });
 
         Napi::FunctionReference *constructor = new Napi::FunctionReference();
@@ -836,13 +2146,22 @@ class JSEVMBinding : public Napi::ObjectWrap<JSEVMBinding>
     /**
      * Construct a new JSEVMBinding object.
      * @param info - Napi callback info
-     * @param info_0 - External level db object
+     * @param info_0 - Exposed level db object
      * @param info_1 - Network id
      */
-    JSEVMBinding(const Napi::CallbackInfo &info)
-        : Napi::ObjectWrap<JSEVMBinding>(info),
-          m_binding(std::make_shared<EVMBinding>(toExternalPointer(info[0]), Network(toUint32(info[1]))))
+    JSEVMBinding(const Napi::CallbackInfo &info) : Napi::ObjectWrap<JSEVMBinding>(info)
     {
+        auto db = static_cast<leveldown::ExposedDB *>(toExternalPointer(info[0]));
+        if (db == nullptr)
+        {
+            if (!info.Env().IsExceptionPending())
+            {
+                Napi::Error::New(info.Env(), "database is not open").ThrowAsJavaScriptException();
+            }
+            return;
+        }
+
+        m_binding = std::make_shared<EVMBinding>(db, Network(toUint32(info[1])));
     }
 
     /**
@@ -878,6 +2197,18 @@ class JSEVMBinding : public Napi::ObjectWrap<JSEVMBinding>
         return info.Env().Undefined();
     }
 
+    /**
+     * Set the default budget of calls, stateless executions, access lists and traces
+     * @param info - Napi callback info
+     * @param info_0 - Budget object, zero or omitted fields leave a limit out
+     */
+    Napi::Value setCallBudget(const Napi::CallbackInfo &info)
+    {
+        m_binding->setCallBudget(toCallBudget(info[0]));
+
+        return info.Env().Undefined();
+    }
+
     /**
      * Initialize genesis state.
      * @param info - Napi callback info
@@ -947,6 +2278,69 @@ class JSEVMBinding : public Napi::ObjectWrap<JSEVMBinding>
         });
     }
 
+    /**
+     * Start recording a witness.
+     * @param info - Napi callback info
+     */
+    Napi::Value startWitness(const Napi::CallbackInfo &info)
+    {
+        m_binding->startWitness();
+
+        return info.Env().Undefined();
+    }
+
+    /**
+     * Stop recording a witness.
+     * @param info - Napi callback info
+     * @return RLP encoded witness
+     */
+    Napi::Value stopWitness(const Napi::CallbackInfo &info)
+    {
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            auto witness = m_binding->stopWitness();
+            return Buffer::Copy(info.Env(), witness.data(), witness.size());
+        });
+    }
+
+    /**
+     * Execute transactions against a witness.
+     * @param info - Napi callback info
+     * @param info_0 - RLP encoded witness
+     * @param info_1 - Previous state root hash
+     * @param info_2 - RLP encoded block header or header object
+     * @param info_3 - Array of RLP encoded transactions or transaction objects
+     * @param info_4 - Gas used before the first transaction
+     * @param info_5 - A function used to load block hash
+     * @param info_6 - Budget of every transaction, overrides the default one
+     * @return New state root hash, execution result and receipt of every transaction
+     */
+    Napi::Value runTxsStateless(const Napi::CallbackInfo &info)
+    {
+        // parse input params
+        auto witness = toBytesConstRef(info[0]);
+        auto stateRoot = toH256(info[1]);
+        auto header = toHeader(info[2]);
+        auto txs = toTxs(info[3]);
+        auto gasUsed = toU256(info[4]);
+        auto loader = toLoader(info[5]);
+        auto budget = toCallBudget(info[6], m_binding->callBudget());
+
+        // invoke cpp impl
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            auto results = m_binding->runTxsStateless(witness, stateRoot, header, txs, gasUsed, loader, budget);
+            auto array = Napi::Array::New(info.Env(), results.size());
+            for (std::size_t i = 0; i < results.size(); i++)
+            {
+                auto result = Napi::Object::New(info.Env());
+                result.Set("stateRoot", toNapiValue(info.Env(), results[i].stateRoot));
+                result.Set("result", toNapiValue(info.Env(), results[i].result));
+                result.Set("receipt", toNapiValue(info.Env(), results[i].receipt));
+                array.Set(i, result);
+            }
+            return array;
+        });
+    }
+
     /**
      * Execute call.
      * @param info - Napi callback info
@@ -955,21 +2349,181 @@ class JSEVMBinding : public Napi::ObjectWrap<JSEVMBinding>
      * @param info_2 - RLP encoded transaction or transaction object
      * @param info_3 - Gas used
      * @param info_4 - A function used to load block hash
+     * @param info_5 - Exposed level db snapshot to read the state at
+     * @param info_6 - Budget of the call, overrides the default one
      * @return Contract output
      */
     Napi::Value runCall(const Napi::CallbackInfo &info)
     {
         // parse input params
         auto params = parseRunParams(info);
+        auto snapshot = toExposedSnapshot(info[5]);
+        auto budget = toCallBudget(info[6], m_binding->callBudget());
 
         // invoke cpp impl
         return executeUnderTryCatch(info.Env(), [&, this]() {
             auto [stateRoot, header, tx, gasUsed, loader] = params;
-            auto output = m_binding->runCall(stateRoot, header, tx, gasUsed, loader);
+            SnapshotPin pin(snapshot);
+            auto output = m_binding->runCall(stateRoot, header, tx, gasUsed, loader, budget, pin.get());
             return toNapiValue(info.Env(), output);
         });
     }
 
+    /**
+     * Execute many calls.
+     * @param info - Napi callback info
+     * @param info_0 - Previous state root hash
+     * @param info_1 - RLP encoded block header or header object
+     * @param info_2 - Array of RLP encoded transactions or transaction objects
+     * @param info_3 - Gas used
+     * @param info_4 - A function used to load block hash
+     * @param info_5 - Number of threads, 0 means one per hardware thread, 1 by default
+     * @param info_6 - Exposed level db snapshot to read the state at
+     * @param info_7 - Budget of every call, overrides the default one
+     * @return Promise of the packed execution results in the order of the transactions
+     */
+    Napi::Value runCalls(const Napi::CallbackInfo &info)
+    {
+        // parse input params
+        auto stateRoot = toH256(info[0]);
+        auto header = toHeader(info[1]);
+        auto txs = toTxs(info[2]);
+        auto gasUsed = toU256(info[3]);
+        auto loader = toLoader(info[4]);
+        auto threads = toUint32(info[5], 1);
+        auto snapshot = toExposedSnapshot(info[6]);
+        auto budget = toCallBudget(info[7], m_binding->callBudget());
+
+        // invoke cpp impl on a worker thread
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            auto read = m_binding->startRead(snapshot);
+            auto task = m_binding->runCalls(stateRoot, header, std::move(txs), gasUsed, loader, threads, budget,
+                                            read->snapshot());
+            auto worker = new PromiseWorker<PackedCallResults>(info.Env(), info[6], std::move(read), std::move(task));
+            auto promise = worker->promise();
+            worker->Queue();
+            return promise;
+        });
+    }
+
+    /**
+     * Create access list.
+     * @param info - Napi callback info
+     * @param info_0 - Previous state root hash
+     * @param info_1 - RLP encoded block header or header object
+     * @param info_2 - RLP encoded transaction or transaction object
+     * @param info_3 - Gas used
+     * @param info_4 - A function used to load block hash
+     * @param info_5 - Exposed level db snapshot to read the state at
+     * @param info_6 - Budget shared by the executions, overrides the default one
+     * @return Promise of the access list, gas used and execution error
+     */
+    Napi::Value createAccessList(const Napi::CallbackInfo &info)
+    {
+        // parse input params
+        auto params = parseRunParams(info);
+        auto snapshot = toExposedSnapshot(info[5]);
+        auto budget = toCallBudget(info[6], m_binding->callBudget());
+
+        // invoke cpp impl on a worker thread
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            auto [stateRoot, header, tx, gasUsed, loader] = params;
+            auto read = m_binding->startRead(snapshot);
+            auto task = m_binding->createAccessList(stateRoot, header, tx, gasUsed, loader, budget, read->snapshot());
+            auto worker = new PromiseWorker<CreatedAccessList>(info.Env(), info[5], std::move(read), std::move(task));
+            auto promise = worker->promise();
+            worker->Queue();
+            return promise;
+        });
+    }
+
+    /**
+     * Trace call.
+     * @param info - Napi callback info
+     * @param info_0 - Previous state root hash
+     * @param info_1 - RLP encoded block header or header object
+     * @param info_2 - RLP encoded transaction or transaction object
+     * @param info_3 - Gas used
+     * @param info_4 - A function used to load block hash
+     * @param info_5 - Trace options
+     * @param info_6 - A function called with every chunk of the trace
+     * @param info_7 - Exposed level db snapshot
+     * @param info_8 - Budget of the call, overrides the default one
+     */
+    Napi::Value traceCall(const Napi::CallbackInfo &info)
+    {
+        // parse input params
+        auto params = parseRunParams(info);
+        auto options = toTraceOptions(info[5]);
+        if (!info[6].IsFunction())
+        {
+            Napi::TypeError::New(info.Env(), "Wrong arguments").ThrowAsJavaScriptException();
+            return info.Env().Undefined();
+        }
+        auto onChunk = info[6].As<Napi::Function>();
+        auto snapshot = toExposedSnapshot(info[7]);
+        auto budget = toCallBudget(info[8], m_binding->callBudget());
+
+        // JS may only be called from this thread, deep calls can run on an offloaded stack,
+        // their output is kept until the execution is back, up to maxBuffered bytes.
+        // An exception thrown by onChunk can't cross the vm: the execution is cancelled
+        // and the exception is rethrown once it has stopped.
+        auto thread = std::this_thread::get_id();
+        ExecutionBudget executionBudget(budget.limits());
+        std::exception_ptr error;
+        auto sink = [&](bytesConstRef chunk) {
+            if (error)
+            {
+                return true;
+            }
+            if (std::this_thread::get_id() != thread)
+            {
+                if (chunk.size() <= options.maxBuffered)
+                {
+                    return false;
+                }
+                error = std::make_exception_ptr(std::runtime_error("trace exceeds maxBuffered"));
+            }
+            else
+            {
+                try
+                {
+                    onChunk.Call({Buffer::Copy(info.Env(), chunk.data(), chunk.size())});
+                    return true;
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+            }
+            executionBudget.cancel();
+            return true;
+        };
+
+        // invoke cpp impl
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            auto [stateRoot, header, tx, gasUsed, loader] = params;
+            SnapshotPin pin(snapshot);
+            try
+            {
+                m_binding->traceCall(stateRoot, header, tx, gasUsed, loader, options, sink, executionBudget,
+                                     pin.get());
+            }
+            catch (const ExecutionBudgetExceeded &)
+            {
+                if (!error)
+                {
+                    throw;
+                }
+            }
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+            return info.Env().Undefined();
+        });
+    }
+
     /**
      * Execute message.
      * @param info - Napi callback info
@@ -1000,6 +2554,186 @@ class JSEVMBinding : public Napi::ObjectWrap<JSEVMBinding>
         });
     }
 
+    /**
+     * Dump a batch of accounts of a state on a worker thread.
+     * @param info - Napi callback info
+     * @param info_0 - State root hash
+     * @param info_1 - Position of every range to start from, the cursor returned by the previous batch
+     * @param info_2 - Dump options
+     * @param info_3 - Exposed level db snapshot to read the state at
+     * @return Promise of the accounts and the cursor of the next batch
+     */
+    Napi::Value dumpState(const Napi::CallbackInfo &info)
+    {
+        // parse input params
+        auto stateRoot = toH256(info[0]);
+        auto cursor = toStateDumpCursor(info[1]);
+        auto options = toStateDumpOptions(info[2]);
+        auto snapshot = toExposedSnapshot(info[3]);
+
+        // invoke cpp impl on a worker thread
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            auto read = m_binding->startRead(snapshot);
+            auto task = m_binding->dumpState(stateRoot, std::move(cursor), options, read->snapshot());
+            auto worker = new PromiseWorker<StateDumpBatch>(info.Env(), info[3], std::move(read), std::move(task));
+            auto promise = worker->promise();
+            worker->Queue();
+            return promise;
+        });
+    }
+
+    /**
+     * Import trie nodes downloaded by state sync.
+     * @param info - Napi callback info
+     * @param info_0 - An array containing RLP encoded trie nodes or code
+     * @param info_1 - Import options
+     * @return Import result and the next frontier
+     */
+    Napi::Value importTrieNodes(const Napi::CallbackInfo &info)
+    {
+        // parse input params, the nodes are copied as js may reuse the buffers
+        std::vector<bytes> nodes;
+        for (const auto &node : toBytesConstRefs(info[0]))
+        {
+            nodes.emplace_back(node.toBytes());
+        }
+        auto params = toTrieNodeImportOptions(info[1]);
+
+        // invoke cpp impl on a worker thread
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            auto [options, expected] = params;
+            auto write = m_binding->startWrite();
+            auto task = m_binding->importTrieNodes(std::move(nodes), expected, options);
+            auto worker = new PromiseWorker<TrieNodeImportResult>(info.Env(), info.Env().Undefined(), std::move(write),
+                                                                  std::move(task));
+            auto promise = worker->promise();
+            worker->Queue();
+            return promise;
+        });
+    }
+
+    /**
+     * Set when a commit returns.
+     * @param info - Napi callback info
+     * @param info_0 - Durability, "acknowledged", "written" or "synced"
+     */
+    Napi::Value setDurability(const Napi::CallbackInfo &info)
+    {
+        auto durability = toDurability(info[0]);
+
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            m_binding->setDurability(durability);
+            return info.Env().Undefined();
+        });
+    }
+
+    /**
+     * Wait until every commit is written to the database.
+     * @param info - Napi callback info
+     */
+    Napi::Value flush(const Napi::CallbackInfo &info)
+    {
+        m_binding->flush();
+
+        return info.Env().Undefined();
+    }
+
+    /**
+     * Start pruning unreachable state in background.
+     * @param info - Napi callback info
+     * @param info_0 - Pruner options
+     */
+    Napi::Value startPruner(const Napi::CallbackInfo &info)
+    {
+        auto options = toStatePrunerOptions(info[0]);
+
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            m_binding->startPruner(options);
+            return info.Env().Undefined();
+        });
+    }
+
+    /**
+     * Stop pruning.
+     * @param info - Napi callback info
+     */
+    Napi::Value stopPruner(const Napi::CallbackInfo &info)
+    {
+        m_binding->stopPruner();
+
+        return info.Env().Undefined();
+    }
+
+    /**
+     * Retain a state root.
+     * @param info - Napi callback info
+     * @param info_0 - State root hash
+     */
+    Napi::Value retainRoot(const Napi::CallbackInfo &info)
+    {
+        auto stateRoot = toH256(info[0]);
+
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            m_binding->retainRoot(stateRoot);
+            return info.Env().Undefined();
+        });
+    }
+
+    /**
+     * Get pruner statistics.
+     * @param info - Napi callback info
+     * @return Pruner statistics
+     */
+    Napi::Value prunerStats(const Napi::CallbackInfo &info)
+    {
+        return toNapiValue(info.Env(), m_binding->prunerStats());
+    }
+
+    /**
+     * Index the logs of a block.
+     * @param info - Napi callback info
+     * @param info_0 - Block number
+     * @param info_1 - Block hash
+     * @param info_2 - An array containing the transaction hash and the logs of every transaction
+     */
+    Napi::Value indexBlock(const Napi::CallbackInfo &info)
+    {
+        auto number = toBlockNumber(info[0]);
+        auto blockHash = toH256(info[1]);
+        auto transactions = toTransactionLogs(info[2]);
+
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            m_binding->indexBlock(number, blockHash, transactions);
+            return info.Env().Undefined();
+        });
+    }
+
+    /**
+     * Find the logs of indexed blocks.
+     * @param info - Napi callback info
+     * @param info_0 - First block number
+     * @param info_1 - Last block number
+     * @param info_2 - Log filter
+     * @return Promise of the matching logs
+     */
+    Napi::Value filterLogs(const Napi::CallbackInfo &info)
+    {
+        auto from = toBlockNumber(info[0]);
+        auto to = toBlockNumber(info[1]);
+        auto filter = toLogFilter(info[2]);
+
+        // invoke cpp impl on a worker thread
+        return executeUnderTryCatch(info.Env(), [&, this]() {
+            auto read = m_binding->startRead(nullptr);
+            auto task = m_binding->filterLogs(from, to, std::move(filter), read->snapshot());
+            auto worker = new PromiseWorker<LocalisedLogEntries>(info.Env(), info.Env().Undefined(), std::move(read),
+                                                                 std::move(task));
+            auto promise = worker->promise();
+            worker->Queue();
+            return promise;
+        });
+    }
+
   private:
     /**
      * Parse napi value for vm.
@@ -1064,10 +2798,69 @@ Napi::Value init(const Napi::CallbackInfo &info)
     return info.Env().Undefined();
 }
 
+/**
+ * Set the number of bytes the precompiled contract result cache may use,
+ * the cache is shared by all instances
+ * @param info - Napi callback info
+ * @param info_0 - Capacity in bytes, 0 disables the cache
+ */
+Napi::Value setPrecompileCacheSize(const Napi::CallbackInfo &info)
+{
+    PrecompiledCache::instance().setCapacity(toUint32(info[0]));
+    return info.Env().Undefined();
+}
+
+/**
+ * Get precompiled contract result cache statistics
+ * @param info - Napi callback info
+ * @return Cache statistics
+ */
+Napi::Value precompileCacheStats(const Napi::CallbackInfo &info)
+{
+    return toNapiValue(info.Env(), PrecompiledCache::instance().stats());
+}
+
+/**
+ * Set the number of bytes the contract code cache may use,
+ * the cache is shared by all instances
+ * @param info - Napi callback info
+ * @param info_0 - Capacity in bytes, 0 disables the cache
+ */
+Napi::Value setCodeCacheSize(const Napi::CallbackInfo &info)
+{
+    CodeCache::instance().setCapacity(toUint32(info[0]));
+    return info.Env().Undefined();
+}
+
+/**
+ * Get contract code cache statistics
+ * @param info - Napi callback info
+ * @return Cache statistics
+ */
+Napi::Value codeCacheStats(const Napi::CallbackInfo &info)
+{
+    return toNapiValue(info.Env(), CodeCache::instance().stats());
+}
+
+/**
+ * Get statistics of the per transaction arenas of all states
+ * @param info - Napi callback info
+ * @return Arena statistics
+ */
+Napi::Value arenaStats(const Napi::CallbackInfo &info)
+{
+    return toNapiValue(info.Env(), Arena::stats());
+}
+
 Napi::Object initExports(Napi::Env env, Napi::Object exports)
 {
     JSEVMBinding::Init(env, exports);
     exports.Set(Napi::String::New(env, "init"), Napi::Function::New(env, init));
+    exports.Set(Napi::String::New(env, "setPrecompileCacheSize"), Napi::Function::New(env, setPrecompileCacheSize));
+    exports.Set(Napi::String::New(env, "precompileCacheStats"), Napi::Function::New(env, precompileCacheStats));
+    exports.Set(Napi::String::New(env, "setCodeCacheSize"), Napi::Function::New(env, setCodeCacheSize));
+    exports.Set(Napi::String::New(env, "codeCacheStats"), Napi::Function::New(env, codeCacheStats));
+    exports.Set(Napi::String::New(env, "arenaStats"), Napi::Function::New(env, arenaStats));
     return exports;
 }
 
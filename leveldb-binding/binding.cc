@@ -1,4 +1,4 @@
-#define NAPI_VERSION 3
+#define NAPI_VERSION 4
 
 #include <assert.h>
 #include <napi-macros.h>
@@ -9,15 +9,32 @@
 #include <leveldb/filter_policy.h>
 #include <leveldb/write_batch.h>
 
+#include "exposed.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
 #include <map>
+#include <mutex>
+#include <set>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 /**
  * Forward declarations.
  */
+struct BaseWorker;
 struct Database;
 struct Iterator;
+struct Snapshot;
+struct ThreadPool;
 static void iterator_end_do(napi_env env, Iterator *iterator, napi_value cb);
+static void ScheduleWork(napi_env env, BaseWorker *worker);
+static void StartWriteGroup(napi_env env, Database *database);
 
 /**
  * Macros.
@@ -31,6 +48,10 @@ static void iterator_end_do(napi_env env, Iterator *iterator, napi_value cb);
     Iterator *iterator = NULL;                                                                                         \
     NAPI_STATUS_THROWS(napi_get_value_external(env, argv[0], (void **)&iterator));
 
+#define NAPI_SNAPSHOT_CONTEXT()                                                                                        \
+    Snapshot *snapshot = NULL;                                                                                         \
+    NAPI_STATUS_THROWS(napi_get_value_external(env, argv[0], (void **)&snapshot));
+
 #define NAPI_BATCH_CONTEXT()                                                                                           \
     Batch *batch = NULL;                                                                                               \
     NAPI_STATUS_THROWS(napi_get_value_external(env, argv[0], (void **)&batch));
@@ -181,6 +202,16 @@ static int Int32Property(napi_env env, napi_value obj, const char *key, int DEFA
     return DEFAULT;
 }
 
+/**
+ * Sets a number property on an object.
+ */
+static void SetNumberProperty(napi_env env, napi_value obj, const char *key, const double value)
+{
+    napi_value number;
+    napi_create_double(env, value, &number);
+    napi_set_named_property(env, obj, key, number);
+}
+
 /**
  * Returns a string property 'key' from 'obj'.
  * Returns empty string if the property doesn't exist.
@@ -214,6 +245,60 @@ static void DisposeSliceBuffer(leveldb::Slice slice)
         delete[] slice.data();
 }
 
+/**
+ * Appends 'value' to 'out' as a little-endian uint32.
+ */
+static void AppendUint32(std::string &out, uint32_t value)
+{
+    const char bytes[4] = {(char)(value & 0xff), (char)((value >> 8) & 0xff), (char)((value >> 16) & 0xff),
+                           (char)((value >> 24) & 0xff)};
+    out.append(bytes, 4);
+}
+
+/**
+ * Reads a varint32 length prefixed slice from the front of 'input' into 'result',
+ * the same encoding LevelDB uses for the records of a WriteBatch.
+ * Returns false if 'input' is truncated.
+ */
+static bool GetLengthPrefixedSlice(leveldb::Slice *input, leveldb::Slice *result)
+{
+    uint32_t length = 0;
+    size_t pos = 0;
+
+    for (uint32_t shift = 0; shift <= 28; shift += 7)
+    {
+        if (pos >= input->size())
+            return false;
+
+        const uint32_t byte = static_cast<unsigned char>((*input)[pos++]);
+        length |= (byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            if (input->size() - pos < length)
+                return false;
+
+            *result = leveldb::Slice(input->data() + pos, length);
+            input->remove_prefix(pos + length);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Frees the string backing an external buffer once the buffer is garbage collected,
+ * and takes its memory back from what V8 accounts to JS land.
+ */
+static void FinalizeString(napi_env env, void *data, void *hint)
+{
+    std::string *s = (std::string *)hint;
+    int64_t adjusted;
+    napi_adjust_external_memory(env, -(int64_t)s->capacity(), &adjusted);
+    delete s;
+}
+
 /**
  * Convert a napi_value to a leveldb::Slice.
  */
@@ -314,6 +399,23 @@ enum Mode
     values
 };
 
+/**
+ * Priority classes of the addon thread pool, highest first.
+ */
+enum WorkClass
+{
+    workRead = 0,
+    workWrite = 1,
+    workBackground = 2
+};
+
+static const size_t workClasses = 3;
+
+/**
+ * The addon thread pool, NULL until configured. Shared by all environments.
+ */
+static std::atomic<ThreadPool *> threadPool(NULL);
+
 /**
  * Helper struct for caching and converting a key-value pair to napi_values.
  */
@@ -375,6 +477,28 @@ struct Entry
         }
     }
 
+    /**
+     * Like Convert() but takes ownership of 's'. If 'zeroCopy' is set, buffers are
+     * created on top of the memory of 's' which is freed once the buffer is
+     * garbage collected. Falls back to copying for empty values and for runtimes
+     * that don't allow external buffers. The memory of 's' is reported to V8, so
+     * GC runs as external buffers pile up like it does for copied ones.
+     */
+    static void ConvertOwned(napi_env env, std::string *s, bool asBuffer, bool zeroCopy, napi_value *result)
+    {
+        if (s != NULL && asBuffer && zeroCopy && !s->empty() &&
+            napi_create_external_buffer(env, s->size(), &(*s)[0], FinalizeString, s, result) == napi_ok)
+        {
+            int64_t adjusted;
+            napi_adjust_external_memory(env, (int64_t)s->capacity(), &adjusted);
+            return;
+        }
+
+        Convert(env, s, asBuffer, result);
+        if (s != NULL)
+            delete s;
+    }
+
   private:
     std::string *key_;
     std::string *value_;
@@ -392,10 +516,16 @@ struct Entry
 struct BaseWorker
 {
     // Note: storing env is discouraged as we'd end up using it in unsafe places.
-    BaseWorker(napi_env env, Database *database, napi_value callback, const char *resourceName)
-        : database_(database), errMsg_(NULL)
+    BaseWorker(napi_env env, Database *database, napi_value callback, const char *resourceName,
+               const WorkClass workClass)
+        : database_(database), workClass_(workClass), asyncWork_(NULL), errMsg_(NULL)
     {
         NAPI_STATUS_THROWS_VOID(napi_create_reference(env, callback, 1, &callbackRef_));
+
+        // Work on a database goes to the addon thread pool once it's configured.
+        if (database != NULL && threadPool.load() != NULL)
+            return;
+
         napi_value asyncResourceName;
         NAPI_STATUS_THROWS_VOID(napi_create_string_utf8(env, resourceName, NAPI_AUTO_LENGTH, &asyncResourceName));
         NAPI_STATUS_THROWS_VOID(napi_create_async_work(env, callback, asyncResourceName, BaseWorker::Execute,
@@ -476,17 +606,22 @@ struct BaseWorker
     virtual void DoFinally(napi_env env)
     {
         napi_delete_reference(env, callbackRef_);
-        napi_delete_async_work(env, asyncWork_);
+        if (asyncWork_ != NULL)
+            napi_delete_async_work(env, asyncWork_);
 
         delete this;
     }
 
     void Queue(napi_env env)
     {
-        napi_queue_async_work(env, asyncWork_);
+        if (asyncWork_ != NULL)
+            napi_queue_async_work(env, asyncWork_);
+        else
+            ScheduleWork(env, this);
     }
 
     Database *database_;
+    const WorkClass workClass_;
 
   private:
     napi_ref callbackRef_;
@@ -496,267 +631,1621 @@ struct BaseWorker
 };
 
 /**
- * Owns the LevelDB storage, cache, filter policy and iterators.
+ * Puts, dels and batches written together in a single WriteBatch.
  */
-struct Database
+struct WriteGroup
 {
-    Database()
-        : db_(NULL), blockCache_(NULL), filterPolicy_(leveldb::NewBloomFilterPolicy(10)), currentIteratorId_(0),
-          pendingCloseWorker_(NULL), ref_(NULL), priorityWork_(0)
+    WriteGroup() : sync_(false)
     {
     }
 
-    ~Database()
-    {
-        if (db_ != NULL)
-        {
-            delete db_;
-            db_ = NULL;
-        }
-    }
+    leveldb::WriteBatch batch_;
+    std::vector<napi_ref> callbacks_;
+    bool sync_;
+};
 
-    leveldb::Status Open(const leveldb::Options &options, const char *location)
+/**
+ * Merges puts, dels and batches into write groups. Writes arriving while a group
+ * is gathered or written go into the next group, which is written once the
+ * previous one is done, so there's at most one group writer at a time and writes
+ * keep their order. Main thread only, except for Take().
+ */
+struct WriteQueue
+{
+    WriteQueue(const uint32_t window, const size_t maxBytes)
+        : window_(window), maxBytes_(maxBytes), writing_(false), flushScheduled_(false), pending_(new WriteGroup())
     {
-        return leveldb::DB::Open(options, location, &db_);
     }
 
-    void CloseDatabase()
+    ~WriteQueue()
     {
-        delete db_;
-        db_ = NULL;
-        if (blockCache_)
-        {
-            delete blockCache_;
-            blockCache_ = NULL;
-        }
+        delete pending_;
     }
 
-    leveldb::Status Put(const leveldb::WriteOptions &options, leveldb::Slice key, leveldb::Slice value)
+    /**
+     * Adds a put, or a del if 'value' is NULL, to the pending group.
+     * Returns true if the group is full.
+     */
+    bool Add(napi_env env, leveldb::Slice key, const leveldb::Slice *value, const bool sync, napi_value callback)
     {
-        return db_->Put(options, key, value);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (value != NULL)
+            pending_->batch_.Put(key, *value);
+        else
+            pending_->batch_.Delete(key);
+        return AddCallback(env, sync, callback);
     }
 
-    leveldb::Status Get(const leveldb::ReadOptions &options, leveldb::Slice key, std::string &value)
+    /**
+     * Adds a copy of the ops of 'batch' to the pending group.
+     * Returns true if the group is full.
+     */
+    bool AddBatch(napi_env env, const leveldb::WriteBatch &batch, const bool sync, napi_value callback)
     {
-        return db_->Get(options, key, &value);
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_->batch_.Append(batch);
+        return AddCallback(env, sync, callback);
     }
 
-    leveldb::Status Del(const leveldb::WriteOptions &options, leveldb::Slice key)
+    /**
+     * Takes the pending group. Worker thread only.
+     */
+    WriteGroup *Take()
     {
-        return db_->Delete(options, key);
+        std::lock_guard<std::mutex> lock(mutex_);
+        WriteGroup *group = pending_;
+        pending_ = new WriteGroup();
+        return group;
     }
 
-    leveldb::Status WriteBatch(const leveldb::WriteOptions &options, leveldb::WriteBatch *batch)
+    bool HasPending()
     {
-        return db_->Write(options, batch);
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !pending_->callbacks_.empty();
     }
 
-    uint64_t ApproximateSize(const leveldb::Range *range)
-    {
-        uint64_t size = 0;
-        db_->GetApproximateSizes(range, 1, &size);
-        return size;
-    }
+    const uint32_t window_;
+    const size_t maxBytes_;
+    bool writing_;
+    bool flushScheduled_; ///< A JS timer will call db_flush_writes()
 
-    void CompactRange(const leveldb::Slice *start, const leveldb::Slice *end)
+  private:
+    bool AddCallback(napi_env env, const bool sync, napi_value callback)
     {
-        db_->CompactRange(start, end);
-    }
+        napi_ref callbackRef;
+        napi_create_reference(env, callback, 1, &callbackRef);
+        pending_->callbacks_.push_back(callbackRef);
+        pending_->sync_ = pending_->sync_ || sync;
 
-    void GetProperty(const leveldb::Slice &property, std::string *value)
-    {
-        db_->GetProperty(property, value);
+        return pending_->batch_.ApproximateSize() >= maxBytes_;
     }
 
-    const leveldb::Snapshot *NewSnapshot()
+    std::mutex mutex_;
+    WriteGroup *pending_;
+};
+
+/**
+ * Sharded LRU cache of decoded rows in front of LevelDB, bounded by bytes.
+ * Every write through the Database or its exposed db erases its keys. A read
+ * only inserts its row if the shard wasn't written to since the read started, so
+ * a racing write can't leave a stale row behind. Safe to use from any thread.
+ */
+struct RowCache
+{
+    RowCache(const size_t capacity) : shards_(kShards)
     {
-        return db_->GetSnapshot();
+        for (Shard &shard : shards_)
+            shard.capacity_ = capacity / kShards;
     }
 
-    leveldb::Iterator *NewIterator(leveldb::ReadOptions *options)
+    /**
+     * Returns the write generation of the shard of 'key', to pass to Insert().
+     */
+    uint64_t Generation(leveldb::Slice key)
     {
-        return db_->NewIterator(*options);
+        Shard &shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        return shard.generation_;
     }
 
-    void ReleaseSnapshot(const leveldb::Snapshot *snapshot)
+    bool Lookup(leveldb::Slice key, std::string *value)
     {
-        return db_->ReleaseSnapshot(snapshot);
+        Shard &shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        auto it = shard.index_.find(std::string_view(key.data(), key.size()));
+        if (it == shard.index_.end())
+            return false;
+
+        shard.lru_.splice(shard.lru_.begin(), shard.lru_, it->second);
+        value->assign(it->second->second);
+        return true;
     }
 
-    void AttachIterator(napi_env env, uint32_t id, Iterator *iterator)
+    void Insert(leveldb::Slice key, const std::string &value, const uint64_t generation)
     {
-        iterators_[id] = iterator;
-        IncrementPriorityWork(env);
+        const size_t charge = Charge(key.size(), value.size());
+        Shard &shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        if (shard.generation_ != generation || charge > shard.capacity_)
+            return;
+
+        shard.Remove(std::string_view(key.data(), key.size()));
+        shard.lru_.emplace_front(key.ToString(), value);
+        shard.index_.emplace(shard.lru_.front().first, shard.lru_.begin());
+        shard.usage_ += charge;
+
+        while (shard.usage_ > shard.capacity_)
+            shard.Remove(shard.lru_.back().first);
     }
 
-    void DetachIterator(napi_env env, uint32_t id)
+    void Erase(leveldb::Slice key)
     {
-        iterators_.erase(id);
-        DecrementPriorityWork(env);
+        Shard &shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        shard.generation_++;
+        shard.Remove(std::string_view(key.data(), key.size()));
     }
 
-    void IncrementPriorityWork(napi_env env)
+    void Clear()
     {
-        napi_reference_ref(env, ref_, &priorityWork_);
+        for (Shard &shard : shards_)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            shard.generation_++;
+            shard.index_.clear();
+            shard.lru_.clear();
+            shard.usage_ = 0;
+        }
     }
 
-    void DecrementPriorityWork(napi_env env)
+  private:
+    typedef std::list<std::pair<std::string, std::string>> Rows;
+
+    struct Shard
     {
-        napi_reference_unref(env, ref_, &priorityWork_);
+        Shard() : capacity_(0), usage_(0), generation_(0)
+        {
+        }
 
-        if (priorityWork_ == 0 && pendingCloseWorker_ != NULL)
+        void Remove(std::string_view key)
         {
-            pendingCloseWorker_->Queue(env);
-            pendingCloseWorker_ = NULL;
+            auto it = index_.find(key);
+            if (it == index_.end())
+                return;
+
+            usage_ -= Charge(it->second->first.size(), it->second->second.size());
+            Rows::iterator row = it->second;
+            index_.erase(it);
+            lru_.erase(row);
         }
-    }
 
-    bool HasPriorityWork() const
+        std::mutex mutex_;
+        Rows lru_;
+        std::unordered_map<std::string_view, Rows::iterator> index_;
+        size_t capacity_;
+        size_t usage_;
+        uint64_t generation_;
+    };
+
+    static constexpr size_t kShards = 16;
+
+    static size_t Charge(const size_t keySize, const size_t valueSize)
     {
-        return priorityWork_ > 0;
+        return keySize + valueSize + 64;
     }
 
-    leveldb::DB *db_;
-    leveldb::Cache *blockCache_;
-    const leveldb::FilterPolicy *filterPolicy_;
-    uint32_t currentIteratorId_;
-    BaseWorker *pendingCloseWorker_;
-    std::map<uint32_t, Iterator *> iterators_;
-    napi_ref ref_;
+    Shard &ShardFor(leveldb::Slice key)
+    {
+        return shards_[std::hash<std::string_view>()(std::string_view(key.data(), key.size())) % kShards];
+    }
 
-  private:
-    uint32_t priorityWork_;
+    std::vector<Shard> shards_;
 };
 
 /**
- * Base worker class for doing async work that defers closing the database.
+ * Erases the keys of a batch from a RowCache.
  */
-struct PriorityWorker : public BaseWorker
+struct RowCacheInvalidator final : public leveldb::WriteBatch::Handler
 {
-    PriorityWorker(napi_env env, Database *database, napi_value callback, const char *resourceName)
-        : BaseWorker(env, database, callback, resourceName)
+    RowCacheInvalidator(RowCache *rowCache) : rowCache_(rowCache)
     {
-        database_->IncrementPriorityWork(env);
     }
 
-    virtual ~PriorityWorker()
+    void Put(const leveldb::Slice &key, const leveldb::Slice &value) override
     {
+        rowCache_->Erase(key);
     }
 
-    void DoFinally(napi_env env) override
+    void Delete(const leveldb::Slice &key) override
     {
-        database_->DecrementPriorityWork(env);
-        BaseWorker::DoFinally(env);
+        rowCache_->Erase(key);
     }
+
+  private:
+    RowCache *rowCache_;
 };
 
 /**
- * Owns a leveldb iterator.
+ * The database handed out by db_expose(). Forwards to LevelDB and, with a row
+ * cache, erases the keys it writes from the row cache, so the state commits,
+ * prunes and imports of the EVM binding don't leave stale rows behind.
+ * The open Database holds a reference, as do the JS handle and native code
+ * using it.
  */
-struct BaseIterator
+struct DatabaseExposure final : public leveldown::ExposedDB
 {
-    BaseIterator(Database *database, const bool reverse, std::string *lt, std::string *lte, std::string *gt,
-                 std::string *gte, const int limit, const bool fillCache)
-        : database_(database), hasEnded_(false), didSeek_(false), reverse_(reverse), lt_(lt), lte_(lte), gt_(gt),
-          gte_(gte), limit_(limit), count_(0)
+    DatabaseExposure(napi_env env, Database *database, leveldb::DB *db, RowCache *rowCache)
+        : env_(env), database_(database), db_(db), rowCache_(rowCache), closing_(false), refs_(1), closed_(false),
+          users_(0)
     {
-        options_ = new leveldb::ReadOptions();
-        options_->fill_cache = fillCache;
-        options_->snapshot = database->NewSnapshot();
-        dbIterator_ = database_->NewIterator(options_);
     }
 
-    virtual ~BaseIterator()
+    leveldb::Status Put(const leveldb::WriteOptions &options, const leveldb::Slice &key,
+                        const leveldb::Slice &value) override
     {
-        assert(hasEnded_);
-
-        if (lt_ != NULL)
-            delete lt_;
-        if (gt_ != NULL)
-            delete gt_;
-        if (lte_ != NULL)
-            delete lte_;
-        if (gte_ != NULL)
-            delete gte_;
-
-        delete options_;
+        if (!Enter())
+            return ClosedStatus();
+        leveldb::Status status = db_->Put(options, key, value);
+        if (rowCache_ != NULL)
+            rowCache_->Erase(key);
+        Leave();
+        return status;
     }
 
-    bool DidSeek() const
+    leveldb::Status Delete(const leveldb::WriteOptions &options, const leveldb::Slice &key) override
     {
-        return didSeek_;
+        if (!Enter())
+            return ClosedStatus();
+        leveldb::Status status = db_->Delete(options, key);
+        if (rowCache_ != NULL)
+            rowCache_->Erase(key);
+        Leave();
+        return status;
     }
 
-    /**
-     * Seek to the first relevant key based on range options.
-     */
-    void SeekToRange()
+    leveldb::Status Write(const leveldb::WriteOptions &options, leveldb::WriteBatch *batch) override
     {
-        didSeek_ = true;
-
-        if (!reverse_ && gte_ != NULL)
+        if (!Enter())
+            return ClosedStatus();
+        leveldb::Status status = db_->Write(options, batch);
+        if (rowCache_ != NULL)
         {
-            dbIterator_->Seek(*gte_);
+            RowCacheInvalidator invalidator(rowCache_);
+            batch->Iterate(&invalidator);
         }
-        else if (!reverse_ && gt_ != NULL)
-        {
-            dbIterator_->Seek(*gt_);
+        Leave();
+        return status;
+    }
 
-            if (dbIterator_->Valid() && dbIterator_->key().compare(*gt_) == 0)
-            {
-                dbIterator_->Next();
-            }
-        }
-        else if (reverse_ && lte_ != NULL)
-        {
-            dbIterator_->Seek(*lte_);
+    leveldb::Status Get(const leveldb::ReadOptions &options, const leveldb::Slice &key, std::string *value) override
+    {
+        if (!Enter())
+            return ClosedStatus();
+        leveldb::Status status = db_->Get(options, key, value);
+        Leave();
+        return status;
+    }
 
-            if (!dbIterator_->Valid())
-            {
-                dbIterator_->SeekToLast();
-            }
-            else if (dbIterator_->key().compare(*lte_) > 0)
-            {
-                dbIterator_->Prev();
-            }
-        }
-        else if (reverse_ && lt_ != NULL)
-        {
-            dbIterator_->Seek(*lt_);
+    leveldb::Iterator *NewIterator(const leveldb::ReadOptions &options) override
+    {
+        if (!Enter())
+            return leveldb::NewErrorIterator(ClosedStatus());
+        return new ExposedIterator(this, db_->NewIterator(options));
+    }
 
-            if (!dbIterator_->Valid())
-            {
-                dbIterator_->SeekToLast();
-            }
-            else if (dbIterator_->key().compare(*lt_) >= 0)
-            {
-                dbIterator_->Prev();
-            }
-        }
-        else if (reverse_)
-        {
-            dbIterator_->SeekToLast();
-        }
-        else
-        {
-            dbIterator_->SeekToFirst();
-        }
+    const leveldb::Snapshot *GetSnapshot() override
+    {
+        if (!Enter())
+            return NULL;
+        const leveldb::Snapshot *snapshot = db_->GetSnapshot();
+        Leave();
+        return snapshot;
     }
 
-    /**
-     * Seek manually (during iteration).
-     */
-    void Seek(leveldb::Slice &target)
+    void ReleaseSnapshot(const leveldb::Snapshot *snapshot) override
     {
-        didSeek_ = true;
+        if (snapshot == NULL || !Enter())
+            return;
+        db_->ReleaseSnapshot(snapshot);
+        Leave();
+    }
 
-        if (OutOfRange(target))
+    bool GetProperty(const leveldb::Slice &property, std::string *value) override
+    {
+        if (!Enter())
+            return false;
+        bool found = db_->GetProperty(property, value);
+        Leave();
+        return found;
+    }
+
+    void GetApproximateSizes(const leveldb::Range *range, int n, uint64_t *sizes) override
+    {
+        if (!Enter())
         {
-            return SeekToEnd();
+            std::fill(sizes, sizes + n, 0);
+            return;
         }
+        db_->GetApproximateSizes(range, n, sizes);
+        Leave();
+    }
+
+    void CompactRange(const leveldb::Slice *begin, const leveldb::Slice *end) override
+    {
+        if (!Enter())
+            return;
+        db_->CompactRange(begin, end);
+        Leave();
+    }
+
+    void Ref() override
+    {
+        refs_++;
+    }
+
+    void Unref() override
+    {
+        if (--refs_ == 0)
+            delete this;
+    }
+
+    bool DeferClose() override;
+    void AllowClose() override;
+
+    void AddCloseHook(CloseHook hook, void *arg) override
+    {
+        if (!closing_)
+            closeHooks_.emplace_back(hook, arg);
+    }
+
+    void RemoveCloseHook(CloseHook hook, void *arg) override
+    {
+        closeHooks_.erase(std::remove(closeHooks_.begin(), closeHooks_.end(), std::make_pair(hook, arg)),
+                          closeHooks_.end());
+    }
+
+    /**
+     * Runs the close hooks and stops deferring close, the database is closing.
+     */
+    void Close()
+    {
+        if (closing_)
+            return;
+        std::vector<std::pair<CloseHook, void *>> hooks;
+        hooks.swap(closeHooks_);
+        for (auto &hook : hooks)
+            hook.first(hook.second);
+        closing_ = true;
+    }
+
+    /**
+     * Fails every later call and waits for calls and iterators in flight, so the
+     * LevelDB can be deleted. May run off the main thread.
+     */
+    void Shutdown()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        closed_ = true;
+        drained_.wait(lock, [this] { return users_ == 0; });
+    }
+
+    napi_env env_;
+    // NULL once the Database is gone
+    Database *database_;
+
+  private:
+    /**
+     * Forwards to a LevelDB iterator, holding the database open until deleted.
+     */
+    struct ExposedIterator final : public leveldb::Iterator
+    {
+        ExposedIterator(DatabaseExposure *exposure, leveldb::Iterator *it) : exposure_(exposure), it_(it)
+        {
+        }
+
+        ~ExposedIterator() override
+        {
+            delete it_;
+            exposure_->Leave();
+        }
+
+        bool Valid() const override
+        {
+            return it_->Valid();
+        }
+
+        void SeekToFirst() override
+        {
+            it_->SeekToFirst();
+        }
+
+        void SeekToLast() override
+        {
+            it_->SeekToLast();
+        }
+
+        void Seek(const leveldb::Slice &target) override
+        {
+            it_->Seek(target);
+        }
+
+        void Next() override
+        {
+            it_->Next();
+        }
+
+        void Prev() override
+        {
+            it_->Prev();
+        }
+
+        leveldb::Slice key() const override
+        {
+            return it_->key();
+        }
+
+        leveldb::Slice value() const override
+        {
+            return it_->value();
+        }
+
+        leveldb::Status status() const override
+        {
+            return it_->status();
+        }
+
+        DatabaseExposure *exposure_;
+        leveldb::Iterator *it_;
+    };
+
+    static leveldb::Status ClosedStatus()
+    {
+        return leveldb::Status::InvalidArgument("Database is not open");
+    }
+
+    bool Enter()
+    {
+        users_++;
+        if (!closed_)
+            return true;
+        Leave();
+        return false;
+    }
+
+    void Leave()
+    {
+        if (--users_ == 0 && closed_)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            drained_.notify_all();
+        }
+    }
+
+    leveldb::DB *db_;
+    RowCache *rowCache_;
+    bool closing_;
+    std::vector<std::pair<CloseHook, void *>> closeHooks_;
+    std::atomic<uint32_t> refs_;
+    std::atomic<bool> closed_;
+    // Calls and iterators in flight
+    std::atomic<uint32_t> users_;
+    std::mutex mutex_;
+    std::condition_variable drained_;
+};
+
+/**
+ * A block cache and filter policy shared by many databases, so cache memory
+ * goes to whichever database is busy. Every open database holds a reference,
+ * as does the JS handle.
+ */
+struct SharedCache
+{
+    SharedCache(const size_t capacity)
+        : cache_(leveldb::NewLRUCache(capacity)), filterPolicy_(leveldb::NewBloomFilterPolicy(10)),
+          capacity_(capacity), refs_(1)
+    {
+    }
+
+    ~SharedCache()
+    {
+        delete cache_;
+        delete filterPolicy_;
+    }
+
+    void Ref()
+    {
+        refs_++;
+    }
+
+    void Unref()
+    {
+        if (--refs_ == 0)
+            delete this;
+    }
+
+    leveldb::Cache *cache_;
+    const leveldb::FilterPolicy *filterPolicy_;
+    const size_t capacity_;
+
+  private:
+    std::atomic<uint32_t> refs_;
+};
+
+/**
+ * Forwards to the block cache of a database, private or shared, and counts
+ * the block lookups of that database.
+ */
+struct CountingCache final : public leveldb::Cache
+{
+    CountingCache(leveldb::Cache *target) : target_(target), hits_(0), misses_(0)
+    {
+    }
+
+    Handle *Insert(const leveldb::Slice &key, void *value, size_t charge,
+                   void (*deleter)(const leveldb::Slice &key, void *value)) override
+    {
+        return target_->Insert(key, value, charge, deleter);
+    }
+
+    Handle *Lookup(const leveldb::Slice &key) override
+    {
+        Handle *handle = target_->Lookup(key);
+        if (handle != NULL)
+            hits_++;
+        else
+            misses_++;
+        return handle;
+    }
+
+    void Release(Handle *handle) override
+    {
+        target_->Release(handle);
+    }
+
+    void *Value(Handle *handle) override
+    {
+        return target_->Value(handle);
+    }
+
+    void Erase(const leveldb::Slice &key) override
+    {
+        target_->Erase(key);
+    }
+
+    uint64_t NewId() override
+    {
+        return target_->NewId();
+    }
+
+    void Prune() override
+    {
+        target_->Prune();
+    }
+
+    size_t TotalCharge() const override
+    {
+        return target_->TotalCharge();
+    }
+
+    leveldb::Cache *target_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+};
+
+/**
+ * Operations with a latency histogram.
+ */
+enum MetricOp
+{
+    opGet = 0,
+    opGetMany = 1,
+    opPut = 2,
+    opDel = 3,
+    opBatch = 4,
+    opIteratorNext = 5
+};
+
+static const size_t metricOps = 6;
+
+/**
+ * Latency histogram in microseconds, in the spirit of HDR histograms: every
+ * power of two is split into 8 linear sub-buckets, so a recorded value is
+ * known within 12.5%. Recording takes a few relaxed atomic increments.
+ */
+struct LatencyHistogram
+{
+    LatencyHistogram() : count_(0), sum_(0), max_(0)
+    {
+        for (std::atomic<uint64_t> &bucket : buckets_)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+
+    void Record(const uint64_t micros)
+    {
+        buckets_[Index(micros)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(micros, std::memory_order_relaxed);
+
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (micros > max && !max_.compare_exchange_weak(max, micros, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /**
+     * Returns the upper bound of the bucket holding quantile 'q'.
+     */
+    uint64_t Quantile(const double q) const
+    {
+        const uint64_t count = count_.load(std::memory_order_relaxed);
+        if (count == 0)
+            return 0;
+
+        const uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * count + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; i++)
+        {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return std::min(UpperBound(i), max_.load(std::memory_order_relaxed));
+        }
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+
+  private:
+    static constexpr size_t kSubBits = 3;
+    static constexpr size_t kSub = 1 << kSubBits;
+    static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSub;
+
+    static size_t Index(const uint64_t value)
+    {
+        if (value < kSub)
+            return value;
+
+        size_t exponent = kSubBits;
+        while (exponent < 63 && (value >> (exponent + 1)) != 0)
+            exponent++;
+
+        const size_t mantissa = (value >> (exponent - kSubBits)) & (kSub - 1);
+        return (exponent - kSubBits + 1) * kSub + mantissa;
+    }
+
+    static uint64_t UpperBound(const size_t index)
+    {
+        if (index < kSub)
+            return index;
+
+        const size_t exponent = index / kSub + kSubBits - 1;
+        const uint64_t lower = (uint64_t)(kSub + index % kSub) << (exponent - kSubBits);
+        return lower + ((uint64_t)1 << (exponent - kSubBits)) - 1;
+    }
+
+    std::atomic<uint64_t> buckets_[kBuckets];
+};
+
+/**
+ * Counters of a database, cumulative over its lifetime so they can be
+ * scraped as monotonic counters.
+ */
+struct DatabaseMetrics
+{
+    typedef std::chrono::steady_clock Clock;
+
+    DatabaseMetrics() : bytesRead_(0), bytesWritten_(0), slowWrites_(0)
+    {
+    }
+
+    static uint64_t Since(const Clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    }
+
+    void Read(const MetricOp op, const Clock::time_point start, const size_t bytes)
+    {
+        ops_[op].Record(Since(start));
+        bytesRead_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void Write(const MetricOp op, const Clock::time_point start, const size_t bytes, const bool sync)
+    {
+        const uint64_t micros = Since(start);
+        ops_[op].Record(micros);
+        bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+
+        // LevelDB doesn't report its stalls, not even in 'leveldb.stats'. This
+        // only counts unsynced writes that took 1ms or more, which includes
+        // the writes LevelDB slowed down or stopped for level 0 but isn't a
+        // stall count.
+        if (!sync && micros >= 1000)
+            slowWrites_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram ops_[metricOps];
+    std::atomic<uint64_t> bytesRead_;
+    std::atomic<uint64_t> bytesWritten_;
+    std::atomic<uint64_t> slowWrites_;
+};
+
+/**
+ * Owns the LevelDB storage, cache, filter policy and iterators.
+ */
+struct Database
+{
+    Database()
+        : db_(NULL), blockCache_(NULL), sharedCache_(NULL), countingCache_(NULL), cacheCapacity_(0),
+          filterPolicy_(leveldb::NewBloomFilterPolicy(10)), currentIteratorId_(0),
+          currentSnapshotId_(0), pendingCloseWorker_(NULL), ref_(NULL), zeroCopy_(true), writeQueue_(NULL),
+          rowCache_(NULL), exposed_(NULL), completions_(NULL), pendingPoolWork_(0), inflightPoolWork_(0), priorityWork_(0)
+    {
+    }
+
+    ~Database()
+    {
+        if (writeQueue_ != NULL)
+        {
+            delete writeQueue_;
+            writeQueue_ = NULL;
+        }
+
+        if (exposed_ != NULL)
+        {
+            exposed_->Shutdown();
+            exposed_->database_ = NULL;
+            exposed_->Unref();
+            exposed_ = NULL;
+        }
+
+        if (rowCache_ != NULL)
+        {
+            delete rowCache_;
+            rowCache_ = NULL;
+        }
+
+        if (db_ != NULL)
+        {
+            delete db_;
+            db_ = NULL;
+        }
+    }
+
+    leveldb::Status Open(const leveldb::Options &options, const char *location)
+    {
+        return leveldb::DB::Open(options, location, &db_);
+    }
+
+    void CloseDatabase()
+    {
+        if (exposed_ != NULL)
+        {
+            exposed_->Shutdown();
+            exposed_->Unref();
+            exposed_ = NULL;
+        }
+        delete db_;
+        db_ = NULL;
+        if (rowCache_ != NULL)
+            rowCache_->Clear();
+        if (blockCache_)
+        {
+            delete blockCache_;
+            blockCache_ = NULL;
+        }
+        if (sharedCache_ != NULL)
+        {
+            sharedCache_->Unref();
+            sharedCache_ = NULL;
+        }
+        if (countingCache_ != NULL)
+        {
+            delete countingCache_;
+            countingCache_ = NULL;
+        }
+    }
+
+    /**
+     * Uses the block cache and filter policy of 'sharedCache' instead of its
+     * own ones. Or creates a block cache of 'cacheSize' bytes.
+     */
+    void UseCache(SharedCache *sharedCache, const size_t cacheSize)
+    {
+        if (sharedCache != NULL)
+        {
+            sharedCache->Ref();
+            sharedCache_ = sharedCache;
+            countingCache_ = new CountingCache(sharedCache->cache_);
+        }
+        else
+        {
+            blockCache_ = leveldb::NewLRUCache(cacheSize);
+            countingCache_ = new CountingCache(blockCache_);
+        }
+        cacheCapacity_ = sharedCache != NULL ? sharedCache->capacity_ : cacheSize;
+    }
+
+    const leveldb::FilterPolicy *FilterPolicy()
+    {
+        return sharedCache_ != NULL ? sharedCache_->filterPolicy_ : filterPolicy_;
+    }
+
+    leveldb::Status Put(const leveldb::WriteOptions &options, leveldb::Slice key, leveldb::Slice value)
+    {
+        const DatabaseMetrics::Clock::time_point start = DatabaseMetrics::Clock::now();
+        leveldb::Status status = db_->Put(options, key, value);
+        metrics_.Write(opPut, start, key.size() + value.size(), options.sync);
+        if (rowCache_ != NULL)
+            rowCache_->Erase(key);
+        return status;
+    }
+
+    leveldb::Status Get(const leveldb::ReadOptions &options, leveldb::Slice key, std::string &value)
+    {
+        const DatabaseMetrics::Clock::time_point start = DatabaseMetrics::Clock::now();
+        leveldb::Status status = db_->Get(options, key, &value);
+        metrics_.Read(opGet, start, status.ok() ? value.size() : 0);
+        return status;
+    }
+
+    leveldb::Status Del(const leveldb::WriteOptions &options, leveldb::Slice key)
+    {
+        const DatabaseMetrics::Clock::time_point start = DatabaseMetrics::Clock::now();
+        leveldb::Status status = db_->Delete(options, key);
+        metrics_.Write(opDel, start, key.size(), options.sync);
+        if (rowCache_ != NULL)
+            rowCache_->Erase(key);
+        return status;
+    }
+
+    leveldb::Status WriteBatch(const leveldb::WriteOptions &options, leveldb::WriteBatch *batch)
+    {
+        const DatabaseMetrics::Clock::time_point start = DatabaseMetrics::Clock::now();
+        leveldb::Status status = db_->Write(options, batch);
+        metrics_.Write(opBatch, start, batch->ApproximateSize(), options.sync);
+        if (rowCache_ != NULL)
+        {
+            RowCacheInvalidator invalidator(rowCache_);
+            batch->Iterate(&invalidator);
+        }
+        return status;
+    }
+
+    uint64_t ApproximateSize(const leveldb::Range *range)
+    {
+        uint64_t size = 0;
+        db_->GetApproximateSizes(range, 1, &size);
+        return size;
+    }
+
+    void CompactRange(const leveldb::Slice *start, const leveldb::Slice *end)
+    {
+        db_->CompactRange(start, end);
+    }
+
+    void GetProperty(const leveldb::Slice &property, std::string *value)
+    {
+        db_->GetProperty(property, value);
+    }
+
+    const leveldb::Snapshot *NewSnapshot()
+    {
+        return db_->GetSnapshot();
+    }
+
+    leveldb::Iterator *NewIterator(leveldb::ReadOptions *options)
+    {
+        return db_->NewIterator(*options);
+    }
+
+    void ReleaseSnapshot(const leveldb::Snapshot *snapshot)
+    {
+        return db_->ReleaseSnapshot(snapshot);
+    }
+
+    void AttachIterator(napi_env env, uint32_t id, Iterator *iterator)
+    {
+        iterators_[id] = iterator;
+        IncrementPriorityWork(env);
+    }
+
+    void DetachIterator(napi_env env, uint32_t id)
+    {
+        iterators_.erase(id);
+        DecrementPriorityWork(env);
+    }
+
+    void AttachSnapshot(napi_env env, uint32_t id, Snapshot *snapshot)
+    {
+        snapshots_[id] = snapshot;
+        IncrementPriorityWork(env);
+    }
+
+    void DetachSnapshot(napi_env env, uint32_t id)
+    {
+        snapshots_.erase(id);
+        DecrementPriorityWork(env);
+    }
+
+    void IncrementPriorityWork(napi_env env)
+    {
+        napi_reference_ref(env, ref_, &priorityWork_);
+    }
+
+    void DecrementPriorityWork(napi_env env)
+    {
+        napi_reference_unref(env, ref_, &priorityWork_);
+
+        if (priorityWork_ == 0 && pendingCloseWorker_ != NULL)
+        {
+            pendingCloseWorker_->Queue(env);
+            pendingCloseWorker_ = NULL;
+        }
+    }
+
+    bool HasPriorityWork() const
+    {
+        return priorityWork_ > 0;
+    }
+
+    leveldb::DB *db_;
+    leveldb::Cache *blockCache_;
+    SharedCache *sharedCache_;
+    CountingCache *countingCache_;
+    size_t cacheCapacity_;
+    const leveldb::FilterPolicy *filterPolicy_;
+    uint32_t currentIteratorId_;
+    uint32_t currentSnapshotId_;
+    BaseWorker *pendingCloseWorker_;
+    std::map<uint32_t, Iterator *> iterators_;
+    std::map<uint32_t, Snapshot *> snapshots_;
+    napi_ref ref_;
+    bool zeroCopy_;
+    WriteQueue *writeQueue_;
+    RowCache *rowCache_;
+    DatabaseExposure *exposed_;
+    DatabaseMetrics metrics_;
+    napi_threadsafe_function completions_;
+    uint32_t pendingPoolWork_;
+    uint32_t inflightPoolWork_;
+
+  private:
+    uint32_t priorityWork_;
+};
+
+bool DatabaseExposure::DeferClose()
+{
+    if (closing_ || database_ == NULL)
+        return false;
+
+    database_->IncrementPriorityWork(env_);
+    return true;
+}
+
+void DatabaseExposure::AllowClose()
+{
+    // The deferred close keeps the Database alive
+    database_->DecrementPriorityWork(env_);
+}
+
+/**
+ * Base worker class for doing async work that defers closing the database.
+ */
+struct PriorityWorker : public BaseWorker
+{
+    PriorityWorker(napi_env env, Database *database, napi_value callback, const char *resourceName,
+                   const WorkClass workClass)
+        : BaseWorker(env, database, callback, resourceName, workClass)
+    {
+        database_->IncrementPriorityWork(env);
+    }
+
+    virtual ~PriorityWorker()
+    {
+    }
+
+    void DoFinally(napi_env env) override
+    {
+        database_->DecrementPriorityWork(env);
+        BaseWorker::DoFinally(env);
+    }
+};
+
+/**
+ * Counters of one priority class of the addon thread pool. Times are in
+ * microseconds.
+ */
+struct WorkStats
+{
+    WorkStats() : queued_(0), running_(0), completed_(0), aged_(0), waitTime_(0), maxWaitTime_(0), runTime_(0)
+    {
+    }
+
+    uint32_t queued_;
+    uint32_t running_;
+    uint64_t completed_;
+    // Workers that ran ahead of higher classes because they waited too long
+    uint64_t aged_;
+    uint64_t waitTime_;
+    uint64_t maxWaitTime_;
+    uint64_t runTime_;
+};
+
+/**
+ * Runs database work on threads owned by the addon rather than on the libuv
+ * thread pool, which is shared with fs, dns and crypto. Reads go before writes
+ * and writes before background work, which never takes more than
+ * 'maxBackground_' threads so scans and compactions leave room for the rest.
+ * A worker that has waited 'maxWait_' or longer ages past the priorities and
+ * runs first, the longest waiting one first, so a steady stream of reads can't
+ * starve writes and background work. Completions go back to the main thread
+ * through the threadsafe function of the database.
+ */
+struct ThreadPool
+{
+    ThreadPool(const uint32_t size, const uint32_t maxBackground, const uint32_t maxWaitMs)
+        : size_(size), maxBackground_(maxBackground), maxWait_(std::chrono::milliseconds(maxWaitMs)),
+          stats_(workClasses)
+    {
+        // Threads live as long as the process, like the libuv ones.
+        for (uint32_t i = 0; i < size; i++)
+            std::thread(&ThreadPool::Run, this).detach();
+    }
+
+    /**
+     * Queues a worker, main thread only.
+     */
+    void Schedule(BaseWorker *worker)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        worker->database_->inflightPoolWork_++;
+        queues_[worker->workClass_].push_back(Task(worker));
+        stats_[worker->workClass_].queued_++;
+        ready_.notify_one();
+    }
+
+    /**
+     * Waits until every worker of a database queued so far has run and sent
+     * its completion.
+     */
+    void Drain(Database *database)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [database] { return database->inflightPoolWork_ == 0; });
+    }
+
+    std::vector<WorkStats> Stats()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    const uint32_t size_;
+    const uint32_t maxBackground_;
+    const std::chrono::steady_clock::duration maxWait_;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Task
+    {
+        Task(BaseWorker *worker = NULL) : worker_(worker), queuedAt_(Clock::now())
+        {
+        }
+
+        BaseWorker *worker_;
+        Clock::time_point queuedAt_;
+    };
+
+    static uint64_t Micros(Clock::duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    }
+
+    bool Runnable(const size_t workClass) const
+    {
+        return !queues_[workClass].empty() &&
+               (workClass != workBackground || stats_[workClass].running_ < maxBackground_);
+    }
+
+    bool Pick(Task *task)
+    {
+        // Queues are in order, the front of a queue is its longest waiting worker
+        const Clock::time_point agedBefore = Clock::now() - maxWait_;
+        size_t pick = workClasses;
+        for (size_t i = 0; i < workClasses; i++)
+        {
+            if (Runnable(i) && queues_[i].front().queuedAt_ <= agedBefore &&
+                (pick == workClasses || queues_[i].front().queuedAt_ < queues_[pick].front().queuedAt_))
+                pick = i;
+        }
+
+        if (pick != workClasses)
+        {
+            // Only count it if it overtook work of a higher class
+            for (size_t i = 0; i < pick; i++)
+            {
+                if (Runnable(i))
+                {
+                    stats_[pick].aged_++;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < workClasses && pick == workClasses; i++)
+            {
+                if (Runnable(i))
+                    pick = i;
+            }
+            if (pick == workClasses)
+                return false;
+        }
+
+        *task = queues_[pick].front();
+        queues_[pick].pop_front();
+        return true;
+    }
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            Task task;
+            ready_.wait(lock, [this, &task] { return Pick(&task); });
+
+            BaseWorker *worker = task.worker_;
+            Database *database = worker->database_;
+            WorkStats &stats = stats_[worker->workClass_];
+            const Clock::time_point start = Clock::now();
+            const uint64_t waitTime = Micros(start - task.queuedAt_);
+            stats.queued_--;
+            stats.running_++;
+            stats.waitTime_ += waitTime;
+            stats.maxWaitTime_ = std::max(stats.maxWaitTime_, waitTime);
+            lock.unlock();
+
+            worker->DoExecute();
+            const uint64_t runTime = Micros(Clock::now() - start);
+
+            // The worker belongs to the main thread from here on.
+            napi_call_threadsafe_function(database->completions_, worker, napi_tsfn_nonblocking);
+
+            lock.lock();
+            stats.running_--;
+            stats.completed_++;
+            stats.runTime_ += runTime;
+            if (--database->inflightPoolWork_ == 0)
+                idle_.notify_all();
+
+            // A thread may be waiting for a background slot.
+            ready_.notify_one();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable idle_;
+    std::list<Task> queues_[workClasses];
+    std::vector<WorkStats> stats_;
+};
+
+/**
+ * Calls back a worker that ran on the addon thread pool, on the main thread.
+ */
+static void CompleteWork(napi_env env, napi_value js_cb, void *context, void *data)
+{
+    // The threadsafe function is being torn down with the environment, there's
+    // nothing to call back anymore.
+    if (env == NULL)
+        return;
+
+    Database *database = (Database *)context;
+    BaseWorker::Complete(env, napi_ok, data);
+
+    // Let the event loop exit once there's no pool work left.
+    if (--database->pendingPoolWork_ == 0)
+        napi_unref_threadsafe_function(env, database->completions_);
+}
+
+/**
+ * Hook for when the environment exits. Added after the threadsafe function of
+ * the database, so it runs before the threadsafe function is torn down (which
+ * node takes care of) and before env_cleanup_hook() closes the database.
+ */
+static void pool_cleanup_hook(void *arg)
+{
+    Database *database = (Database *)arg;
+    threadPool.load()->Drain(database);
+    database->completions_ = NULL;
+}
+
+/**
+ * Queues a worker on the addon thread pool.
+ */
+static void ScheduleWork(napi_env env, BaseWorker *worker)
+{
+    Database *database = worker->database_;
+
+    if (database->completions_ == NULL)
+    {
+        napi_value asyncResourceName;
+        napi_create_string_utf8(env, "leveldown.pool", NAPI_AUTO_LENGTH, &asyncResourceName);
+        napi_create_threadsafe_function(env, NULL, NULL, asyncResourceName, 0, 1, NULL, NULL, database, CompleteWork,
+                                        &database->completions_);
+        napi_unref_threadsafe_function(env, database->completions_);
+        napi_add_env_cleanup_hook(env, pool_cleanup_hook, database);
+    }
+
+    if (database->pendingPoolWork_++ == 0)
+        napi_ref_threadsafe_function(env, database->completions_);
+
+    threadPool.load()->Schedule(worker);
+}
+
+/**
+ * A snapshot handed to native code by snapshot_expose(). Until it's unexposed,
+ * explicitly or when its JS handle is garbage collected, it holds a reference
+ * on the snapshot. Every pin holds one as well, so a call reading the snapshot
+ * keeps it until the call is done, even if the snapshot is unexposed meanwhile.
+ */
+struct SnapshotExposure final : public leveldown::ExposedSnapshot
+{
+    SnapshotExposure(napi_env env, Snapshot *snapshot) : env_(env), snapshot_(snapshot), exposed_(true), pins_(0)
+    {
+    }
+
+    const leveldb::Snapshot *Pin() override;
+    void Unpin() override;
+
+    napi_env env_;
+    // NULL once it's neither exposed nor pinned
+    Snapshot *snapshot_;
+    bool exposed_;
+    uint32_t pins_;
+};
+
+/**
+ * Owns a leveldb snapshot that many reads from JS land share. Reads, pins and
+ * exposures of the snapshot take a reference on its JS handle, so it can't be
+ * garbage collected under them. The leveldb snapshot is released once the
+ * snapshot is released (explicitly, on db close or by GC), no read or pin uses
+ * it and it's not exposed anymore. Closing the database releases it regardless
+ * of exposures, they can't be pinned anymore once it's closing.
+ * All of this happens on the main thread.
+ */
+struct Snapshot
+{
+    Snapshot(Database *database, const uint32_t id)
+        : database_(database), id_(id), snapshot_(database->NewSnapshot()), users_(0), released_(false),
+          closing_(false), exposed_(0), ref_(NULL)
+    {
+    }
+
+    void Attach(napi_env env, napi_value context)
+    {
+        // A weak reference, it only keeps the handle alive while reads use it
+        napi_create_reference(env, context, 0, &ref_);
+        database_->AttachSnapshot(env, id_, this);
+    }
+
+    void Release(napi_env env)
+    {
+        if (!released_)
+        {
+            released_ = true;
+            database_->DetachSnapshot(env, id_);
+            MaybeReleaseSnapshot();
+        }
+    }
+
+    /**
+     * Releases the snapshot as its database closes, exposures stop keeping the
+     * leveldb snapshot.
+     */
+    void ReleaseForClose(napi_env env)
+    {
+        closing_ = true;
+        Release(env);
+    }
+
+    /**
+     * Releases the leveldb snapshot right away, for when the environment exits
+     * and no reads are in-flight.
+     */
+    void ReleaseNow()
+    {
+        released_ = true;
+        closing_ = true;
+        users_ = 0;
+        MaybeReleaseSnapshot();
+    }
+
+    SnapshotExposure *Expose(napi_env env)
+    {
+        uint32_t refs;
+        napi_reference_ref(env, ref_, &refs);
+        SnapshotExposure *exposure = new SnapshotExposure(env, this);
+        exposures_.insert(exposure);
+        exposed_++;
+        return exposure;
+    }
+
+    void Unexpose(napi_env env, SnapshotExposure *exposure)
+    {
+        if (!exposure->exposed_)
+            return;
+
+        uint32_t refs;
+        exposure->exposed_ = false;
+        exposed_--;
+        if (exposure->pins_ == 0)
+            Detach(exposure);
+        napi_reference_unref(env, ref_, &refs);
+        MaybeReleaseSnapshot();
+    }
+
+    void UnexposeAll(napi_env env)
+    {
+        std::set<SnapshotExposure *> exposures = exposures_;
+        std::set<SnapshotExposure *>::iterator it;
+
+        for (it = exposures.begin(); it != exposures.end(); ++it)
+        {
+            Unexpose(env, *it);
+        }
+    }
+
+    /**
+     * Forgets an exposure that is neither exposed nor pinned anymore, or is
+     * garbage collected.
+     */
+    void Detach(SnapshotExposure *exposure)
+    {
+        exposure->snapshot_ = NULL;
+        exposures_.erase(exposure);
+    }
+
+    /**
+     * Returns the leveldb snapshot for native code and holds it until Unref(),
+     * or NULL if the snapshot is closing.
+     */
+    const leveldb::Snapshot *Pin(napi_env env)
+    {
+        if (closing_ || snapshot_ == NULL)
+            return NULL;
+
+        Ref(env);
+        return snapshot_;
+    }
+
+    void Ref(napi_env env)
+    {
+        uint32_t refs;
+        napi_reference_ref(env, ref_, &refs);
+        users_++;
+    }
+
+    void Unref(napi_env env)
+    {
+        uint32_t refs;
+        napi_reference_unref(env, ref_, &refs);
+        users_--;
+        MaybeReleaseSnapshot();
+    }
+
+    bool IsReleased() const
+    {
+        return released_;
+    }
+
+    void Finalize(napi_env env)
+    {
+        Release(env);
+
+        // Only the environment teardown finalizes an exposed or pinned
+        // snapshot, its exposures may be finalized after it
+        std::set<SnapshotExposure *>::iterator it;
+        for (it = exposures_.begin(); it != exposures_.end(); ++it)
+        {
+            (*it)->snapshot_ = NULL;
+        }
+        exposures_.clear();
+
+        if (ref_ != NULL)
+            napi_delete_reference(env, ref_);
+    }
+
+    Database *database_;
+    const uint32_t id_;
+    const leveldb::Snapshot *snapshot_;
+
+  private:
+    void MaybeReleaseSnapshot()
+    {
+        if (released_ && users_ == 0 && (exposed_ == 0 || closing_) && snapshot_ != NULL)
+        {
+            database_->ReleaseSnapshot(snapshot_);
+            snapshot_ = NULL;
+        }
+    }
+
+    uint32_t users_;
+    bool released_;
+    bool closing_;
+    // Exposures that are exposed or pinned, 'exposed_' of them are exposed
+    std::set<SnapshotExposure *> exposures_;
+    uint32_t exposed_;
+    napi_ref ref_;
+};
+
+const leveldb::Snapshot *SnapshotExposure::Pin()
+{
+    if (!exposed_ || snapshot_ == NULL)
+        return NULL;
+
+    const leveldb::Snapshot *snapshot = snapshot_->Pin(env_);
+    if (snapshot != NULL)
+        pins_++;
+    return snapshot;
+}
+
+void SnapshotExposure::Unpin()
+{
+    Snapshot *snapshot = snapshot_;
+    pins_--;
+    if (snapshot == NULL)
+        return;
+
+    if (pins_ == 0 && !exposed_)
+        snapshot->Detach(this);
+    snapshot->Unref(env_);
+}
+
+/**
+ * Takes the snapshot passed as the 'snapshot' property of 'opts', either a
+ * snapshot context or an object with one as its 'context' property.
+ * Returns an error message if the snapshot can't be used to read 'database'.
+ */
+static const char *SnapshotOption(napi_env env, napi_value opts, Database *database, Snapshot **snapshot)
+{
+    *snapshot = NULL;
+
+    if (!IsObject(env, opts) || !HasProperty(env, opts, "snapshot"))
+        return NULL;
+
+    napi_value value = GetProperty(env, opts, "snapshot");
+    napi_valuetype type;
+    napi_typeof(env, value, &type);
+
+    if (type == napi_undefined || type == napi_null)
+        return NULL;
+    if (type == napi_object)
+        value = GetProperty(env, value, "context");
+
+    if (napi_get_value_external(env, value, (void **)snapshot) != napi_ok || *snapshot == NULL)
+    {
+        *snapshot = NULL;
+        return "invalid snapshot";
+    }
+    if ((*snapshot)->database_ != database)
+        return "snapshot belongs to another database";
+    if ((*snapshot)->IsReleased())
+        return "snapshot has been released";
+
+    return NULL;
+}
+
+/**
+ * Owns a leveldb iterator.
+ */
+struct BaseIterator
+{
+    BaseIterator(Database *database, const bool reverse, std::string *lt, std::string *lte, std::string *gt,
+                 std::string *gte, const int limit, const bool fillCache, const leveldb::Snapshot *snapshot = NULL)
+        : database_(database), hasEnded_(false), didSeek_(false), reverse_(reverse), lt_(lt), lte_(lte), gt_(gt),
+          gte_(gte), limit_(limit), count_(0), ownsSnapshot_(snapshot == NULL)
+    {
+        options_ = new leveldb::ReadOptions();
+        options_->fill_cache = fillCache;
+        options_->snapshot = ownsSnapshot_ ? database->NewSnapshot() : snapshot;
+        dbIterator_ = database_->NewIterator(options_);
+    }
+
+    virtual ~BaseIterator()
+    {
+        assert(hasEnded_);
+
+        if (lt_ != NULL)
+            delete lt_;
+        if (gt_ != NULL)
+            delete gt_;
+        if (lte_ != NULL)
+            delete lte_;
+        if (gte_ != NULL)
+            delete gte_;
+
+        delete options_;
+    }
+
+    bool DidSeek() const
+    {
+        return didSeek_;
+    }
+
+    /**
+     * Seek to the first relevant key based on range options.
+     */
+    void SeekToRange()
+    {
+        didSeek_ = true;
+
+        if (!reverse_ && gte_ != NULL)
+        {
+            dbIterator_->Seek(*gte_);
+        }
+        else if (!reverse_ && gt_ != NULL)
+        {
+            dbIterator_->Seek(*gt_);
+
+            if (dbIterator_->Valid() && dbIterator_->key().compare(*gt_) == 0)
+            {
+                dbIterator_->Next();
+            }
+        }
+        else if (reverse_ && lte_ != NULL)
+        {
+            dbIterator_->Seek(*lte_);
+
+            if (!dbIterator_->Valid())
+            {
+                dbIterator_->SeekToLast();
+            }
+            else if (dbIterator_->key().compare(*lte_) > 0)
+            {
+                dbIterator_->Prev();
+            }
+        }
+        else if (reverse_ && lt_ != NULL)
+        {
+            dbIterator_->Seek(*lt_);
+
+            if (!dbIterator_->Valid())
+            {
+                dbIterator_->SeekToLast();
+            }
+            else if (dbIterator_->key().compare(*lt_) >= 0)
+            {
+                dbIterator_->Prev();
+            }
+        }
+        else if (reverse_)
+        {
+            dbIterator_->SeekToLast();
+        }
+        else
+        {
+            dbIterator_->SeekToFirst();
+        }
+    }
+
+    /**
+     * Seek manually (during iteration).
+     */
+    void Seek(leveldb::Slice &target)
+    {
+        didSeek_ = true;
+
+        if (OutOfRange(target))
+        {
+            return SeekToEnd();
+        }
+
+        dbIterator_->Seek(target);
 
-        dbIterator_->Seek(target);
-
         if (dbIterator_->Valid())
         {
             int cmp = dbIterator_->key().compare(target);
@@ -786,7 +2275,8 @@ struct BaseIterator
             hasEnded_ = true;
             delete dbIterator_;
             dbIterator_ = NULL;
-            database_->ReleaseSnapshot(options_->snapshot);
+            if (ownsSnapshot_)
+                database_->ReleaseSnapshot(options_->snapshot);
         }
     }
 
@@ -870,6 +2360,7 @@ struct BaseIterator
     std::string *gte_;
     const int limit_;
     int count_;
+    const bool ownsSnapshot_;
     leveldb::ReadOptions *options_;
 };
 
@@ -880,10 +2371,13 @@ struct Iterator final : public BaseIterator
 {
     Iterator(Database *database, const uint32_t id, const bool reverse, const bool keys, const bool values,
              const int limit, std::string *lt, std::string *lte, std::string *gt, std::string *gte,
-             const bool fillCache, const bool keyAsBuffer, const bool valueAsBuffer, const uint32_t highWaterMark)
-        : BaseIterator(database, reverse, lt, lte, gt, gte, limit, fillCache), id_(id), keys_(keys), values_(values),
-          keyAsBuffer_(keyAsBuffer), valueAsBuffer_(valueAsBuffer), highWaterMark_(highWaterMark), landed_(false),
-          nexting_(false), isEnding_(false), endWorker_(NULL), ref_(NULL)
+             const bool fillCache, const bool keyAsBuffer, const bool valueAsBuffer, const uint32_t highWaterMark,
+             const bool background, Snapshot *snapshot)
+        : BaseIterator(database, reverse, lt, lte, gt, gte, limit, fillCache,
+                       snapshot != NULL ? snapshot->snapshot_ : NULL),
+          id_(id), keys_(keys), values_(values), keyAsBuffer_(keyAsBuffer), valueAsBuffer_(valueAsBuffer),
+          highWaterMark_(highWaterMark), background_(background), landed_(false), nexting_(false), isEnding_(false),
+          endWorker_(NULL), snapshot_(snapshot), ref_(NULL)
     {
     }
 
@@ -894,11 +2388,18 @@ struct Iterator final : public BaseIterator
     void Attach(napi_env env, napi_value context)
     {
         napi_create_reference(env, context, 1, &ref_);
+        if (snapshot_ != NULL)
+            snapshot_->Ref(env);
         database_->AttachIterator(env, id_, this);
     }
 
     void Detach(napi_env env)
     {
+        if (snapshot_ != NULL)
+        {
+            snapshot_->Unref(env);
+            snapshot_ = NULL;
+        }
         database_->DetachIterator(env, id_);
         if (ref_ != NULL)
             napi_delete_reference(env, ref_);
@@ -953,26 +2454,82 @@ struct Iterator final : public BaseIterator
         return false;
     }
 
+    /**
+     * Reads entries into packed_ until it holds highWaterMark_ bytes, there's no
+     * limit on the number of entries. Every entry is stored as a uint32 key length,
+     * the key, a uint32 value length and the value, followed by a table of uint32
+     * entry offsets and the uint32 number of entries. Integers are little-endian,
+     * omitted keys or values have a length of 0.
+     */
+    bool ReadPacked()
+    {
+        packed_.clear();
+        packed_.reserve(std::min<uint32_t>(highWaterMark_, 4 << 20) + 64);
+        std::vector<uint32_t> offsets;
+        bool more = false;
+
+        while (true)
+        {
+            if (landed_)
+                Next();
+            if (!Valid() || !Increment())
+                break;
+
+            offsets.push_back(static_cast<uint32_t>(packed_.size()));
+
+            leveldb::Slice key = keys_ ? CurrentKey() : leveldb::Slice();
+            AppendUint32(packed_, static_cast<uint32_t>(key.size()));
+            packed_.append(key.data(), key.size());
+
+            leveldb::Slice value = values_ ? CurrentValue() : leveldb::Slice();
+            AppendUint32(packed_, static_cast<uint32_t>(value.size()));
+            packed_.append(value.data(), value.size());
+
+            if (!landed_)
+            {
+                landed_ = true;
+                more = true;
+                break;
+            }
+
+            if (packed_.size() >= highWaterMark_)
+            {
+                more = true;
+                break;
+            }
+        }
+
+        for (uint32_t offset : offsets)
+            AppendUint32(packed_, offset);
+        AppendUint32(packed_, static_cast<uint32_t>(offsets.size()));
+
+        return more;
+    }
+
     const uint32_t id_;
     const bool keys_;
     const bool values_;
     const bool keyAsBuffer_;
     const bool valueAsBuffer_;
     const uint32_t highWaterMark_;
+    const bool background_;
     bool landed_;
     bool nexting_;
     bool isEnding_;
     BaseWorker *endWorker_;
     std::vector<std::string> cache_;
+    std::string packed_;
 
   private:
+    Snapshot *snapshot_;
     napi_ref ref_;
 };
 
 /**
  * Hook for when the environment exits. This hook will be called after
- * already-scheduled napi_async_work items have finished, which gives us
- * the guarantee that no db operations will be in-flight at this time.
+ * already-scheduled napi_async_work items have finished and after
+ * pool_cleanup_hook() drained the thread pool, which gives us the
+ * guarantee that no db operations will be in-flight at this time.
  */
 static void env_cleanup_hook(void *arg)
 {
@@ -986,6 +2543,9 @@ static void env_cleanup_hook(void *arg)
     // be a safe noop if called before db_open() or after db_close().
     if (database && database->db_ != NULL)
     {
+        if (database->exposed_ != NULL)
+            database->exposed_->Close();
+
         std::map<uint32_t, Iterator *> iterators = database->iterators_;
         std::map<uint32_t, Iterator *>::iterator it;
 
@@ -995,6 +2555,14 @@ static void env_cleanup_hook(void *arg)
             it->second->End();
         }
 
+        std::map<uint32_t, Snapshot *> snapshots = database->snapshots_;
+        std::map<uint32_t, Snapshot *>::iterator st;
+
+        for (st = snapshots.begin(); st != snapshots.end(); ++st)
+        {
+            st->second->ReleaseNow();
+        }
+
         // Having ended the iterators (and released snapshots) we can safely close.
         database->CloseDatabase();
     }
@@ -1009,6 +2577,12 @@ static void FinalizeDatabase(napi_env env, void *data, void *hint)
     {
         Database *database = (Database *)data;
         napi_remove_env_cleanup_hook(env, env_cleanup_hook, database);
+        if (database->completions_ != NULL)
+        {
+            threadPool.load()->Drain(database);
+            napi_remove_env_cleanup_hook(env, pool_cleanup_hook, database);
+            napi_release_threadsafe_function(database->completions_, napi_tsfn_abort);
+        }
         if (database->ref_ != NULL)
             napi_delete_reference(env, database->ref_);
         delete database;
@@ -1033,7 +2607,16 @@ NAPI_METHOD(db_init)
 }
 
 /**
- * Returns a low-level db object.
+ * Runs when an exposed database is garbage collected.
+ */
+static void FinalizeExposedDatabase(napi_env env, void *data, void *hint)
+{
+    static_cast<DatabaseExposure *>((leveldown::ExposedDB *)data)->Unref();
+}
+
+/**
+ * Returns a leveldown::ExposedDB for native code, or NULL if the database
+ * isn't open. With a row cache, its writes erase their keys from the row cache.
  */
 NAPI_METHOD(db_expose)
 {
@@ -1041,11 +2624,54 @@ NAPI_METHOD(db_expose)
     NAPI_DB_CONTEXT();
 
     napi_value result;
-    NAPI_STATUS_THROWS(napi_create_external(env, database->db_, NULL, NULL, &result));
+    if (database->db_ == NULL)
+    {
+        NAPI_STATUS_THROWS(napi_create_external(env, NULL, NULL, NULL, &result));
+        return result;
+    }
+
+    if (database->exposed_ == NULL)
+        database->exposed_ = new DatabaseExposure(env, database, database->db_, database->rowCache_);
+
+    database->exposed_->Ref();
+    napi_status status = napi_create_external(env, static_cast<leveldown::ExposedDB *>(database->exposed_),
+                                              FinalizeExposedDatabase, NULL, &result);
+    if (status != napi_ok)
+        database->exposed_->Unref();
+    NAPI_STATUS_THROWS(status);
 
     return result;
 }
 
+/**
+ * Reads the 'sharedCache' option, a SharedCache handle or its context.
+ * Returns an error message if the option is invalid.
+ */
+static const char *SharedCacheOption(napi_env env, napi_value opts, SharedCache **sharedCache)
+{
+    *sharedCache = NULL;
+
+    if (!IsObject(env, opts) || !HasProperty(env, opts, "sharedCache"))
+        return NULL;
+
+    napi_value value = GetProperty(env, opts, "sharedCache");
+    napi_valuetype type;
+    napi_typeof(env, value, &type);
+
+    if (type == napi_undefined || type == napi_null)
+        return NULL;
+    if (type == napi_object)
+        value = GetProperty(env, value, "context");
+
+    if (napi_get_value_external(env, value, (void **)sharedCache) != napi_ok || *sharedCache == NULL)
+    {
+        *sharedCache = NULL;
+        return "invalid shared cache";
+    }
+
+    return NULL;
+}
+
 /**
  * Worker class for opening a database.
  * TODO: shouldn't this be a PriorityWorker?
@@ -1056,10 +2682,10 @@ struct OpenWorker final : public BaseWorker
                const bool createIfMissing, const bool errorIfExists, const bool compression,
                const uint32_t writeBufferSize, const uint32_t blockSize, const uint32_t maxOpenFiles,
                const uint32_t blockRestartInterval, const uint32_t maxFileSize, const uint64_t manifestFileMaxSize)
-        : BaseWorker(env, database, callback, "leveldown.db.open"), location_(location)
+        : BaseWorker(env, database, callback, "leveldown.db.open", workWrite), location_(location)
     {
-        options_.block_cache = database->blockCache_;
-        options_.filter_policy = database->filterPolicy_;
+        options_.block_cache = database->countingCache_;
+        options_.filter_policy = database->FilterPolicy();
         options_.create_if_missing = createIfMissing;
         options_.error_if_exists = errorIfExists;
         options_.compression = compression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
@@ -1106,9 +2732,32 @@ NAPI_METHOD(db_open)
     const uint32_t maxFileSize = Uint32Property(env, options, "maxFileSize", 2 << 20);
     const uint32_t manifestFileMaxSize = Uint32Property(env, options, "manifestFileMaxSize", 0);
 
-    database->blockCache_ = leveldb::NewLRUCache(cacheSize);
+    database->zeroCopy_ = BooleanProperty(env, options, "zeroCopy", true);
+
+    if (BooleanProperty(env, options, "coalesceWrites", false) && database->writeQueue_ == NULL)
+    {
+        const uint32_t coalesceWindow = Uint32Property(env, options, "coalesceWindow", 0);
+        const uint32_t coalesceBytes = Uint32Property(env, options, "coalesceBytes", 1024 * 1024);
+        database->writeQueue_ = new WriteQueue(coalesceWindow, coalesceBytes);
+    }
+
+    const uint32_t rowCacheSize = Uint32Property(env, options, "rowCacheSize", 0);
+    if (rowCacheSize > 0 && database->rowCache_ == NULL)
+        database->rowCache_ = new RowCache(rowCacheSize);
 
     napi_value callback = argv[3];
+
+    SharedCache *sharedCache;
+    const char *sharedCacheError = SharedCacheOption(env, options, &sharedCache);
+    if (sharedCacheError != NULL)
+    {
+        delete[] location;
+        napi_value argv = CreateError(env, sharedCacheError);
+        CallFunction(env, callback, 1, &argv);
+        NAPI_RETURN_UNDEFINED();
+    }
+    database->UseCache(sharedCache, cacheSize);
+
     OpenWorker *worker =
         new OpenWorker(env, database, callback, location, createIfMissing, errorIfExists, compression, writeBufferSize,
                        blockSize, maxOpenFiles, blockRestartInterval, maxFileSize, manifestFileMaxSize);
@@ -1124,7 +2773,7 @@ NAPI_METHOD(db_open)
 struct CloseWorker final : public BaseWorker
 {
     CloseWorker(napi_env env, Database *database, napi_value callback)
-        : BaseWorker(env, database, callback, "leveldown.db.close")
+        : BaseWorker(env, database, callback, "leveldown.db.close", workWrite)
     {
     }
 
@@ -1154,6 +2803,28 @@ NAPI_METHOD(db_close)
     napi_value callback = argv[1];
     CloseWorker *worker = new CloseWorker(env, database, callback);
 
+    // Native work that deferred closing goes on, no more can be deferred
+    if (database->exposed_ != NULL)
+        database->exposed_->Close();
+
+    // Coalesced writes are written before closing, without waiting for their window
+    WriteQueue *queue = database->writeQueue_;
+    if (queue != NULL)
+    {
+        queue->flushScheduled_ = false;
+        if (!queue->writing_ && queue->HasPending())
+            StartWriteGroup(env, database);
+    }
+
+    // Snapshots still in use by reads are released once those are done
+    std::map<uint32_t, Snapshot *> snapshots = database->snapshots_;
+    std::map<uint32_t, Snapshot *>::iterator st;
+
+    for (st = snapshots.begin(); st != snapshots.end(); ++st)
+    {
+        st->second->ReleaseForClose(env);
+    }
+
     if (!database->HasPriorityWork())
     {
         worker->Queue(env);
@@ -1183,7 +2854,7 @@ struct PutWorker final : public PriorityWorker
 {
     PutWorker(napi_env env, Database *database, napi_value callback, leveldb::Slice key, leveldb::Slice value,
               bool sync)
-        : PriorityWorker(env, database, callback, "leveldown.db.put"), key_(key), value_(value)
+        : PriorityWorker(env, database, callback, "leveldown.db.put", workWrite), key_(key), value_(value)
     {
         options_.sync = sync;
     }
@@ -1204,6 +2875,162 @@ struct PutWorker final : public PriorityWorker
     leveldb::Slice value_;
 };
 
+/**
+ * Worker class for writing a group of coalesced puts and dels, the callback
+ * of every op is called once the group is written.
+ */
+struct WriteGroupWorker final : public PriorityWorker
+{
+    WriteGroupWorker(napi_env env, Database *database, napi_value callback)
+        : PriorityWorker(env, database, callback, "leveldown.db.write_group", workWrite), group_(NULL)
+    {
+    }
+
+    ~WriteGroupWorker()
+    {
+        delete group_;
+    }
+
+    void DoExecute() override
+    {
+        group_ = database_->writeQueue_->Take();
+
+        leveldb::WriteOptions options;
+        options.sync = group_->sync_;
+
+        leveldb::Status status = database_->WriteBatch(options, &group_->batch_);
+        if (!SetStatus(status))
+            error_ = status.ToString();
+    }
+
+    void HandleOKCallback(napi_env env, napi_value callback) override
+    {
+        napi_value argv;
+        napi_get_null(env, &argv);
+        CallGroupCallbacks(env, argv);
+    }
+
+    void HandleErrorCallback(napi_env env, napi_value callback) override
+    {
+        CallGroupCallbacks(env, CreateError(env, error_.c_str()));
+    }
+
+    void DoFinally(napi_env env) override
+    {
+        // Queue the ops that arrived meanwhile before this worker stops counting as priority work
+        WriteQueue *queue = database_->writeQueue_;
+        queue->writing_ = false;
+        if (queue->HasPending())
+            StartWriteGroup(env, database_);
+
+        PriorityWorker::DoFinally(env);
+    }
+
+  private:
+    void CallGroupCallbacks(napi_env env, napi_value argv)
+    {
+        for (napi_ref callbackRef : group_->callbacks_)
+        {
+            napi_value callback;
+            napi_get_reference_value(env, callbackRef, &callback);
+            CallFunction(env, callback, 1, &argv);
+            napi_delete_reference(env, callbackRef);
+
+            // Report an exception thrown by a callback without skipping the others
+            bool pending = false;
+            napi_is_exception_pending(env, &pending);
+            if (pending)
+            {
+                napi_value exception;
+                napi_get_and_clear_last_exception(env, &exception);
+                napi_fatal_exception(env, exception);
+            }
+        }
+        group_->callbacks_.clear();
+    }
+
+    WriteGroup *group_;
+    std::string error_;
+};
+
+/**
+ * Starts writing the pending group of the write queue of a database.
+ */
+static void StartWriteGroup(napi_env env, Database *database)
+{
+    database->writeQueue_->writing_ = true;
+    napi_value noop;
+    napi_create_function(env, NULL, 0, noop_callback, NULL, &noop);
+    (new WriteGroupWorker(env, database, noop))->Queue(env);
+}
+
+/**
+ * Writes the pending group right away if it's full or there's no coalesce window.
+ * A group being written already writes the next one when done. Otherwise returns
+ * the window in milliseconds, after which JS calls db_flush_writes(), so the wait
+ * doesn't hold a pool thread. Returns undefined if no flush needs to be scheduled.
+ */
+static napi_value ScheduleWriteGroup(napi_env env, Database *database, const bool full)
+{
+    WriteQueue *queue = database->writeQueue_;
+
+    napi_value result;
+    napi_get_undefined(env, &result);
+
+    if (queue->writing_)
+        return result;
+
+    if (full || queue->window_ == 0)
+    {
+        StartWriteGroup(env, database);
+    }
+    else if (!queue->flushScheduled_)
+    {
+        queue->flushScheduled_ = true;
+        napi_create_uint32(env, (queue->window_ + 999) / 1000, &result);
+    }
+
+    return result;
+}
+
+/**
+ * Adds a put or del to the write queue of a database.
+ */
+static napi_value QueueWrite(napi_env env, Database *database, leveldb::Slice key, const leveldb::Slice *value,
+                             const bool sync, napi_value callback)
+{
+    return ScheduleWriteGroup(env, database, database->writeQueue_->Add(env, key, value, sync, callback));
+}
+
+/**
+ * Adds the ops of a batch to the write queue of a database. Batches go through the
+ * queue as well, so they can't overtake puts and dels queued before them.
+ */
+static napi_value QueueBatch(napi_env env, Database *database, const leveldb::WriteBatch &batch, const bool sync,
+                             napi_value callback)
+{
+    return ScheduleWriteGroup(env, database, database->writeQueue_->AddBatch(env, batch, sync, callback));
+}
+
+/**
+ * Writes the pending group of coalesced writes once the coalesce window has passed.
+ */
+NAPI_METHOD(db_flush_writes)
+{
+    NAPI_ARGV(1);
+    NAPI_DB_CONTEXT();
+
+    WriteQueue *queue = database->writeQueue_;
+    if (queue != NULL)
+    {
+        queue->flushScheduled_ = false;
+        if (!queue->writing_ && queue->HasPending())
+            StartWriteGroup(env, database);
+    }
+
+    NAPI_RETURN_UNDEFINED();
+}
+
 /**
  * Puts a key and a value to a database.
  */
@@ -1217,6 +3044,14 @@ NAPI_METHOD(db_put)
     bool sync = BooleanProperty(env, argv[3], "sync", false);
     napi_value callback = argv[4];
 
+    if (database->writeQueue_ != NULL)
+    {
+        napi_value flushAfter = QueueWrite(env, database, key, &value, sync, callback);
+        DisposeSliceBuffer(key);
+        DisposeSliceBuffer(value);
+        return flushAfter;
+    }
+
     PutWorker *worker = new PutWorker(env, database, callback, key, value, sync);
     worker->Queue(env);
 
@@ -1229,10 +3064,16 @@ NAPI_METHOD(db_put)
 struct GetWorker final : public PriorityWorker
 {
     GetWorker(napi_env env, Database *database, napi_value callback, leveldb::Slice key, const bool asBuffer,
-              const bool fillCache)
-        : PriorityWorker(env, database, callback, "leveldown.db.get"), key_(key), asBuffer_(asBuffer)
+              const bool fillCache, Snapshot *snapshot)
+        : PriorityWorker(env, database, callback, "leveldown.db.get", workRead), key_(key), asBuffer_(asBuffer),
+          snapshot_(snapshot)
     {
         options_.fill_cache = fillCache;
+        if (snapshot_ != NULL)
+        {
+            snapshot_->Ref(env);
+            options_.snapshot = snapshot_->snapshot_;
+        }
     }
 
     ~GetWorker()
@@ -1240,26 +3081,68 @@ struct GetWorker final : public PriorityWorker
         DisposeSliceBuffer(key_);
     }
 
-    void DoExecute() override
-    {
-        SetStatus(database_->Get(options_, key_, value_));
+    void DoExecute() override
+    {
+        RowCache *rowCache = snapshot_ == NULL ? database_->rowCache_ : NULL;
+        if (rowCache == NULL)
+        {
+            SetStatus(database_->Get(options_, key_, value_));
+            return;
+        }
+
+        if (rowCache->Lookup(key_, &value_))
+            return;
+
+        const uint64_t generation = rowCache->Generation(key_);
+        if (SetStatus(database_->Get(options_, key_, value_)) && options_.fill_cache)
+            rowCache->Insert(key_, value_, generation);
     }
 
     void HandleOKCallback(napi_env env, napi_value callback) override
     {
         napi_value argv[2];
         napi_get_null(env, &argv[0]);
-        Entry::Convert(env, &value_, asBuffer_, &argv[1]);
+        Entry::ConvertOwned(env, new std::string(std::move(value_)), asBuffer_, database_->zeroCopy_, &argv[1]);
         CallFunction(env, callback, 2, argv);
     }
 
+    void DoFinally(napi_env env) override
+    {
+        if (snapshot_ != NULL)
+            snapshot_->Unref(env);
+        PriorityWorker::DoFinally(env);
+    }
+
   private:
     leveldb::ReadOptions options_;
     leveldb::Slice key_;
     std::string value_;
     const bool asBuffer_;
+    Snapshot *snapshot_;
 };
 
+/**
+ * Queues a GetWorker, takes ownership of 'key'.
+ */
+static void db_get_do(napi_env env, Database *database, leveldb::Slice key, napi_value options, napi_value callback)
+{
+    const bool asBuffer = BooleanProperty(env, options, "asBuffer", true);
+    const bool fillCache = BooleanProperty(env, options, "fillCache", true);
+
+    Snapshot *snapshot;
+    const char *snapshotError = SnapshotOption(env, options, database, &snapshot);
+    if (snapshotError != NULL)
+    {
+        DisposeSliceBuffer(key);
+        napi_value argv = CreateError(env, snapshotError);
+        CallFunction(env, callback, 1, &argv);
+        return;
+    }
+
+    GetWorker *worker = new GetWorker(env, database, callback, key, asBuffer, fillCache, snapshot);
+    worker->Queue(env);
+}
+
 /**
  * Gets a value from a database.
  */
@@ -1268,14 +3151,37 @@ NAPI_METHOD(db_get)
     NAPI_ARGV(4);
     NAPI_DB_CONTEXT();
 
+    db_get_do(env, database, ToSlice(env, argv[1]), argv[2], argv[3]);
+
+    NAPI_RETURN_UNDEFINED();
+}
+
+/**
+ * Gets a value from the row cache of a database without leaving the main thread.
+ * Returns the value on a hit and doesn't call the callback. Returns undefined on
+ * a miss and gets the value asynchronously, like db_get().
+ */
+NAPI_METHOD(db_get_sync_cached)
+{
+    NAPI_ARGV(4);
+    NAPI_DB_CONTEXT();
+
     leveldb::Slice key = ToSlice(env, argv[1]);
     napi_value options = argv[2];
-    const bool asBuffer = BooleanProperty(env, options, "asBuffer", true);
-    const bool fillCache = BooleanProperty(env, options, "fillCache", true);
-    napi_value callback = argv[3];
 
-    GetWorker *worker = new GetWorker(env, database, callback, key, asBuffer, fillCache);
-    worker->Queue(env);
+    if (database->rowCache_ != NULL && !(IsObject(env, options) && HasProperty(env, options, "snapshot")))
+    {
+        std::string value;
+        if (database->rowCache_->Lookup(key, &value))
+        {
+            DisposeSliceBuffer(key);
+            napi_value result;
+            Entry::Convert(env, &value, BooleanProperty(env, options, "asBuffer", true), &result);
+            return result;
+        }
+    }
+
+    db_get_do(env, database, key, options, argv[3]);
 
     NAPI_RETURN_UNDEFINED();
 }
@@ -1286,11 +3192,20 @@ NAPI_METHOD(db_get)
 struct GetManyWorker final : public PriorityWorker
 {
     GetManyWorker(napi_env env, Database *database, const std::vector<std::string> *keys, napi_value callback,
-                  const bool valueAsBuffer, const bool fillCache)
-        : PriorityWorker(env, database, callback, "leveldown.get.many"), keys_(keys), valueAsBuffer_(valueAsBuffer)
+                  const bool valueAsBuffer, const bool fillCache, Snapshot *snapshot)
+        : PriorityWorker(env, database, callback, "leveldown.get.many", workRead), keys_(keys),
+          valueAsBuffer_(valueAsBuffer), snapshot_(snapshot)
     {
         options_.fill_cache = fillCache;
-        options_.snapshot = database->NewSnapshot();
+        if (snapshot_ != NULL)
+        {
+            snapshot_->Ref(env);
+            options_.snapshot = snapshot_->snapshot_;
+        }
+        else
+        {
+            options_.snapshot = database->NewSnapshot();
+        }
     }
 
     ~GetManyWorker()
@@ -1300,15 +3215,19 @@ struct GetManyWorker final : public PriorityWorker
 
     void DoExecute() override
     {
+        const DatabaseMetrics::Clock::time_point start = DatabaseMetrics::Clock::now();
         cache_.reserve(keys_->size());
+        size_t bytes = 0;
 
         for (const std::string &key : *keys_)
         {
+            // Not through Database::Get(), the keys aren't gets of their own in the metrics
             std::string *value = new std::string();
-            leveldb::Status status = database_->Get(options_, key, *value);
+            leveldb::Status status = database_->db_->Get(options_, key, value);
 
             if (status.ok())
             {
+                bytes += value->size();
                 cache_.push_back(value);
             }
             else if (status.IsNotFound())
@@ -1329,7 +3248,10 @@ struct GetManyWorker final : public PriorityWorker
             }
         }
 
-        database_->ReleaseSnapshot(options_.snapshot);
+        database_->metrics_.Read(opGetMany, start, bytes);
+
+        if (snapshot_ == NULL)
+            database_->ReleaseSnapshot(options_.snapshot);
     }
 
     void HandleOKCallback(napi_env env, napi_value callback) override
@@ -1340,12 +3262,9 @@ struct GetManyWorker final : public PriorityWorker
 
         for (size_t idx = 0; idx < size; idx++)
         {
-            std::string *value = cache_[idx];
             napi_value element;
-            Entry::Convert(env, value, valueAsBuffer_, &element);
+            Entry::ConvertOwned(env, cache_[idx], valueAsBuffer_, database_->zeroCopy_, &element);
             napi_set_element(env, array, static_cast<uint32_t>(idx), element);
-            if (value != NULL)
-                delete value;
         }
 
         napi_value argv[2];
@@ -1354,10 +3273,18 @@ struct GetManyWorker final : public PriorityWorker
         CallFunction(env, callback, 2, argv);
     }
 
+    void DoFinally(napi_env env) override
+    {
+        if (snapshot_ != NULL)
+            snapshot_->Unref(env);
+        PriorityWorker::DoFinally(env);
+    }
+
   private:
     leveldb::ReadOptions options_;
     const std::vector<std::string> *keys_;
     const bool valueAsBuffer_;
+    Snapshot *snapshot_;
     std::vector<std::string *> cache_;
 };
 
@@ -1369,13 +3296,22 @@ NAPI_METHOD(db_get_many)
     NAPI_ARGV(4);
     NAPI_DB_CONTEXT();
 
-    const std::vector<std::string> *keys = KeyArray(env, argv[1]);
     napi_value options = argv[2];
     const bool asBuffer = BooleanProperty(env, options, "asBuffer", true);
     const bool fillCache = BooleanProperty(env, options, "fillCache", true);
     napi_value callback = argv[3];
 
-    GetManyWorker *worker = new GetManyWorker(env, database, keys, callback, asBuffer, fillCache);
+    Snapshot *snapshot;
+    const char *snapshotError = SnapshotOption(env, options, database, &snapshot);
+    if (snapshotError != NULL)
+    {
+        napi_value argv = CreateError(env, snapshotError);
+        CallFunction(env, callback, 1, &argv);
+        NAPI_RETURN_UNDEFINED();
+    }
+
+    const std::vector<std::string> *keys = KeyArray(env, argv[1]);
+    GetManyWorker *worker = new GetManyWorker(env, database, keys, callback, asBuffer, fillCache, snapshot);
 
     worker->Queue(env);
     NAPI_RETURN_UNDEFINED();
@@ -1387,7 +3323,7 @@ NAPI_METHOD(db_get_many)
 struct DelWorker final : public PriorityWorker
 {
     DelWorker(napi_env env, Database *database, napi_value callback, leveldb::Slice key, bool sync)
-        : PriorityWorker(env, database, callback, "leveldown.db.del"), key_(key)
+        : PriorityWorker(env, database, callback, "leveldown.db.del", workWrite), key_(key)
     {
         options_.sync = sync;
     }
@@ -1418,6 +3354,13 @@ NAPI_METHOD(db_del)
     bool sync = BooleanProperty(env, argv[2], "sync", false);
     napi_value callback = argv[3];
 
+    if (database->writeQueue_ != NULL)
+    {
+        napi_value flushAfter = QueueWrite(env, database, key, NULL, sync, callback);
+        DisposeSliceBuffer(key);
+        return flushAfter;
+    }
+
     DelWorker *worker = new DelWorker(env, database, callback, key, sync);
     worker->Queue(env);
 
@@ -1431,7 +3374,7 @@ struct ClearWorker final : public PriorityWorker
 {
     ClearWorker(napi_env env, Database *database, napi_value callback, const bool reverse, const int limit,
                 std::string *lt, std::string *lte, std::string *gt, std::string *gte)
-        : PriorityWorker(env, database, callback, "leveldown.db.clear")
+        : PriorityWorker(env, database, callback, "leveldown.db.clear", workBackground)
     {
         iterator_ = new BaseIterator(database, reverse, lt, lte, gt, gte, limit, false);
         writeOptions_ = new leveldb::WriteOptions();
@@ -1493,140 +3436,450 @@ NAPI_METHOD(db_clear)
     NAPI_ARGV(3);
     NAPI_DB_CONTEXT();
 
-    napi_value options = argv[1];
-    napi_value callback = argv[2];
+    napi_value options = argv[1];
+    napi_value callback = argv[2];
+
+    const bool reverse = BooleanProperty(env, options, "reverse", false);
+    const int limit = Int32Property(env, options, "limit", -1);
+
+    std::string *lt = RangeOption(env, options, "lt");
+    std::string *lte = RangeOption(env, options, "lte");
+    std::string *gt = RangeOption(env, options, "gt");
+    std::string *gte = RangeOption(env, options, "gte");
+
+    ClearWorker *worker = new ClearWorker(env, database, callback, reverse, limit, lt, lte, gt, gte);
+    worker->Queue(env);
+
+    NAPI_RETURN_UNDEFINED();
+}
+
+/**
+ * Worker class for calculating the size of a range.
+ */
+struct ApproximateSizeWorker final : public PriorityWorker
+{
+    ApproximateSizeWorker(napi_env env, Database *database, napi_value callback, leveldb::Slice start,
+                          leveldb::Slice end)
+        : PriorityWorker(env, database, callback, "leveldown.db.approximate_size", workBackground), start_(start),
+          end_(end)
+    {
+    }
+
+    ~ApproximateSizeWorker()
+    {
+        DisposeSliceBuffer(start_);
+        DisposeSliceBuffer(end_);
+    }
+
+    void DoExecute() override
+    {
+        leveldb::Range range(start_, end_);
+        size_ = database_->ApproximateSize(&range);
+    }
+
+    void HandleOKCallback(napi_env env, napi_value callback) override
+    {
+        napi_value argv[2];
+        napi_get_null(env, &argv[0]);
+        napi_create_int64(env, (uint64_t)size_, &argv[1]);
+        CallFunction(env, callback, 2, argv);
+    }
+
+    leveldb::Slice start_;
+    leveldb::Slice end_;
+    uint64_t size_;
+};
+
+/**
+ * Calculates the approximate size of a range in a database.
+ */
+NAPI_METHOD(db_approximate_size)
+{
+    NAPI_ARGV(4);
+    NAPI_DB_CONTEXT();
+
+    leveldb::Slice start = ToSlice(env, argv[1]);
+    leveldb::Slice end = ToSlice(env, argv[2]);
+
+    napi_value callback = argv[3];
+
+    ApproximateSizeWorker *worker = new ApproximateSizeWorker(env, database, callback, start, end);
+    worker->Queue(env);
+
+    NAPI_RETURN_UNDEFINED();
+}
+
+/**
+ * Worker class for compacting a range in a database.
+ */
+struct CompactRangeWorker final : public PriorityWorker
+{
+    CompactRangeWorker(napi_env env, Database *database, napi_value callback, leveldb::Slice start, leveldb::Slice end)
+        : PriorityWorker(env, database, callback, "leveldown.db.compact_range", workBackground), start_(start),
+          end_(end)
+    {
+    }
+
+    ~CompactRangeWorker()
+    {
+        DisposeSliceBuffer(start_);
+        DisposeSliceBuffer(end_);
+    }
+
+    void DoExecute() override
+    {
+        database_->CompactRange(&start_, &end_);
+    }
+
+    leveldb::Slice start_;
+    leveldb::Slice end_;
+};
+
+/**
+ * Compacts a range in a database.
+ */
+NAPI_METHOD(db_compact_range)
+{
+    NAPI_ARGV(4);
+    NAPI_DB_CONTEXT();
+
+    leveldb::Slice start = ToSlice(env, argv[1]);
+    leveldb::Slice end = ToSlice(env, argv[2]);
+    napi_value callback = argv[3];
+
+    CompactRangeWorker *worker = new CompactRangeWorker(env, database, callback, start, end);
+    worker->Queue(env);
+
+    NAPI_RETURN_UNDEFINED();
+}
+
+/**
+ * Get a property from a database.
+ */
+NAPI_METHOD(db_get_property)
+{
+    NAPI_ARGV(2);
+    NAPI_DB_CONTEXT();
+
+    leveldb::Slice property = ToSlice(env, argv[1]);
+
+    std::string value;
+    database->GetProperty(property, &value);
+
+    napi_value result;
+    napi_create_string_utf8(env, value.data(), value.size(), &result);
+
+    DisposeSliceBuffer(property);
+
+    return result;
+}
+
+/**
+ * Returns the block cache counters of a database. The usage and capacity are
+ * those of the shared cache if the database uses one.
+ */
+NAPI_METHOD(db_cache_stats)
+{
+    NAPI_ARGV(1);
+    NAPI_DB_CONTEXT();
+
+    CountingCache *cache = database->countingCache_;
+    if (database->db_ == NULL || cache == NULL)
+    {
+        napi_throw_error(env, NULL, "database is not open");
+        return NULL;
+    }
+
+    napi_value result;
+    NAPI_STATUS_THROWS(napi_create_object(env, &result));
+    SetNumberProperty(env, result, "hits", (double)cache->hits_.load());
+    SetNumberProperty(env, result, "misses", (double)cache->misses_.load());
+    SetNumberProperty(env, result, "usage", (double)cache->TotalCharge());
+    SetNumberProperty(env, result, "capacity", (double)database->cacheCapacity_);
+
+    napi_value shared;
+    NAPI_STATUS_THROWS(napi_get_boolean(env, database->sharedCache_ != NULL, &shared));
+    NAPI_STATUS_THROWS(napi_set_named_property(env, result, "shared", shared));
+
+    return result;
+}
+
+/**
+ * Returns the count, sum, max and quantiles of a latency histogram.
+ */
+static napi_value HistogramObject(napi_env env, const LatencyHistogram &histogram)
+{
+    napi_value result;
+    napi_create_object(env, &result);
+    SetNumberProperty(env, result, "count", (double)histogram.count_.load());
+    SetNumberProperty(env, result, "sum", (double)histogram.sum_.load());
+    SetNumberProperty(env, result, "max", (double)histogram.max_.load());
+    SetNumberProperty(env, result, "p50", (double)histogram.Quantile(0.5));
+    SetNumberProperty(env, result, "p90", (double)histogram.Quantile(0.9));
+    SetNumberProperty(env, result, "p99", (double)histogram.Quantile(0.99));
+    SetNumberProperty(env, result, "p999", (double)histogram.Quantile(0.999));
+    return result;
+}
+
+/**
+ * Parses the compaction table of the 'leveldb.stats' property into an array
+ * of { level, files, sizeMB, timeSec, readMB, writeMB } objects. Levels that
+ * have no files and were never compacted are left out, like LevelDB does.
+ */
+static napi_value LevelStatsArray(napi_env env, const std::string &stats, uint32_t *level0Files)
+{
+    napi_value result;
+    napi_create_array(env, &result);
+    *level0Files = 0;
+
+    size_t pos = stats.find("---\n");
+    if (pos == std::string::npos)
+        return result;
+
+    uint32_t count = 0;
+    pos = stats.find('\n', pos) + 1;
+    while (pos < stats.size())
+    {
+        int level, files;
+        double size, time, read, write;
+        if (sscanf(stats.c_str() + pos, "%d %d %lf %lf %lf %lf", &level, &files, &size, &time, &read, &write) != 6)
+            break;
+
+        if (level == 0)
+            *level0Files = files;
+
+        napi_value entry;
+        napi_create_object(env, &entry);
+        SetNumberProperty(env, entry, "level", level);
+        SetNumberProperty(env, entry, "files", files);
+        SetNumberProperty(env, entry, "sizeMB", size);
+        SetNumberProperty(env, entry, "timeSec", time);
+        SetNumberProperty(env, entry, "readMB", read);
+        SetNumberProperty(env, entry, "writeMB", write);
+        napi_set_element(env, result, count++, entry);
+
+        pos = stats.find('\n', pos);
+        if (pos == std::string::npos)
+            break;
+        pos++;
+    }
+
+    return result;
+}
+
+/**
+ * Returns all metrics of a database in one go: latency histograms per op in
+ * microseconds, bytes read and written, block cache hits, unsynced writes that
+ * took 1ms or more, memory usage and the parsed 'leveldb.stats' property.
+ */
+NAPI_METHOD(db_metrics)
+{
+    NAPI_ARGV(1);
+    NAPI_DB_CONTEXT();
+
+    if (database->db_ == NULL)
+    {
+        napi_throw_error(env, NULL, "database is not open");
+        return NULL;
+    }
+
+    static const char *const opNames[metricOps] = {"get", "getMany", "put", "del", "batch", "iteratorNext"};
+    DatabaseMetrics &metrics = database->metrics_;
+
+    napi_value result;
+    NAPI_STATUS_THROWS(napi_create_object(env, &result));
+
+    napi_value latency;
+    NAPI_STATUS_THROWS(napi_create_object(env, &latency));
+    for (size_t i = 0; i < metricOps; i++)
+        NAPI_STATUS_THROWS(napi_set_named_property(env, latency, opNames[i], HistogramObject(env, metrics.ops_[i])));
+    NAPI_STATUS_THROWS(napi_set_named_property(env, result, "latency", latency));
+
+    SetNumberProperty(env, result, "bytesRead", (double)metrics.bytesRead_.load());
+    SetNumberProperty(env, result, "bytesWritten", (double)metrics.bytesWritten_.load());
+    SetNumberProperty(env, result, "slowWrites", (double)metrics.slowWrites_.load());
+
+    const uint64_t hits = database->countingCache_->hits_.load();
+    const uint64_t misses = database->countingCache_->misses_.load();
+    SetNumberProperty(env, result, "blockCacheHits", (double)hits);
+    SetNumberProperty(env, result, "blockCacheMisses", (double)misses);
+    SetNumberProperty(env, result, "blockCacheHitRatio", hits + misses > 0 ? (double)hits / (hits + misses) : 0);
+
+    std::string memoryUsage;
+    database->GetProperty("leveldb.approximate-memory-usage", &memoryUsage);
+    SetNumberProperty(env, result, "memoryUsage", strtod(memoryUsage.c_str(), NULL));
+
+    std::string stats;
+    database->GetProperty("leveldb.stats", &stats);
+    uint32_t level0Files;
+    napi_value levels = LevelStatsArray(env, stats, &level0Files);
+    NAPI_STATUS_THROWS(napi_set_named_property(env, result, "levels", levels));
+    SetNumberProperty(env, result, "level0Files", level0Files);
+
+    return result;
+}
+
+/**
+ * Runs when a SharedCache is garbage collected.
+ */
+static void FinalizeSharedCache(napi_env env, void *data, void *hint)
+{
+    if (data)
+        ((SharedCache *)data)->Unref();
+}
+
+/**
+ * Returns a context object for a block cache of 'size' bytes that databases
+ * can share.
+ */
+NAPI_METHOD(shared_cache_init)
+{
+    NAPI_ARGV(1);
 
-    const bool reverse = BooleanProperty(env, options, "reverse", false);
-    const int limit = Int32Property(env, options, "limit", -1);
+    // Not limited to uint32 like 'cacheSize' as a shared cache is usually large.
+    int64_t size = 0;
+    NAPI_STATUS_THROWS(napi_get_value_int64(env, argv[0], &size));
+    if (size < 0)
+    {
+        napi_throw_error(env, NULL, "cache size must not be negative");
+        return NULL;
+    }
 
-    std::string *lt = RangeOption(env, options, "lt");
-    std::string *lte = RangeOption(env, options, "lte");
-    std::string *gt = RangeOption(env, options, "gt");
-    std::string *gte = RangeOption(env, options, "gte");
+    SharedCache *sharedCache = new SharedCache((size_t)size);
 
-    ClearWorker *worker = new ClearWorker(env, database, callback, reverse, limit, lt, lte, gt, gte);
-    worker->Queue(env);
+    napi_value result;
+    NAPI_STATUS_THROWS(napi_create_external(env, sharedCache, FinalizeSharedCache, NULL, &result));
 
-    NAPI_RETURN_UNDEFINED();
+    return result;
 }
 
 /**
- * Worker class for calculating the size of a range.
+ * Returns the usage and capacity of a shared cache.
  */
-struct ApproximateSizeWorker final : public PriorityWorker
+NAPI_METHOD(shared_cache_stats)
 {
-    ApproximateSizeWorker(napi_env env, Database *database, napi_value callback, leveldb::Slice start,
-                          leveldb::Slice end)
-        : PriorityWorker(env, database, callback, "leveldown.db.approximate_size"), start_(start), end_(end)
-    {
-    }
+    NAPI_ARGV(1);
 
-    ~ApproximateSizeWorker()
-    {
-        DisposeSliceBuffer(start_);
-        DisposeSliceBuffer(end_);
-    }
+    SharedCache *sharedCache = NULL;
+    NAPI_STATUS_THROWS(napi_get_value_external(env, argv[0], (void **)&sharedCache));
 
-    void DoExecute() override
-    {
-        leveldb::Range range(start_, end_);
-        size_ = database_->ApproximateSize(&range);
-    }
+    napi_value result;
+    NAPI_STATUS_THROWS(napi_create_object(env, &result));
+    SetNumberProperty(env, result, "usage", (double)sharedCache->cache_->TotalCharge());
+    SetNumberProperty(env, result, "capacity", (double)sharedCache->capacity_);
 
-    void HandleOKCallback(napi_env env, napi_value callback) override
+    return result;
+}
+
+/**
+ * Runs when a Snapshot is garbage collected.
+ */
+static void FinalizeSnapshot(napi_env env, void *data, void *hint)
+{
+    if (data)
     {
-        napi_value argv[2];
-        napi_get_null(env, &argv[0]);
-        napi_create_int64(env, (uint64_t)size_, &argv[1]);
-        CallFunction(env, callback, 2, argv);
+        Snapshot *snapshot = (Snapshot *)data;
+        snapshot->Finalize(env);
+        delete snapshot;
     }
-
-    leveldb::Slice start_;
-    leveldb::Slice end_;
-    uint64_t size_;
-};
+}
 
 /**
- * Calculates the approximate size of a range in a database.
+ * Creates a snapshot of a database.
  */
-NAPI_METHOD(db_approximate_size)
+NAPI_METHOD(snapshot_init)
 {
-    NAPI_ARGV(4);
+    NAPI_ARGV(1);
     NAPI_DB_CONTEXT();
 
-    leveldb::Slice start = ToSlice(env, argv[1]);
-    leveldb::Slice end = ToSlice(env, argv[2]);
+    if (database->db_ == NULL)
+    {
+        napi_throw_error(env, NULL, "database is not open");
+        return NULL;
+    }
 
-    napi_value callback = argv[3];
+    const uint32_t id = database->currentSnapshotId_++;
+    Snapshot *snapshot = new Snapshot(database, id);
+    napi_value result;
 
-    ApproximateSizeWorker *worker = new ApproximateSizeWorker(env, database, callback, start, end);
-    worker->Queue(env);
+    NAPI_STATUS_THROWS(napi_create_external(env, snapshot, FinalizeSnapshot, NULL, &result));
 
-    NAPI_RETURN_UNDEFINED();
+    // Keep track of unreleased snapshots to release them on db close.
+    snapshot->Attach(env, result);
+
+    return result;
 }
 
 /**
- * Worker class for compacting a range in a database.
+ * Runs when an exposed snapshot is garbage collected.
  */
-struct CompactRangeWorker final : public PriorityWorker
+static void FinalizeExposedSnapshot(napi_env env, void *data, void *hint)
 {
-    CompactRangeWorker(napi_env env, Database *database, napi_value callback, leveldb::Slice start, leveldb::Slice end)
-        : PriorityWorker(env, database, callback, "leveldown.db.compact_range"), start_(start), end_(end)
+    SnapshotExposure *exposure = static_cast<SnapshotExposure *>((leveldown::ExposedSnapshot *)data);
+    if (exposure->snapshot_ != NULL)
     {
+        exposure->snapshot_->Unexpose(env, exposure);
+        if (exposure->snapshot_ != NULL)
+            exposure->snapshot_->Detach(exposure);
     }
+    delete exposure;
+}
 
-    ~CompactRangeWorker()
+/**
+ * Returns a leveldown::ExposedSnapshot for native code reading the exposed
+ * database. It can be pinned after the snapshot is released, until it's
+ * garbage collected, snapshot_unexpose() is called or the database is closing.
+ */
+NAPI_METHOD(snapshot_expose)
+{
+    NAPI_ARGV(1);
+    NAPI_SNAPSHOT_CONTEXT();
+
+    if (snapshot->IsReleased())
     {
-        DisposeSliceBuffer(start_);
-        DisposeSliceBuffer(end_);
+        napi_throw_error(env, NULL, "snapshot has been released");
+        return NULL;
     }
 
-    void DoExecute() override
+    SnapshotExposure *exposure = snapshot->Expose(env);
+    napi_value result;
+    napi_status status = napi_create_external(env, static_cast<leveldown::ExposedSnapshot *>(exposure),
+                                              FinalizeExposedSnapshot, NULL, &result);
+    if (status != napi_ok)
     {
-        database_->CompactRange(&start_, &end_);
+        snapshot->Unexpose(env, exposure);
+        delete exposure;
     }
+    NAPI_STATUS_THROWS(status);
 
-    leveldb::Slice start_;
-    leveldb::Slice end_;
-};
+    return result;
+}
 
 /**
- * Compacts a range in a database.
+ * Drops every exposure of a snapshot. Native calls that pinned it go on until
+ * they're done, it can't be pinned anymore.
  */
-NAPI_METHOD(db_compact_range)
+NAPI_METHOD(snapshot_unexpose)
 {
-    NAPI_ARGV(4);
-    NAPI_DB_CONTEXT();
-
-    leveldb::Slice start = ToSlice(env, argv[1]);
-    leveldb::Slice end = ToSlice(env, argv[2]);
-    napi_value callback = argv[3];
+    NAPI_ARGV(1);
+    NAPI_SNAPSHOT_CONTEXT();
 
-    CompactRangeWorker *worker = new CompactRangeWorker(env, database, callback, start, end);
-    worker->Queue(env);
+    snapshot->UnexposeAll(env);
 
     NAPI_RETURN_UNDEFINED();
 }
 
 /**
- * Get a property from a database.
+ * Releases a snapshot, reads that use it go on until they're done.
  */
-NAPI_METHOD(db_get_property)
+NAPI_METHOD(snapshot_release)
 {
-    NAPI_ARGV(2);
-    NAPI_DB_CONTEXT();
-
-    leveldb::Slice property = ToSlice(env, argv[1]);
-
-    std::string value;
-    database->GetProperty(property, &value);
-
-    napi_value result;
-    napi_create_string_utf8(env, value.data(), value.size(), &result);
+    NAPI_ARGV(1);
+    NAPI_SNAPSHOT_CONTEXT();
 
-    DisposeSliceBuffer(property);
+    snapshot->Release(env);
 
-    return result;
+    NAPI_RETURN_UNDEFINED();
 }
 
 /**
@@ -1635,7 +3888,7 @@ NAPI_METHOD(db_get_property)
 struct DestroyWorker final : public BaseWorker
 {
     DestroyWorker(napi_env env, const std::string &location, napi_value callback)
-        : BaseWorker(env, NULL, callback, "leveldown.destroy_db"), location_(location)
+        : BaseWorker(env, NULL, callback, "leveldown.destroy_db", workBackground), location_(location)
     {
     }
 
@@ -1675,7 +3928,7 @@ NAPI_METHOD(destroy_db)
 struct RepairWorker final : public BaseWorker
 {
     RepairWorker(napi_env env, const std::string &location, napi_value callback)
-        : BaseWorker(env, NULL, callback, "leveldown.repair_db"), location_(location)
+        : BaseWorker(env, NULL, callback, "leveldown.repair_db", workBackground), location_(location)
     {
     }
 
@@ -1736,7 +3989,17 @@ NAPI_METHOD(iterator_init)
     const bool keyAsBuffer = BooleanProperty(env, options, "keyAsBuffer", true);
     const bool valueAsBuffer = BooleanProperty(env, options, "valueAsBuffer", true);
     const int limit = Int32Property(env, options, "limit", -1);
-    const uint32_t highWaterMark = Uint32Property(env, options, "highWaterMark", 16 * 1024);
+    const bool packed = BooleanProperty(env, options, "packed", false);
+    const uint32_t highWaterMark = Uint32Property(env, options, "highWaterMark", packed ? 1024 * 1024 : 16 * 1024);
+    const bool background = BooleanProperty(env, options, "background", false);
+
+    Snapshot *snapshot;
+    const char *snapshotError = SnapshotOption(env, options, database, &snapshot);
+    if (snapshotError != NULL)
+    {
+        napi_throw_error(env, NULL, snapshotError);
+        return NULL;
+    }
 
     std::string *lt = RangeOption(env, options, "lt");
     std::string *lte = RangeOption(env, options, "lte");
@@ -1745,7 +4008,7 @@ NAPI_METHOD(iterator_init)
 
     const uint32_t id = database->currentIteratorId_++;
     Iterator *iterator = new Iterator(database, id, reverse, keys, values, limit, lt, lte, gt, gte, fillCache,
-                                      keyAsBuffer, valueAsBuffer, highWaterMark);
+                                      keyAsBuffer, valueAsBuffer, highWaterMark, background, snapshot);
     napi_value result;
 
     NAPI_STATUS_THROWS(napi_create_external(env, iterator, FinalizeIterator, NULL, &result));
@@ -1784,7 +4047,7 @@ NAPI_METHOD(iterator_seek)
 struct EndWorker final : public BaseWorker
 {
     EndWorker(napi_env env, Iterator *iterator, napi_value callback)
-        : BaseWorker(env, iterator->database_, callback, "leveldown.iterator.end"), iterator_(iterator)
+        : BaseWorker(env, iterator->database_, callback, "leveldown.iterator.end", workRead), iterator_(iterator)
     {
     }
 
@@ -1847,8 +4110,10 @@ NAPI_METHOD(iterator_end)
  */
 struct NextWorker final : public BaseWorker
 {
-    NextWorker(napi_env env, Iterator *iterator, napi_value callback)
-        : BaseWorker(env, iterator->database_, callback, "leveldown.iterator.next"), iterator_(iterator), ok_()
+    NextWorker(napi_env env, Iterator *iterator, napi_value callback, const bool packed)
+        : BaseWorker(env, iterator->database_, callback, "leveldown.iterator.next",
+                     iterator->background_ ? workBackground : workRead),
+          iterator_(iterator), packed_(packed), ok_()
     {
     }
 
@@ -1858,14 +4123,30 @@ struct NextWorker final : public BaseWorker
 
     void DoExecute() override
     {
+        const DatabaseMetrics::Clock::time_point start = DatabaseMetrics::Clock::now();
+        size_t bytes = 0;
+
         if (!iterator_->DidSeek())
         {
             iterator_->SeekToRange();
         }
 
-        // Limit the size of the cache to prevent starving the event loop
-        // in JS-land while we're recursively calling process.nextTick().
-        ok_ = iterator_->ReadMany(1000);
+        if (packed_)
+        {
+            // A packed batch is handed over in one go, only its size in bytes is limited.
+            ok_ = iterator_->ReadPacked();
+            bytes = iterator_->packed_.size();
+        }
+        else
+        {
+            // Limit the size of the cache to prevent starving the event loop
+            // in JS-land while we're recursively calling process.nextTick().
+            ok_ = iterator_->ReadMany(1000);
+            for (const std::string &entry : iterator_->cache_)
+                bytes += entry.size();
+        }
+
+        database_->metrics_.Read(opIteratorNext, start, bytes);
 
         if (!ok_)
         {
@@ -1875,20 +4156,34 @@ struct NextWorker final : public BaseWorker
 
     void HandleOKCallback(napi_env env, napi_value callback) override
     {
+        if (packed_)
+        {
+            napi_value argv[3];
+            napi_get_null(env, &argv[0]);
+            Entry::ConvertOwned(env, new std::string(std::move(iterator_->packed_)), true,
+                                iterator_->database_->zeroCopy_, &argv[1]);
+            napi_get_boolean(env, !ok_, &argv[2]);
+            CallFunction(env, callback, 3, argv);
+            return;
+        }
+
         size_t arraySize = iterator_->cache_.size();
         napi_value jsArray;
         napi_create_array_with_length(env, arraySize, &jsArray);
 
+        const bool zeroCopy = iterator_->database_->zeroCopy_;
+
         for (size_t idx = 0; idx < iterator_->cache_.size(); idx += 2)
         {
-            std::string key = iterator_->cache_[idx];
-            std::string value = iterator_->cache_[idx + 1];
+            // the cached strings are refilled by the next ReadMany(), so move them out
+            std::string *key = new std::string(std::move(iterator_->cache_[idx]));
+            std::string *value = new std::string(std::move(iterator_->cache_[idx + 1]));
 
             napi_value returnKey;
             napi_value returnValue;
 
-            Entry::Convert(env, &key, iterator_->keyAsBuffer_, &returnKey);
-            Entry::Convert(env, &value, iterator_->valueAsBuffer_, &returnValue);
+            Entry::ConvertOwned(env, key, iterator_->keyAsBuffer_, zeroCopy, &returnKey);
+            Entry::ConvertOwned(env, value, iterator_->valueAsBuffer_, zeroCopy, &returnValue);
 
             // put the key & value in a descending order, so that they can be .pop:ed in javascript-land
             napi_set_element(env, jsArray, static_cast<int>(arraySize - idx - 1), returnKey);
@@ -1918,30 +4213,49 @@ struct NextWorker final : public BaseWorker
 
   private:
     Iterator *iterator_;
+    const bool packed_;
     bool ok_;
 };
 
 /**
- * Moves an iterator to next element.
+ * Queues a NextWorker, or calls back with an error if the iterator has ended.
  */
-NAPI_METHOD(iterator_next)
+static void iterator_next_do(napi_env env, Iterator *iterator, napi_value callback, const bool packed)
 {
-    NAPI_ARGV(2);
-    NAPI_ITERATOR_CONTEXT();
-
-    napi_value callback = argv[1];
-
     if (iterator->isEnding_ || iterator->hasEnded_)
     {
         napi_value argv = CreateError(env, "iterator has ended");
         CallFunction(env, callback, 1, &argv);
-
-        NAPI_RETURN_UNDEFINED();
+        return;
     }
 
-    NextWorker *worker = new NextWorker(env, iterator, callback);
+    NextWorker *worker = new NextWorker(env, iterator, callback, packed);
     iterator->nexting_ = true;
     worker->Queue(env);
+}
+
+/**
+ * Moves an iterator to next element.
+ */
+NAPI_METHOD(iterator_next)
+{
+    NAPI_ARGV(2);
+    NAPI_ITERATOR_CONTEXT();
+
+    iterator_next_do(env, iterator, argv[1], false);
+
+    NAPI_RETURN_UNDEFINED();
+}
+
+/**
+ * Reads the next entries of an iterator into a single packed buffer.
+ */
+NAPI_METHOD(iterator_next_packed)
+{
+    NAPI_ARGV(2);
+    NAPI_ITERATOR_CONTEXT();
+
+    iterator_next_do(env, iterator, argv[1], true);
 
     NAPI_RETURN_UNDEFINED();
 }
@@ -1953,7 +4267,7 @@ struct BatchWorker final : public PriorityWorker
 {
     BatchWorker(napi_env env, Database *database, napi_value callback, leveldb::WriteBatch *batch, const bool sync,
                 const bool hasData)
-        : PriorityWorker(env, database, callback, "leveldown.batch.do"), batch_(batch), hasData_(hasData)
+        : PriorityWorker(env, database, callback, "leveldown.batch.do", workWrite), batch_(batch), hasData_(hasData)
     {
         options_.sync = sync;
     }
@@ -2036,12 +4350,119 @@ NAPI_METHOD(batch_do)
         }
     }
 
+    if (database->writeQueue_ != NULL && hasData)
+    {
+        napi_value flushAfter = QueueBatch(env, database, *batch, sync, callback);
+        delete batch;
+        return flushAfter;
+    }
+
     BatchWorker *worker = new BatchWorker(env, database, callback, batch, sync, hasData);
     worker->Queue(env);
 
     NAPI_RETURN_UNDEFINED();
 }
 
+/**
+ * Record tags of a packed batch, the same as LevelDB's.
+ */
+enum PackedOp
+{
+    packedDel = 0x0,
+    packedPut = 0x1
+};
+
+/**
+ * Decodes a packed batch into 'batch'. The packed batch is a sequence of records,
+ * each a tag byte followed by a varint32 length prefixed key and, for puts, a
+ * varint32 length prefixed value. This is the record format of LevelDB's
+ * WriteBatch, so decoding it takes no N-API calls. Returns false if it's malformed.
+ */
+static bool DecodePackedBatch(leveldb::Slice input, leveldb::WriteBatch *batch)
+{
+    while (!input.empty())
+    {
+        const char tag = input[0];
+        input.remove_prefix(1);
+
+        leveldb::Slice key;
+        leveldb::Slice value;
+
+        if (tag == packedPut && GetLengthPrefixedSlice(&input, &key) && GetLengthPrefixedSlice(&input, &value))
+        {
+            batch->Put(key, value);
+        }
+        else if (tag == packedDel && GetLengthPrefixedSlice(&input, &key))
+        {
+            batch->Delete(key);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Worker class for writing a packed batch, which is decoded off the main thread.
+ */
+struct PackedBatchWorker final : public PriorityWorker
+{
+    PackedBatchWorker(napi_env env, Database *database, napi_value callback, const char *data, size_t length,
+                      const bool sync)
+        : PriorityWorker(env, database, callback, "leveldown.batch.packed", workWrite), ops_(data, length)
+    {
+        options_.sync = sync;
+    }
+
+    void DoExecute() override
+    {
+        leveldb::WriteBatch batch;
+        if (!DecodePackedBatch(ops_, &batch))
+        {
+            SetStatus(leveldb::Status::Corruption("malformed packed batch"));
+            return;
+        }
+
+        if (!ops_.empty())
+        {
+            SetStatus(database_->WriteBatch(options_, &batch));
+        }
+    }
+
+  private:
+    leveldb::WriteOptions options_;
+    const std::string ops_;
+};
+
+/**
+ * Does a batch write operation with a packed batch.
+ */
+NAPI_METHOD(batch_packed)
+{
+    NAPI_ARGV(4);
+    NAPI_DB_CONTEXT();
+
+    char *data = NULL;
+    size_t length = 0;
+    NAPI_STATUS_THROWS(napi_get_buffer_info(env, argv[1], (void **)&data, &length));
+    const bool sync = BooleanProperty(env, argv[2], "sync", false);
+    napi_value callback = argv[3];
+
+    // With coalesced writes the batch is decoded here to keep its place in the queue,
+    // a malformed one is still reported by the worker
+    leveldb::WriteBatch batch;
+    if (database->writeQueue_ != NULL && length > 0 && DecodePackedBatch(leveldb::Slice(data, length), &batch))
+        return QueueBatch(env, database, batch, sync, callback);
+
+    PackedBatchWorker *worker = new PackedBatchWorker(env, database, callback, data, length, sync);
+    worker->Queue(env);
+
+    NAPI_RETURN_UNDEFINED();
+}
+
 /**
  * Owns a WriteBatch.
  */
@@ -2163,7 +4584,8 @@ NAPI_METHOD(batch_clear)
 struct BatchWriteWorker final : public PriorityWorker
 {
     BatchWriteWorker(napi_env env, napi_value context, Batch *batch, napi_value callback, const bool sync)
-        : PriorityWorker(env, batch->database_, callback, "leveldown.batch.write"), batch_(batch), sync_(sync)
+        : PriorityWorker(env, batch->database_, callback, "leveldown.batch.write", workWrite), batch_(batch),
+          sync_(sync)
     {
         // Prevent GC of batch object before we execute
         NAPI_STATUS_THROWS_VOID(napi_create_reference(env, context, 1, &contextRef_));
@@ -2205,12 +4627,85 @@ NAPI_METHOD(batch_write)
     const bool sync = BooleanProperty(env, options, "sync", false);
     napi_value callback = argv[2];
 
+    if (batch->database_->writeQueue_ != NULL && batch->hasData_)
+        return QueueBatch(env, batch->database_, *batch->batch_, sync, callback);
+
     BatchWriteWorker *worker = new BatchWriteWorker(env, argv[0], batch, callback, sync);
     worker->Queue(env);
 
     NAPI_RETURN_UNDEFINED();
 }
 
+/**
+ * Starts the addon thread pool. Work queued from then on runs on it instead
+ * of the libuv thread pool. Can only be done once per process.
+ */
+NAPI_METHOD(threadpool_configure)
+{
+    NAPI_ARGV(1);
+
+    static std::mutex configureMutex;
+
+    napi_value options = argv[0];
+    const uint32_t size = Uint32Property(env, options, "size", std::max(4u, std::thread::hardware_concurrency()));
+    const uint32_t maxBackground = Uint32Property(env, options, "maxBackground", std::max(1u, size / 2));
+    const uint32_t maxWait = Uint32Property(env, options, "maxWait", 100);
+
+    if (size == 0)
+    {
+        napi_throw_error(env, NULL, "thread pool size must be positive");
+        return NULL;
+    }
+
+    std::lock_guard<std::mutex> lock(configureMutex);
+    if (threadPool.load() != NULL)
+    {
+        napi_throw_error(env, NULL, "thread pool is already configured");
+        return NULL;
+    }
+    threadPool.store(new ThreadPool(size, std::min(std::max(maxBackground, 1u), size), maxWait));
+
+    NAPI_RETURN_UNDEFINED();
+}
+
+/**
+ * Returns queue depths and latencies of the addon thread pool per priority
+ * class, or undefined if it's not configured. Times are in microseconds.
+ */
+NAPI_METHOD(threadpool_stats)
+{
+    ThreadPool *pool = threadPool.load();
+    if (pool == NULL)
+        NAPI_RETURN_UNDEFINED();
+
+    static const char *const names[workClasses] = {"read", "write", "background"};
+    const std::vector<WorkStats> stats = pool->Stats();
+
+    napi_value result;
+    NAPI_STATUS_THROWS(napi_create_object(env, &result));
+    SetNumberProperty(env, result, "size", pool->size_);
+    SetNumberProperty(env, result, "maxBackground", pool->maxBackground_);
+    SetNumberProperty(env, result, "maxWait",
+                      (double)std::chrono::duration_cast<std::chrono::milliseconds>(pool->maxWait_).count());
+
+    for (size_t i = 0; i < workClasses; i++)
+    {
+        const WorkStats &s = stats[i];
+        napi_value entry;
+        NAPI_STATUS_THROWS(napi_create_object(env, &entry));
+        SetNumberProperty(env, entry, "queued", s.queued_);
+        SetNumberProperty(env, entry, "running", s.running_);
+        SetNumberProperty(env, entry, "completed", (double)s.completed_);
+        SetNumberProperty(env, entry, "aged", (double)s.aged_);
+        SetNumberProperty(env, entry, "avgWait", s.completed_ > 0 ? (double)s.waitTime_ / s.completed_ : 0);
+        SetNumberProperty(env, entry, "maxWait", (double)s.maxWaitTime_);
+        SetNumberProperty(env, entry, "avgRun", s.completed_ > 0 ? (double)s.runTime_ / s.completed_ : 0);
+        NAPI_STATUS_THROWS(napi_set_named_property(env, result, names[i], entry));
+    }
+
+    return result;
+}
+
 /**
  * All exported functions.
  */
@@ -2222,25 +4717,42 @@ NAPI_INIT()
     NAPI_EXPORT_FUNCTION(db_close);
     NAPI_EXPORT_FUNCTION(db_put);
     NAPI_EXPORT_FUNCTION(db_get);
+    NAPI_EXPORT_FUNCTION(db_get_sync_cached);
     NAPI_EXPORT_FUNCTION(db_get_many);
     NAPI_EXPORT_FUNCTION(db_del);
+    NAPI_EXPORT_FUNCTION(db_flush_writes);
     NAPI_EXPORT_FUNCTION(db_clear);
     NAPI_EXPORT_FUNCTION(db_approximate_size);
     NAPI_EXPORT_FUNCTION(db_compact_range);
     NAPI_EXPORT_FUNCTION(db_get_property);
+    NAPI_EXPORT_FUNCTION(db_cache_stats);
+    NAPI_EXPORT_FUNCTION(db_metrics);
+
+    NAPI_EXPORT_FUNCTION(shared_cache_init);
+    NAPI_EXPORT_FUNCTION(shared_cache_stats);
 
     NAPI_EXPORT_FUNCTION(destroy_db);
     NAPI_EXPORT_FUNCTION(repair_db);
 
+    NAPI_EXPORT_FUNCTION(snapshot_init);
+    NAPI_EXPORT_FUNCTION(snapshot_expose);
+    NAPI_EXPORT_FUNCTION(snapshot_unexpose);
+    NAPI_EXPORT_FUNCTION(snapshot_release);
+
     NAPI_EXPORT_FUNCTION(iterator_init);
     NAPI_EXPORT_FUNCTION(iterator_seek);
     NAPI_EXPORT_FUNCTION(iterator_end);
     NAPI_EXPORT_FUNCTION(iterator_next);
+    NAPI_EXPORT_FUNCTION(iterator_next_packed);
 
     NAPI_EXPORT_FUNCTION(batch_do);
+    NAPI_EXPORT_FUNCTION(batch_packed);
     NAPI_EXPORT_FUNCTION(batch_init);
     NAPI_EXPORT_FUNCTION(batch_put);
     NAPI_EXPORT_FUNCTION(batch_del);
     NAPI_EXPORT_FUNCTION(batch_clear);
     NAPI_EXPORT_FUNCTION(batch_write);
+
+    NAPI_EXPORT_FUNCTION(threadpool_configure);
+    NAPI_EXPORT_FUNCTION(threadpool_stats);
 }
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <leveldb/db.h>
+
+/**
+ * Handles the leveldb binding hands to native code of other addons, like the
+ * EVM binding. The addons are built together but don't link each other, they
+ * only share these classes.
+ */
+namespace leveldown
+{
+
+/**
+ * A database exposed by db_expose(), it forwards to LevelDB. Once the database
+ * is closed every leveldb::DB method fails with an InvalidArgument status (or
+ * does nothing), closing waits for calls and iterators in flight. Everything
+ * but the leveldb::DB methods may only be called on the main thread.
+ */
+struct ExposedDB : public leveldb::DB
+{
+    typedef void (*CloseHook)(void *arg);
+
+    /**
+     * Runs hook(arg) when db.close() is called, before anything is closed, so
+     * the owner of 'arg' can write what it buffers. Hooks run once.
+     */
+    virtual void AddCloseHook(CloseHook hook, void *arg) = 0;
+
+    virtual void RemoveCloseHook(CloseHook hook, void *arg) = 0;
+
+    /**
+     * Keeps this object alive, not the database.
+     */
+    virtual void Ref() = 0;
+
+    virtual void Unref() = 0;
+
+    /**
+     * Keeps the database open until AllowClose(), for work reading or writing
+     * it off the main thread. Returns false, deferring nothing, once the
+     * database is closing.
+     */
+    virtual bool DeferClose() = 0;
+
+    virtual void AllowClose() = 0;
+
+  protected:
+    virtual ~ExposedDB()
+    {
+    }
+};
+
+/**
+ * A snapshot exposed by snapshot_expose(). Pin() and Unpin() may only be
+ * called on the main thread.
+ */
+struct ExposedSnapshot
+{
+    /**
+     * Returns the leveldb snapshot and holds it until Unpin(). Returns NULL,
+     * holding nothing, once the snapshot is unexposed or its database closing.
+     */
+    virtual const leveldb::Snapshot *Pin() = 0;
+
+    virtual void Unpin() = 0;
+
+  protected:
+    virtual ~ExposedSnapshot()
+    {
+    }
+};
+
+} // namespace leveldown
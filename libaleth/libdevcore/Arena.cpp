@@ -0,0 +1,71 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include "Arena.h"
+
+#include <atomic>
+
+namespace dev
+{
+namespace
+{
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_bytes{0};
+std::atomic<uint64_t> g_chunkAllocations{0};
+std::atomic<uint64_t> g_resets{0};
+}  // namespace
+
+void* Arena::do_allocate(size_t _bytes, size_t _alignment)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(_bytes, std::memory_order_relaxed);
+
+    // Try the current chunk, then the retained ones, and allocate a new chunk at last.
+    for (; m_current < m_chunks.size(); ++m_current, m_used = 0)
+    {
+        Chunk const& chunk = m_chunks[m_current];
+        uintptr_t const base = reinterpret_cast<uintptr_t>(chunk.data.get());
+        size_t const offset = ((base + m_used + _alignment - 1) & ~(_alignment - 1)) - base;
+        if (offset + _bytes <= chunk.size)
+        {
+            m_used = offset + _bytes;
+            return chunk.data.get() + offset;
+        }
+    }
+
+    // A chunk is aligned for any fundamental type, over-aligned requests get extra room.
+    size_t const size = std::max(m_chunkSize, _bytes + _alignment);
+    g_chunkAllocations.fetch_add(1, std::memory_order_relaxed);
+    m_chunks.push_back({std::make_unique<std::byte[]>(size), size});
+    m_current = m_chunks.size() - 1;
+    uintptr_t const base = reinterpret_cast<uintptr_t>(m_chunks.back().data.get());
+    size_t const offset = ((base + _alignment - 1) & ~(_alignment - 1)) - base;
+    m_used = offset + _bytes;
+    return m_chunks.back().data.get() + offset;
+}
+
+void Arena::reset() noexcept
+{
+    g_resets.fetch_add(1, std::memory_order_relaxed);
+
+    size_t retained = 0;
+    size_t kept = 0;
+    for (; kept < m_chunks.size() && retained + m_chunks[kept].size <= c_retainedBytes; ++kept)
+        retained += m_chunks[kept].size;
+    m_chunks.resize(kept);
+    m_current = 0;
+    m_used = 0;
+}
+
+ArenaStats Arena::stats()
+{
+    ArenaStats ret;
+    ret.allocations = g_allocations.load(std::memory_order_relaxed);
+    ret.bytes = g_bytes.load(std::memory_order_relaxed);
+    ret.chunkAllocations = g_chunkAllocations.load(std::memory_order_relaxed);
+    ret.resets = g_resets.load(std::memory_order_relaxed);
+    return ret;
+}
+
+}  // namespace dev
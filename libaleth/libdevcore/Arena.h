@@ -0,0 +1,72 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Bump allocator for short-lived containers
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace dev
+{
+/// Allocations of all arenas of the process.
+struct ArenaStats
+{
+    uint64_t allocations = 0;       ///< Allocations served by arenas.
+    uint64_t bytes = 0;             ///< Bytes handed out by arenas.
+    uint64_t chunkAllocations = 0;  ///< Chunks allocated from the heap for them.
+    uint64_t resets = 0;
+};
+
+/**
+ * @brief Memory resource handing out memory from chunks by bumping a pointer, deallocation does
+ * nothing. reset() makes all memory available again at once and keeps the chunks for reuse, so an
+ * arena that is reset after every transaction stops allocating from the heap once it has grown
+ * to the needs of a transaction.
+ *
+ * Not thread-safe.
+ */
+class Arena : public std::pmr::memory_resource
+{
+public:
+    explicit Arena(size_t _chunkSize = 16 * 1024) : m_chunkSize(_chunkSize) {}
+
+    Arena(Arena const&) = delete;
+    Arena& operator=(Arena const&) = delete;
+
+    /// Makes all memory of the arena available again.
+    /// Nothing allocated from the arena may be used afterwards.
+    void reset() noexcept;
+
+    static ArenaStats stats();
+
+private:
+    void* do_allocate(size_t _bytes, size_t _alignment) override;
+    void do_deallocate(void*, size_t, size_t) noexcept override {}
+    bool do_is_equal(std::pmr::memory_resource const& _other) const noexcept override
+    {
+        return this == &_other;
+    }
+
+    struct Chunk
+    {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    /// Chunks beyond this size in total are freed on reset, after a transaction that was
+    /// unusually large.
+    static constexpr size_t c_retainedBytes = 1024 * 1024;
+
+    size_t m_chunkSize;
+    std::vector<Chunk> m_chunks;
+    size_t m_current = 0;  ///< Index of the chunk allocated from.
+    size_t m_used = 0;     ///< Bytes used of the current chunk.
+};
+
+}  // namespace dev
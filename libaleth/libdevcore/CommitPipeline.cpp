@@ -0,0 +1,199 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "CommitPipeline.h"
+#include "Log.h"
+
+namespace dev
+{
+namespace
+{
+inline db::Slice toSlice(h256 const& _h)
+{
+    return db::Slice(reinterpret_cast<char const*>(_h.data()), _h.size);
+}
+
+inline db::Slice toSlice(std::string const& _str)
+{
+    return db::Slice(_str.data(), _str.size());
+}
+
+inline db::Slice toSlice(bytes const& _b)
+{
+    return db::Slice(reinterpret_cast<char const*>(_b.data()), _b.size());
+}
+}  // namespace
+
+CommitPipeline::CommitPipeline(std::shared_ptr<db::DatabaseFace> _db, size_t _maxInFlight)
+  : m_db(std::move(_db)), m_maxInFlight(std::max<size_t>(1, _maxInFlight))
+{
+    m_writer = std::thread([this]() {
+        setThreadName("commit");
+        writeLoop();
+    });
+}
+
+CommitPipeline::~CommitPipeline()
+{
+    {
+        std::lock_guard<std::mutex> l(x_queue);
+        m_stopping = true;
+    }
+    m_queueChanged.notify_all();
+    m_writer.join();
+}
+
+uint64_t CommitPipeline::push(MainEntries&& _main, AuxEntries&& _aux, bool _sync)
+{
+    std::unique_lock<std::mutex> l(x_queue);
+    m_queueChanged.wait(l, [this]() { return m_queue.size() < m_maxInFlight; });
+    if (m_error)
+        std::rethrow_exception(m_error);
+
+    uint64_t const seq = ++m_lastPushed;
+    auto batch = std::make_shared<Batch>();
+    batch->seq = seq;
+    batch->main = std::move(_main);
+    batch->aux = std::move(_aux);
+    batch->sync = _sync;
+    m_queue.push_back(std::move(batch));
+
+    l.unlock();
+    m_queueChanged.notify_all();
+    return seq;
+}
+
+void CommitPipeline::waitWritten(uint64_t _seq)
+{
+    std::unique_lock<std::mutex> l(x_queue);
+    m_queueChanged.wait(l, [&]() { return m_lastWritten >= _seq; });
+    if (m_error)
+        std::rethrow_exception(m_error);
+}
+
+void CommitPipeline::flush()
+{
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> l(x_queue);
+        seq = m_lastPushed;
+    }
+    waitWritten(seq);
+}
+
+bool CommitPipeline::lookup(h256 const& _h, std::string& o_value) const
+{
+    std::lock_guard<std::mutex> l(x_queue);
+    for (auto it = m_queue.rbegin(); it != m_queue.rend(); ++it)
+    {
+        auto found = (*it)->main.find(_h);
+        if (found != (*it)->main.end())
+        {
+            o_value = found->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CommitPipeline::lookupAux(h256 const& _h, bytes& o_value) const
+{
+    std::lock_guard<std::mutex> l(x_queue);
+    for (auto it = m_queue.rbegin(); it != m_queue.rend(); ++it)
+    {
+        auto found = (*it)->aux.find(_h);
+        if (found != (*it)->aux.end())
+        {
+            o_value = found->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t CommitPipeline::inFlight() const
+{
+    std::lock_guard<std::mutex> l(x_queue);
+    return m_queue.size();
+}
+
+void CommitPipeline::writeLoop()
+{
+    while (true)
+    {
+        std::shared_ptr<Batch const> batch;
+        {
+            std::unique_lock<std::mutex> l(x_queue);
+            m_queueChanged.wait(l, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty())
+                return;
+            // leave the batch in the queue so it stays readable while it is written
+            batch = m_queue.front();
+        }
+
+        bool const written = write(*batch);
+
+        {
+            std::lock_guard<std::mutex> l(x_queue);
+            if (written)
+            {
+                m_queue.pop_front();
+                m_lastWritten = batch->seq;
+            }
+            else
+            {
+                // nothing queued can be written after the failed batch, waiters get the error
+                m_queue.clear();
+                m_lastWritten = m_lastPushed;
+            }
+        }
+        m_queueChanged.notify_all();
+    }
+}
+
+bool CommitPipeline::write(Batch const& _batch)
+{
+    for (unsigned i = 0; i < 10; ++i)
+    {
+        auto writeBatch = m_db->createWriteBatch();
+        for (auto const& entry: _batch.main)
+            writeBatch->insert(toSlice(entry.first), toSlice(entry.second));
+        for (auto const& entry: _batch.aux)
+        {
+            bytes b = entry.first.asBytes();
+            b.push_back(255);   // for aux
+            writeBatch->insert(toSlice(b), toSlice(entry.second));
+        }
+
+        try
+        {
+            if (_batch.sync)
+                m_db->commitSynced(std::move(writeBatch));
+            else
+                m_db->commit(std::move(writeBatch));
+            return true;
+        }
+        catch (boost::exception const& ex)
+        {
+            if (!db::isTransient(ex))
+            {
+                cwarn << "Error writing to state database, dropping queued commits: "
+                      << boost::diagnostic_information(ex);
+                std::lock_guard<std::mutex> l(x_queue);
+                m_error = std::current_exception();
+                return false;
+            }
+            if (i == 9)
+            {
+                cwarn << "Fail writing to state database. Bombing out.";
+                exit(-1);
+            }
+            cwarn << "Error writing to state database: " << boost::diagnostic_information(ex);
+            cwarn << "Sleeping for" << (i + 1) << "seconds, then retrying.";
+            std::this_thread::sleep_for(std::chrono::seconds(i + 1));
+        }
+    }
+    return false;
+}
+
+}
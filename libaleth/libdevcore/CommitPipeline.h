@@ -0,0 +1,110 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#pragma once
+
+#include "Common.h"
+#include "FixedHash.h"
+#include "db.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace dev
+{
+
+/// When OverlayDB::commit() returns.
+enum class Durability
+{
+    /// Once the changes are queued, readers see them but a crash may lose them.
+    Acknowledged,
+    /// Once the changes are written to the database.
+    Written,
+    /// Once the changes are written to the database and synced to disk.
+    Synced
+};
+
+/// Durability of an OverlayDB unless set otherwise, the one of commits without a CommitPipeline.
+constexpr Durability c_defaultDurability = Durability::Written;
+
+/**
+ * Writes committed overlays on a background thread.
+ *
+ * Batches are written strictly in the order they were pushed. Until a batch
+ * is written it stays readable through lookup() and lookupAux(), so the next
+ * execution can go on reading the state it just committed.
+ *
+ * IO errors are retried. Any other write error, like the database being closed,
+ * drops every queued batch and is thrown again by push(), waitWritten() and flush().
+ */
+class CommitPipeline
+{
+public:
+    using MainEntries = std::unordered_map<h256, std::string>;
+    using AuxEntries = std::unordered_map<h256, bytes>;
+
+    /// @param _maxInFlight Number of queued batches push() blocks at.
+    explicit CommitPipeline(std::shared_ptr<db::DatabaseFace> _db, size_t _maxInFlight = 64);
+
+    /// Writes every queued batch, then stops the writer thread. Never throws.
+    ~CommitPipeline();
+
+    CommitPipeline(CommitPipeline const&) = delete;
+    CommitPipeline& operator=(CommitPipeline const&) = delete;
+
+    /// Queues a batch for writing, blocks while too many batches are in flight.
+    /// @returns the sequence number of the batch.
+    uint64_t push(MainEntries&& _main, AuxEntries&& _aux, bool _sync);
+
+    /// Blocks until the batch @a _seq and every batch before it are written.
+    void waitWritten(uint64_t _seq);
+
+    /// Blocks until every queued batch is written.
+    void flush();
+
+    /// Looks @a _h up in the queued batches, newest first.
+    /// @returns false if no queued batch contains it.
+    bool lookup(h256 const& _h, std::string& o_value) const;
+
+    /// Looks the aux entry @a _h up in the queued batches, newest first.
+    /// @returns false if no queued batch contains it.
+    bool lookupAux(h256 const& _h, bytes& o_value) const;
+
+    /// @returns the number of batches not written yet.
+    size_t inFlight() const;
+
+private:
+    struct Batch
+    {
+        uint64_t seq;
+        MainEntries main;
+        AuxEntries aux;
+        bool sync;
+    };
+
+    void writeLoop();
+    /// @returns false if the batch can't be written, having set m_error.
+    bool write(Batch const& _batch);
+
+    std::shared_ptr<db::DatabaseFace> m_db;
+    size_t const m_maxInFlight;
+
+    mutable std::mutex x_queue;
+    std::condition_variable m_queueChanged;
+    /// Batches not written yet, the front one is being written.
+    std::deque<std::shared_ptr<Batch const>> m_queue;
+    uint64_t m_lastPushed = 0;
+    uint64_t m_lastWritten = 0;
+    bool m_stopping = false;
+    /// The write error that stopped writing.
+    std::exception_ptr m_error;
+
+    std::thread m_writer;
+};
+
+}
@@ -99,6 +99,13 @@ std::unique_ptr<DatabaseFace> DBFactory::create(void* db)
     return create(DatabaseKind::ExternalLevelDB, databasePath(), db);
 }
 
+std::unique_ptr<DatabaseFace> DBFactory::create(void* db, void const* snapshot)
+{
+    leveldb::ReadOptions readOptions = ExternalLevelDB::defaultReadOptions();
+    readOptions.snapshot = static_cast<leveldb::Snapshot const*>(snapshot);
+    return std::unique_ptr<DatabaseFace>(new ExternalLevelDB(db, readOptions));
+}
+
 std::unique_ptr<DatabaseFace> DBFactory::create(fs::path const& _path)
 {
     return create(g_kind, _path);
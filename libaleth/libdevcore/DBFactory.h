@@ -35,6 +35,8 @@ public:
 
     static std::unique_ptr<DatabaseFace> create();
     static std::unique_ptr<DatabaseFace> create(void* db);
+    /// Reads @a db at the leveldb snapshot @a snapshot, writes are not affected by it.
+    static std::unique_ptr<DatabaseFace> create(void* db, void const* snapshot);
     static std::unique_ptr<DatabaseFace> create(boost::filesystem::path const& _path);
     static std::unique_ptr<DatabaseFace> create(DatabaseKind _kind);
     static std::unique_ptr<DatabaseFace> create(
@@ -25,6 +25,10 @@ DatabaseStatus toDatabaseStatus(leveldb::Status const& _status)
         return DatabaseStatus::Corruption;
     else if (_status.IsNotFound())
         return DatabaseStatus::NotFound;
+    else if (_status.IsNotSupportedError())
+        return DatabaseStatus::NotSupported;
+    else if (_status.IsInvalidArgument())
+        return DatabaseStatus::InvalidArgument;
     else
         return DatabaseStatus::Unknown;
 }
@@ -66,6 +70,21 @@ void LevelDBWriteBatch::kill(Slice _key)
     m_writeBatch.Delete(toLDBSlice(_key));
 }
 
+leveldb::WriteBatch& toLDBWriteBatch(WriteBatchFace* _batch)
+{
+    if (!_batch)
+    {
+        BOOST_THROW_EXCEPTION(DatabaseError() << errinfo_comment("Cannot commit null batch"));
+    }
+    auto* batchPtr = dynamic_cast<LevelDBWriteBatch*>(_batch);
+    if (!batchPtr)
+    {
+        BOOST_THROW_EXCEPTION(
+            DatabaseError() << errinfo_comment("Invalid batch type passed to LevelDB::commit"));
+    }
+    return batchPtr->writeBatch();
+}
+
 }  // namespace
 
 leveldb::ReadOptions LevelDB::defaultReadOptions()
@@ -144,21 +163,37 @@ std::unique_ptr<WriteBatchFace> LevelDB::createWriteBatch() const
 
 void LevelDB::commit(std::unique_ptr<WriteBatchFace> _batch)
 {
-    if (!_batch)
+    auto const status = m_db->Write(m_writeOptions, &toLDBWriteBatch(_batch.get()));
+    checkStatus(status);
+}
+
+void LevelDB::commitSynced(std::unique_ptr<WriteBatchFace> _batch)
+{
+    leveldb::WriteOptions options = m_writeOptions;
+    options.sync = true;
+    auto const status = m_db->Write(options, &toLDBWriteBatch(_batch.get()));
+    checkStatus(status);
+}
+
+void LevelDB::forEach(std::function<bool(Slice, Slice)> _f) const
+{
+    std::unique_ptr<leveldb::Iterator> itr(m_db->NewIterator(m_readOptions));
+    if (itr == nullptr)
     {
-        BOOST_THROW_EXCEPTION(DatabaseError() << errinfo_comment("Cannot commit null batch"));
+        BOOST_THROW_EXCEPTION(DatabaseError() << errinfo_comment("null iterator"));
     }
-    auto* batchPtr = dynamic_cast<LevelDBWriteBatch*>(_batch.get());
-    if (!batchPtr)
+    auto keepIterating = true;
+    for (itr->SeekToFirst(); keepIterating && itr->Valid(); itr->Next())
     {
-        BOOST_THROW_EXCEPTION(
-            DatabaseError() << errinfo_comment("Invalid batch type passed to LevelDB::commit"));
+        auto const dbKey = itr->key();
+        auto const dbValue = itr->value();
+        Slice const key(dbKey.data(), dbKey.size());
+        Slice const value(dbValue.data(), dbValue.size());
+        keepIterating = _f(key, value);
     }
-    auto const status = m_db->Write(m_writeOptions, &batchPtr->writeBatch());
-    checkStatus(status);
 }
 
-void LevelDB::forEach(std::function<bool(Slice, Slice)> _f) const
+void LevelDB::forEachFrom(Slice _start, std::function<bool(Slice, Slice)> _f) const
 {
     std::unique_ptr<leveldb::Iterator> itr(m_db->NewIterator(m_readOptions));
     if (itr == nullptr)
@@ -166,7 +201,7 @@ void LevelDB::forEach(std::function<bool(Slice, Slice)> _f) const
         BOOST_THROW_EXCEPTION(DatabaseError() << errinfo_comment("null iterator"));
     }
     auto keepIterating = true;
-    for (itr->SeekToFirst(); keepIterating && itr->Valid(); itr->Next())
+    for (itr->Seek(toLDBSlice(_start)); keepIterating && itr->Valid(); itr->Next())
     {
         auto const dbKey = itr->key();
         auto const dbValue = itr->value();
@@ -247,21 +282,37 @@ std::unique_ptr<WriteBatchFace> ExternalLevelDB::createWriteBatch() const
 
 void ExternalLevelDB::commit(std::unique_ptr<WriteBatchFace> _batch)
 {
-    if (!_batch)
+    auto const status = m_db->Write(m_writeOptions, &toLDBWriteBatch(_batch.get()));
+    checkStatus(status);
+}
+
+void ExternalLevelDB::commitSynced(std::unique_ptr<WriteBatchFace> _batch)
+{
+    leveldb::WriteOptions options = m_writeOptions;
+    options.sync = true;
+    auto const status = m_db->Write(options, &toLDBWriteBatch(_batch.get()));
+    checkStatus(status);
+}
+
+void ExternalLevelDB::forEach(std::function<bool(Slice, Slice)> _f) const
+{
+    std::unique_ptr<leveldb::Iterator> itr(m_db->NewIterator(m_readOptions));
+    if (itr == nullptr)
     {
-        BOOST_THROW_EXCEPTION(DatabaseError() << errinfo_comment("Cannot commit null batch"));
+        BOOST_THROW_EXCEPTION(DatabaseError() << errinfo_comment("null iterator"));
     }
-    auto* batchPtr = dynamic_cast<LevelDBWriteBatch*>(_batch.get());
-    if (!batchPtr)
+    auto keepIterating = true;
+    for (itr->SeekToFirst(); keepIterating && itr->Valid(); itr->Next())
     {
-        BOOST_THROW_EXCEPTION(
-            DatabaseError() << errinfo_comment("Invalid batch type passed to LevelDB::commit"));
+        auto const dbKey = itr->key();
+        auto const dbValue = itr->value();
+        Slice const key(dbKey.data(), dbKey.size());
+        Slice const value(dbValue.data(), dbValue.size());
+        keepIterating = _f(key, value);
     }
-    auto const status = m_db->Write(m_writeOptions, &batchPtr->writeBatch());
-    checkStatus(status);
 }
 
-void ExternalLevelDB::forEach(std::function<bool(Slice, Slice)> _f) const
+void ExternalLevelDB::forEachFrom(Slice _start, std::function<bool(Slice, Slice)> _f) const
 {
     std::unique_ptr<leveldb::Iterator> itr(m_db->NewIterator(m_readOptions));
     if (itr == nullptr)
@@ -269,7 +320,7 @@ void ExternalLevelDB::forEach(std::function<bool(Slice, Slice)> _f) const
         BOOST_THROW_EXCEPTION(DatabaseError() << errinfo_comment("null iterator"));
     }
     auto keepIterating = true;
-    for (itr->SeekToFirst(); keepIterating && itr->Valid(); itr->Next())
+    for (itr->Seek(toLDBSlice(_start)); keepIterating && itr->Valid(); itr->Next())
     {
         auto const dbKey = itr->key();
         auto const dbValue = itr->value();
@@ -33,8 +33,10 @@ public:
 
     std::unique_ptr<WriteBatchFace> createWriteBatch() const override;
     void commit(std::unique_ptr<WriteBatchFace> _batch) override;
+    void commitSynced(std::unique_ptr<WriteBatchFace> _batch) override;
 
     void forEach(std::function<bool(Slice, Slice)> _f) const override;
+    void forEachFrom(Slice _start, std::function<bool(Slice, Slice)> _f) const override;
 
 private:
     std::unique_ptr<leveldb::DB> m_db;
@@ -62,8 +64,10 @@ public:
 
     std::unique_ptr<WriteBatchFace> createWriteBatch() const override;
     void commit(std::unique_ptr<WriteBatchFace> _batch) override;
+    void commitSynced(std::unique_ptr<WriteBatchFace> _batch) override;
 
     void forEach(std::function<bool(Slice, Slice)> _f) const override;
+    void forEachFrom(Slice _start, std::function<bool(Slice, Slice)> _f) const override;
 
 private:
     leveldb::DB* m_db;
@@ -3,6 +3,8 @@
 // Licensed under the GNU General Public License, Version 3.
 #include "MemoryDB.h"
 
+#include <algorithm>
+
 namespace dev
 {
 namespace db
@@ -87,5 +89,42 @@ void MemoryDB::forEach(std::function<bool(Slice, Slice)> _f) const
     }
 }
 
+void MemoryDB::forEachFrom(Slice _start, std::function<bool(Slice, Slice)> _f) const
+{
+    // the records are unordered, heap the keys from _start so a walk that stops early
+    // sorts only the keys it visits
+    std::vector<std::string> keys;
+    {
+        Guard lock(m_mutex);
+        std::string const start = _start.toString();
+        for (auto const& e : m_db)
+            if (e.first >= start)
+                keys.push_back(e.first);
+    }
+    std::make_heap(keys.begin(), keys.end(), std::greater<std::string>());
+
+    // visit one record at a time without holding the lock, so _f may write to the database
+    while (!keys.empty())
+    {
+        std::pop_heap(keys.begin(), keys.end(), std::greater<std::string>());
+        std::string const key = std::move(keys.back());
+        keys.pop_back();
+
+        std::string value;
+        {
+            Guard lock(m_mutex);
+            auto const it = m_db.find(key);
+            if (it == m_db.end())
+                continue;
+            value = it->second;
+        }
+
+        if (!_f(Slice(key), Slice(value)))
+        {
+            return;
+        }
+    }
+}
+
 }  // namespace db
 }  // namespace dev
\ No newline at end of file
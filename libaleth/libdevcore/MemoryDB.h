@@ -41,6 +41,7 @@ public:
     // of each record in the database. If `f` returns false, the `forEach`
     // method must return immediately.
     void forEach(std::function<bool(Slice, Slice)> _f) const override;
+    void forEachFrom(Slice _start, std::function<bool(Slice, Slice)> _f) const override;
 
     size_t size() const { return m_db.size(); }
 
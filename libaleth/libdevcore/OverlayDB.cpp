@@ -1,6 +1,7 @@
 // Aleth: Ethereum C++ client, tools and libraries.
 // Copyright 2014-2019 Aleth Authors.
 // Licensed under the GNU General Public License, Version 3.
+#include <cassert>
 #include <thread>
 #include <libdevcore/db.h>
 #include <libdevcore/Common.h>
@@ -31,11 +32,58 @@ inline db::Slice toSlice(bytes const& _b)
 
 OverlayDB::~OverlayDB() = default;
 
+void OverlayDB::setCommitPipeline(std::shared_ptr<CommitPipeline> _pipeline, Durability _durability)
+{
+    if (m_pipeline && m_pipeline != _pipeline)
+        m_pipeline->flush();
+    m_pipeline = std::move(_pipeline);
+    m_durability = _durability;
+}
+
+void OverlayDB::flush()
+{
+    if (m_pipeline)
+        m_pipeline->flush();
+}
+
 void OverlayDB::commit()
 {
-    if (m_db)
+    if (m_db && m_pipeline)
+    {
+        CommitPipeline::MainEntries main;
+        CommitPipeline::AuxEntries aux;
+        h256s written;
+#if DEV_GUARDED_DB
+        DEV_WRITE_GUARDED(x_this)
+#endif
+        {
+            for (auto& i: m_main)
+                if (i.second.second)
+                {
+                    if (m_commitObserver)
+                        written.push_back(i.first);
+                    if (m_witness)
+                        m_witness->noteWritten(i.first);
+                    main.emplace(i.first, std::move(i.second.first));
+                }
+            for (auto& i: m_aux)
+                if (i.second.second)
+                    aux.emplace(i.first, std::move(i.second.first));
+            m_aux.clear();
+            m_main.clear();
+        }
+
+        if (m_commitObserver && !written.empty())
+            m_commitObserver(written);
+
+        uint64_t const seq = m_pipeline->push(std::move(main), std::move(aux), m_durability == Durability::Synced);
+        if (m_durability != Durability::Acknowledged)
+            m_pipeline->waitWritten(seq);
+    }
+    else if (m_db)
     {
         auto writeBatch = m_db->createWriteBatch();
+        h256s written;
 //      cnote << "Committing nodes to disk DB:";
 #if DEV_GUARDED_DB
         DEV_READ_GUARDED(x_this)
@@ -44,7 +92,13 @@ void OverlayDB::commit()
             for (auto const& i: m_main)
             {
                 if (i.second.second)
+                {
                     writeBatch->insert(toSlice(i.first), toSlice(i.second.first));
+                    if (m_commitObserver)
+                        written.push_back(i.first);
+                    if (m_witness)
+                        m_witness->noteWritten(i.first);
+                }
 //              cnote << i.first << "#" << m_main[i.first].second;
             }
             for (auto const& i: m_aux)
@@ -56,6 +110,9 @@ void OverlayDB::commit()
                 }
         }
 
+        if (m_commitObserver && !written.empty())
+            m_commitObserver(written);
+
         for (unsigned i = 0; i < 10; ++i)
         {
             try
@@ -65,6 +122,8 @@ void OverlayDB::commit()
             }
             catch (boost::exception const& ex)
             {
+                if (!db::isTransient(ex))
+                    throw;
                 if (i == 9)
                 {
                     cwarn << "Fail writing to state database. Bombing out.";
@@ -85,10 +144,53 @@ void OverlayDB::commit()
     }
 }
 
+OverlayDB OverlayDB::fork() const
+{
+    OverlayDB ret;
+    ret.m_db = m_db;
+    ret.m_pipeline = m_pipeline;
+    ret.m_durability = m_durability;
+    ret.m_parent = this;
+    ret.m_witness = m_witness;
+    return ret;
+}
+
+void OverlayDB::merge(OverlayDB& _fork)
+{
+    assert(_fork.m_parent == this);
+#if DEV_GUARDED_DB
+    WriteGuard l(x_this);
+    WriteGuard l2(_fork.x_this);
+#endif
+    // the reference counts add up as if the fork's inserts and kills had been made here
+    for (auto& i: _fork.m_main)
+    {
+        auto it = m_main.find(i.first);
+        if (it == m_main.end())
+            m_main.emplace(i.first, std::move(i.second));
+        else
+        {
+            it->second.first = std::move(i.second.first);
+            it->second.second += i.second.second;
+        }
+    }
+    for (auto& i: _fork.m_aux)
+        m_aux[i.first] = std::move(i.second);
+    _fork.m_main.clear();
+    _fork.m_aux.clear();
+}
+
 bytes OverlayDB::lookupAux(h256 const& _h) const
 {
     bytes ret = StateCacheDB::lookupAux(_h);
-    if (!ret.empty() || !m_db)
+    if (!ret.empty())
+        return ret;
+    if (m_parent)
+        return m_parent->lookupAux(_h);
+    if (!m_db)
+        return ret;
+
+    if (m_pipeline && m_pipeline->lookupAux(_h, ret))
         return ret;
 
     bytes b = _h.asBytes();
@@ -111,24 +213,38 @@ void OverlayDB::rollback()
 std::string OverlayDB::lookup(h256 const& _h) const
 {
     std::string ret = StateCacheDB::lookup(_h);
-    if (!ret.empty() || !m_db)
+    if (!ret.empty())
+        return ret;
+    if (m_parent)
+        return m_parent->lookup(_h);
+    if (!m_db)
         return ret;
 
-    return m_db->lookup(toSlice(_h));
+    if (!m_pipeline || !m_pipeline->lookup(_h, ret))
+        ret = m_db->lookup(toSlice(_h));
+    if (m_witness && !ret.empty())
+        m_witness->noteRead(_h, bytesConstRef(reinterpret_cast<byte const*>(ret.data()), ret.size()));
+    return ret;
 }
 
 bool OverlayDB::exists(h256 const& _h) const
 {
     if (StateCacheDB::exists(_h))
         return true;
+    if (m_parent)
+        return m_parent->exists(_h);
+    std::string value;
+    if (m_pipeline && m_pipeline->lookup(_h, value))
+        return true;
     return m_db && m_db->exists(toSlice(_h));
 }
 
 void OverlayDB::kill(h256 const& _h)
 {
+    // like the nodes in the database, the nodes of the parent are not dereferenced by a fork
     if (!StateCacheDB::kill(_h))
     {
-        if (m_db)
+        if (m_db && !m_parent)
         {
             if (!m_db->exists(toSlice(_h)))
             {
@@ -4,11 +4,14 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <libdevcore/db.h>
 #include <libdevcore/Common.h>
+#include <libdevcore/CommitPipeline.h>
 #include <libdevcore/Log.h>
 #include <libdevcore/StateCacheDB.h>
+#include <libdevcore/Witness.h>
 
 namespace dev
 {
@@ -41,10 +44,52 @@ public:
 
 	bytes lookupAux(h256 const& _h) const;
 
+    /// Called by commit() with the hashes of the nodes it is about to write, before they are written.
+    using CommitObserver = std::function<void(h256s const&)>;
+    void setCommitObserver(CommitObserver _observer) { m_commitObserver = std::move(_observer); }
+
+    /// Makes commit() hand the changes to a background writer, see CommitPipeline.
+    /// Copies made afterwards share the pipeline. Passing nullptr flushes and goes back to
+    /// synchronous commits.
+    void setCommitPipeline(std::shared_ptr<CommitPipeline> _pipeline, Durability _durability = c_defaultDurability);
+
+    /// The database of this overlay, e.g. to create a CommitPipeline for it.
+    std::shared_ptr<db::DatabaseFace> const& database() const { return m_db; }
+
+    /// Blocks until every change committed so far is written to the database.
+    void flush();
+
+    /// Records the values read from the database and the nodes committed to it in @a _witness.
+    /// Copies and forks made afterwards share the witness. nullptr stops recording.
+    void setWitness(std::shared_ptr<Witness> _witness) { m_witness = std::move(_witness); }
+    std::shared_ptr<Witness> const& witness() const { return m_witness; }
+
+    /// Records @a _value, a value of the database that was found elsewhere, e.g. in a cache.
+    void noteWitnessRead(h256 const& _h, bytesConstRef _value) const
+    {
+        if (m_witness)
+            m_witness->noteRead(_h, _value);
+    }
+
+    /// @returns an empty overlay on top of this one: it reads the nodes of this overlay and
+    /// keeps its own writes, which are not visible here until merge(). A fork is merged instead
+    /// of committed. This overlay must outlive the fork and must not change while it is used.
+    OverlayDB fork() const;
+
+    /// Moves the nodes and aux entries of @a _fork, an overlay returned by fork(), into this one
+    /// in time linear to their number. The fork is left empty.
+    void merge(OverlayDB& _fork);
+
 private:
 	using StateCacheDB::clear;
 
     std::shared_ptr<db::DatabaseFace> m_db;
+    CommitObserver m_commitObserver;
+    std::shared_ptr<CommitPipeline> m_pipeline;
+    Durability m_durability = c_defaultDurability;
+    /// The overlay this one is a fork of, read before the database.
+    OverlayDB const* m_parent = nullptr;
+    std::shared_ptr<Witness> m_witness;
 };
 
 }
@@ -189,5 +189,22 @@ void RocksDB::forEach(std::function<bool(Slice, Slice)> f) const
     }
 }
 
+void RocksDB::forEachFrom(Slice _start, std::function<bool(Slice, Slice)> f) const
+{
+    std::unique_ptr<rocksdb::Iterator> itr(m_db->NewIterator(m_readOptions));
+    if (itr == nullptr)
+        BOOST_THROW_EXCEPTION(DatabaseError() << errinfo_comment("null iterator"));
+
+    auto keepIterating = true;
+    for (itr->Seek(rocksdb::Slice(_start.data(), _start.size())); keepIterating && itr->Valid(); itr->Next())
+    {
+        auto const dbKey = itr->key();
+        auto const dbValue = itr->value();
+        Slice const key(dbKey.data(), dbKey.size());
+        Slice const value(dbValue.data(), dbValue.size());
+        keepIterating = f(key, value);
+    }
+}
+
 }  // namespace db
 }  // namespace dev
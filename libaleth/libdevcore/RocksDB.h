@@ -34,6 +34,7 @@ public:
     void commit(std::unique_ptr<WriteBatchFace> _batch) override;
 
     void forEach(std::function<bool(Slice, Slice)> f) const override;
+    void forEachFrom(Slice _start, std::function<bool(Slice, Slice)> f) const override;
 
 private:
     std::unique_ptr<rocksdb::DB> m_db;
@@ -0,0 +1,129 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#pragma once
+
+#include "Guards.h"
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+namespace dev
+{
+struct SizedLruCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t size = 0;      ///< Bytes charged for the cached values.
+    size_t capacity = 0;  ///< Bytes the cache may use, 0 if it is disabled.
+};
+
+/**
+ * @brief Thread-safe LRU cache bounded by the bytes charged for its values, for caches shared
+ * by all threads of the process. Values are returned by copy, so they are small or shared
+ * pointers.
+ */
+template <class Key, class Value, class Hash = std::hash<Key>>
+class SizedLruCache
+{
+public:
+    /// @a _charge returns the bytes a value is charged, including the overhead of its entry.
+    SizedLruCache(size_t _capacity, std::function<size_t(Value const&)> _charge)
+      : m_charge(std::move(_charge)), m_capacity(_capacity)
+    {}
+
+    /// @returns true and sets @a o_value if @a _key is cached.
+    bool get(Key const& _key, Value& o_value)
+    {
+        Guard l(x_cache);
+        auto it = m_index.find(_key);
+        if (it == m_index.end())
+        {
+            ++m_misses;
+            return false;
+        }
+        ++m_hits;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        o_value = it->second->second;
+        return true;
+    }
+
+    /// Caches @a _value unless @a _key is cached already or the cache is disabled.
+    void insert(Key const& _key, Value _value)
+    {
+        Guard l(x_cache);
+        if (m_capacity == 0 || m_index.find(_key) != m_index.end())
+            return;
+        m_size += m_charge(_value);
+        m_lru.emplace_front(_key, std::move(_value));
+        m_index.emplace(_key, m_lru.begin());
+        evict();
+    }
+
+    /// @returns the cached value of @a _key, or runs @a _make and caches the value it returns.
+    /// @a _make runs without holding the lock, nothing is cached if it throws.
+    template <class F>
+    Value getOrInsert(Key const& _key, F const& _make)
+    {
+        Value value;
+        if (get(_key, value))
+            return value;
+        value = _make();
+        // another thread may have cached the same key meanwhile, insert() keeps that value
+        insert(_key, value);
+        return value;
+    }
+
+    /// Set the number of bytes the cache may use, 0 disables and clears it.
+    void setCapacity(size_t _capacity)
+    {
+        Guard l(x_cache);
+        m_capacity = _capacity;
+        evict();
+    }
+
+    SizedLruCacheStats stats() const
+    {
+        Guard l(x_cache);
+        SizedLruCacheStats stats;
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.evictions = m_evictions;
+        stats.entries = m_index.size();
+        stats.size = m_size;
+        stats.capacity = m_capacity;
+        return stats;
+    }
+
+private:
+    using Entry = std::pair<Key, Value>;
+
+    /// Drop least recently used entries until the cache fits its capacity.
+    void evict()
+    {
+        while (m_size > m_capacity && !m_lru.empty())
+        {
+            m_size -= m_charge(m_lru.back().second);
+            m_index.erase(m_lru.back().first);
+            m_lru.pop_back();
+            ++m_evictions;
+        }
+    }
+
+    std::function<size_t(Value const&)> const m_charge;
+
+    mutable Mutex x_cache;
+    std::list<Entry> m_lru;  ///< Most recently used first.
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> m_index;
+    size_t m_capacity;
+    size_t m_size = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_evictions = 0;
+};
+
+}  // namespace dev
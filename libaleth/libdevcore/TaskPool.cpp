@@ -0,0 +1,128 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "TaskPool.h"
+#include "Log.h"
+
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace dev
+{
+namespace
+{
+/// State of a parallelFor() call, pool threads may start after the call returned.
+struct Loop
+{
+    std::function<void(size_t)> const* f;
+    size_t count;
+    size_t chunks;
+    std::atomic<size_t> next{0};
+
+    std::mutex x_done;
+    std::condition_variable doneChanged;
+    size_t done = 0;
+    std::exception_ptr error;
+
+    /// Runs chunks until none is left.
+    void work()
+    {
+        for (size_t c = next++; c < chunks; c = next++)
+        {
+            std::exception_ptr chunkError;
+            try
+            {
+                for (size_t i = count * c / chunks; i < count * (c + 1) / chunks; ++i)
+                    (*f)(i);
+            }
+            catch (...)
+            {
+                chunkError = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> l(x_done);
+            if (chunkError && !error)
+                error = chunkError;
+            if (++done == chunks)
+                doneChanged.notify_all();
+        }
+    }
+};
+}  // namespace
+
+TaskPool::TaskPool(unsigned _threads)
+{
+    if (_threads == 0)
+        _threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < _threads; ++i)
+        m_threads.emplace_back([this]() {
+            setThreadName("tasks");
+            run();
+        });
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> l(x_tasks);
+        m_stopping = true;
+    }
+    m_tasksChanged.notify_all();
+    for (auto& t: m_threads)
+        t.join();
+}
+
+TaskPool& TaskPool::shared()
+{
+    static TaskPool s_pool;
+    return s_pool;
+}
+
+void TaskPool::parallelFor(size_t _count, size_t _maxChunks, std::function<void(size_t)> const& _f)
+{
+    size_t const chunks = std::min(_count, _maxChunks);
+    if (chunks <= 1)
+    {
+        for (size_t i = 0; i < _count; ++i)
+            _f(i);
+        return;
+    }
+
+    auto loop = std::make_shared<Loop>();
+    loop->f = &_f;
+    loop->count = _count;
+    loop->chunks = chunks;
+    {
+        std::lock_guard<std::mutex> l(x_tasks);
+        for (size_t c = 1; c < std::min<size_t>(chunks, m_threads.size() + 1); ++c)
+            m_tasks.push_back([loop]() { loop->work(); });
+    }
+    m_tasksChanged.notify_all();
+
+    loop->work();
+
+    std::unique_lock<std::mutex> l(loop->x_done);
+    loop->doneChanged.wait(l, [&]() { return loop->done == chunks; });
+    if (loop->error)
+        std::rethrow_exception(loop->error);
+}
+
+void TaskPool::run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> l(x_tasks);
+            m_tasksChanged.wait(l, [this]() { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+}
@@ -0,0 +1,55 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dev
+{
+
+/**
+ * A fixed set of threads running the chunks of parallel loops.
+ *
+ * The calling thread runs chunks too and takes over any chunk no pool thread
+ * has started, so loops make progress when the pool is busy and loops nested
+ * in a chunk can't deadlock.
+ */
+class TaskPool
+{
+public:
+    /// @param _threads Number of pool threads, 0 means one per hardware thread.
+    explicit TaskPool(unsigned _threads = 0);
+
+    /// Stops the pool threads once the queued tasks are done.
+    ~TaskPool();
+
+    TaskPool(TaskPool const&) = delete;
+    TaskPool& operator=(TaskPool const&) = delete;
+
+    /// @returns the pool shared by the process, with one thread per hardware thread.
+    static TaskPool& shared();
+
+    /// @returns the number of pool threads.
+    unsigned threads() const { return static_cast<unsigned>(m_threads.size()); }
+
+    /// Runs @a _f for every index in [0, @a _count), split into at most @a _maxChunks
+    /// chunks. Returns once every chunk is done, throwing the first exception of @a _f.
+    void parallelFor(size_t _count, size_t _maxChunks, std::function<void(size_t)> const& _f);
+
+private:
+    void run();
+
+    std::vector<std::thread> m_threads;
+    std::mutex x_tasks;
+    std::condition_variable m_tasksChanged;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stopping = false;
+};
+
+}
@@ -110,4 +110,34 @@ byte uniqueInUse(RLP const& _orig, byte except)
 	return used;
 }
 
+void forEachChild(RLP const& _node, std::function<void(h256 const&)> const& _child, std::function<void(bytesConstRef)> const& _leaf)
+{
+	auto child = [&](RLP const& _ref)
+	{
+		if (_ref.isList())
+			// nodes shorter than 32 bytes are inlined into their parent
+			forEachChild(_ref, _child, _leaf);
+		else if (_ref.size() == h256::size)
+			_child(_ref.toHash<h256>());
+	};
+
+	if (!_node.isList())
+		return;
+
+	if (_node.itemCount() == 2)
+	{
+		if (isLeaf(_node))
+			_leaf(_node[1].payload());
+		else
+			child(_node[1]);
+	}
+	else if (_node.itemCount() == 17)
+	{
+		for (unsigned i = 0; i < 16; ++i)
+			child(_node[i]);
+		if (!_node[16].isEmpty())
+			_leaf(_node[16].payload());
+	}
+}
+
 }
@@ -7,6 +7,8 @@
 #include "Common.h"
 #include "RLP.h"
 
+#include <functional>
+
 namespace dev
 {
 extern const h256 EmptyTrie;
@@ -100,6 +102,10 @@ inline NibbleSlice keyOf(RLP const& _twoItem)
 }
 
 byte uniqueInUse(RLP const& _orig, byte except);
+
+/// Calls @a _child with the hash of every node referenced by @a _node, descending into
+/// inlined nodes, and @a _leaf with every value stored in @a _node.
+void forEachChild(RLP const& _node, std::function<void(h256 const&)> const& _child, std::function<void(bytesConstRef)> const& _leaf);
 std::string hexPrefixEncode(bytes const& _hexVector, bool _leaf = false, int _begin = 0, int _end = -1);
 std::string hexPrefixEncode(bytesConstRef _data, bool _leaf, int _beginNibble, int _endNibble, unsigned _offset);
 std::string hexPrefixEncode(bytesConstRef _d1, unsigned _o1, bytesConstRef _d2, unsigned _o2, bool _leaf);
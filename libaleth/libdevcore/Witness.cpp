@@ -0,0 +1,64 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "Witness.h"
+
+#include "RLP.h"
+#include "SHA3.h"
+
+#include <map>
+
+namespace dev
+{
+
+void Witness::noteRead(h256 const& _hash, bytesConstRef _value)
+{
+    Guard l(x_this);
+    if (!m_written.count(_hash))
+        m_values.emplace(_hash, _value.toBytes());
+}
+
+void Witness::noteWritten(h256 const& _hash)
+{
+    Guard l(x_this);
+    m_written.insert(_hash);
+}
+
+size_t Witness::size() const
+{
+    Guard l(x_this);
+    return m_values.size();
+}
+
+bytes Witness::rlp() const
+{
+    Guard l(x_this);
+    std::map<h256, bytes const*> ordered;
+    for (auto const& i : m_values)
+        ordered.emplace(i.first, &i.second);
+
+    RLPStream s(ordered.size());
+    for (auto const& i : ordered)
+        s << *i.second;
+    return s.out();
+}
+
+size_t Witness::populate(bytesConstRef _rlp, db::DatabaseFace& _db)
+{
+    RLP const values(_rlp);
+    if (!values.isList())
+        BOOST_THROW_EXCEPTION(BadRLP());
+
+    auto batch = _db.createWriteBatch();
+    for (RLP const& value : values)
+    {
+        bytesConstRef const v = value.toBytesConstRef(RLP::ThrowOnFail);
+        h256 const hash = sha3(v);
+        batch->insert(db::Slice(reinterpret_cast<char const*>(hash.data()), hash.size),
+            db::Slice(reinterpret_cast<char const*>(v.data()), v.size()));
+    }
+    _db.commit(std::move(batch));
+    return values.itemCount();
+}
+
+}  // namespace dev
@@ -0,0 +1,57 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// The trie nodes and code an execution reads, enough to execute it again without the state
+/// database.
+#pragma once
+
+#include "Common.h"
+#include "Exceptions.h"
+#include "FixedHash.h"
+#include "Guards.h"
+#include "db.h"
+
+#include <unordered_map>
+
+namespace dev
+{
+DEV_SIMPLE_EXCEPTION(MissingWitnessNode);
+
+/**
+ * Collects the values read through an OverlayDB, see OverlayDB::setWitness().
+ *
+ * Only values read from the database count, not the ones the overlay holds in memory. A node
+ * committed while recording is left out even if it is read later, executing again writes it
+ * as well. Lookups that find nothing are not noted.
+ *
+ * Thread-safe.
+ */
+class Witness
+{
+public:
+    /// Notes @a _value, read from the database under @a _hash.
+    void noteRead(h256 const& _hash, bytesConstRef _value);
+
+    /// Notes a node written to the database.
+    void noteWritten(h256 const& _hash);
+
+    /// @returns the number of values in the witness.
+    size_t size() const;
+
+    /// @returns the values as an RLP list ordered by their hash, each value once. The hashes
+    /// are not included, they are the Keccak-256 hashes of the values.
+    bytes rlp() const;
+
+    /// Writes the values of @a _rlp, a witness returned by rlp(), to @a _db under their hashes.
+    /// @returns the number of values written.
+    static size_t populate(bytesConstRef _rlp, db::DatabaseFace& _db);
+
+private:
+    mutable Mutex x_this;
+    std::unordered_map<h256, bytes> m_values;
+    h256Hash m_written;
+};
+
+}  // namespace dev
@@ -46,11 +46,20 @@ public:
     virtual std::unique_ptr<WriteBatchFace> createWriteBatch() const = 0;
     virtual void commit(std::unique_ptr<WriteBatchFace> _batch) = 0;
 
+    // Same as `commit`, but only returns once the batch is synced to disk.
+    // Databases that have no notion of syncing may keep the default implementation.
+    virtual void commitSynced(std::unique_ptr<WriteBatchFace> _batch) { commit(std::move(_batch)); }
+
     // A database must implement the `forEach` method that allows the caller
     // to pass in a function `f`, which will be called with the key and value
     // of each record in the database. If `f` returns false, the `forEach`
     // method must return immediately.
     virtual void forEach(std::function<bool(Slice, Slice)> f) const = 0;
+
+    // Same as `forEach`, but visits the records in ascending key order starting
+    // at the first key not less than `_start`. Every call reads from a fresh
+    // iterator, so long walks can be split into short calls.
+    virtual void forEachFrom(Slice _start, std::function<bool(Slice, Slice)> f) const = 0;
 };
 
 DEV_SIMPLE_EXCEPTION(DatabaseError);
@@ -69,5 +78,13 @@ enum class DatabaseStatus
 using errinfo_dbStatusCode = boost::error_info<struct tag_dbStatusCode, DatabaseStatus>;
 using errinfo_dbStatusString = boost::error_info<struct tag_dbStatusString, std::string>;
 
+/// @returns true if the operation that threw @a _ex may succeed when retried, which is
+/// the case for IO errors and errors without a status.
+inline bool isTransient(boost::exception const& _ex)
+{
+    auto const* status = boost::get_error_info<errinfo_dbStatusCode>(_ex);
+    return !status || *status == DatabaseStatus::IOError;
+}
+
 }  // namespace db
 }  // namespace dev
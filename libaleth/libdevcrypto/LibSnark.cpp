@@ -11,6 +11,9 @@
 
 #include <libdevcore/Exceptions.h>
 #include <libdevcore/Log.h>
+#include <libdevcore/SizedLruCache.h>
+
+#include <memory>
 
 using namespace std;
 using namespace dev;
@@ -112,6 +115,56 @@ libff::alt_bn128_G2 decodePointG2(dev::bytesConstRef _data)
 	return p;
 }
 
+/// Miller loop precomputations of valid G2 points, keyed by their encoding.
+/// The verifier contracts pass the same verifying key points in every call, a hit skips the
+/// decoding, the subgroup check and the line function precomputation of such a point.
+class G2PrecompCache
+{
+public:
+	/// nullptr stands for the point at infinity.
+	using Precomp = std::shared_ptr<libff::alt_bn128_G2_precomp const>;
+
+	static G2PrecompCache& instance()
+	{
+		static G2PrecompCache cache;
+		return cache;
+	}
+
+	/// @returns the precomputation of the encoded point, throws InvalidEncoding if the point is
+	/// not on the curve or not an element of the group. Invalid points are never cached.
+	Precomp get(dev::bytesConstRef _data)
+	{
+		return m_cache.getOrInsert(h1024(_data), [&]() {
+			libff::alt_bn128_G2 const p = decodePointG2(_data);
+			if (-libff::alt_bn128_G2::scalar_field::one() * p + p != libff::alt_bn128_G2::zero())
+				// p is not an element of the group (has wrong order)
+				BOOST_THROW_EXCEPTION(InvalidEncoding());
+			Precomp precomp;
+			if (!p.is_zero())
+				precomp = std::make_shared<libff::alt_bn128_G2_precomp const>(libff::alt_bn128_precompute_G2(p));
+			return precomp;
+		});
+	}
+
+private:
+	G2PrecompCache(): m_cache(c_capacity, charge) {}
+
+	/// A precomputation takes about 17 KiB, mostly its line coefficients.
+	static size_t charge(Precomp const& _precomp)
+	{
+		size_t const entry = sizeof(h1024) + 64;
+		if (!_precomp)
+			return entry;
+		return entry + sizeof(libff::alt_bn128_G2_precomp) +
+			_precomp->coeffs.size() * sizeof(libff::alt_bn128_ate_ell_coeffs);
+	}
+
+	/// About 256 verifying key points.
+	static constexpr size_t c_capacity = 4 * 1024 * 1024;
+
+	SizedLruCache<h1024, Precomp, h1024::hash> m_cache;
+};
+
 }
 
 pair<bool, bytes> dev::crypto::alt_bn128_pairing_product(dev::bytesConstRef _in)
@@ -128,22 +181,29 @@ pair<bool, bytes> dev::crypto::alt_bn128_pairing_product(dev::bytesConstRef _in)
 	try
 	{
 		initLibSnark();
-		libff::alt_bn128_Fq12 x = libff::alt_bn128_Fq12::one();
+		vector<pair<libff::alt_bn128_G1_precomp, G2PrecompCache::Precomp>> terms;
+		terms.reserve(pairs);
 		for (size_t i = 0; i < pairs; ++i)
 		{
 			bytesConstRef const pair = _in.cropped(i * pairSize, pairSize);
 			libff::alt_bn128_G1 const g1 = decodePointG1(pair);
-			libff::alt_bn128_G2 const p = decodePointG2(pair.cropped(2 * 32));
-			if (-libff::alt_bn128_G2::scalar_field::one() * p + p != libff::alt_bn128_G2::zero())
-				// p is not an element of the group (has wrong order)
-				return {false, bytes()};
-			if (p.is_zero() || g1.is_zero())
+			G2PrecompCache::Precomp p = G2PrecompCache::instance().get(pair.cropped(2 * 32));
+			if (!p || g1.is_zero())
 				continue; // the pairing is one
-			x = x * libff::alt_bn128_miller_loop(
-				libff::alt_bn128_precompute_G1(g1),
-				libff::alt_bn128_precompute_G2(p)
-			);
+			terms.emplace_back(libff::alt_bn128_precompute_G1(g1), std::move(p));
 		}
+
+		// The Miller loops of two pairs share their squarings, all pairs share one final
+		// exponentiation.
+		libff::alt_bn128_Fq12 x = libff::alt_bn128_Fq12::one();
+		size_t i = 0;
+		for (; i + 1 < terms.size(); i += 2)
+			x = x * libff::alt_bn128_double_miller_loop(
+				terms[i].first, *terms[i].second,
+				terms[i + 1].first, *terms[i + 1].second
+			);
+		if (i < terms.size())
+			x = x * libff::alt_bn128_miller_loop(terms[i].first, *terms[i].second);
 		bool const result = libff::alt_bn128_final_exponentiation(x) == libff::alt_bn128_GT::one();
 		return {true, h256{result}.asBytes()};
 	}
@@ -0,0 +1,246 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include "ModExp.h"
+
+#include <libdevcore/CommonData.h>
+
+#include <array>
+
+// Montgomery multiplication uses the CIOS (coarsely integrated operand scanning) method,
+// see Koc, Acar, Kaliski: "Analyzing and Comparing Montgomery Multiplication Algorithms".
+// The limb count is a template parameter so the inner loops have fixed bounds.
+
+namespace dev
+{
+namespace crypto
+{
+namespace
+{
+using Limb = uint64_t;
+
+/// The largest modulus handled with Montgomery multiplication, in bytes.
+constexpr size_t c_maxMontgomeryBytes = 512;
+
+/// @returns the low limb of _a * _b + _c + io_carry and stores the high limb in io_carry.
+inline Limb mulAdd(Limb _a, Limb _b, Limb _c, Limb& io_carry) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 const t = static_cast<unsigned __int128>(_a) * _b + _c + io_carry;
+    io_carry = static_cast<Limb>(t >> 64);
+    return static_cast<Limb>(t);
+#else
+    Limb const aLo = _a & 0xffffffff;
+    Limb const aHi = _a >> 32;
+    Limb const bLo = _b & 0xffffffff;
+    Limb const bHi = _b >> 32;
+    Limb const ll = aLo * bLo;
+    Limb const lh = aLo * bHi;
+    Limb const hl = aHi * bLo;
+    Limb const mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    Limb lo = (ll & 0xffffffff) | (mid << 32);
+    Limb hi = aHi * bHi + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    lo += _c;
+    hi += lo < _c;
+    lo += io_carry;
+    hi += lo < io_carry;
+    io_carry = hi;
+    return lo;
+#endif
+}
+
+/// @returns the low limb of _a + _b + io_carry and stores the carry in io_carry.
+inline Limb addCarry(Limb _a, Limb _b, Limb& io_carry) noexcept
+{
+    Limb const s = _a + _b;
+    Limb const r = s + io_carry;
+    io_carry = (s < _a) | (r < s);
+    return r;
+}
+
+/// Arithmetic modulo an odd number of at most N limbs, numbers are little-endian limbs.
+template <size_t N>
+class Montgomery
+{
+public:
+    using Number = std::array<Limb, N>;
+
+    explicit Montgomery(Number const& _mod) noexcept : m_mod(_mod)
+    {
+        // Newton's iteration for the inverse of the lowest limb. An odd number is its own
+        // inverse modulo 8, every step doubles the number of correct bits.
+        Limb inv = _mod[0];
+        for (int i = 0; i < 5; ++i)
+            inv *= 2 - _mod[0] * inv;
+        m_inv = 0 - inv;
+    }
+
+    /// @returns _a * _b / R % mod with R = 2^(64 * N). _a * _b must be less than mod * R.
+    Number mul(Number const& _a, Number const& _b) const noexcept
+    {
+        Limb t[N + 2] = {};
+        for (size_t i = 0; i < N; ++i)
+        {
+            Limb carry = 0;
+            for (size_t j = 0; j < N; ++j)
+                t[j] = mulAdd(_a[j], _b[i], t[j], carry);
+            Limb top = 0;
+            t[N] = addCarry(t[N], carry, top);
+            t[N + 1] = top;
+
+            // Add a multiple of mod that clears the lowest limb, then shift by a limb.
+            Limb const m = t[0] * m_inv;
+            carry = 0;
+            mulAdd(m, m_mod[0], t[0], carry);
+            for (size_t j = 1; j < N; ++j)
+                t[j - 1] = mulAdd(m, m_mod[j], t[j], carry);
+            top = 0;
+            t[N - 1] = addCarry(t[N], carry, top);
+            t[N] = t[N + 1] + top;
+        }
+
+        Number r;
+        std::copy(t, t + N, r.begin());
+        if (t[N] != 0 || !less(r, m_mod))
+        {
+            Limb borrow = 0;
+            for (size_t j = 0; j < N; ++j)
+            {
+                Limb const d = r[j] - m_mod[j];
+                Limb const b = (r[j] < m_mod[j]) | (d < borrow);
+                r[j] = d - borrow;
+                borrow = b;
+            }
+        }
+        return r;
+    }
+
+private:
+    static bool less(Number const& _a, Number const& _b) noexcept
+    {
+        for (size_t j = N; j > 0; --j)
+            if (_a[j - 1] != _b[j - 1])
+                return _a[j - 1] < _b[j - 1];
+        return false;
+    }
+
+    Number m_mod;
+    Limb m_inv;  ///< -mod^-1 % 2^64
+};
+
+/// @returns _in without leading zero bytes.
+bytesConstRef stripLeadingZeros(bytesConstRef _in)
+{
+    size_t zeros = 0;
+    while (zeros < _in.size() && _in[zeros] == 0)
+        ++zeros;
+    return _in.cropped(zeros);
+}
+
+/// Converts a big-endian integer of at most 8 * N significant bytes.
+template <size_t N>
+std::array<Limb, N> toNumber(bytesConstRef _in)
+{
+    std::array<Limb, N> ret = {};
+    size_t const size = std::min(_in.size(), N * 8);
+    for (size_t k = 0; k < size; ++k)
+        ret[k / 8] |= Limb(_in[_in.size() - 1 - k]) << (8 * (k % 8));
+    return ret;
+}
+
+template <size_t N>
+std::array<Limb, N> toNumber(bigint const& _in)
+{
+    bytes be(N * 8);
+    toBigEndian(_in, be);
+    return toNumber<N>(bytesConstRef{&be});
+}
+
+/// Computes _base ^ _exp % _mod for an odd _mod without leading zeros of at most N limbs.
+/// The result is written to the end of o_ret.
+template <size_t N>
+void montgomeryModexp(bytesConstRef _base, bytesConstRef _exp, bytesConstRef _mod, bytes& o_ret)
+{
+    using Number = std::array<Limb, N>;
+
+    bigint const mod = fromBigEndian<bigint>(_mod);
+    Montgomery<N> const mont(toNumber<N>(_mod));
+
+    // R^2 % mod moves a number into the Montgomery domain, a base wider than R is reduced first.
+    Number const r2 = toNumber<N>(bigint(bigint(1) << (128 * N)) % mod);
+    bytesConstRef const base = stripLeadingZeros(_base);
+    Number const x = mont.mul(
+        base.size() > N * 8 ? toNumber<N>(bigint(fromBigEndian<bigint>(base) % mod)) : toNumber<N>(base), r2);
+    Number unit = {};
+    unit[0] = 1;
+    Number const one = mont.mul(unit, r2);
+
+    // Left-to-right exponentiation with a fixed window of 4 bits.
+    std::array<Number, 16> table;
+    table[0] = one;
+    table[1] = x;
+    for (size_t i = 2; i < table.size(); ++i)
+        table[i] = mont.mul(table[i - 1], x);
+
+    Number acc = one;
+    bool started = false;
+    for (byte b : _exp)
+    {
+        for (int shift = 4; shift >= 0; shift -= 4)
+        {
+            unsigned const window = (b >> shift) & 0xf;
+            if (started)
+                for (int i = 0; i < 4; ++i)
+                    acc = mont.mul(acc, acc);
+            if (window != 0)
+            {
+                acc = started ? mont.mul(acc, table[window]) : table[window];
+                started = true;
+            }
+        }
+    }
+
+    Number const result = mont.mul(acc, unit);
+    for (size_t k = 0; k < std::min(o_ret.size(), N * 8); ++k)
+        o_ret[o_ret.size() - 1 - k] = static_cast<byte>(result[k / 8] >> (8 * (k % 8)));
+}
+}  // namespace
+
+bytes modexp(bytesConstRef _base, bytesConstRef _exp, bytesConstRef _mod)
+{
+    bytesConstRef const mod = stripLeadingZeros(_mod);
+    if (mod.empty())
+        return bytes(_mod.size());
+    if (mod.size() > c_maxMontgomeryBytes || mod[mod.size() - 1] % 2 == 0)
+        return modexpGeneric(_base, _exp, _mod);
+
+    bytes ret(_mod.size());
+    size_t const limbs = (mod.size() + 7) / 8;
+    if (limbs <= 4)
+        montgomeryModexp<4>(_base, _exp, mod, ret);
+    else if (limbs <= 8)
+        montgomeryModexp<8>(_base, _exp, mod, ret);
+    else if (limbs <= 16)
+        montgomeryModexp<16>(_base, _exp, mod, ret);
+    else if (limbs <= 32)
+        montgomeryModexp<32>(_base, _exp, mod, ret);
+    else
+        montgomeryModexp<64>(_base, _exp, mod, ret);
+    return ret;
+}
+
+bytes modexpGeneric(bytesConstRef _base, bytesConstRef _exp, bytesConstRef _mod)
+{
+    bigint const mod = fromBigEndian<bigint>(_mod);
+    bytes ret(_mod.size());
+    if (mod != 0)
+    {
+        bigint const result = boost::multiprecision::powm(
+            fromBigEndian<bigint>(_base), fromBigEndian<bigint>(_exp), mod);
+        toBigEndian(result, ret);
+    }
+    return ret;
+}
+}  // namespace crypto
+}  // namespace dev
@@ -0,0 +1,22 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#pragma once
+
+#include <libdevcore/Common.h>
+
+namespace dev
+{
+namespace crypto
+{
+/// Calculates _base ^ _exp % _mod of big-endian unsigned integers.
+/// Odd moduli of up to 4096 bits use Montgomery multiplication on fixed-size limbs,
+/// other moduli fall back to modexpGeneric().
+/// @returns the result as a big-endian integer of _mod.size() bytes, zero for a zero modulus
+bytes modexp(bytesConstRef _base, bytesConstRef _exp, bytesConstRef _mod);
+
+/// Same as modexp() using arbitrary-precision integers for any modulus.
+bytes modexpGeneric(bytesConstRef _base, bytesConstRef _exp, bytesConstRef _mod);
+}  // namespace crypto
+}  // namespace dev
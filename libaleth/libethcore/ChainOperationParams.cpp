@@ -4,6 +4,7 @@
 
 
 #include "ChainOperationParams.h"
+#include "PrecompiledCache.h"
 #include <libdevcore/CommonData.h>
 #include <libdevcore/Log.h>
 
@@ -15,7 +16,8 @@ PrecompiledContract::PrecompiledContract(
     std::string const& _name, u256 const& _startingBlock /*= 0*/)
   : m_cost(PrecompiledRegistrar::pricer(_name)),
     m_execute(PrecompiledRegistrar::executor(_name)),
-    m_startingBlock(_startingBlock)
+    m_startingBlock(_startingBlock),
+    m_cacheable(PrecompiledCache::cacheable(_name))
 {}
 
 ChainOperationParams::ChainOperationParams():
@@ -39,10 +39,14 @@ public:
 
     u256 const& startingBlock() const { return m_startingBlock; }
 
+    /// @returns true if the result only depends on the input and may be kept in PrecompiledCache.
+    bool cacheable() const { return m_cacheable; }
+
 private:
     PrecompiledPricer m_cost;
     PrecompiledExecutor m_execute;
     u256 m_startingBlock = 0;
+    bool m_cacheable = false;
 };
 
 constexpr int64_t c_infiniteBlockNumber = std::numeric_limits<int64_t>::max();
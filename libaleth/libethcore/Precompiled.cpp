@@ -11,6 +11,7 @@
 #include <libdevcrypto/Common.h>
 #include <libdevcrypto/Hash.h>
 #include <libdevcrypto/LibSnark.h>
+#include <libdevcrypto/ModExp.h>
 #include <libethcore/Common.h>
 using namespace std;
 using namespace dev;
@@ -137,6 +138,20 @@ bigint parseBigEndianRightPadded(bytesConstRef _in, bigint const& _begin, bigint
     return ret;
 }
 
+// Copy _count bytes of _in starting with _begin offset, right-padded like parseBigEndianRightPadded.
+bytes copyRightPadded(bytesConstRef _in, bigint const& _begin, bigint const& _count)
+{
+    assert(_count <= numeric_limits<size_t>::max() / 8);
+    bytes ret(static_cast<size_t>(_count));
+    if (_begin < _in.count())
+    {
+        size_t const begin{_begin};
+        bytesConstRef cropped = _in.cropped(begin, min(ret.size(), _in.count() - begin));
+        std::copy(cropped.begin(), cropped.end(), ret.begin());
+    }
+    return ret;
+}
+
 ETH_REGISTER_PRECOMPILED(modexp)(bytesConstRef _in)
 {
     bigint const baseLength(parseBigEndianRightPadded(_in, 0, 32));
@@ -148,17 +163,11 @@ ETH_REGISTER_PRECOMPILED(modexp)(bytesConstRef _in)
         return {true, bytes{}}; // This is a special case where expLength can be very big.
     assert(expLength <= numeric_limits<size_t>::max() / 8);
 
-    bigint const base(parseBigEndianRightPadded(_in, 96, baseLength));
-    bigint const exp(parseBigEndianRightPadded(_in, 96 + baseLength, expLength));
-    bigint const mod(parseBigEndianRightPadded(_in, 96 + baseLength + expLength, modLength));
-
-    bigint const result = mod != 0 ? boost::multiprecision::powm(base, exp, mod) : bigint{0};
-
-    size_t const retLength(modLength);
-    bytes ret(retLength);
-    toBigEndian(result, ret);
+    bytes const base(copyRightPadded(_in, 96, baseLength));
+    bytes const exp(copyRightPadded(_in, 96 + baseLength, expLength));
+    bytes const mod(copyRightPadded(_in, 96 + baseLength + expLength, modLength));
 
-    return {true, ret};
+    return {true, dev::crypto::modexp(&base, &exp, &mod)};
 }
 
 namespace
@@ -0,0 +1,35 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include "PrecompiledCache.h"
+
+#include <libdevcore/SHA3.h>
+
+#include <set>
+
+namespace dev
+{
+namespace eth
+{
+bool PrecompiledCache::cacheable(std::string const& _name)
+{
+    // estimate_fee reads the state and must never be cached. identity, sha256 and ripemd160
+    // cost about as much as hashing the input for the key.
+    static std::set<std::string> const c_cacheable = {"ecrecover", "modexp", "alt_bn128_G1_add",
+        "alt_bn128_G1_mul", "alt_bn128_pairing_product", "blake2_compression"};
+    return c_cacheable.count(_name) != 0;
+}
+
+PrecompiledCache::PrecompiledCache()
+  : m_cache(c_defaultCapacity, [](Result const& _result) { return _result.second.size() + 128; })
+{}
+
+PrecompiledCache::Result PrecompiledCache::execute(
+    Address const& _address, bytesConstRef _in, std::function<Result()> const& _execute)
+{
+    return m_cache.getOrInsert(Key{_address, sha3(_in)}, _execute);
+}
+
+}  // namespace eth
+}  // namespace dev
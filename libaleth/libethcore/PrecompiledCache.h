@@ -0,0 +1,76 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#pragma once
+
+#include <libdevcore/Address.h>
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/SizedLruCache.h>
+
+#include <functional>
+
+namespace dev
+{
+namespace eth
+{
+using PrecompiledCacheStats = SizedLruCacheStats;
+
+/**
+ * @brief Thread-safe LRU cache of precompiled contract results, keyed by the address of the
+ * contract and the hash of the input. Only contracts whose result depends on nothing but
+ * the input may be cached, see cacheable().
+ */
+class PrecompiledCache
+{
+public:
+    using Result = std::pair<bool, bytes>;
+
+    static PrecompiledCache& instance()
+    {
+        static PrecompiledCache cache;
+        return cache;
+    }
+
+    /// @returns true if the results of the precompiled contract @a _name may be cached.
+    static bool cacheable(std::string const& _name);
+
+    /// @returns the cached result of @a _address for @a _in, or runs @a _execute and caches
+    /// its result. @a _execute runs without holding the lock.
+    Result execute(Address const& _address, bytesConstRef _in, std::function<Result()> const& _execute);
+
+    /// Set the number of bytes the cache may use, 0 disables and clears it.
+    void setCapacity(size_t _capacity) { m_cache.setCapacity(_capacity); }
+
+    PrecompiledCacheStats stats() const { return m_cache.stats(); }
+
+private:
+    PrecompiledCache();
+
+    struct Key
+    {
+        Address address;
+        h256 inputHash;
+
+        bool operator==(Key const& _other) const
+        {
+            return address == _other.address && inputHash == _other.inputHash;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(Key const& _key) const
+        {
+            return std::hash<h256>{}(_key.inputHash) ^ std::hash<Address>{}(_key.address);
+        }
+    };
+
+    static constexpr size_t c_defaultCapacity = 16 * 1024 * 1024;
+
+    SizedLruCache<Key, Result, KeyHash> m_cache;
+};
+
+}  // namespace eth
+}  // namespace dev
@@ -12,6 +12,7 @@
 #include <libdevcore/RLP.h>
 #include "BlockHeader.h"
 #include "Common.h"
+#include "PrecompiledCache.h"
 
 namespace dev
 {
@@ -79,7 +80,13 @@ public:
     {
         return m_params.precompiled.at(_a).cost(_in, evmSchedule(_blockNumber), _blockNumber);
     }
-    virtual std::pair<bool, bytes> executePrecompiled(Address const& _a, bytesConstRef _in, EstimateFeeCallback _callback, u256 const&) const { return m_params.precompiled.at(_a).execute(_in, _callback); }
+    virtual std::pair<bool, bytes> executePrecompiled(Address const& _a, bytesConstRef _in, EstimateFeeCallback _callback, u256 const&) const
+    {
+        auto const& contract = m_params.precompiled.at(_a);
+        if (!contract.cacheable())
+            return contract.execute(_in, _callback);
+        return PrecompiledCache::instance().execute(_a, _in, [&]() { return contract.execute(_in, _callback); });
+    }
 
 protected:
     virtual bool onOptionChanging(std::string const&, bytes const&) { return true; }
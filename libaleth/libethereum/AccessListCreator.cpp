@@ -0,0 +1,113 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "AccessListCreator.h"
+
+#include <libethcore/SealEngine.h>
+
+using namespace std;
+
+namespace dev
+{
+namespace eth
+{
+
+namespace
+{
+/// Gives up on a list that keeps changing, the list of the last run is returned then.
+constexpr unsigned c_maxRuns = 16;
+
+/// Records the accesses of executed code while in scope.
+class ScopedAccessRecorder
+{
+public:
+    ScopedAccessRecorder(State& _state, State::AccessedSet& _accessed) : m_state(_state)
+    {
+        m_state.setAccessRecorder(&_accessed);
+    }
+    ~ScopedAccessRecorder() { m_state.setAccessRecorder(nullptr); }
+
+    ScopedAccessRecorder(ScopedAccessRecorder const&) = delete;
+    ScopedAccessRecorder& operator=(ScopedAccessRecorder const&) = delete;
+
+private:
+    State& m_state;
+};
+
+/// @returns a copy of @a _t carrying @a _list, the sender is kept.
+Transaction withAccessList(Transaction const& _t, AccessListStruct const& _list, uint64_t _chainID)
+{
+    Transaction ret = _t.isCreation() ?
+        Transaction(_t.value(), _t.gasPrice(), _t.gas(), _t.data(), _t.nonce(), _list, _chainID) :
+        Transaction(_t.value(), _t.gasPrice(), _t.gas(), _t.receiveAddress(), _t.data(), _t.nonce(),
+            _list, _chainID);
+    ret.forceSender(_t.sender());
+    return ret;
+}
+
+AccessListStruct toAccessListStruct(State::AccessedSet const& _accessed)
+{
+    AccessListStruct ret;
+    ret.reserve(_accessed.size());
+    for (auto const& account : _accessed)
+        ret.emplace_back(account.first, u256s(account.second.begin(), account.second.end()));
+    return ret;
+}
+}  // namespace
+
+CreatedAccessList createAccessList(State& _state, h256 const& _stateRoot, EnvInfo const& _envInfo,
+    SealEngineFace const& _sealEngine, Transaction const& _t, ExecutionLimits const& _limits)
+{
+    if (!_sealEngine.evmSchedule(_envInfo.number()).eip2930Mode)
+        BOOST_THROW_EXCEPTION(AccessListNotSupported());
+
+    uint64_t const chainID = _envInfo.chainID().convert_to<uint64_t>();
+    Address const sender = _t.sender();
+    // Excluded accounts are warm anyway, they are only listed for the storage keys accessed on them.
+    auto const isListed = [&](Address const& _a, bool _hasKeys, Address const& _recipient) {
+        return _hasKeys ||
+               (_a != sender && _a != _recipient && !_sealEngine.isPrecompiled(_a, _envInfo.number()));
+    };
+
+    // The list grows monotonically: an access seen in one run stays listed, so that runs
+    // cannot alternate between two lists.
+    State::AccessedSet list;
+    if (_t.accessList())
+        _t.accessList()->forEach([&](Address const& _a, u256s const& _keys) {
+            if (isListed(_a, !_keys.empty(), _t.receiveAddress()))
+                list[_a].insert(_keys.begin(), _keys.end());
+        });
+
+    ExecutionBudget budget(_limits);
+    CreatedAccessList ret;
+    while (true)
+    {
+        State::AccessedSet accessed;
+        ExecutionResult result;
+        {
+            ScopedAccessRecorder recorder(_state, accessed);
+            _state.setRoot(_stateRoot);
+            result = _state.execute(_envInfo, _sealEngine, withAccessList(_t, toAccessListStruct(list), chainID),
+                Permanence::Reverted, OnOpFunc(), nullptr, _limits.unlimited() ? nullptr : &budget).first;
+        }
+        ++ret.runs;
+        ret.gasUsed = result.gasUsed;
+        ret.excepted = result.excepted;
+
+        Address const recipient = _t.isCreation() ? result.newAddress : _t.receiveAddress();
+        State::AccessedSet next = list;
+        for (auto const& account : accessed)
+            if (isListed(account.first, !account.second.empty(), recipient))
+                next[account.first].insert(account.second.begin(), account.second.end());
+
+        if (next == list || ret.runs == c_maxRuns)
+            break;
+        list = std::move(next);
+    }
+
+    ret.accessList = toAccessListStruct(list);
+    return ret;
+}
+
+}  // namespace eth
+}  // namespace dev
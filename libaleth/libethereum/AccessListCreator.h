@@ -0,0 +1,49 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Generation of EIP-2930 access lists by executing a transaction
+#pragma once
+
+#include "State.h"
+#include "Transaction.h"
+
+#include <libethcore/Common.h>
+#include <libethcore/Exceptions.h>
+
+namespace dev
+{
+namespace eth
+{
+
+class SealEngineFace;
+
+DEV_SIMPLE_EXCEPTION(AccessListNotSupported);
+
+/// An access list found by createAccessList().
+struct CreatedAccessList
+{
+    /// Accessed accounts ordered by address, each with its accessed storage keys in order.
+    AccessListStruct accessList;
+    /// Gas used by the transaction carrying the access list.
+    u256 gasUsed;
+    TransactionException excepted = TransactionException::None;
+    /// Number of executions until the access list stopped changing.
+    unsigned runs = 0;
+};
+
+/// Executes @a _t on @a _state at @a _stateRoot with the accesses of its code recorded, and runs
+/// it again carrying the recorded access list until the list does not change anymore: another
+/// list changes the gas available to the code and so possibly the paths it takes.
+/// The sender, the recipient or the created contract, and the precompiled contracts are only
+/// listed with the storage keys accessed on them, as are the entries of the transaction's own list.
+/// Nothing is written, @a _state is reset to @a _stateRoot before every execution.
+/// The executions share one ExecutionBudget of @a _limits.
+/// @throws AccessListNotSupported if the schedule at the block of @a _envInfo lacks EIP-2930.
+/// @throws ExecutionBudgetExceeded once the budget is exhausted.
+CreatedAccessList createAccessList(State& _state, h256 const& _stateRoot, EnvInfo const& _envInfo,
+    SealEngineFace const& _sealEngine, Transaction const& _t, ExecutionLimits const& _limits = ExecutionLimits());
+
+}  // namespace eth
+}  // namespace dev
@@ -66,7 +66,7 @@ void Account::setCode(bytes&& _code, u256 const& _version)
         if (m_codeHash != EmptySHA3)
             changed();
 
-        m_codeCache = std::move(_code);
+        m_codeCache = std::make_shared<bytes const>(std::move(_code));
         m_hasNewCode = true;
         m_codeHash = newHash;
     }
@@ -75,7 +75,7 @@ void Account::setCode(bytes&& _code, u256 const& _version)
 
 void Account::resetCode()
 {
-    m_codeCache.clear();
+    m_codeCache.reset();
     m_hasNewCode = false;
     m_codeHash = EmptySHA3;
     // Reset the version, as it was set together with code
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include "CodeCache.h"
+
 #include <libdevcore/Common.h>
 #include <libdevcore/SHA3.h>
 #include <libdevcore/RLP.h>
@@ -224,10 +226,16 @@ public:
 
     /// Specify to the object what the actual code is for the account. @a _code must have a SHA3
     /// equal to codeHash().
-    void noteCode(bytesConstRef _code) { assert(sha3(_code) == m_codeHash); m_codeCache = _code.toBytes(); }
+    void noteCode(SharedCode _code) { assert(sha3(*_code) == m_codeHash); m_codeCache = std::move(_code); }
+
+    /// @returns true if the code is known, either set or noted.
+    bool hasCode() const { return !!m_codeCache; }
 
     /// @returns the account's code.
-    bytes const& code() const { return m_codeCache; }
+    bytes const& code() const { return m_codeCache ? *m_codeCache : NullBytes; }
+
+    /// @returns the account's code without copying it, nullptr if it is not known.
+    SharedCode const& sharedCode() const { return m_codeCache; }
 
     u256 version() const { return m_version; }
 
@@ -275,8 +283,8 @@ private:
     mutable std::unordered_map<u256, u256> m_storageOriginal;
 
     /// The associated code for this account. The SHA3 of this should be equal to m_codeHash unless
-    /// m_codeHash equals c_contractConceptionCodeHash.
-    bytes m_codeCache;
+    /// m_codeHash equals c_contractConceptionCodeHash. Shared with CodeCache and running VMs.
+    SharedCode m_codeCache;
 
     /// Value for m_codeHash when this account is having its code determined.
     static const h256 c_contractConceptionCodeHash;
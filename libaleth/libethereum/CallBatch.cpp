@@ -0,0 +1,81 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "CallBatch.h"
+#include "State.h"
+
+#include <libethcore/SealEngine.h>
+
+#include <future>
+#include <memory>
+#include <thread>
+
+namespace dev
+{
+namespace eth
+{
+
+namespace
+{
+void executeRun(State& _state, EnvInfo const& _envInfo, SealEngineFace const& _sealEngine,
+    std::vector<Transaction> const& _calls, ExecutionLimits const& _limits, size_t _begin, size_t _end,
+    std::vector<ExecutionResult>& o_results)
+{
+    for (size_t i = _begin; i < _end; ++i)
+    {
+        size_t const savept = _state.savepoint();
+        try
+        {
+            ExecutionBudget budget(_limits);
+            o_results[i] = _state.execute(_envInfo, _sealEngine, _calls[i], Permanence::Uncommitted,
+                OnOpFunc(), nullptr, _limits.unlimited() ? nullptr : &budget).first;
+        }
+        catch (Exception const& _e)
+        {
+            o_results[i].excepted = toTransactionException(_e);
+        }
+        _state.discard(savept);
+    }
+}
+}  // namespace
+
+std::vector<ExecutionResult> executeCalls(OverlayDB const& _db, h256 const& _root, EnvInfo const& _envInfo,
+    SealEngineFace const& _sealEngine, std::vector<Transaction> const& _calls, unsigned _threads,
+    ExecutionLimits const& _limits)
+{
+    std::vector<ExecutionResult> results(_calls.size());
+    if (_threads == 0)
+        _threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t const runs = std::max<size_t>(1, std::min<size_t>(_threads, _calls.size()));
+
+    // the threads run on forks of one state, which they only read
+    State base(0, _db, BaseState::PreExisting);
+    base.setRoot(_root);
+    std::vector<std::unique_ptr<State>> states;
+    for (size_t r = 0; r < runs; ++r)
+        states.push_back(std::make_unique<State>(base.fork()));
+
+    if (runs == 1)
+    {
+        executeRun(*states.front(), _envInfo, _sealEngine, _calls, _limits, 0, _calls.size(), results);
+        return results;
+    }
+
+    // every thread writes a disjoint part of the results
+    std::vector<std::future<void>> futures;
+    for (size_t r = 0; r < runs; ++r)
+    {
+        size_t const begin = _calls.size() * r / runs;
+        size_t const end = _calls.size() * (r + 1) / runs;
+        State& state = *states[r];
+        futures.push_back(std::async(std::launch::async, [&, begin, end]() {
+            executeRun(state, _envInfo, _sealEngine, _calls, _limits, begin, end, results);
+        }));
+    }
+    for (auto& f : futures)
+        f.get();
+    return results;
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,43 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Execution of many read-only calls against a single state
+#pragma once
+
+#include "Transaction.h"
+
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/OverlayDB.h>
+#include <libevm/ExtVMFace.h>
+
+#include <vector>
+
+namespace dev
+{
+namespace eth
+{
+
+class SealEngineFace;
+
+/**
+ * Executes every call of @a _calls against the state at @a _root, nothing is written.
+ *
+ * The calls share a State whose account cache stays warm from one call to the next, each call
+ * only sees the state at @a _root: its changes are discarded through a savepoint before the next
+ * call runs. With @a _threads > 1 the calls are split into that many contiguous runs that are
+ * executed concurrently, each on its own fork of the State, 0 means one per hardware thread.
+ * @a _envInfo is shared by the threads, its block hashes must be readable from any thread.
+ *
+ * Every call gets its own ExecutionBudget of @a _limits. A call that is invalid, e.g. with a
+ * wrong nonce, or that exhausts its budget does not stop the others, its result only carries
+ * the error in ExecutionResult::excepted.
+ * @returns the results in the order of @a _calls
+ */
+std::vector<ExecutionResult> executeCalls(OverlayDB const& _db, h256 const& _root, EnvInfo const& _envInfo,
+    SealEngineFace const& _sealEngine, std::vector<Transaction> const& _calls, unsigned _threads = 1,
+    ExecutionLimits const& _limits = ExecutionLimits());
+
+}  // namespace eth
+}  // namespace dev
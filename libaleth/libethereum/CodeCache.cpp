@@ -0,0 +1,29 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include "CodeCache.h"
+
+namespace dev
+{
+namespace eth
+{
+CodeCache::CodeCache()
+  : m_cache(c_defaultCapacity, [](SharedCode const& _code) { return _code->size() + 96; })
+{}
+
+SharedCode CodeCache::get(h256 const& _hash)
+{
+    SharedCode code;
+    m_cache.get(_hash, code);
+    return code;
+}
+
+void CodeCache::store(h256 const& _hash, SharedCode _code)
+{
+    if (_code)
+        m_cache.insert(_hash, std::move(_code));
+}
+
+}  // namespace eth
+}  // namespace dev
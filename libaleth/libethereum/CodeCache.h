@@ -0,0 +1,56 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#pragma once
+
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/SizedLruCache.h>
+
+#include <memory>
+
+namespace dev
+{
+namespace eth
+{
+/// Contract code shared by the code cache, accounts and running VMs.
+using SharedCode = std::shared_ptr<bytes const>;
+
+using CodeCacheStats = SizedLruCacheStats;
+
+/**
+ * @brief Thread-safe LRU cache of contract code keyed by code hash, shared by all states of
+ * the process. Code is immutable once deployed, so an entry never needs to be invalidated and
+ * the accounts of any state may reference it without copying.
+ */
+class CodeCache
+{
+public:
+    static CodeCache& instance()
+    {
+        static CodeCache cache;
+        return cache;
+    }
+
+    /// @returns the code of @a _hash, nullptr if it is not cached.
+    SharedCode get(h256 const& _hash);
+
+    /// Caches @a _code, whose hash must be @a _hash.
+    void store(h256 const& _hash, SharedCode _code);
+
+    /// Set the number of bytes the cache may use, 0 disables and clears it.
+    void setCapacity(size_t _capacity) { m_cache.setCapacity(_capacity); }
+
+    CodeCacheStats stats() const { return m_cache.stats(); }
+
+private:
+    CodeCache();
+
+    static constexpr size_t c_defaultCapacity = 64 * 1024 * 1024;
+
+    SizedLruCache<h256, SharedCode> m_cache;
+};
+
+}  // namespace eth
+}  // namespace dev
@@ -293,13 +293,14 @@ bool Executive::call(CallParameters const& _p, u256 const& _gasPrice, Address co
         m_gas = _p.gas;
         if (m_s.addressHasCode(_p.codeAddress))
         {
-            bytes const& c = m_s.code(_p.codeAddress);
+            // the code is shared with the account and the code cache, not copied
+            SharedCode c = m_s.sharedCode(_p.codeAddress);
             h256 codeHash = m_s.codeHash(_p.codeAddress);
             // Contract will be executed with the version stored in account
             auto const version = m_s.version(_p.codeAddress);
             m_ext = make_shared<ExtVM>(m_s, m_envInfo, m_sealEngine, _p.receiveAddress,
-                _p.senderAddress, _origin, _p.apparentValue, _gasPrice, _p.data, &c, codeHash,
-                version, m_depth, false, _p.staticCall);
+                _p.senderAddress, _origin, _p.apparentValue, _gasPrice, _p.data, std::move(c),
+                codeHash, version, m_depth, false, _p.staticCall);
         }
     }
 
@@ -409,8 +410,8 @@ bool Executive::executeCreate(Address const& _sender, u256 const& _endowment, u2
     // Schedule _init execution if not empty.
     if (!_init.empty())
         m_ext = make_shared<ExtVM>(m_s, m_envInfo, m_sealEngine, m_newAddress, _sender, _origin,
-            _endowment, _gasPrice, bytesConstRef(), _init, sha3(_init), _version, m_depth, true,
-            false);
+            _endowment, _gasPrice, bytesConstRef(), make_shared<bytes const>(_init.toBytes()),
+            sha3(_init), _version, m_depth, true, false);
     else
         // code stays empty, but we set the version
         m_s.setCode(m_newAddress, {}, _version);
@@ -453,8 +454,8 @@ bool Executive::executeUpgrade(Address const& _sender, u256 const& _endowment, u
         // Schedule _init execution if not empty.
         if (!_init.empty())
             m_ext = make_shared<ExtVM>(m_s, m_envInfo, m_sealEngine, m_newAddress, _sender, _origin,
-                _endowment, _gasPrice, bytesConstRef(), _init, sha3(_init), _version, m_depth, true,
-                false);
+                _endowment, _gasPrice, bytesConstRef(), make_shared<bytes const>(_init.toBytes()),
+                sha3(_init), _version, m_depth, true, false);
         else
             // code stays empty, but we set the version
             m_s.setCode(m_newAddress, {}, _version);
@@ -504,6 +505,8 @@ bool Executive::go(OnOpFunc const& _onOp)
 {
     if (m_ext)
     {
+        m_ext->tracer = m_tracer;
+        m_ext->budget = m_budget;
 #if ETH_TIMED_EXECUTIONS
         Timer t;
 #endif
@@ -568,6 +571,15 @@ bool Executive::go(OnOpFunc const& _onOp)
             revert();
             throw;
         }
+        catch (ExecutionBudgetExceeded const&)
+        {
+            revert();
+            // A nested frame fails like one out of gas, its caller stops right after it.
+            if (m_depth == 0)
+                throw;
+            m_gas = 0;
+            m_excepted = TransactionException::OutOfGas;
+        }
         catch (Exception const& _e)
         {
             // TODO: AUDIT: check that this can never reasonably happen. Consider what to do if it does.
@@ -133,6 +133,12 @@ public:
     /// Collect execution results in the result storage provided.
     void setResultRecipient(ExecutionResult& _res) { m_res = &_res; }
 
+    /// Report the execution to @a _tracer, it is handed down to nested calls and creates.
+    void setTracer(VMTracer* _tracer) { m_tracer = _tracer; }
+
+    /// Limit the execution by @a _budget, it is shared with nested calls and creates.
+    void setBudget(ExecutionBudget* _budget) { m_budget = _budget; }
+
     /// Revert all changes made to the state by this execution.
     void revert();
 
@@ -162,6 +168,8 @@ private:
     std::shared_ptr<ExtVM> m_ext;		///< The VM externality object for the VM execution or null if no VM is required. shared_ptr used only to allow ExtVM forward reference. This field does *NOT* survive this object.
     owning_bytes_ref m_output;			///< Execution output.
     ExecutionResult* m_res = nullptr;	///< Optional storage for execution results.
+    VMTracer* m_tracer = nullptr;		///< Optional tracer of the execution.
+    ExecutionBudget* m_budget = nullptr;	///< Optional budget of the execution.
 
     unsigned m_depth = 0;				///< The context's call-depth.
     TransactionException m_excepted = TransactionException::None;	///< Details if the VM's execution resulted in an exception.
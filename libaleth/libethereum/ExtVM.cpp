@@ -108,6 +108,8 @@ evmc_status_code transactionExceptionToEvmcStatusCode(TransactionException ex) n
 CallResult ExtVM::call(CallParameters& _p)
 {
     Executive e{m_s, envInfo(), m_sealEngine, depth + 1};
+    e.setTracer(tracer);
+    e.setBudget(budget);
     if (!e.call(_p, gasPrice, origin))
     {
         go(depth, e, _p.onOp);
@@ -136,6 +138,8 @@ void ExtVM::setStore(u256 _n, u256 _v)
 CreateResult ExtVM::create(u256 _endowment, u256& io_gas, bytesConstRef _code, Instruction _op, u256 _salt, OnOpFunc const& _onOp)
 {
     Executive e{m_s, envInfo(), m_sealEngine, depth + 1};
+    e.setTracer(tracer);
+    e.setBudget(budget);
     bool result = false;
     if (_op == Instruction::CREATE)
         result = e.createOpcode(myAddress, _endowment, gasPrice, io_gas, _code, origin);
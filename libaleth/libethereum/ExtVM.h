@@ -28,9 +28,9 @@ public:
     /// Full constructor.
     ExtVM(State& _s, EnvInfo const& _envInfo, SealEngineFace const& _sealEngine, Address _myAddress,
         Address _caller, Address _origin, u256 _value, u256 _gasPrice, bytesConstRef _data,
-        bytesConstRef _code, h256 const& _codeHash, u256 const& _version, unsigned _depth,
+        SharedCode _code, h256 const& _codeHash, u256 const& _version, unsigned _depth,
         bool _isCreate, bool _staticCall)
-      : ExtVMFace(_envInfo, _myAddress, _caller, _origin, _value, _gasPrice, _data, _code.toBytes(),
+      : ExtVMFace(_envInfo, _myAddress, _caller, _origin, _value, _gasPrice, _data, std::move(_code),
             _codeHash, _version, _depth, _isCreate, _staticCall),
         m_s(_s),
         m_sealEngine(_sealEngine),
@@ -96,10 +96,18 @@ public:
     bool checkNonce(Address) final;
 
     /// Access account.
-    bool accessAddress(Address const& _addr) final { return m_s.accessAddress(_addr); }
+    bool accessAddress(Address const& _addr) final
+    {
+        m_s.recordAccess(_addr);
+        return m_s.accessAddress(_addr);
+    }
 
     /// Access account storage.
-    bool accessStorage(Address const& _addr, u256 const& _key) final { return m_s.accessStorage(_addr, _key); }
+    bool accessStorage(Address const& _addr, u256 const& _key) final
+    {
+        m_s.recordAccess(_addr, _key);
+        return m_s.accessStorage(_addr, _key);
+    }
 
 private:
     EVMSchedule const& initEvmSchedule(int64_t _blockNumber, u256 const& _version) const
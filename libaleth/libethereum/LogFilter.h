@@ -54,8 +54,12 @@ public:
 
 	bool matches(LogBloom _bloom) const;
 	bool matches(Block const& _b, unsigned _i) const;
+	bool matches(LogEntry const& _e) const;
 	LogEntries matches(TransactionReceipt const& _r) const;
 
+	AddressHash const& addresses() const { return m_addresses; }
+	std::array<h256Hash, 4> const& topics() const { return m_topics; }
+
 	LogFilter address(Address _a) { m_addresses.insert(_a); return *this; }
 	LogFilter topic(unsigned _index, h256 const& _t) { if (_index < 4) m_topics[_index].insert(_t); return *this; }
 	LogFilter withEarliest(h256 _e) { m_earliest = _e; return *this; }
@@ -0,0 +1,356 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "LogIndex.h"
+
+#include <libdevcore/RLP.h>
+#include <libdevcore/SHA3.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace dev
+{
+namespace eth
+{
+
+namespace
+{
+// Key prefixes, no key is 32 bytes long so the state pruner never sweeps them.
+char const c_blockPrefix[] = "logIndexBlock";
+char const c_bloomPrefix[] = "logIndexBloom";
+char const c_columnPrefix[] = "logIndexColumn";
+char const c_countPrefix[] = "logIndexCount";
+
+void appendBigEndian(std::string& io_key, uint64_t _value, unsigned _bytes)
+{
+    for (unsigned i = _bytes; i > 0; --i)
+        io_key.push_back(static_cast<char>(_value >> (8 * (i - 1))));
+}
+
+uint64_t readBigEndian(char const* _data, unsigned _bytes)
+{
+    uint64_t value = 0;
+    for (unsigned i = 0; i < _bytes; ++i)
+        value = (value << 8) | static_cast<byte>(_data[i]);
+    return value;
+}
+
+/// The logs of a block.
+std::string blockKey(uint64_t _number)
+{
+    std::string key = c_blockPrefix;
+    appendBigEndian(key, _number, 8);
+    return key;
+}
+
+/// The bloom of a block, kept apart so that open sections are rebuilt without reading logs.
+std::string bloomKey(uint64_t _number)
+{
+    std::string key = c_bloomPrefix;
+    appendBigEndian(key, _number, 8);
+    return key;
+}
+
+/// A column of a complete section, all-zero columns are not written.
+std::string columnKey(uint64_t _section, unsigned _bit)
+{
+    std::string key = c_columnPrefix;
+    appendBigEndian(key, _section, 8);
+    appendBigEndian(key, _bit, 2);
+    return key;
+}
+
+/// The number of indexed blocks of a section.
+std::string countKey(uint64_t _section)
+{
+    std::string key = c_countPrefix;
+    appendBigEndian(key, _section, 8);
+    return key;
+}
+
+db::Slice toSlice(std::string const& _s)
+{
+    return db::Slice(_s.data(), _s.size());
+}
+
+db::Slice toSlice(bytes const& _b)
+{
+    return db::Slice(reinterpret_cast<char const*>(_b.data()), _b.size());
+}
+
+/// @returns the indices of the bits set in @a _bloom, bit j of byte i is bit 8 * i + j.
+std::vector<unsigned> setBits(LogBloom const& _bloom)
+{
+    std::vector<unsigned> ret;
+    for (unsigned i = 0; i < LogBloom::size; ++i)
+        for (unsigned j = 0; _bloom[i] >> j; ++j)
+            if ((_bloom[i] >> j) & 1)
+                ret.push_back(8 * i + j);
+    return ret;
+}
+
+/// @returns the bloom bits set by an address or topic.
+std::vector<unsigned> bloomBits(bytesConstRef _value)
+{
+    LogBloom bloom;
+    bloom.shiftBloom<3>(sha3(_value));
+    return setBits(bloom);
+}
+
+LogBloom toBloom(db::Slice _value)
+{
+    return LogBloom(bytesConstRef(reinterpret_cast<byte const*>(_value.data()), _value.size()));
+}
+}  // namespace
+
+LogIndex::LogIndex(std::shared_ptr<db::DatabaseFace> _db) : m_db(std::move(_db)) {}
+
+void LogIndex::indexBlock(
+    uint64_t _number, h256 const& _blockHash, std::vector<TransactionLogs> const& _transactions)
+{
+    LogBloom bloom;
+    for (auto const& transaction : _transactions)
+        for (auto const& log : transaction.logs)
+            bloom |= log.bloom();
+
+    RLPStream record(2);
+    record.appendList(_transactions.size());
+    for (auto const& transaction : _transactions)
+    {
+        record.appendList(2) << transaction.transactionHash;
+        record.appendList(transaction.logs.size());
+        for (auto const& log : transaction.logs)
+            log.streamRLP(record);
+    }
+    record << _blockHash;
+
+    uint64_t const section = _number / c_sectionSize;
+    size_t const index = _number % c_sectionSize;
+    std::string const key = bloomKey(_number);
+    std::string const previous = m_db->lookup(toSlice(key));
+    LogBloom const previousBloom = previous.empty() ? LogBloom{} : toBloom(toSlice(previous));
+
+    auto batch = m_db->createWriteBatch();
+    batch->insert(toSlice(blockKey(_number)), toSlice(record.out()));
+    batch->insert(toSlice(key), db::Slice(reinterpret_cast<char const*>(bloom.data()), LogBloom::size));
+
+    uint64_t const bit = uint64_t(1) << (index % 64);
+    bool completed = false;
+    if (sectionCount(section) == c_sectionSize)
+    {
+        // A block of a written section was replaced, only the columns of changed bits are updated.
+        for (unsigned b : setBits(bloom ^ previousBloom))
+        {
+            Column column = loadColumn(section, b);
+            column[index / 64] ^= bit;
+            batch->insert(toSlice(columnKey(section, b)), toSlice(encodeColumn(column)));
+        }
+    }
+    else
+    {
+        OpenSection& open = openSection(section);
+        for (unsigned b : setBits(previousBloom))
+            open.columns[b][index / 64] &= ~bit;
+        for (unsigned b : setBits(bloom))
+            open.columns[b][index / 64] |= bit;
+        if (!(open.indexed[index / 64] & bit))
+        {
+            open.indexed[index / 64] |= bit;
+            ++open.count;
+            std::string count;
+            appendBigEndian(count, open.count, 8);
+            batch->insert(toSlice(countKey(section)), toSlice(count));
+        }
+
+        completed = open.count == c_sectionSize;
+        if (completed)
+            for (unsigned b = 0; b < c_bloomBits; ++b)
+                if (open.columns[b] != Column{})
+                    batch->insert(toSlice(columnKey(section, b)), toSlice(encodeColumn(open.columns[b])));
+    }
+
+    m_db->commit(std::move(batch));
+    if (completed)
+        m_open.erase(section);
+}
+
+LocalisedLogEntries LogIndex::filterLogs(uint64_t _from, uint64_t _to, LogFilter const& _filter)
+{
+    LocalisedLogEntries ret;
+    if (_from > _to)
+        return ret;
+
+    // Every group must match, a group matches if any of its alternatives does.
+    std::vector<std::vector<BitSet>> groups;
+    if (!_filter.addresses().empty())
+    {
+        groups.emplace_back();
+        for (Address const& address : _filter.addresses())
+            groups.back().push_back(bloomBits(address.ref()));
+    }
+    for (auto const& topics : _filter.topics())
+        if (!topics.empty())
+        {
+            groups.emplace_back();
+            for (h256 const& topic : topics)
+                groups.back().push_back(bloomBits(topic.ref()));
+        }
+
+    for (uint64_t section = _from / c_sectionSize; section <= _to / c_sectionSize; ++section)
+    {
+        uint64_t const count = sectionCount(section);
+        if (!count)
+            continue;
+
+        Column const candidates = matchSection(section, count == c_sectionSize, groups);
+        for (size_t w = 0; w < c_columnWords; ++w)
+            for (unsigned b = 0; candidates[w] && b < 64; ++b)
+            {
+                uint64_t const number = section * c_sectionSize + w * 64 + b;
+                if (!((candidates[w] >> b) & 1) || number < _from || number > _to)
+                    continue;
+
+                // The bloom may match by chance, the logs themselves are checked.
+                std::string const record = m_db->lookup(toSlice(blockKey(number)));
+                if (record.empty())
+                    continue;
+                RLP const r(record);
+                h256 const blockHash = r[1].toHash<h256>();
+                unsigned logIndex = 0;
+                unsigned transactionIndex = 0;
+                for (RLP const& transaction : r[0])
+                {
+                    h256 const transactionHash = transaction[0].toHash<h256>();
+                    for (RLP const& l : transaction[1])
+                    {
+                        LogEntry const log(l);
+                        if (_filter.matches(log))
+                            ret.emplace_back(log, blockHash, static_cast<BlockNumber>(number),
+                                transactionHash, transactionIndex, logIndex);
+                        ++logIndex;
+                    }
+                    ++transactionIndex;
+                }
+            }
+    }
+    return ret;
+}
+
+LogIndex::OpenSection& LogIndex::openSection(uint64_t _section)
+{
+    auto it = m_open.find(_section);
+    if (it == m_open.end())
+    {
+        // Everything in memory is written too, any section can be dropped and rebuilt later.
+        if (m_open.size() >= c_cachedSections)
+            m_open.erase(std::min_element(m_open.begin(), m_open.end(), [](auto const& _a, auto const& _b) {
+                return _a.second->lastUse < _b.second->lastUse;
+            }));
+        it = m_open.emplace(_section, loadSection(_section)).first;
+    }
+    it->second->lastUse = ++m_uses;
+    return *it->second;
+}
+
+std::unique_ptr<LogIndex::OpenSection> LogIndex::loadSection(uint64_t _section) const
+{
+    auto open = std::make_unique<OpenSection>();
+    if (!sectionCount(_section))
+        return open;
+
+    // The bloom keys of a section are contiguous, only those of indexed blocks are read.
+    uint64_t const first = _section * c_sectionSize;
+    std::string const end = bloomKey(first + c_sectionSize);
+    m_db->forEachFrom(toSlice(bloomKey(first)), [&](db::Slice _key, db::Slice _value) {
+        if (_key.toString() >= end)
+            return false;
+
+        size_t const index = readBigEndian(_key.data() + _key.size() - 8, 8) - first;
+        uint64_t const bit = uint64_t(1) << (index % 64);
+        for (unsigned b : setBits(toBloom(_value)))
+            open->columns[b][index / 64] |= bit;
+        open->indexed[index / 64] |= bit;
+        ++open->count;
+        return true;
+    });
+    return open;
+}
+
+uint64_t LogIndex::sectionCount(uint64_t _section) const
+{
+    std::string const value = m_db->lookup(toSlice(countKey(_section)));
+    return readBigEndian(value.data(), value.size());
+}
+
+LogIndex::Column LogIndex::loadColumn(uint64_t _section, unsigned _bit) const
+{
+    Column column = {};
+    std::string const value = m_db->lookup(toSlice(columnKey(_section, _bit)));
+    for (size_t i = 0; i < std::min<size_t>(value.size() * 8, c_sectionSize); ++i)
+        if (static_cast<byte>(value[i / 8]) & (0x80 >> (i % 8)))
+            column[i / 64] |= uint64_t(1) << (i % 64);
+    return column;
+}
+
+bytes LogIndex::encodeColumn(Column const& _column)
+{
+    bytes value(c_sectionSize / 8);
+    for (size_t i = 0; i < c_sectionSize; ++i)
+        if ((_column[i / 64] >> (i % 64)) & 1)
+            value[i / 8] |= 0x80 >> (i % 8);
+    return value;
+}
+
+LogIndex::Column LogIndex::matchSection(
+    uint64_t _section, bool _complete, std::vector<std::vector<BitSet>> const& _groups)
+{
+    // The columns of an open section are in memory, or kept there for the next queries once built.
+    OpenSection const* open = _complete ? nullptr : &openSection(_section);
+
+    Column result;
+    if (open)
+        result = open->indexed;
+    else
+        result.fill(~uint64_t(0));
+
+    std::map<unsigned, Column> columns;
+    auto column = [&](unsigned _bit) -> Column const& {
+        if (open)
+            return open->columns[_bit];
+        auto it = columns.find(_bit);
+        if (it == columns.end())
+            it = columns.emplace(_bit, loadColumn(_section, _bit)).first;
+        return it->second;
+    };
+
+    // Whole columns are combined a word at a time, the fixed bounds let the compiler vectorize.
+    for (auto const& group : _groups)
+    {
+        Column any = {};
+        for (BitSet const& alternative : group)
+        {
+            Column all = result;
+            for (unsigned bit : alternative)
+            {
+                Column const& c = column(bit);
+                for (size_t i = 0; i < c_columnWords; ++i)
+                    all[i] &= c[i];
+            }
+            for (size_t i = 0; i < c_columnWords; ++i)
+                any[i] |= all[i];
+        }
+        result = any;
+
+        uint64_t remaining = 0;
+        for (size_t i = 0; i < c_columnWords; ++i)
+            remaining |= result[i];
+        if (!remaining)
+            break;
+    }
+    return result;
+}
+
+}  // namespace eth
+}  // namespace dev
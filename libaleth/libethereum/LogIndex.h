@@ -0,0 +1,110 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Bloom-bits index of the logs of imported blocks
+#pragma once
+
+#include "LogFilter.h"
+
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/db.h>
+#include <libethcore/LogEntry.h>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace dev
+{
+namespace eth
+{
+
+/// The logs of a transaction of an indexed block.
+struct TransactionLogs
+{
+    h256 transactionHash;
+    LogEntries logs;
+};
+
+/**
+ * Finds the logs of a range of blocks without testing the bloom of every block.
+ *
+ * Blocks are grouped into sections of c_sectionSize blocks. The blooms of a section are
+ * stored transposed, one column per bloom bit holding that bit of every block of the section,
+ * so a filter only reads the few columns of the bits its addresses and topics set.
+ * A section is written once its last block is indexed, until then its columns are rebuilt
+ * from the blooms of its indexed blocks, stored apart from their logs, and the last
+ * c_cachedSections of them are kept in memory. The number of indexed blocks of every section
+ * is stored too, so sections without any are skipped without reading. The logs of every
+ * block are stored as well, the candidate blocks found through the columns are checked
+ * against them.
+ *
+ * Not thread-safe.
+ */
+class LogIndex
+{
+public:
+    /// Number of blocks in a section.
+    static constexpr uint64_t c_sectionSize = 4096;
+
+    explicit LogIndex(std::shared_ptr<db::DatabaseFace> _db);
+
+    /// Indexes the logs of block @a _number, replacing a block of the same number indexed before.
+    void indexBlock(uint64_t _number, h256 const& _blockHash, std::vector<TransactionLogs> const& _transactions);
+
+    /// @returns the logs of the blocks @a _from to @a _to (inclusive) matching @a _filter, in order.
+    /// Blocks that were not indexed are not searched.
+    LocalisedLogEntries filterLogs(uint64_t _from, uint64_t _to, LogFilter const& _filter);
+
+private:
+    /// Number of sections not written yet whose columns are kept in memory.
+    static constexpr size_t c_cachedSections = 8;
+    static constexpr size_t c_columnWords = c_sectionSize / 64;
+    static constexpr unsigned c_bloomBits = LogBloom::size * 8;
+
+    /// One bit per block of a section, block i is bit i % 64 of word i / 64.
+    using Column = std::array<uint64_t, c_columnWords>;
+
+    /// Bloom bits set by a single address or topic.
+    using BitSet = std::vector<unsigned>;
+
+    /// A section whose last block has not been indexed yet.
+    struct OpenSection
+    {
+        std::vector<Column> columns = std::vector<Column>(c_bloomBits);
+        Column indexed = {};  ///< The blocks indexed so far.
+        size_t count = 0;
+        uint64_t lastUse = 0;  ///< Value of m_uses when last accessed.
+    };
+
+    /// @returns the open section @a _section, reading the blooms of its indexed blocks if it
+    /// is not in memory. The least recently used section is evicted beyond c_cachedSections.
+    OpenSection& openSection(uint64_t _section);
+
+    /// @returns a section built from the blooms of its indexed blocks.
+    std::unique_ptr<OpenSection> loadSection(uint64_t _section) const;
+
+    /// @returns the number of indexed blocks of @a _section, its columns are written once it
+    /// is c_sectionSize.
+    uint64_t sectionCount(uint64_t _section) const;
+
+    /// Columns are written with a byte per 8 blocks, the first block in the highest bit.
+    Column loadColumn(uint64_t _section, unsigned _bit) const;
+    static bytes encodeColumn(Column const& _column);
+
+    /// @returns the blocks of @a _section whose blooms match @a _groups: every group must have
+    /// an alternative with all of its bits set. The columns of a @a _complete section are read,
+    /// those of other sections are rebuilt or taken from memory.
+    Column matchSection(uint64_t _section, bool _complete, std::vector<std::vector<BitSet>> const& _groups);
+
+    std::shared_ptr<db::DatabaseFace> m_db;
+    std::map<uint64_t, std::unique_ptr<OpenSection>> m_open;
+    uint64_t m_uses = 0;
+};
+
+}  // namespace eth
+}  // namespace dev
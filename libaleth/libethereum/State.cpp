@@ -38,9 +38,63 @@ State::State(State const& _s):
     m_nonExistingAccountsCache(_s.m_nonExistingAccountsCache),
     m_touched(_s.m_touched),
     m_unrevertablyTouched(_s.m_unrevertablyTouched),
+    m_parent(_s.m_parent),
+    m_readsThroughParent(_s.m_readsThroughParent),
+    m_committedSinceFork(_s.m_committedSinceFork),
     m_accountStartNonce(_s.m_accountStartNonce)
 {}
 
+State::State(ForkTag, State const& _parent):
+    m_db(_parent.m_db.fork()),
+    m_state(&m_db, _parent.m_state.root(), Verification::Skip),
+    m_parent(&_parent),
+    m_readsThroughParent(true),
+    m_accountStartNonce(_parent.m_accountStartNonce)
+{}
+
+State State::fork() const
+{
+    return State(ForkTag{}, *this);
+}
+
+void State::merge(State&& _fork)
+{
+    if (_fork.m_parent != this)
+        BOOST_THROW_EXCEPTION(NotAForkOfThisState());
+
+    m_db.merge(_fork.m_db);
+
+    // The fork holds its own version of every account it read, the others are still current
+    // here. After a commit in the fork none of the accounts cached here is current anymore,
+    // even if the commit left the root as it was: the fork's trie holds them all.
+    bool const committed = _fork.m_committedSinceFork;
+    if (committed)
+    {
+        m_cache.clear();
+        m_unchangedCacheEntries.clear();
+        m_nonExistingAccountsCache.clear();
+        m_changeLog.clear();
+        resetWarmed();
+        m_state.setRoot(_fork.m_state.root());
+        // this state was committed through the fork, its own parent's accounts are stale too
+        m_readsThroughParent = false;
+        m_committedSinceFork = true;
+    }
+
+    for (auto& i: _fork.m_cache)
+        m_cache.insert_or_assign(i.first, std::move(i.second));
+    m_unchangedCacheEntries.insert(m_unchangedCacheEntries.end(),
+        _fork.m_unchangedCacheEntries.begin(), _fork.m_unchangedCacheEntries.end());
+    m_nonExistingAccountsCache.insert(
+        _fork.m_nonExistingAccountsCache.begin(), _fork.m_nonExistingAccountsCache.end());
+    m_touched += _fork.m_touched;
+    m_unrevertablyTouched += _fork.m_unrevertablyTouched;
+    for (auto const& i: _fork.m_warmed)
+        m_warmed[i.first].insert(i.second.begin(), i.second.end());
+    m_changeLog.insert(m_changeLog.end(), _fork.m_changeLog.begin(), _fork.m_changeLog.end());
+    _fork.m_cache.clear();
+}
+
 OverlayDB State::openDB(fs::path const& _basePath, h256 const& _genesisHash, WithExisting _we)
 {
     DatabasePaths const dbPaths{_basePath, _genesisHash};
@@ -124,6 +178,15 @@ void State::noteAccountStartNonce(u256 const& _actual)
         BOOST_THROW_EXCEPTION(IncorrectAccountStartNonceInState());
 }
 
+void State::copyParentChanges() const
+{
+    for (State const* s = m_readsThroughParent ? m_parent : nullptr; s;
+         s = s->m_readsThroughParent ? s->m_parent : nullptr)
+        for (auto const& i: s->m_cache)
+            if (i.second.isDirty())
+                m_cache.emplace(i.first, i.second);
+}
+
 void State::removeEmptyAccounts()
 {
     for (auto& i: m_cache)
@@ -150,6 +213,9 @@ State& State::operator=(State const& _s)
     m_nonExistingAccountsCache = _s.m_nonExistingAccountsCache;
     m_touched = _s.m_touched;
     m_unrevertablyTouched = _s.m_unrevertablyTouched;
+    m_parent = _s.m_parent;
+    m_readsThroughParent = _s.m_readsThroughParent;
+    m_committedSinceFork = _s.m_committedSinceFork;
     m_accountStartNonce = _s.m_accountStartNonce;
     return *this;
 }
@@ -168,6 +234,26 @@ Account* State::account(Address const& _addr)
     if (m_nonExistingAccountsCache.count(_addr))
         return nullptr;
 
+    // A fork copies the accounts of its parents on first access, changed ones included.
+    for (State const* s = m_readsThroughParent ? m_parent : nullptr; s;
+         s = s->m_readsThroughParent ? s->m_parent : nullptr)
+    {
+        auto const parentIt = s->m_cache.find(_addr);
+        if (parentIt != s->m_cache.end())
+        {
+            clearCacheIfTooLarge();
+            auto i = m_cache.emplace(_addr, parentIt->second);
+            if (!parentIt->second.isDirty())
+                m_unchangedCacheEntries.push_back(_addr);
+            return &i.first->second;
+        }
+        if (s->m_nonExistingAccountsCache.count(_addr))
+        {
+            m_nonExistingAccountsCache.insert(_addr);
+            return nullptr;
+        }
+    }
+
     // Populate basic info.
     string stateBack = m_state.at(_addr);
     if (stateBack.empty())
@@ -214,10 +300,13 @@ void State::clearCacheIfTooLarge() const
 
 void State::commit(CommitBehaviour _commitBehaviour)
 {
+    copyParentChanges();
     if (_commitBehaviour == CommitBehaviour::RemoveEmptyAccounts)
         removeEmptyAccounts();
     m_touched += dev::eth::commit(m_cache, m_state);
-    m_warmed.clear();
+    m_readsThroughParent = false;
+    m_committedSinceFork = true;
+    resetWarmed();
     m_changeLog.clear();
     m_cache.clear();
     m_unchangedCacheEntries.clear();
@@ -226,6 +315,7 @@ void State::commit(CommitBehaviour _commitBehaviour)
 unordered_map<Address, u256> State::addresses() const
 {
 #if ETH_FATDB
+    copyParentChanges();
     unordered_map<Address, u256> ret;
     for (auto& i: m_cache)
         if (i.second.isAlive())
@@ -244,6 +334,7 @@ std::pair<State::AddressMap, h256> State::addresses(
 {
     AddressMap addresses;
     h256 nextKey;
+    copyParentChanges();
 
 #if ETH_FATDB
     for (auto it = m_state.hashedLowerBound(_beginHash); it != m_state.hashedEnd(); ++it)
@@ -298,9 +389,11 @@ std::pair<State::AddressMap, h256> State::addresses(
 void State::setRoot(h256 const& _r)
 {
     m_cache.clear();
-    m_warmed.clear();
+    resetWarmed();
     m_unchangedCacheEntries.clear();
     m_nonExistingAccountsCache.clear();
+    m_readsThroughParent = false;
+    m_committedSinceFork = true;
 //  m_touched.clear();
     m_state.setRoot(_r);
 }
@@ -520,20 +613,41 @@ h256 State::storageRoot(Address const& _id) const
 }
 
 bytes const& State::code(Address const& _addr) const
+{
+    SharedCode const code = sharedCode(_addr);
+    // the account keeps referencing the code
+    return code ? *code : NullBytes;
+}
+
+SharedCode State::sharedCode(Address const& _addr) const
 {
     Account const* a = account(_addr);
     if (!a || a->codeHash() == EmptySHA3)
-        return NullBytes;
+        return nullptr;
 
-    if (a->code().empty())
+    if (!a->hasCode())
     {
-        // Load the code from the backend.
+        // Load the code from the shared cache or the backend.
+        auto& codeCache = CodeCache::instance();
+        SharedCode code = codeCache.get(a->codeHash());
+        if (!code)
+        {
+            code = std::make_shared<bytes const>(asBytes(m_db.lookup(a->codeHash())));
+            // A miss, e.g. of a witness lacking the code, is never cached: the caches are shared
+            // by every state of the process. The account is left without code, the miss surfaces
+            // as empty code in this execution only.
+            if (code->empty() || sha3(*code) != a->codeHash())
+                return nullptr;
+            codeCache.store(a->codeHash(), code);
+        }
+        else
+            m_db.noteWitnessRead(a->codeHash(), bytesConstRef(code.get()));
         Account* mutableAccount = const_cast<Account*>(a);
-        mutableAccount->noteCode(m_db.lookup(a->codeHash()));
+        mutableAccount->noteCode(std::move(code));
         CodeSizeCache::instance().store(a->codeHash(), a->code().size());
     }
 
-    return a->code();
+    return a->sharedCode();
 }
 
 void State::setCode(Address const& _address, bytes&& _code, u256 const& _version)
@@ -555,16 +669,19 @@ size_t State::codeSize(Address const& _a) const
 {
     if (Account const* a = account(_a))
     {
-        if (a->hasNewCode())
+        if (a->hasNewCode() || a->hasCode())
             return a->code().size();
         auto& codeSizeCache = CodeSizeCache::instance();
         h256 codeHash = a->codeHash();
-        if (codeSizeCache.contains(codeHash))
+        // A witness needs the code itself.
+        if (codeSizeCache.contains(codeHash) && !m_db.witness())
             return codeSizeCache.get(codeHash);
         else
         {
             size_t size = code(_a).size();
-            codeSizeCache.store(codeHash, size);
+            // not cached if the code was missing
+            if (account(_a)->hasCode())
+                codeSizeCache.store(codeHash, size);
             return size;
         }
     }
@@ -655,13 +772,31 @@ void State::rollback(size_t _savepoint)
     }
 }
 
-std::pair<ExecutionResult, TransactionReceipt> State::execute(EnvInfo const& _envInfo, SealEngineFace const& _sealEngine, Transaction const& _t, Permanence _p, OnOpFunc const& _onOp)
+void State::discard(size_t _savepoint)
+{
+    rollback(_savepoint);
+
+    // Killing an account is not logged, a dead account is read from the database again.
+    for (auto it = m_cache.begin(); it != m_cache.end();)
+        if (!it->second.isAlive())
+            it = m_cache.erase(it);
+        else
+            ++it;
+    m_unrevertablyTouched.clear();
+    // Everything warmed since the first change is forgotten, its memory is reused.
+    if (_savepoint == 0)
+        resetWarmed();
+}
+
+std::pair<ExecutionResult, TransactionReceipt> State::execute(EnvInfo const& _envInfo, SealEngineFace const& _sealEngine, Transaction const& _t, Permanence _p, OnOpFunc const& _onOp, VMTracer* _tracer, ExecutionBudget* _budget)
 {
     // Create and initialize the executive. This will throw fairly cheaply and quickly if the
     // transaction is bad in any way.
     Executive e(*this, _envInfo, _sealEngine);
     ExecutionResult res;
     e.setResultRecipient(res);
+    e.setTracer(_tracer);
+    e.setBudget(_budget);
 
     auto onOp = _onOp;
     if (isVmTraceEnabled() && !onOp)
@@ -782,11 +917,18 @@ bool State::isWarmedStorage(Address const& _addr, u256 const& _key) const
     return itr != m_warmed.end() && itr->second.count(_key) > 0;
 }
 
+void State::resetWarmed()
+{
+    // the new table owns no memory, the old one is destroyed before its memory is reused
+    m_warmed = decltype(m_warmed)(&m_arena);
+    m_arena.reset();
+}
+
 void State::addWarmedAddress(Address const& _addr)
 {
     if (m_warmed.find(_addr) == m_warmed.end())
     {
-        m_warmed[_addr] = std::set<h256>{};
+        m_warmed[_addr];
         m_changeLog.emplace_back(Change::WarmedAddress, _addr, 0, 0);
     }
 }
@@ -796,7 +938,7 @@ void State::addWarmedStorage(Address const& _addr, u256 const& _key)
     auto itr = m_warmed.find(_addr);
     if (itr == m_warmed.end())
     {
-        itr = m_warmed.insert(std::make_pair(_addr, std::set<h256>{})).first;
+        itr = m_warmed.try_emplace(_addr).first;
         m_changeLog.emplace_back(Change::WarmedAddressAndStorage, _addr, _key, 0);
     }
     else
@@ -812,6 +954,7 @@ std::ostream& dev::eth::operator<<(std::ostream& _out, State const& _s)
     auto trie = SecureTrieDB<Address, OverlayDB>(const_cast<OverlayDB*>(&_s.m_db), _s.rootHash());
     for (auto i: trie)
         d.insert(i.first), dtr.insert(i.first);
+    _s.copyParentChanges();
     for (auto i: _s.m_cache)
         d.insert(i.first);
 
@@ -931,6 +1074,7 @@ AddressHash dev::eth::commit(AccountMap const& _cache, SecureTrieDB<Address, DB>
                         h256 ch = i.second.codeHash();
                         // Store the size of the code
                         CodeSizeCache::instance().store(ch, i.second.code().size());
+                        CodeCache::instance().store(ch, i.second.sharedCode());
                         _state.db()->insert(ch, &i.second.code());
                         s << ch;
                     }
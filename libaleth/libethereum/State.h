@@ -10,6 +10,7 @@
 #include "Transaction.h"
 #include "TransactionReceipt.h"
 #include "Message.h"
+#include <libdevcore/Arena.h>
 #include <libdevcore/Common.h>
 #include <libdevcore/OverlayDB.h>
 #include <libdevcore/RLP.h>
@@ -18,6 +19,8 @@
 #include <libethereum/CodeSizeCache.h>
 #include <libevm/ExtVMFace.h>
 #include <array>
+#include <map>
+#include <set>
 #include <unordered_map>
 
 namespace dev
@@ -66,6 +69,7 @@ enum class Permanence
 
 DEV_SIMPLE_EXCEPTION(InvalidAccountStartNonceInState);
 DEV_SIMPLE_EXCEPTION(IncorrectAccountStartNonceInState);
+DEV_SIMPLE_EXCEPTION(NotAForkOfThisState);
 
 class SealEngineFace;
 class Executive;
@@ -149,6 +153,14 @@ using ChangeLog = std::vector<Change>;
  * In case some changes must be reverted, the changes are popped from the
  * changelog and undone. For possible atomic changes list @see Change::Kind.
  * The changelog is managed by savepoint(), rollback() and commit() methods.
+ *
+ * # Forks
+ *
+ * fork() makes a child state that behaves like a copy, but copies nothing up front: it reads
+ * through to the accounts its parent cached and to the nodes of the parent's overlay, and keeps
+ * only its own changes. The child is discarded by destroying it or merged back with merge().
+ * The parent must outlive its forks and is read-only while they exist: no account changes,
+ * commit(), setRoot() or merge() of another fork until they are destroyed or one is merged.
  */
 class State
 {
@@ -184,6 +196,21 @@ public:
     /// Copy state object.
     State& operator=(State const& _s);
 
+    /// @returns a copy-on-write child of this state, see Forks. Nothing is copied up front, every
+    /// account is read from this state on first access, changed or not. A commit in the fork
+    /// copies the changed accounts it has not read. Several forks of a state can be used
+    /// concurrently.
+    /// @warning This state must not change while the fork exists: the fork reads its cached
+    /// accounts and overlay without locking and without checking they are still those it forked.
+    State fork() const;
+
+    /// Makes this state equal to @a _fork, a fork of it: the accounts the fork read or changed, its
+    /// trie nodes and changelog are moved here, the other accounts cached here are left alone.
+    /// If the fork was committed, this state's own cache is dropped as well.
+    /// Other forks of this state must not be used afterwards, @a _fork must only be destroyed.
+    /// @throws NotAForkOfThisState if @a _fork was not forked from this state.
+    void merge(State&& _fork);
+
     /// Open a DB - useful for passing into the constructor & keeping for other states that are necessary.
     static OverlayDB openDB(boost::filesystem::path const& _path, h256 const& _genesisHash, WithExisting _we = WithExisting::Trust);
     OverlayDB const& db() const { return m_db; }
@@ -202,8 +229,10 @@ public:
     std::pair<AddressMap, h256> addresses(h256 const& _begin, size_t _maxResults) const;
 
     /// Execute a given transaction.
-    /// This will change the state accordingly.
-    std::pair<ExecutionResult, TransactionReceipt> execute(EnvInfo const& _envInfo, SealEngineFace const& _sealEngine, Transaction const& _t, Permanence _p = Permanence::Committed, OnOpFunc const& _onOp = OnOpFunc());
+    /// This will change the state accordingly. The execution is reported to @a _tracer if given.
+    /// @throws ExecutionBudgetExceeded if @a _budget is given and exhausted, the state is left
+    /// as it was before the transaction.
+    std::pair<ExecutionResult, TransactionReceipt> execute(EnvInfo const& _envInfo, SealEngineFace const& _sealEngine, Transaction const& _t, Permanence _p = Permanence::Committed, OnOpFunc const& _onOp = OnOpFunc(), VMTracer* _tracer = nullptr, ExecutionBudget* _budget = nullptr);
 
     /// Execute a given message.
     /// This will change the state accordingly.
@@ -286,6 +315,11 @@ public:
     ///          other account. Do not keep it.
     bytes const& code(Address const& _addr) const;
 
+    /// Get the code of an account without copying it, the code stays valid as long as it
+    /// is referenced. Code is shared through CodeCache.
+    /// @returns nullptr if no account exists at that address or it has no code.
+    SharedCode sharedCode(Address const& _addr) const;
+
     /// Get the code hash of an account.
     /// @returns EmptySHA3 if no account exists at that address or if there is no code associated with the address.
     h256 codeHash(Address const& _contract) const;
@@ -336,6 +370,13 @@ public:
     /// Revert all recent changes up to the given @p _savepoint savepoint.
     void rollback(size_t _savepoint);
 
+    /// Revert all changes of whole transactions executed since @p _savepoint, including the ones
+    /// rollback() keeps: accounts killed since then are dropped from the cache and unrevertable
+    /// touches are forgotten. The accounts read meanwhile stay cached. Discarding down to
+    /// savepoint 0 also resets the warmed addresses, see resetWarmed().
+    /// Nothing must have been committed since @p _savepoint.
+    void discard(size_t _savepoint);
+
     ChangeLog const& changeLog() const { return m_changeLog; }
 
     /// Access account.
@@ -344,7 +385,32 @@ public:
     /// Access account storage.
     bool accessStorage(Address const& _addr, u256 const& _key);
 
+    /// Addresses and storage keys accessed by executed code.
+    using AccessedSet = std::map<Address, std::set<u256>>;
+
+    /// Records every address and storage key accessed by executed code in @a _accessed, also the
+    /// accesses of frames that are reverted later. nullptr stops recording.
+    void setAccessRecorder(AccessedSet* _accessed) { m_accessRecorder = _accessed; }
+
+    /// Notes an account access of executed code, see setAccessRecorder().
+    void recordAccess(Address const& _addr)
+    {
+        if (m_accessRecorder)
+            (*m_accessRecorder)[_addr];
+    }
+
+    /// Notes a storage access of executed code, see setAccessRecorder().
+    void recordAccess(Address const& _addr, u256 const& _key)
+    {
+        if (m_accessRecorder)
+            (*m_accessRecorder)[_addr].insert(_key);
+    }
+
 private:
+    /// Creates a fork of @a _parent, see fork().
+    struct ForkTag {};
+    State(ForkTag, State const& _parent);
+
     /// Turns all "touched" empty accounts into non-alive accounts.
     void removeEmptyAccounts();
 
@@ -359,12 +425,19 @@ private:
     /// Purges non-modified entries in m_cache if it grows too large.
     void clearCacheIfTooLarge() const;
 
+    /// Copies the changed accounts of the states a fork reads through that it has not read yet,
+    /// before all of m_cache is walked, e.g. to commit it.
+    void copyParentChanges() const;
+
     void createAccount(Address const& _address, Account const&& _account);
 
     /// @returns true when normally halted; false when exceptionally halted; throws when internal VM
     /// exception occurred.
     bool executeTransaction(Executive& _e, Transaction const& _t, OnOpFunc const& _onOp);
 
+    /// Forget all warmed addresses and reuse their memory.
+    void resetWarmed();
+
     /// Check an address is warmed.
     bool isWarmedAddress(Address const& _addr) const { return m_warmed.count(_addr) > 0; }
 
@@ -392,8 +465,21 @@ private:
     AddressHash m_touched;
     /// Tracks addresses that were touched and should stay touched in case of rollback
     AddressHash m_unrevertablyTouched;
+    /// Holds the warmed addresses until the next commit(), setRoot() or discard(0), see resetWarmed().
+    /// Declared before m_warmed, which must be destroyed first.
+    Arena m_arena;
     /// Tracks all warmed addresses
-    std::unordered_map<Address, std::set<h256>> m_warmed;
+    std::pmr::unordered_map<Address, std::pmr::set<h256>> m_warmed{&m_arena};
+    /// Receives the accesses of executed code, not copied with the state.
+    AccessedSet* m_accessRecorder = nullptr;
+    /// The state this one is a fork of, see fork().
+    State const* m_parent = nullptr;
+    /// Whether the accounts cached by the parent are still those of this state, i.e. this
+    /// state is a fork that has not been committed or moved to another root.
+    bool m_readsThroughParent = false;
+    /// Whether commit() or setRoot() ran on this state since it was forked. merge() then
+    /// replaces everything cached by the parent instead of layering the fork's changes on it.
+    bool m_committedSinceFork = false;
 
     u256 m_accountStartNonce;
 
@@ -0,0 +1,161 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "StateDumper.h"
+
+#include <libdevcore/RLP.h>
+#include <libdevcore/TaskPool.h>
+#include <libdevcore/TrieDB.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace dev
+{
+namespace eth
+{
+
+StateDumper::StateDumper(OverlayDB const& _db, h256 const& _root, StateDumpOptions const& _options)
+  : m_db(_db), m_root(_root), m_options(_options)
+{
+    if (m_options.ranges != 16 && m_options.ranges != 256)
+        BOOST_THROW_EXCEPTION(InvalidStateDumpOptions() << errinfo_comment("ranges must be 16 or 256"));
+    if (m_options.batchSize == 0)
+        BOOST_THROW_EXCEPTION(InvalidStateDumpOptions() << errinfo_comment("batch size must be positive"));
+    if (m_options.includeStorage && m_options.storageBatchSize == 0)
+        BOOST_THROW_EXCEPTION(InvalidStateDumpOptions() << errinfo_comment("storage batch size must be positive"));
+
+    if (m_options.threads == 0)
+        m_options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // throws RootNotFound for an unknown root
+    GenericTrieDB<OverlayDB> trie(&m_db, m_root);
+}
+
+h256 StateDumper::rangeBegin(unsigned _index) const
+{
+    h256 ret;
+    ret[0] = static_cast<byte>(m_options.ranges == 16 ? _index << 4 : _index);
+    return ret;
+}
+
+StateDumper::RangeResult StateDumper::walkRange(
+    unsigned _index, StateDumpRangeCursor const& _from, size_t _accountLimit, size_t _slotLimit) const
+{
+    RangeResult ret;
+    bool const last = _index + 1 == m_options.ranges;
+    h256 const end = last ? h256() : rangeBegin(_index + 1);
+
+    GenericTrieDB<OverlayDB> trie(&m_db, m_root);
+    for (auto it = trie.lower_bound(_from.account.ref()); it != trie.end(); ++it)
+    {
+        auto const item = *it;
+        h256 const hashedAddress(item.first);
+        if (!last && hashedAddress >= end)
+            break;
+
+        if (ret.accounts.size() == _accountLimit || (m_options.includeStorage && ret.slots == _slotLimit))
+        {
+            // there is at least one more account in this range, remember where it is
+            ret.next.account = hashedAddress;
+            return ret;
+        }
+
+        StateDumpAccount account{hashedAddress, item.second.toBytes(), {}};
+        if (m_options.includeStorage)
+        {
+            h256 const storageRoot = RLP(item.second)[2].toHash<h256>();
+            if (storageRoot != EmptyTrie)
+            {
+                GenericTrieDB<OverlayDB> storage(&m_db, storageRoot);
+                bool const resume = _from.inStorage && hashedAddress == _from.account;
+                for (auto slot = resume ? storage.lower_bound(_from.slot.ref()) : storage.begin();
+                     slot != storage.end(); ++slot)
+                {
+                    auto const entry = *slot;
+                    if (ret.slots == _slotLimit)
+                    {
+                        // the rest of the storage goes to the next batch
+                        account.storageComplete = false;
+                        ret.accounts.push_back(std::move(account));
+                        ret.next.account = hashedAddress;
+                        ret.next.slot = h256(entry.first);
+                        ret.next.inStorage = true;
+                        return ret;
+                    }
+                    account.storage.emplace_back(h256(entry.first), entry.second.toBytes());
+                    ++ret.slots;
+                }
+            }
+        }
+        ret.accounts.push_back(std::move(account));
+    }
+
+    ret.next.finished = true;
+    return ret;
+}
+
+StateDumpBatch StateDumper::next(StateDumpCursor const& _cursor) const
+{
+    StateDumpBatch ret;
+    if (_cursor.empty())
+    {
+        ret.next.resize(m_options.ranges);
+        for (unsigned i = 0; i < m_options.ranges; ++i)
+            ret.next[i].account = rangeBegin(i);
+    }
+    else if (_cursor.size() == m_options.ranges)
+        ret.next = _cursor;
+    else
+        BOOST_THROW_EXCEPTION(
+            InvalidStateDumpOptions() << errinfo_comment("cursor doesn't match the number of ranges"));
+
+    // every round splits what is left of the budgets between the unfinished ranges and walks
+    // them in parallel. A range stops only at the end or at its share, so every round either
+    // finishes a range or uses up a share, and the next round hands the rest to the others
+    std::vector<std::vector<StateDumpAccount>> accounts(m_options.ranges);
+    size_t accountSpace = m_options.batchSize;
+    size_t slotSpace = m_options.includeStorage ? m_options.storageBatchSize : 0;
+    while (accountSpace > 0 && (!m_options.includeStorage || slotSpace > 0))
+    {
+        std::vector<unsigned> active;
+        for (unsigned i = 0; i < m_options.ranges; ++i)
+            if (!ret.next[i].finished)
+                active.push_back(i);
+        if (active.empty())
+            break;
+
+        // every walked range gets at least one account and one slot
+        size_t count = std::min(active.size(), accountSpace);
+        if (m_options.includeStorage)
+            count = std::min(count, slotSpace);
+        active.resize(count);
+
+        std::vector<RangeResult> results(count);
+        TaskPool::shared().parallelFor(count, m_options.threads, [&](size_t j) {
+            size_t const accountShare = accountSpace / count + (j < accountSpace % count ? 1 : 0);
+            size_t const slotShare = slotSpace / count + (j < slotSpace % count ? 1 : 0);
+            results[j] = walkRange(active[j], ret.next[active[j]], accountShare, slotShare);
+        });
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            RangeResult& result = results[j];
+            accountSpace -= result.accounts.size();
+            slotSpace -= result.slots;
+            ret.next[active[j]] = result.next;
+            for (auto& account: result.accounts)
+                accounts[active[j]].push_back(std::move(account));
+        }
+    }
+
+    for (auto& range: accounts)
+        for (auto& account: range)
+            ret.accounts.push_back(std::move(account));
+
+    ret.finished = std::all_of(ret.next.begin(), ret.next.end(),
+        [](StateDumpRangeCursor const& _range) { return _range.finished; });
+    return ret;
+}
+}
+}
@@ -0,0 +1,125 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Class for walking the accounts of a State Trie in hashed-key order
+#pragma once
+
+#include <libdevcore/Common.h>
+#include <libdevcore/Exceptions.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/OverlayDB.h>
+
+#include <vector>
+
+namespace dev
+{
+namespace eth
+{
+
+DEV_SIMPLE_EXCEPTION(InvalidStateDumpOptions);
+
+/// A single account of the state trie.
+struct StateDumpAccount
+{
+    h256 hashedAddress;
+    /// Account RLP exactly as it is stored in the trie.
+    bytes account;
+    /// Hashed storage key and RLP encoded value, only filled when storage is requested.
+    std::vector<std::pair<h256, bytes>> storage;
+    /// False if the storage continues in the same account at the start of its range in the next batch.
+    bool storageComplete = true;
+};
+
+/// Position to resume a single range from.
+struct StateDumpRangeCursor
+{
+    /// Hashed address of the first account not returned yet.
+    h256 account;
+    /// Hashed key of the first storage slot of @a account not returned yet, if @a inStorage.
+    h256 slot;
+    /// True if @a account was returned with part of its storage, which continues at @a slot.
+    bool inStorage = false;
+    /// True if every account of the range was returned.
+    bool finished = false;
+};
+
+/// Position to resume every range from, in range order. Empty to start at the beginning.
+using StateDumpCursor = std::vector<StateDumpRangeCursor>;
+
+/// A batch of accounts and the position to resume from.
+struct StateDumpBatch
+{
+    /// Accounts of every range in hashed-address order, the ranges in order.
+    std::vector<StateDumpAccount> accounts;
+    /// Position of the next batch, only meaningful if @a finished is false.
+    StateDumpCursor next;
+    /// True if every range has been walked.
+    bool finished = false;
+};
+
+struct StateDumpOptions
+{
+    /// Number of ranges the keyspace is split into, 16 (first nibble) or 256 (first byte).
+    unsigned ranges = 16;
+    /// Number of ranges walked concurrently, 0 means one per hardware thread.
+    unsigned threads = 0;
+    /// Maximum number of accounts returned in a single batch.
+    size_t batchSize = 256;
+    /// Whether to load the storage of every returned account.
+    bool includeStorage = false;
+    /// Maximum number of storage slots returned in a single batch.
+    size_t storageBatchSize = 4096;
+};
+
+/**
+ * Walks the account trie of a given state root in hashed-key order.
+ *
+ * The keyspace is split into nibble ranges, each with its own position in the
+ * cursor. A batch walks the unfinished ranges in parallel on the shared TaskPool,
+ * each with a share of the batch's account and storage slot budgets, in rounds
+ * until the budgets are used up or every range is finished. The accounts of every
+ * range are merged back in range order. Storage is resumable too, so a batch is
+ * bounded however large a contract is: an account whose storage does not fit is
+ * returned again with the following slots.
+ */
+class StateDumper
+{
+public:
+    /// @throws RootNotFound if @a _root is not in the database.
+    StateDumper(OverlayDB const& _db, h256 const& _root, StateDumpOptions const& _options = StateDumpOptions());
+
+    /// @returns at most StateDumpOptions::batchSize accounts and StateDumpOptions::storageBatchSize
+    /// slots from the positions of @a _cursor.
+    /// @throws InvalidStateDumpOptions if @a _cursor has a different number of ranges.
+    StateDumpBatch next(StateDumpCursor const& _cursor = StateDumpCursor()) const;
+
+    h256 const& root() const { return m_root; }
+
+private:
+    /// Result of walking a single range.
+    struct RangeResult
+    {
+        std::vector<StateDumpAccount> accounts;
+        /// Number of storage slots in @a accounts.
+        size_t slots = 0;
+        /// Position to resume the range from.
+        StateDumpRangeCursor next;
+    };
+
+    /// Walks the range @a _index from @a _from and collects at most @a _accountLimit accounts
+    /// and @a _slotLimit storage slots.
+    RangeResult walkRange(unsigned _index, StateDumpRangeCursor const& _from, size_t _accountLimit,
+        size_t _slotLimit) const;
+
+    /// @returns the first hashed key of the range @a _index.
+    h256 rangeBegin(unsigned _index) const;
+
+    mutable OverlayDB m_db;
+    h256 m_root;
+    StateDumpOptions m_options;
+};
+
+}
+}
@@ -0,0 +1,465 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "StatePruner.h"
+
+#include <libdevcore/SHA3.h>
+#include <libdevcore/TrieCommon.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace dev
+{
+namespace eth
+{
+
+namespace
+{
+/// Key of the persisted list of retained roots, not 32 bytes long so it is never swept.
+char const c_retainedRootsKey[] = "statePrunerRetainedRoots";
+
+/// Prefix of the marker records of the marked set, the keys are longer than 32 bytes so they are never swept.
+char const c_markPrefix[] = "statePrunerMark";
+
+db::Slice retainedRootsKey()
+{
+    return db::Slice(c_retainedRootsKey, sizeof(c_retainedRootsKey) - 1);
+}
+
+db::Slice toSlice(h256 const& _h)
+{
+    return db::Slice(reinterpret_cast<char const*>(_h.data()), _h.size);
+}
+
+db::Slice toSlice(std::string const& _s)
+{
+    return db::Slice(_s.data(), _s.size());
+}
+
+std::string markKey(h256 const& _h)
+{
+    return std::string(c_markPrefix) + std::string(reinterpret_cast<char const*>(_h.data()), _h.size);
+}
+
+bool isMarkKey(db::Slice _key)
+{
+    size_t const prefixSize = sizeof(c_markPrefix) - 1;
+    return _key.size() >= prefixSize && std::equal(c_markPrefix, c_markPrefix + prefixSize, _key.data());
+}
+}  // namespace
+
+/// Nodes reachable from the retained roots. Every node is a marker record in the database,
+/// a bloom filter answers most lookups of unmarked nodes without reading it.
+class StatePruner::MarkedSet
+{
+public:
+    MarkedSet(db::DatabaseFace& _db, size_t _filterBytes, size_t _batchSize)
+      : m_db(_db), m_filter(std::max<size_t>(_filterBytes / sizeof(uint64_t), 1)), m_batchSize(_batchSize)
+    {}
+
+    /// Marks @a _h.
+    /// @returns false if it was marked already.
+    bool insert(h256 const& _h)
+    {
+        if (contains(_h))
+            return false;
+
+        forEachBit(_h, [&](size_t _word, uint64_t _bit) { m_filter[_word] |= _bit; });
+        m_buffered.insert(_h);
+        ++m_size;
+        if (m_buffered.size() >= m_batchSize)
+            flush();
+        return true;
+    }
+
+    bool contains(h256 const& _h) const
+    {
+        bool maybe = true;
+        forEachBit(_h, [&](size_t _word, uint64_t _bit) { maybe = maybe && (m_filter[_word] & _bit); });
+        return maybe && (m_buffered.count(_h) || m_db.exists(toSlice(markKey(_h))));
+    }
+
+    /// Writes the buffered markers.
+    void flush()
+    {
+        if (m_buffered.empty())
+            return;
+
+        auto batch = m_db.createWriteBatch();
+        for (auto const& h: m_buffered)
+            batch->insert(toSlice(markKey(h)), db::Slice());
+        m_db.commit(std::move(batch));
+        m_buffered.clear();
+    }
+
+    uint64_t size() const { return m_size; }
+
+private:
+    /// Calls @a _f with the 4 filter bits of @a _h, taken from the hash itself as it is uniformly distributed.
+    template <class F>
+    void forEachBit(h256 const& _h, F const& _f) const
+    {
+        size_t const bits = m_filter.size() * 64;
+        for (size_t i = 0; i < h256::size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, _h.data() + i, sizeof(word));
+            size_t const bit = word % bits;
+            _f(bit / 64, uint64_t(1) << (bit % 64));
+        }
+    }
+
+    db::DatabaseFace& m_db;
+    std::vector<uint64_t> m_filter;
+    /// Markers not written yet.
+    h256Hash m_buffered;
+    size_t m_batchSize;
+    uint64_t m_size = 0;
+};
+
+StatePruner::StatePruner(std::shared_ptr<db::DatabaseFace> _db, StatePrunerOptions const& _options)
+  : Worker("pruner", 1000), m_db(std::move(_db)), m_options(_options)
+{
+    if (m_options.retainedRoots == 0 || m_options.interval == 0 || m_options.batchSize == 0 ||
+        m_options.markFilterBytes == 0)
+        BOOST_THROW_EXCEPTION(InvalidStatePrunerOptions());
+
+    loadRoots();
+}
+
+StatePruner::~StatePruner()
+{
+    terminate();
+}
+
+void StatePruner::retainRoot(h256 const& _root)
+{
+    Guard l(x_roots);
+    if (!m_roots.empty() && m_roots.back() == _root)
+        return;
+
+    m_roots.push_back(_root);
+    while (m_roots.size() > m_options.retainedRoots)
+        m_roots.pop_front();
+    ++m_newRoots;
+    m_hasFreshRoot = true;
+    saveRoots();
+
+    // the commit writing the root and those before are reachable from it or garbage, later
+    // commits, e.g. of the next block, are not, a cycle sees either both the root and the
+    // released nodes or neither
+    Guard w(x_written);
+    auto const written = m_pending.find(_root);
+    if (written != m_pending.end())
+        release(written->second);
+    // the nodes of a sync can't be told apart by commit, the target root is imported first
+    if (m_imported.count(_root))
+        m_imported.clear();
+}
+
+void StatePruner::noteWritten(h256s const& _hashes)
+{
+    Guard l(x_written);
+    uint64_t const seq = ++m_commitSeq;
+    for (auto const& h: _hashes)
+    {
+        m_pending[h] = seq;
+        if (m_cycleActive)
+            m_protected.insert(h);
+    }
+    m_commits.emplace_back(seq, _hashes);
+}
+
+void StatePruner::noteImported(h256s const& _hashes)
+{
+    Guard l(x_written);
+    for (auto const& h: _hashes)
+    {
+        m_imported.insert(h);
+        if (m_cycleActive)
+            m_protected.insert(h);
+    }
+}
+
+void StatePruner::release(uint64_t _seq)
+{
+    while (!m_commits.empty() && m_commits.front().first <= _seq)
+    {
+        auto const& commit = m_commits.front();
+        for (auto const& h: commit.second)
+        {
+            // a node written again by a later commit stays protected by it
+            auto const it = m_pending.find(h);
+            if (it != m_pending.end() && it->second == commit.first)
+                m_pending.erase(it);
+        }
+        m_commits.pop_front();
+    }
+}
+
+h256s StatePruner::retainedRoots() const
+{
+    Guard l(x_roots);
+    return h256s(m_roots.begin(), m_roots.end());
+}
+
+StatePrunerStats StatePruner::stats() const
+{
+    Guard l(x_stats);
+    return m_stats;
+}
+
+void StatePruner::doWork()
+{
+    {
+        Guard l(x_roots);
+        if (!m_hasFreshRoot || m_newRoots < m_options.interval)
+            return;
+        m_newRoots = 0;
+    }
+
+    try
+    {
+        prune();
+    }
+    catch (std::exception const& _e)
+    {
+        cwarn << "State pruning failed: " << _e.what();
+    }
+
+    Guard l(x_written);
+    m_protected.clear();
+    m_cycleActive = false;
+}
+
+void StatePruner::prune()
+{
+    auto const start = steady_clock::now();
+    m_windowOps = 0;
+    m_windowStart = start;
+
+    // taken together with the pending nodes, a root retained in between would be in neither
+    h256s roots;
+    {
+        Guard l(x_roots);
+        Guard w(x_written);
+        roots.assign(m_roots.begin(), m_roots.end());
+        m_protected = m_imported;
+        for (auto const& written: m_pending)
+            m_protected.insert(written.first);
+        m_cycleActive = true;
+    }
+    DEV_GUARDED(x_stats)
+        m_stats.running = true;
+
+    // markers left by an interrupted cycle would hide reachable nodes from this one
+    MarkedSet marked(*m_db, m_options.markFilterBytes, m_options.batchSize);
+    uint64_t swept = 0;
+    bool const finished = clearMarks() && mark(roots, marked) && sweep(marked, swept) && clearMarks();
+
+    DEV_GUARDED(x_stats)
+    {
+        m_stats.running = false;
+        m_stats.marked = marked.size();
+        m_stats.swept = swept;
+        m_stats.totalSwept += swept;
+        if (finished)
+        {
+            ++m_stats.cycles;
+            m_stats.lastCycleMs = duration_cast<milliseconds>(steady_clock::now() - start).count();
+        }
+    }
+
+    LOG(m_logger) << "Pruned " << swept << " nodes, " << marked.size() << " reachable from "
+                  << roots.size() << " roots" << (finished ? "" : " (interrupted)");
+}
+
+bool StatePruner::mark(h256s const& _roots, MarkedSet& o_marked)
+{
+    h256s storageRoots;
+    h256s pending(_roots.begin(), _roots.end());
+    bool accounts = true;
+
+    // walk the account tries first, then every storage trie found on the way
+    while (true)
+    {
+        if (pending.empty())
+        {
+            if (!accounts || storageRoots.empty())
+            {
+                o_marked.flush();
+                return true;
+            }
+            accounts = false;
+            pending.swap(storageRoots);
+        }
+
+        h256 const h = pending.back();
+        pending.pop_back();
+        // shared subtrees are visited once
+        if (!o_marked.insert(h))
+            continue;
+
+        if (shouldStop())
+            return false;
+        throttle();
+
+        std::string const node = m_db->lookup(toSlice(h));
+        if (node.empty())
+        {
+            if (h != EmptyTrie)
+                cwarn << "Missing trie node while pruning: " << h;
+            continue;
+        }
+        markNode(RLP(node), pending, accounts ? &storageRoots : nullptr, o_marked);
+    }
+}
+
+void StatePruner::markNode(RLP const& _node, h256s& o_pending, h256s* o_storage, MarkedSet& o_marked)
+{
+    forEachChild(_node, [&](h256 const& _child) { o_pending.push_back(_child); },
+        [&](bytesConstRef _value) {
+            if (!o_storage)
+                return;
+
+            RLP const account(_value);
+            if (account.isList() && account.itemCount() >= 4)
+            {
+                h256 const storageRoot = account[2].toHash<h256>();
+                if (storageRoot != EmptyTrie)
+                    o_storage->push_back(storageRoot);
+                h256 const codeHash = account[3].toHash<h256>();
+                if (codeHash != EmptySHA3)
+                    o_marked.insert(codeHash);
+            }
+        });
+}
+
+bool StatePruner::sweep(MarkedSet const& _marked, uint64_t& o_swept)
+{
+    // every chunk reads from a fresh iterator, so no snapshot is pinned for the whole sweep
+    std::string from;
+    while (true)
+    {
+        if (shouldStop())
+            return false;
+
+        h256s batch;
+        unsigned visited = 0;
+        m_db->forEachFrom(toSlice(from), [&](db::Slice _key, db::Slice _value) {
+            from.assign(_key.data(), _key.size());
+            ++visited;
+
+            // only content-addressed records are candidates, this skips aux entries and foreign data
+            if (_key.size() == h256::size)
+            {
+                h256 const key(bytesConstRef(reinterpret_cast<byte const*>(_key.data()), _key.size()));
+                if (!_marked.contains(key) &&
+                    sha3(bytesConstRef(reinterpret_cast<byte const*>(_value.data()), _value.size())) == key)
+                    batch.push_back(key);
+            }
+            return visited < m_options.batchSize;
+        });
+
+        size_t const deleted = batch.empty() ? 0 : deleteBatch(batch);
+        o_swept += deleted;
+        throttle(visited + deleted);
+
+        if (visited < m_options.batchSize)
+            return true;
+        // resume right after the last key visited
+        from.push_back('\0');
+    }
+}
+
+bool StatePruner::clearMarks()
+{
+    std::string from(c_markPrefix);
+    while (true)
+    {
+        if (shouldStop())
+            return false;
+
+        std::vector<std::string> keys;
+        m_db->forEachFrom(toSlice(from), [&](db::Slice _key, db::Slice) {
+            // the marker records are contiguous, the first other key ends them
+            if (!isMarkKey(_key))
+                return false;
+            keys.push_back(_key.toString());
+            return keys.size() < m_options.batchSize;
+        });
+        if (keys.empty())
+            return true;
+
+        auto writeBatch = m_db->createWriteBatch();
+        for (auto const& key: keys)
+            writeBatch->kill(toSlice(key));
+        m_db->commit(std::move(writeBatch));
+        throttle(keys.size() * 2);
+
+        from = keys.back();
+        from.push_back('\0');
+    }
+}
+
+size_t StatePruner::deleteBatch(h256s const& _keys)
+{
+    // hold the lock until the batch is written, a node noted afterwards is written after it is deleted
+    Guard l(x_written);
+    auto writeBatch = m_db->createWriteBatch();
+    size_t count = 0;
+    for (auto const& key: _keys)
+        if (!m_protected.count(key))
+        {
+            writeBatch->kill(toSlice(key));
+            ++count;
+        }
+
+    if (count)
+        m_db->commit(std::move(writeBatch));
+    return count;
+}
+
+void StatePruner::throttle(unsigned _ops)
+{
+    m_windowOps += _ops;
+    if (!m_options.maxOpsPerSecond || m_windowOps < m_options.maxOpsPerSecond)
+        return;
+
+    // a chunk may exceed the rate on its own, sleep for as long as its operations are due
+    auto const due = microseconds(uint64_t(m_windowOps) * 1000000 / m_options.maxOpsPerSecond);
+    auto const elapsed = steady_clock::now() - m_windowStart;
+    if (elapsed < due)
+        this_thread::sleep_for(due - elapsed);
+    m_windowOps = 0;
+    m_windowStart = steady_clock::now();
+}
+
+void StatePruner::loadRoots()
+{
+    std::string const value = m_db->lookup(retainedRootsKey());
+    if (value.empty())
+        return;
+
+    for (auto const& item: RLP(value))
+        m_roots.push_back(item.toHash<h256>());
+    while (m_roots.size() > m_options.retainedRoots)
+        m_roots.pop_front();
+}
+
+void StatePruner::saveRoots()
+{
+    RLPStream s(m_roots.size());
+    for (auto const& root: m_roots)
+        s << root;
+    bytes const& out = s.out();
+    m_db->insert(retainedRootsKey(), db::Slice(reinterpret_cast<char const*>(out.data()), out.size()));
+}
+
+}
+}
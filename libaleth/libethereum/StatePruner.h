@@ -0,0 +1,187 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Background mark-and-sweep pruning of the state database
+#pragma once
+
+#include <libdevcore/Common.h>
+#include <libdevcore/Exceptions.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/Guards.h>
+#include <libdevcore/Log.h>
+#include <libdevcore/RLP.h>
+#include <libdevcore/Worker.h>
+#include <libdevcore/db.h>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+namespace dev
+{
+namespace eth
+{
+
+DEV_SIMPLE_EXCEPTION(InvalidStatePrunerOptions);
+
+struct StatePrunerOptions
+{
+    /// Number of most recent state roots that are never pruned.
+    unsigned retainedRoots = 128;
+    /// Number of newly retained roots between two prune cycles.
+    unsigned interval = 128;
+    /// Upper bound of database reads and deletes per second, 0 means unlimited.
+    unsigned maxOpsPerSecond = 20000;
+    /// Number of records read or written in a single chunk of the sweep.
+    unsigned batchSize = 1000;
+    /// Size in bytes of the in-memory filter in front of the on-disk marked set.
+    unsigned markFilterBytes = 16 * 1024 * 1024;
+};
+
+struct StatePrunerStats
+{
+    /// Number of completed prune cycles.
+    uint64_t cycles = 0;
+    /// Number of nodes found reachable in the last cycle.
+    uint64_t marked = 0;
+    /// Number of nodes deleted in the last cycle.
+    uint64_t swept = 0;
+    /// Number of nodes deleted since the pruner was created.
+    uint64_t totalSwept = 0;
+    /// Duration of the last cycle in milliseconds.
+    uint64_t lastCycleMs = 0;
+    /// True while a cycle is running.
+    bool running = false;
+};
+
+/**
+ * Deletes trie nodes and code that are no longer reachable from the last
+ * StatePrunerOptions::retainedRoots state roots.
+ *
+ * A cycle marks every node reachable from the retained roots and then sweeps
+ * the database, deleting the content-addressed 32 byte records (sha3(value) == key)
+ * that were not marked. Nodes written while a cycle is running, or written
+ * before their root was retained, are reported through OverlayDB's commit
+ * observer (see noteWritten()) and are never deleted by that cycle. Every
+ * commit is numbered, retaining a root releases the nodes of the commit that
+ * wrote it and of the commits before, the nodes of later commits stay
+ * protected until their own root is retained. Nodes imported by state sync
+ * (see noteImported()) stay protected until one of them is retained as a root.
+ *
+ * The marked set is kept as marker records in the database behind an in-memory
+ * bloom filter of StatePrunerOptions::markFilterBytes, so memory use does not
+ * grow with the state. The sweep walks the database in chunks of
+ * StatePrunerOptions::batchSize records, each read from a fresh iterator and
+ * followed by its deletes, and is throttled between chunks.
+ *
+ * Only unreachable records are ever deleted and the retained roots are
+ * persisted on every change, so a crash at any point leaves at most some
+ * garbage for the next cycle. All database operations are rate limited.
+ *
+ * @warning Every content-addressed record in the database is treated as part
+ * of the state, roots of other tries sharing the database must be retained too.
+ */
+class StatePruner: Worker
+{
+public:
+    StatePruner(std::shared_ptr<db::DatabaseFace> _db, StatePrunerOptions const& _options = StatePrunerOptions());
+    ~StatePruner();
+
+    /// Starts the background thread.
+    void start() { startWorking(); }
+
+    /// Stops the background thread, interrupting a running cycle.
+    void stop() { stopWorking(); }
+
+    /// Retains @a _root, the oldest retained root is released once there are more than
+    /// StatePrunerOptions::retainedRoots.
+    void retainRoot(h256 const& _root);
+
+    /// Notes the nodes of a commit about to be written to the database, must be called before they are written.
+    void noteWritten(h256s const& _hashes);
+
+    /// Notes nodes about to be imported by state sync, must be called before they are written.
+    /// They are protected until one of the imported nodes is retained as a root, the sync target
+    /// should be retained once its sync completed.
+    void noteImported(h256s const& _hashes);
+
+    /// @returns the currently retained roots, the oldest first.
+    h256s retainedRoots() const;
+
+    StatePrunerStats stats() const;
+
+private:
+    class MarkedSet;
+
+    void doWork() override;
+
+    /// Runs a whole mark-and-sweep cycle.
+    void prune();
+
+    /// Marks every node reachable from @a _roots.
+    /// @returns false if the pruner was stopped meanwhile.
+    bool mark(h256s const& _roots, MarkedSet& o_marked);
+
+    /// Marks the children of @a _node, pushing referenced nodes to @a o_pending.
+    /// Accounts found in leaves push their storage roots to @a o_storage and mark their code.
+    void markNode(RLP const& _node, h256s& o_pending, h256s* o_storage, MarkedSet& o_marked);
+
+    /// Deletes every unmarked content-addressed record.
+    /// @returns false if the pruner was stopped meanwhile.
+    bool sweep(MarkedSet const& _marked, uint64_t& o_swept);
+
+    /// Deletes the marker records left by a cycle.
+    /// @returns false if the pruner was stopped meanwhile.
+    bool clearMarks();
+
+    /// Stops protecting the nodes of the commits numbered up to @a _seq.
+    void release(uint64_t _seq);
+
+    /// Deletes @a _keys unless they were written since the cycle started.
+    size_t deleteBatch(h256s const& _keys);
+
+    /// Accounts for @a _ops database operations, sleeping if the pruner exceeds
+    /// StatePrunerOptions::maxOpsPerSecond.
+    void throttle(unsigned _ops = 1);
+
+    void loadRoots();
+    void saveRoots();
+
+    std::shared_ptr<db::DatabaseFace> m_db;
+    StatePrunerOptions m_options;
+
+    /// Taken before x_written when both are held.
+    mutable Mutex x_roots;
+    std::deque<h256> m_roots;
+    /// Number of roots retained since the last cycle.
+    unsigned m_newRoots = 0;
+    /// True once a root was retained by this instance, nothing is pruned before.
+    bool m_hasFreshRoot = false;
+
+    Mutex x_written;
+    /// Nodes written since the retained root of their commit, by number of their latest commit.
+    std::unordered_map<h256, uint64_t> m_pending;
+    /// Numbers and nodes of the commits in m_pending, the oldest first.
+    std::deque<std::pair<uint64_t, h256s>> m_commits;
+    /// Number of the latest commit.
+    uint64_t m_commitSeq = 0;
+    /// Nodes imported since an imported node was retained.
+    h256Hash m_imported;
+    /// Nodes the running cycle must not delete.
+    h256Hash m_protected;
+    bool m_cycleActive = false;
+
+    mutable Mutex x_stats;
+    StatePrunerStats m_stats;
+
+    unsigned m_windowOps = 0;
+    std::chrono::steady_clock::time_point m_windowStart;
+
+    Logger m_logger{createLogger(VerbosityInfo, "pruner")};
+};
+
+}
+}
@@ -0,0 +1,107 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "StatelessExecution.h"
+#include "State.h"
+
+#include <libdevcore/MemoryDB.h>
+#include <libdevcore/OverlayDB.h>
+#include <libdevcore/Witness.h>
+#include <libethcore/SealEngine.h>
+
+#include <memory>
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+/// The values of a witness. Looking up a value it lacks fails the transaction at once: the lookup
+/// throws MissingWitnessNode, or, while a transaction runs, cancels its budget. Host calls of the
+/// VM can't be unwound by an exception, the VM stops at its next instruction instead and the
+/// transaction throws ExecutionBudgetExceeded.
+class WitnessDB : public db::MemoryDB
+{
+public:
+    std::string lookup(db::Slice _key) const override
+    {
+        std::string ret = MemoryDB::lookup(_key);
+        if (ret.empty())
+        {
+            if (!m_missing)
+                m_missing = h256(reinterpret_cast<byte const*>(_key.data()), h256::ConstructFromPointer);
+            if (!m_running)
+                throwMissing();
+            m_running->cancel();
+        }
+        return ret;
+    }
+
+    /// Sets the budget of the running transaction, nullptr once it is done.
+    void setRunning(ExecutionBudget* _budget) { m_running = _budget; }
+
+    /// Throws MissingWitnessNode if a lookup missed.
+    void checkMissing() const
+    {
+        if (m_missing)
+            throwMissing();
+    }
+
+private:
+    [[noreturn]] void throwMissing() const
+    {
+        BOOST_THROW_EXCEPTION(MissingWitnessNode() << errinfo_hash256(m_missing));
+    }
+
+    ExecutionBudget* m_running = nullptr;
+    mutable h256 m_missing;
+};
+}  // namespace
+
+std::vector<StatelessTransactionResult> executeStateless(bytesConstRef _witness, h256 const& _root,
+    BlockHeader const& _header, LastBlockHashesFace const& _lastHashes, u256 const& _gasUsed,
+    u256 const& _chainID, SealEngineFace const& _sealEngine, std::vector<Transaction> const& _transactions,
+    ExecutionLimits const& _limits)
+{
+    auto witness = std::make_unique<WitnessDB>();
+    WitnessDB& values = *witness;
+    Witness::populate(_witness, values);
+    OverlayDB db(std::move(witness));
+
+    std::vector<StatelessTransactionResult> results;
+    State state(0, db, BaseState::PreExisting);
+    u256 gasUsed = _gasUsed;
+    state.setRoot(_root);
+    for (auto const& t : _transactions)
+    {
+        EnvInfo const envInfo(_header, _lastHashes, gasUsed, _chainID);
+        // always given, a missing value cancels it
+        ExecutionBudget budget(_limits);
+        values.setRunning(&budget);
+        try
+        {
+            auto [result, receipt] = state.execute(envInfo, _sealEngine, t, Permanence::Committed, OnOpFunc(),
+                nullptr, &budget);
+            values.setRunning(nullptr);
+            values.checkMissing();
+            gasUsed = receipt.cumulativeGasUsed();
+            results.push_back({state.rootHash(), std::move(result), std::move(receipt)});
+        }
+        catch (MissingWitnessNode const&)
+        {
+            throw;
+        }
+        catch (Exception const&)
+        {
+            // e.g. the cancelled budget or a wrong nonce, read from an account the witness lacks
+            values.setRunning(nullptr);
+            values.checkMissing();
+            throw;
+        }
+    }
+    return results;
+}
+
+}  // namespace eth
+}  // namespace dev
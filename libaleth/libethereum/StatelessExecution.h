@@ -0,0 +1,53 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Execution of transactions against a witness instead of the state database
+#pragma once
+
+#include "Transaction.h"
+#include "TransactionReceipt.h"
+
+#include <libdevcore/FixedHash.h>
+#include <libethcore/BlockHeader.h>
+#include <libevm/ExtVMFace.h>
+
+#include <vector>
+
+namespace dev
+{
+namespace eth
+{
+
+class LastBlockHashesFace;
+class SealEngineFace;
+
+/// The outcome of a transaction executed by executeStateless().
+struct StatelessTransactionResult
+{
+    h256 stateRoot;  ///< The state root after the transaction.
+    ExecutionResult result;
+    TransactionReceipt receipt;
+};
+
+/**
+ * Executes @a _transactions one after another in the block @a _header, starting at the state
+ * @a _root, against a MemoryDB holding only the values of @a _witness, a witness returned by
+ * Witness::rlp(). Nothing is written anywhere else.
+ *
+ * @a _gasUsed is the gas used in the block before the first transaction. A node the witness
+ * lacks fails the execution at the lookup: inside the VM, which can't be unwound by an exception,
+ * the transaction is stopped at its next instruction through its ExecutionBudget.
+ * Every transaction gets its own ExecutionBudget of @a _limits.
+ * @throws MissingWitnessNode with the hash of the first node that was missing.
+ * @throws ExecutionBudgetExceeded once the budget of a transaction is exhausted.
+ * @returns the results in the order of @a _transactions
+ */
+std::vector<StatelessTransactionResult> executeStateless(bytesConstRef _witness, h256 const& _root,
+    BlockHeader const& _header, LastBlockHashesFace const& _lastHashes, u256 const& _gasUsed,
+    u256 const& _chainID, SealEngineFace const& _sealEngine, std::vector<Transaction> const& _transactions,
+    ExecutionLimits const& _limits = ExecutionLimits());
+
+}  // namespace eth
+}  // namespace dev
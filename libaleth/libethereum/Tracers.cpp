@@ -0,0 +1,330 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "Tracers.h"
+
+#include <libdevcore/CommonData.h>
+#include <libevm/ExtVMFace.h>
+
+#include <cstring>
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+/// @returns the word @a _index of the stack counted from the bottom.
+u256 stackWord(bytesConstRef _stack, size_t _index)
+{
+    u256 word;
+    for (size_t i = 32; i > 0; --i)
+        word = (word << 8) | _stack[_index * 32 + i - 1];
+    return word;
+}
+
+/// @returns a 0x prefixed hex number without leading zeros.
+std::string toQuantity(u256 const& _value)
+{
+    std::string hex = toCompactHex(_value);
+    hex.erase(0, std::min(hex.find_first_not_of('0'), hex.size()));
+    return "0x" + (hex.empty() ? std::string{"0"} : hex);
+}
+
+std::string toWord(u256 const& _value)
+{
+    return toHex(toBigEndian(_value));
+}
+
+char const* callType(evmc_call_kind _kind, bool _isStatic, bool _parentIsStatic)
+{
+    switch (_kind)
+    {
+    case EVMC_DELEGATECALL:
+        return "DELEGATECALL";
+    case EVMC_CALLCODE:
+        return "CALLCODE";
+    case EVMC_CREATE:
+        return "CREATE";
+    case EVMC_CREATE2:
+        return "CREATE2";
+    case EVMC_CALL:
+    default:
+        // Calls made from a static frame inherit the flag, a STATICCALL among them is
+        // indistinguishable from a CALL.
+        return _isStatic && !_parentIsStatic ? "STATICCALL" : "CALL";
+    }
+}
+
+char const* errorMessage(evmc_status_code _status)
+{
+    switch (_status)
+    {
+    case EVMC_SUCCESS:
+        return nullptr;
+    case EVMC_REVERT:
+        return "execution reverted";
+    case EVMC_OUT_OF_GAS:
+        return "out of gas";
+    case EVMC_INVALID_INSTRUCTION:
+    case EVMC_UNDEFINED_INSTRUCTION:
+        return "invalid opcode";
+    case EVMC_BAD_JUMP_DESTINATION:
+        return "invalid jump destination";
+    case EVMC_STACK_OVERFLOW:
+        return "stack overflow";
+    case EVMC_STACK_UNDERFLOW:
+        return "stack underflow";
+    case EVMC_STATIC_MODE_VIOLATION:
+        return "write protection";
+    default:
+        return "execution failed";
+    }
+}
+
+evmc_status_code toStatusCode(TransactionException _excepted)
+{
+    switch (_excepted)
+    {
+    case TransactionException::None:
+        return EVMC_SUCCESS;
+    case TransactionException::RevertInstruction:
+        return EVMC_REVERT;
+    case TransactionException::OutOfGas:
+        return EVMC_OUT_OF_GAS;
+    case TransactionException::BadInstruction:
+        return EVMC_UNDEFINED_INSTRUCTION;
+    case TransactionException::BadJumpDestination:
+        return EVMC_BAD_JUMP_DESTINATION;
+    case TransactionException::OutOfStack:
+        return EVMC_STACK_OVERFLOW;
+    case TransactionException::StackUnderflow:
+        return EVMC_STACK_UNDERFLOW;
+    default:
+        return EVMC_FAILURE;
+    }
+}
+}  // namespace
+
+void TraceWriter::flush()
+{
+    if (m_buffer.empty())
+        return;
+    if (m_sink(bytesConstRef{reinterpret_cast<byte const*>(m_buffer.data()), m_buffer.size()}))
+        m_buffer.clear();
+}
+
+StructLogTracer::StructLogTracer(TraceWriter& _writer, StructLogOptions const& _options)
+  : m_writer(_writer), m_options(_options)
+{
+    m_writer << "{\"structLogs\":[";
+}
+
+void StructLogTracer::onFrameEnter(Frame const& _frame) noexcept
+{
+    // The call or create instruction is charged the gas passed on to the new frame.
+    if (m_error || !m_hasPending)
+        return;
+    try
+    {
+        writePending(_frame.gas);
+    }
+    catch (...)
+    {
+        m_error = std::current_exception();
+    }
+}
+
+void StructLogTracer::onStep(Step const& _step) noexcept
+{
+    if (!m_error)
+    {
+        try
+        {
+            logStep(_step);
+            return;
+        }
+        catch (...)
+        {
+            m_error = std::current_exception();
+        }
+    }
+    // like a failing sink, the execution is stopped through its budget
+    if (_step.ext && _step.ext->budget)
+        _step.ext->budget->cancel();
+}
+
+void StructLogTracer::logStep(Step const& _step)
+{
+    if (m_hasPending)
+        writePending(_step.depth == m_pendingDepth ? m_pendingGas - _step.gas : 0);
+
+    auto const name = instructionInfo(_step.op).name;
+    m_pendingHead = "{\"pc\":" + std::to_string(_step.pc) + ",\"op\":\"" +
+                    (name ? std::string{name} : "opcode 0x" + toHex(bytes{byte(_step.op)})) +
+                    "\",\"gas\":" + std::to_string(_step.gas) + ",\"gasCost\":";
+    m_pendingTail = ",\"depth\":" + std::to_string(_step.depth + 1);
+
+    size_t const height = _step.stack.size() / 32;
+    if (!m_options.disableStack)
+    {
+        m_pendingTail += ",\"stack\":[";
+        for (size_t i = 0; i < height; ++i)
+            m_pendingTail += (i ? ",\"" : "\"") + toQuantity(stackWord(_step.stack, i)) + '"';
+        m_pendingTail += ']';
+    }
+
+    if (m_options.enableMemory)
+    {
+        m_pendingTail += ",\"memory\":[";
+        for (size_t i = 0; i + 32 <= _step.memory.size(); i += 32)
+            m_pendingTail += (i ? ",\"" : "\"") + toHex(_step.memory.cropped(i, 32)) + '"';
+        m_pendingTail += ']';
+    }
+
+    bool const isSload = _step.op == Instruction::SLOAD && height >= 1;
+    bool const isSstore = _step.op == Instruction::SSTORE && height >= 2;
+    if (!m_options.disableStorage && (isSload || isSstore))
+    {
+        auto& storage = m_storage[_step.ext->myAddress];
+        u256 const key = stackWord(_step.stack, height - 1);
+        storage[key] = isSload ? _step.ext->store(key) : stackWord(_step.stack, height - 2);
+
+        m_pendingTail += ",\"storage\":{";
+        bool first = true;
+        for (auto const& slot : storage)
+        {
+            m_pendingTail += (first ? "\"" : ",\"") + toWord(slot.first) + "\":\"" + toWord(slot.second) + '"';
+            first = false;
+        }
+        m_pendingTail += '}';
+    }
+    m_pendingTail += '}';
+
+    m_hasPending = true;
+    m_pendingDepth = _step.depth;
+    m_pendingGas = _step.gas;
+}
+
+void StructLogTracer::onExecutionEnd(unsigned _depth, int64_t _gasLeft) noexcept
+{
+    if (m_error || !m_hasPending || _depth != m_pendingDepth)
+        return;
+    try
+    {
+        writePending(m_pendingGas - _gasLeft);
+    }
+    catch (...)
+    {
+        m_error = std::current_exception();
+    }
+}
+
+void StructLogTracer::finish(ExecutionResult const& _res)
+{
+    rethrowError();
+    if (m_hasPending)
+        writePending(0);
+
+    m_writer << "],\"gas\":" << std::to_string(_res.gasUsed.convert_to<uint64_t>())
+             << ",\"failed\":" << (_res.excepted != TransactionException::None ? "true" : "false")
+             << ",\"returnValue\":\"" << toHex(_res.output) << "\"}";
+    m_writer.flush();
+}
+
+void StructLogTracer::rethrowError() const
+{
+    if (m_error)
+        std::rethrow_exception(m_error);
+}
+
+void StructLogTracer::writePending(int64_t _gasCost)
+{
+    if (!m_first)
+        m_writer << ',';
+    m_writer << m_pendingHead << std::to_string(_gasCost) << m_pendingTail;
+    m_writer.maybeFlush();
+
+    m_first = false;
+    m_hasPending = false;
+}
+
+void CallTracer::onFrameEnter(Frame const& _frame) noexcept
+{
+    bool const parentIsStatic = !m_stack.empty() && m_stack.back().isStatic;
+    CallFrame frame{callType(_frame.kind, _frame.isStatic, parentIsStatic), _frame.isStatic,
+        _frame.from, _frame.to, _frame.value, _frame.gas};
+    frame.input = _frame.input.toBytes();
+    m_stack.push_back(std::move(frame));
+}
+
+void CallTracer::onFrameExit(FrameResult const& _result) noexcept
+{
+    if (m_stack.empty())
+        return;
+
+    CallFrame frame = std::move(m_stack.back());
+    m_stack.pop_back();
+    frame.gasUsed = frame.gas - _result.gasLeft;
+    frame.output = _result.output.toBytes();
+    frame.error = errorMessage(_result.status);
+    if (_result.status == EVMC_SUCCESS && _result.createdAddress)
+        frame.to = _result.createdAddress;
+
+    (m_stack.empty() ? m_root : m_stack.back().calls).push_back(std::move(frame));
+}
+
+void CallTracer::finish()
+{
+    // Only a single top level frame is expected, an empty trace is written as null.
+    if (m_root.empty())
+        m_writer << "null";
+    else
+        write(m_root.back());
+    m_writer.flush();
+}
+
+void CallTracer::write(CallFrame const& _frame)
+{
+    m_writer << "{\"type\":\"" << _frame.type << "\",\"from\":\"" << toHexPrefixed(_frame.from)
+             << "\",\"to\":\"" << toHexPrefixed(_frame.to) << '"';
+    if (std::strcmp(_frame.type, "DELEGATECALL") != 0 && std::strcmp(_frame.type, "STATICCALL") != 0)
+        m_writer << ",\"value\":\"" << toQuantity(_frame.value) << '"';
+    m_writer << ",\"gas\":\"" << toQuantity(_frame.gas) << "\",\"gasUsed\":\"" << toQuantity(_frame.gasUsed)
+             << "\",\"input\":\"" << toHexPrefixed(_frame.input) << '"';
+    if (!_frame.output.empty())
+        m_writer << ",\"output\":\"" << toHexPrefixed(_frame.output) << '"';
+    if (_frame.error)
+        m_writer << ",\"error\":\"" << _frame.error << '"';
+    m_writer.maybeFlush();
+
+    if (!_frame.calls.empty())
+    {
+        m_writer << ",\"calls\":[";
+        for (size_t i = 0; i < _frame.calls.size(); ++i)
+        {
+            if (i)
+                m_writer << ',';
+            write(_frame.calls[i]);
+        }
+        m_writer << ']';
+    }
+    m_writer << '}';
+}
+
+void enterTransactionFrame(VMTracer& _tracer, Transaction const& _t)
+{
+    evmc_call_kind const kind = _t.isCreation() ? EVMC_CREATE : EVMC_CALL;
+    Address const to = _t.isCreation() ? Address{} : _t.receiveAddress();
+    _tracer.onFrameEnter({kind, false, 0, _t.sender(), to, _t.value(),
+        static_cast<int64_t>(_t.gas()), bytesConstRef{&_t.data()}});
+}
+
+void exitTransactionFrame(VMTracer& _tracer, Transaction const& _t, ExecutionResult const& _res)
+{
+    _tracer.onFrameExit({toStatusCode(_res.excepted), static_cast<int64_t>(_t.gas() - _res.gasUsed),
+        bytesConstRef{&_res.output}, _res.newAddress});
+}
+
+}  // namespace eth
+}  // namespace dev
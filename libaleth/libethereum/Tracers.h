@@ -0,0 +1,170 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Native tracers writing geth compatible JSON traces in chunks.
+#pragma once
+
+#include "Transaction.h"
+
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libevm/VMTracer.h>
+
+#include <exception>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dev
+{
+namespace eth
+{
+
+/// Buffers trace output and passes it on in chunks of about the requested size.
+class TraceWriter
+{
+public:
+    /// Receives a chunk. @returns false if it can't take the chunk right now, it is offered again
+    /// together with the following output.
+    using Sink = std::function<bool(bytesConstRef)>;
+
+    TraceWriter(Sink _sink, size_t _chunkSize) : m_sink(std::move(_sink)), m_chunkSize(_chunkSize) {}
+
+    TraceWriter& operator<<(char _c)
+    {
+        m_buffer.push_back(_c);
+        return *this;
+    }
+
+    TraceWriter& operator<<(std::string const& _s)
+    {
+        m_buffer += _s;
+        return *this;
+    }
+
+    TraceWriter& operator<<(char const* _s)
+    {
+        m_buffer += _s;
+        return *this;
+    }
+
+    /// Passes the buffered output on if a chunk is complete.
+    void maybeFlush()
+    {
+        if (m_buffer.size() >= m_chunkSize)
+            flush();
+    }
+
+    /// Passes all buffered output on.
+    void flush();
+
+private:
+    Sink m_sink;
+    size_t m_chunkSize;
+    std::string m_buffer;
+};
+
+struct StructLogOptions
+{
+    bool enableMemory = false;
+    bool disableStack = false;
+    bool disableStorage = false;
+};
+
+/// Writes a log entry for every executed instruction, the output is
+/// `{"structLogs":[...],"gas":N,"failed":B,"returnValue":"..."}`.
+///
+/// Logging an instruction may fail, e.g. on a storage read error. The exception can't cross the
+/// VM, it is kept and stops the trace, the execution's budget is cancelled at the next instruction.
+/// finish() and rethrowError() rethrow it.
+class StructLogTracer : public VMTracer
+{
+public:
+    StructLogTracer(TraceWriter& _writer, StructLogOptions const& _options);
+
+    bool wantsSteps() const override { return true; }
+    void onFrameEnter(Frame const& _frame) noexcept override;
+    void onStep(Step const& _step) noexcept override;
+    void onExecutionEnd(unsigned _depth, int64_t _gasLeft) noexcept override;
+
+    /// Writes the result of the transaction and flushes the output.
+    void finish(ExecutionResult const& _res);
+
+    /// Rethrows the exception that stopped the trace, if any.
+    void rethrowError() const;
+
+private:
+    /// Logs @a _step, may throw.
+    void logStep(Step const& _step);
+
+    /// The gas cost of an instruction is only known once the next one starts,
+    /// so every entry is held back until then.
+    void writePending(int64_t _gasCost);
+
+    std::exception_ptr m_error;
+
+    TraceWriter& m_writer;
+    StructLogOptions m_options;
+    bool m_first = true;
+
+    bool m_hasPending = false;
+    unsigned m_pendingDepth = 0;
+    int64_t m_pendingGas = 0;
+    std::string m_pendingHead;  ///< Entry up to the gas cost.
+    std::string m_pendingTail;  ///< Entry after the gas cost.
+
+    /// Storage slots seen so far per contract, like geth every SLOAD and SSTORE logs all of them.
+    std::unordered_map<Address, std::map<u256, u256>> m_storage;
+};
+
+/// Collects the tree of call frames and writes it when the transaction is done, the output is
+/// `{"type":"CALL","from":...,"calls":[...]}` like geth's callTracer.
+///
+/// Unlike geth, a STATICCALL made from a static frame is reported as a CALL: its message only
+/// differs from a CALL's by the static flag, which the frame inherits anyway.
+class CallTracer : public VMTracer
+{
+public:
+    explicit CallTracer(TraceWriter& _writer) : m_writer(_writer) {}
+
+    void onFrameEnter(Frame const& _frame) noexcept override;
+    void onFrameExit(FrameResult const& _result) noexcept override;
+
+    /// Writes the call tree and flushes the output.
+    void finish();
+
+private:
+    struct CallFrame
+    {
+        char const* type;
+        bool isStatic;
+        Address from;
+        Address to;
+        u256 value;
+        int64_t gas;
+        int64_t gasUsed = 0;
+        bytes input;
+        bytes output;
+        char const* error = nullptr;
+        std::vector<CallFrame> calls;
+    };
+
+    void write(CallFrame const& _frame);
+
+    TraceWriter& m_writer;
+    std::vector<CallFrame> m_stack;
+    std::vector<CallFrame> m_root;
+};
+
+/// Reports the top level frame of @a _t to @a _tracer, nested frames are reported by the VM.
+void enterTransactionFrame(VMTracer& _tracer, Transaction const& _t);
+
+/// Reports the end of the top level frame of @a _t.
+void exitTransactionFrame(VMTracer& _tracer, Transaction const& _t, ExecutionResult const& _res);
+
+}  // namespace eth
+}  // namespace dev
@@ -35,7 +35,8 @@ enum class TransactionException
 	StackUnderflow,
 	RevertInstruction,
 	InvalidZeroSignatureFormat,
-	AddressAlreadyUsed
+	AddressAlreadyUsed,
+	ExecutionBudgetExceeded	///< Stopped by the ExecutionBudget of the call.
 };
 
 enum class CodeDeposit
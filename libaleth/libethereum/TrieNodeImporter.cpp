@@ -0,0 +1,153 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "TrieNodeImporter.h"
+
+#include <libdevcore/RLP.h>
+#include <libdevcore/SHA3.h>
+#include <libdevcore/TaskPool.h>
+#include <libdevcore/TrieCommon.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace dev
+{
+namespace eth
+{
+
+namespace
+{
+struct VerifiedNode
+{
+    h256 hash;
+    bool valid = false;
+    h256s children;
+};
+
+db::Slice toSlice(h256 const& _h)
+{
+    return db::Slice(reinterpret_cast<char const*>(_h.data()), _h.size);
+}
+
+db::Slice toSlice(bytesConstRef _b)
+{
+    return db::Slice(reinterpret_cast<char const*>(_b.data()), _b.size());
+}
+}  // namespace
+
+TrieNodeImporter::TrieNodeImporter(
+    std::shared_ptr<db::DatabaseFace> _db, TrieNodeImportOptions const& _options, WriteObserver _observer)
+  : m_db(std::move(_db)), m_options(_options), m_observer(std::move(_observer))
+{
+    if (m_options.threads == 0)
+        m_options.threads = std::max(1u, std::thread::hardware_concurrency());
+    if (m_options.batchSize == 0)
+        m_options.batchSize = 1;
+}
+
+TrieNodeImportResult TrieNodeImporter::import(std::vector<bytesConstRef> const& _nodes, h256s const& _expected)
+{
+    h256Hash const expected(_expected.begin(), _expected.end());
+
+    // hash and decode every node on the verifying threads
+    std::vector<VerifiedNode> verified(_nodes.size());
+    TaskPool::shared().parallelFor(_nodes.size(), m_options.threads, [&](size_t i) {
+        VerifiedNode& v = verified[i];
+        v.hash = sha3(_nodes[i]);
+        if (!expected.empty() && !expected.count(v.hash))
+            return;
+
+        try
+        {
+            RLP const node(_nodes[i]);
+            // the empty trie is the only node that is not a list
+            if (!node.isEmpty() && (!node.isList() || (node.itemCount() != 2 && node.itemCount() != 17)))
+                BOOST_THROW_EXCEPTION(BadRLP());
+
+            forEachChild(node, [&](h256 const& _child) { v.children.push_back(_child); },
+                [&](bytesConstRef _value) {
+                    if (!m_options.accounts)
+                        return;
+
+                    RLP const account(_value);
+                    if (!account.isList() || account.itemCount() < 4)
+                        return;
+                    h256 const storageRoot = account[2].toHash<h256>();
+                    if (storageRoot != EmptyTrie)
+                        v.children.push_back(storageRoot);
+                    h256 const codeHash = account[3].toHash<h256>();
+                    if (codeHash != EmptySHA3)
+                        v.children.push_back(codeHash);
+                });
+        }
+        catch (...)
+        {
+            // only requested data may be something other than a trie node, i.e. code
+            v.children.clear();
+            if (expected.empty())
+                return;
+        }
+        v.valid = true;
+    });
+
+    TrieNodeImportResult ret;
+    std::vector<size_t> order;
+    for (size_t i = 0; i < verified.size(); ++i)
+        if (verified[i].valid)
+            order.push_back(i);
+        else
+            ret.rejected.push_back(i);
+
+    // write the nodes sorted by key, this keeps the write batches cheap for leveldb
+    std::sort(order.begin(), order.end(), [&](size_t _a, size_t _b) { return verified[_a].hash < verified[_b].hash; });
+    order.erase(std::unique(order.begin(), order.end(),
+                    [&](size_t _a, size_t _b) { return verified[_a].hash == verified[_b].hash; }),
+        order.end());
+
+    h256Hash imported;
+    for (size_t begin = 0; begin < order.size(); begin += m_options.batchSize)
+    {
+        size_t const end = std::min(begin + m_options.batchSize, order.size());
+        h256s keys;
+        auto writeBatch = m_db->createWriteBatch();
+        for (size_t i = begin; i < end; ++i)
+        {
+            VerifiedNode const& v = verified[order[i]];
+            writeBatch->insert(toSlice(v.hash), toSlice(_nodes[order[i]]));
+            keys.push_back(v.hash);
+        }
+
+        if (m_observer)
+            m_observer(keys);
+        m_db->commit(std::move(writeBatch));
+
+        imported.insert(keys.begin(), keys.end());
+    }
+    ret.imported = imported.size();
+
+    // the next frontier is every expected or referenced hash that is still unknown
+    h256Hash candidates;
+    for (auto const& h: _expected)
+        if (!imported.count(h))
+            candidates.insert(h);
+    for (size_t i: order)
+        for (auto const& h: verified[i].children)
+            if (!imported.count(h))
+                candidates.insert(h);
+
+    h256s unknown(candidates.begin(), candidates.end());
+    std::vector<char> exists(unknown.size(), 0);
+    TaskPool::shared().parallelFor(
+        unknown.size(), m_options.threads, [&](size_t i) { exists[i] = m_db->exists(toSlice(unknown[i])); });
+
+    for (size_t i = 0; i < unknown.size(); ++i)
+        if (!exists[i])
+            ret.missing.push_back(unknown[i]);
+    std::sort(ret.missing.begin(), ret.missing.end());
+
+    return ret;
+}
+
+}
+}
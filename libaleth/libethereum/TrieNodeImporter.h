@@ -0,0 +1,71 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2015-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Bulk import of downloaded trie nodes for state sync
+#pragma once
+
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/db.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace dev
+{
+namespace eth
+{
+
+struct TrieNodeImportOptions
+{
+    /// Decode leaves as accounts, their storage roots and code hashes are children too.
+    bool accounts = true;
+    /// Number of verifying threads of the shared task pool, 0 means one per hardware thread.
+    unsigned threads = 0;
+    /// Number of nodes written in a single write batch.
+    size_t batchSize = 10000;
+};
+
+struct TrieNodeImportResult
+{
+    /// Number of nodes written to the database.
+    size_t imported = 0;
+    /// Indices of the nodes that were rejected.
+    std::vector<size_t> rejected;
+    /// Expected or referenced hashes that are neither imported nor in the database, sorted.
+    h256s missing;
+};
+
+/**
+ * Imports trie nodes downloaded by state sync.
+ *
+ * Every node is hashed and decoded on the shared task pool, the verified nodes are
+ * written in key-sorted write batches and the children they reference that
+ * are not in the database yet are returned as the next frontier of the sync.
+ */
+class TrieNodeImporter
+{
+public:
+    /// Called with the keys of every write batch before it is written.
+    using WriteObserver = std::function<void(h256s const&)>;
+
+    TrieNodeImporter(std::shared_ptr<db::DatabaseFace> _db, TrieNodeImportOptions const& _options = TrieNodeImportOptions(),
+        WriteObserver _observer = WriteObserver());
+
+    /// Imports @a _nodes.
+    /// If @a _expected is not empty, only nodes whose hash is in @a _expected are accepted and
+    /// nodes that are not trie nodes (i.e. code) are accepted too. Expected hashes that were not
+    /// delivered are part of the returned frontier.
+    TrieNodeImportResult import(std::vector<bytesConstRef> const& _nodes, h256s const& _expected = h256s());
+
+private:
+    std::shared_ptr<db::DatabaseFace> m_db;
+    TrieNodeImportOptions m_options;
+    WriteObserver m_observer;
+};
+
+}
+}
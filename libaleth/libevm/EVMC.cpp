@@ -2,6 +2,7 @@
 // Copyright 2014-2019 Aleth Authors.
 // Licensed under the GNU General Public License, Version 3.
 #include "EVMC.h"
+#include "EvmoneTracing.h"
 
 #include <libdevcore/Log.h>
 #include <libevm/VMFactory.h>
@@ -33,6 +34,57 @@ evmc_revision toRevision(EVMSchedule const& _schedule) noexcept
         return EVMC_HOMESTEAD;
     return EVMC_FRONTIER;
 }
+
+/// Forwards the instructions executed by evmone to a VMTracer.
+class StepForwarder : public evmone::Tracer
+{
+public:
+    StepForwarder(VMTracer& _tracer, ExtVMFace& _ext) noexcept : m_tracer{_tracer}, m_ext{_ext} {}
+
+private:
+    void on_execution_start(
+        evmc_revision, evmc_message const&, evmone::bytes_view) noexcept override
+    {}
+
+    void on_instruction_start(uint32_t _pc, intx::uint256 const* _stackTop, int _stackHeight,
+        evmone::ExecutionState const& _state) noexcept override
+    {
+        // evmone keeps the stack items contiguous with the top item last.
+        auto const* bottom = reinterpret_cast<byte const*>(_stackTop - _stackHeight + 1);
+        m_tracer.onStep({_pc, static_cast<Instruction>(m_ext.code[_pc]), _state.gas_left, m_ext.depth,
+            bytesConstRef{bottom, static_cast<size_t>(_stackHeight) * 32},
+            bytesConstRef{_state.memory.data(), _state.memory.size()}, &m_ext});
+    }
+
+    void on_execution_end(evmc_result const&) noexcept override {}
+
+    VMTracer& m_tracer;
+    ExtVMFace& m_ext;
+};
+
+/// Counts the instructions executed by evmone against an ExecutionBudget, and stops the frame
+/// once it is exhausted. The frames it was called from stop as soon as they are back, see exec().
+class BudgetCounter : public evmone::Tracer
+{
+public:
+    explicit BudgetCounter(ExecutionBudget& _budget) noexcept : m_budget{_budget} {}
+
+private:
+    void on_execution_start(
+        evmc_revision, evmc_message const&, evmone::bytes_view) noexcept override
+    {}
+
+    void on_instruction_start(
+        uint32_t, intx::uint256 const*, int, evmone::ExecutionState const& _state) noexcept override
+    {
+        if (!m_budget.step())
+            evmone_internal::stopAtInstruction(_state);
+    }
+
+    void on_execution_end(evmc_result const&) noexcept override {}
+
+    ExecutionBudget& m_budget;
+};
 }  // namespace
 
 EVMC::EVMC(evmc_vm* _vm, std::vector<std::pair<std::string, std::string>> const& _options) noexcept
@@ -85,7 +137,26 @@ ExecResult EVMC::exec(u256& io_gas, ExtVMFace& _ext, const OnOpFunc& _onOp)
         toEvmC(_ext.caller), _ext.data.data(), _ext.data.size(), toEvmC(_ext.value),
         toEvmC(0x0_cppui256)};
     EvmCHost host{_ext};
+    if (_ext.budget && !_ext.budget->check())
+        BOOST_THROW_EXCEPTION(ExecutionBudgetExceeded());
+    // Every execution gets a new VM instance, so the tracer is attached to this frame only.
+    // Only the baseline interpreter calls the tracers, it is selected whatever the default is.
+    bool const wantsSteps = _ext.tracer && _ext.tracer->wantsSteps();
+    if ((wantsSteps || _ext.budget) && set_option("O", "0") != EVMC_SET_OPTION_SUCCESS)
+        BOOST_THROW_EXCEPTION(
+            InternalVMError() << errinfo_comment("evmone's baseline interpreter is not available"));
+    if (wantsSteps)
+        static_cast<evmone::VM*>(get_raw_pointer())
+            ->add_tracer(std::make_unique<StepForwarder>(*_ext.tracer, _ext));
+    if (_ext.budget)
+        static_cast<evmone::VM*>(get_raw_pointer())
+            ->add_tracer(std::make_unique<BudgetCounter>(*_ext.budget));
     auto r = execute(host, mode, msg, _ext.code.data(), _ext.code.size());
+    if (_ext.tracer)
+        _ext.tracer->onExecutionEnd(_ext.depth, r.gas_left);
+    // Whatever the frame ended with, it may have been cut short or a nested frame may have been.
+    if (_ext.budget && !_ext.budget->check())
+        BOOST_THROW_EXCEPTION(ExecutionBudgetExceeded());
     // FIXME: Copy the output for now, but copyless version possible.
     auto output = owning_bytes_ref{{&r.output_data[0], &r.output_data[r.output_size]}, 0, r.output_size};
 
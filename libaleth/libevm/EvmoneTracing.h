@@ -0,0 +1,57 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// The only place that reaches into evmone's internals: its tracer interface, which is not
+/// part of its public headers, and the ExecutionState a tracer is handed.
+///
+/// Struct logs and instruction budgets depend on it. libevm/CMakeLists.txt adds evmone/lib to
+/// the include path of libevm only and defines the version of the evmone it builds, checked
+/// below against the layout this file relies on. The tracer overrides in EVMC.cpp stop
+/// compiling if the signature of evmone::Tracer changes.
+#pragma once
+
+#if !__has_include(<evmone/tracing.hpp>)
+#error "evmone/tracing.hpp not found, the evmone submodule is missing or too old"
+#endif
+#include <evmone/execution_state.hpp>
+#include <evmone/tracing.hpp>
+#include <evmone/vm.hpp>
+
+#include <cstdint>
+#include <type_traits>
+
+#if !defined(EVMONE_VERSION_MAJOR) || !defined(EVMONE_VERSION_MINOR)
+#error "EVMONE_VERSION_MAJOR and EVMONE_VERSION_MINOR are defined by libevm/CMakeLists.txt"
+#endif
+
+namespace dev
+{
+namespace eth
+{
+namespace evmone_internal
+{
+// From 0.7, evmone's baseline interpreter reports every instruction to the tracers with its
+// ExecutionState, and up to 0.9 it charges the instruction against ExecutionState::gas_left
+// right after. Later versions keep the gas in a local and pass it to on_instruction_start().
+// The advanced interpreter never calls the tracers, EVMC::exec() selects the baseline one
+// through the "O" option whenever a tracer is attached.
+static_assert(EVMONE_VERSION_MAJOR == 0 && EVMONE_VERSION_MINOR >= 7 && EVMONE_VERSION_MINOR <= 9,
+    "the tracer interface and gas accounting of this evmone version are not supported");
+static_assert(std::is_same<decltype(evmone::ExecutionState::gas_left), int64_t>::value,
+    "evmone::ExecutionState::gas_left changed");
+
+/// Makes the instruction about to run fail with out of gas, which stops the frame.
+///
+/// evmone cannot be interrupted from outside. A tracer is handed the interpreter's own state
+/// as const, but the state is not const and its gas is charged only after the tracer returns,
+/// so taking the gas here is seen by the very next charge. Must only be called from
+/// evmone::Tracer::on_instruction_start().
+inline void stopAtInstruction(evmone::ExecutionState const& _state) noexcept
+{
+    const_cast<evmone::ExecutionState&>(_state).gas_left = -1;
+}
+}  // namespace evmone_internal
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,85 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Wall-clock and instruction limits of an execution, independent of its gas.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace dev
+{
+namespace eth
+{
+/// Wall-clock and instruction limits of an ExecutionBudget, a zero limit is left out.
+struct ExecutionLimits
+{
+    std::chrono::milliseconds timeout{0};
+    uint64_t steps = 0;
+
+    bool unlimited() const noexcept { return timeout.count() <= 0 && steps == 0; }
+};
+
+/// Limits how long a transaction may run.
+///
+/// A budget is handed to the top level Executive and shared by every nested frame. Every
+/// instruction is counted and the running frame is stopped as soon as the budget is exhausted,
+/// the whole transaction is then aborted with ExecutionBudgetExceeded.
+class ExecutionBudget
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// A zero @a _timeout or @a _steps leaves that limit out. The time starts running now.
+    ExecutionBudget(std::chrono::milliseconds _timeout, uint64_t _steps) noexcept
+      : m_deadline(_timeout.count() > 0 ? Clock::now() + _timeout : Clock::time_point::max()),
+        m_maxSteps(_steps > 0 ? _steps : std::numeric_limits<uint64_t>::max())
+    {}
+
+    /// The time starts running now.
+    explicit ExecutionBudget(ExecutionLimits const& _limits) noexcept
+      : ExecutionBudget(_limits.timeout, _limits.steps)
+    {}
+
+    /// Counts an executed instruction, the time is read every c_stepsPerClockCheck instructions.
+    /// @returns false once the budget is exhausted.
+    bool step() noexcept
+    {
+        if (++m_steps > m_maxSteps)
+            m_exhausted = true;
+        else if (m_steps % c_stepsPerClockCheck == 0)
+            check();
+        return !m_exhausted;
+    }
+
+    /// Checks the time. @returns false once the budget is exhausted.
+    bool check() noexcept
+    {
+        if (!m_exhausted && Clock::now() >= m_deadline)
+            m_exhausted = true;
+        return !m_exhausted;
+    }
+
+    /// Exhausts the budget now, the execution stops at its next instruction. Used to abort it for
+    /// reasons of its own, e.g. once its trace can't be taken any more.
+    void cancel() noexcept { m_exhausted = true; }
+
+    bool exhausted() const noexcept { return m_exhausted; }
+
+    /// The number of instructions counted so far.
+    uint64_t steps() const noexcept { return m_steps; }
+
+private:
+    static constexpr uint64_t c_stepsPerClockCheck = 1024;
+
+    Clock::time_point m_deadline;
+    uint64_t m_maxSteps;
+    uint64_t m_steps = 0;
+    bool m_exhausted = false;
+};
+
+}  // namespace eth
+}  // namespace dev
@@ -217,7 +217,16 @@ evmc::Result EvmCHost::create(evmc_message const& _msg) noexcept
     // ExtVM::create takes the sender address from .myAddress.
     assert(fromEvmC(_msg.sender) == m_extVM.myAddress);
 
+    if (m_extVM.tracer)
+        m_extVM.tracer->onFrameEnter({_msg.kind, false, static_cast<unsigned>(_msg.depth),
+            m_extVM.myAddress, Address{}, value, _msg.gas, init});
+
     CreateResult result = m_extVM.create(value, gas, init, opcode, salt, {});
+
+    if (m_extVM.tracer)
+        m_extVM.tracer->onFrameExit({result.status, static_cast<int64_t>(gas),
+            result.output, result.address});
+
     evmc_result evmcResult = {};
     evmcResult.status_code = result.status;
     evmcResult.gas_left = static_cast<int64_t>(gas);
@@ -271,7 +280,16 @@ evmc::Result EvmCHost::call(evmc_message const& _msg) noexcept
     params.staticCall = (_msg.flags & EVMC_STATIC) != 0;
     params.onOp = {};
 
+    if (m_extVM.tracer)
+        m_extVM.tracer->onFrameEnter({_msg.kind, params.staticCall, static_cast<unsigned>(_msg.depth),
+            params.senderAddress, params.codeAddress, params.apparentValue, _msg.gas, params.data});
+
     CallResult result = m_extVM.call(params);
+
+    if (m_extVM.tracer)
+        m_extVM.tracer->onFrameExit({result.status, static_cast<int64_t>(params.gas),
+            result.output, Address{}});
+
     evmc_result evmcResult = {};
     evmcResult.status_code = result.status;
     evmcResult.gas_left = static_cast<int64_t>(params.gas);
@@ -316,16 +334,17 @@ bool EvmCHost::check_nonce(const evmc::address& addr) noexcept
 }
 
 ExtVMFace::ExtVMFace(EnvInfo const& _envInfo, Address _myAddress, Address _caller, Address _origin,
-    u256 _value, u256 _gasPrice, bytesConstRef _data, bytes _code, h256 const& _codeHash,
-    u256 const& _version, unsigned _depth, bool _isCreate, bool _staticCall)
+    u256 _value, u256 _gasPrice, bytesConstRef _data, std::shared_ptr<bytes const> _code,
+    h256 const& _codeHash, u256 const& _version, unsigned _depth, bool _isCreate, bool _staticCall)
   : m_envInfo(_envInfo),
+    m_code(std::move(_code)),
     myAddress(_myAddress),
     caller(_caller),
     origin(_origin),
     value(_value),
     gasPrice(_gasPrice),
     data(_data),
-    code(std::move(_code)),
+    code(m_code ? bytesConstRef(m_code.get()) : bytesConstRef()),
     codeHash(_codeHash),
     version(_version),
     depth(_depth),
@@ -3,7 +3,9 @@
 // Licensed under the GNU General Public License, Version 3.
 #pragma once
 
+#include "ExecutionBudget.h"
 #include "Instruction.h"
+#include "VMTracer.h"
 
 #include <libdevcore/Common.h>
 #include <libdevcore/CommonData.h>
@@ -18,6 +20,7 @@
 
 #include <boost/optional.hpp>
 #include <functional>
+#include <memory>
 #include <set>
 
 namespace dev
@@ -195,8 +198,8 @@ class ExtVMFace
 public:
     /// Full constructor.
     ExtVMFace(EnvInfo const& _envInfo, Address _myAddress, Address _caller, Address _origin,
-        u256 _value, u256 _gasPrice, bytesConstRef _data, bytes _code, h256 const& _codeHash,
-        u256 const& _version, unsigned _depth, bool _isCreate, bool _staticCall);
+        u256 _value, u256 _gasPrice, bytesConstRef _data, std::shared_ptr<bytes const> _code,
+        h256 const& _codeHash, u256 const& _version, unsigned _depth, bool _isCreate, bool _staticCall);
 
     ExtVMFace(ExtVMFace const&) = delete;
     ExtVMFace& operator=(ExtVMFace const&) = delete;
@@ -271,6 +274,8 @@ public:
 
 private:
     EnvInfo const& m_envInfo;
+    /// Keeps the executing code alive, it may be shared with the accounts of any state.
+    std::shared_ptr<bytes const> m_code;
 
 public:
     // TODO: make private
@@ -280,7 +285,7 @@ public:
     u256 value;         ///< Value (in Wei) that was passed to this address.
     u256 gasPrice;      ///< Price of gas (that we already paid).
     bytesConstRef data;       ///< Current input data.
-    bytes code;               ///< Current code that is executing.
+    bytesConstRef code;       ///< Current code that is executing.
     h256 codeHash;            ///< SHA3 hash of the executing code
     u256 version;             ///< Version of the VM to execute code
     u256 salt;                ///< Values used in new address construction by CREATE2
@@ -288,6 +293,8 @@ public:
     unsigned depth = 0;       ///< Depth of the present call.
     bool isCreate = false;    ///< Is this a CREATE call?
     bool staticCall = false;  ///< Throw on state changing.
+    VMTracer* tracer = nullptr;  ///< Optional tracer of the transaction, not owned.
+    ExecutionBudget* budget = nullptr;  ///< Optional budget of the transaction, not owned.
 };
 
 class EvmCHost : public evmc::Host
@@ -1354,7 +1354,7 @@ void LegacyVM::interpretCases()
             updateMem(memNeed(m_SP[0], m_SP[2]));
             updateIOGas();
 
-            copyDataToMemory(&m_ext->code, m_SP);
+            copyDataToMemory(m_ext->code, m_SP);
         }
         NEXT
 
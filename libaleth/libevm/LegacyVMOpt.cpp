@@ -32,7 +32,7 @@ void LegacyVM::copyCode(int _extraBytes)
 	// of the code without bounds checks.
 	auto extendedSize = m_ext->code.size() + _extraBytes;
 	m_code.reserve(extendedSize);
-	m_code = m_ext->code;
+	m_code = m_ext->code.toBytes();
 	m_code.resize(extendedSize);
 }
 
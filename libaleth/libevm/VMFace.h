@@ -27,6 +27,13 @@ ETH_SIMPLE_EXCEPTION_VM(BufferOverrun);
 /// differently than defined consensus exceptions.
 struct InternalVMError : Exception {};
 
+/// Reports an execution stopped by its ExecutionBudget. This is not based on VMException because
+/// the whole transaction is aborted, not only the frame that was running.
+struct ExecutionBudgetExceeded : Exception
+{
+	char const* what() const noexcept override { return "Execution budget exceeded"; }
+};
+
 /// Error info for EVMC status code.
 using errinfo_evmcStatusCode = boost::error_info<struct tag_evmcStatusCode, evmc_status_code>;
 
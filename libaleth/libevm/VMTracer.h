@@ -0,0 +1,83 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+/// @file
+/// Native hooks for tracing a transaction while it runs in the VM.
+#pragma once
+
+#include <libdevcore/Address.h>
+#include <libdevcore/Common.h>
+#include <libevm/Instruction.h>
+
+#include <evmc/evmc.h>
+
+namespace dev
+{
+namespace eth
+{
+class ExtVMFace;
+
+/// Receives the events of a transaction execution.
+///
+/// A tracer is handed to the top level Executive and is passed down to every nested frame.
+/// Nested calls and creates are reported by EvmCHost, the top level frame is reported by whoever
+/// runs the transaction. Steps are reported by evmone's tracer interface, which the build requires.
+/// All callbacks run synchronously on the executing thread and must not throw.
+class VMTracer
+{
+public:
+    /// A message call or create frame.
+    struct Frame
+    {
+        evmc_call_kind kind;
+        bool isStatic;
+        unsigned depth;
+        Address from;
+        Address to;  ///< Code address of a call, zero for a create.
+        u256 value;
+        int64_t gas;
+        bytesConstRef input;
+    };
+
+    /// The outcome of a frame.
+    struct FrameResult
+    {
+        evmc_status_code status;
+        int64_t gasLeft;
+        bytesConstRef output;
+        Address createdAddress;
+    };
+
+    /// A single instruction, reported before it is executed.
+    struct Step
+    {
+        uint64_t pc;
+        Instruction op;
+        int64_t gas;  ///< Gas left before the instruction.
+        unsigned depth;
+        /// Stack items as 32 byte little-endian words, bottom first.
+        bytesConstRef stack;
+        bytesConstRef memory;
+        /// The frame's externalities, only to be used for reading.
+        ExtVMFace* ext;
+    };
+
+    virtual ~VMTracer() = default;
+
+    /// @returns true if onStep() should be called, stepping slows down the VM considerably.
+    virtual bool wantsSteps() const { return false; }
+
+    virtual void onFrameEnter(Frame const&) noexcept {}
+    virtual void onFrameExit(FrameResult const&) noexcept {}
+    virtual void onStep(Step const&) noexcept {}
+    /// Called when the code of a frame at @a _depth stopped running, before its result is handled.
+    virtual void onExecutionEnd(unsigned _depth, int64_t _gasLeft) noexcept
+    {
+        (void)_depth;
+        (void)_gasLeft;
+    }
+};
+
+}  // namespace eth
+}  // namespace dev
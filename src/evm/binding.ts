@@ -26,6 +26,8 @@ export type Transaction = {
   nonce?: string | number;
   from?: string;
   to?: string;
+  accessList?: AccessList;
+  chainID?: number;
 };
 
 export type AccessList = [string, string[]][];
@@ -55,12 +57,43 @@ export type ExecutionResult = {
   gasRefunded: string;
 };
 
+export type CallResult = {
+  gasUsed: string;
+  excepted?: { error: string };
+  output: string;
+};
+
+export type CreatedAccessList = {
+  accessList: AccessList;
+  gasUsed: string;
+  excepted?: { error: string };
+  runs: number;
+};
+
 export type Log = {
   address: string;
   topics: string[];
   data: string;
 };
 
+export type LocalisedLog = Log & {
+  blockNumber: number;
+  blockHash: string;
+  transactionHash: string;
+  transactionIndex: number;
+  logIndex: number;
+};
+
+export type TransactionLogs = {
+  transactionHash: string | Buffer;
+  logs: Log[];
+};
+
+export type LogFilter = {
+  address?: string | string[];
+  topics?: (string | Buffer | (string | Buffer)[] | null)[];
+};
+
 export type TransactionReceipt = {
   logs: Log[];
   bloom: string;
@@ -69,12 +102,151 @@ export type TransactionReceipt = {
   stateRoot?: string;
 };
 
+export type StateDumpOptions = {
+  ranges?: 16 | 256;
+  threads?: number;
+  batchSize?: number;
+  includeStorage?: boolean;
+  storageBatchSize?: number;
+};
+
+export type TraceOptions = {
+  tracer?: "structLogs" | "callTracer";
+  enableMemory?: boolean;
+  disableStack?: boolean;
+  disableStorage?: boolean;
+  chunkSize?: number;
+  /**
+   * Bytes of trace kept while deep calls run on another thread,
+   * the trace fails beyond them, 64 MiB if omitted
+   */
+  maxBuffered?: number;
+};
+
+export type CallBudget = {
+  /**
+   * Milliseconds a call may run, unlimited if zero or omitted
+   */
+  timeout?: number;
+  /**
+   * Instructions a call may execute, unlimited if zero or omitted
+   */
+  steps?: number;
+};
+
+export type StateDumpAccount = {
+  hashedAddress: string;
+  account: string;
+  storage: [string, string][];
+  /**
+   * False if the storage continues in the same account in the next batch
+   */
+  storageComplete: boolean;
+};
+
+/**
+ * Position of every range to resume from, null for a finished range.
+ * `slot` is set if the storage of `account` continues at it.
+ */
+export type StateDumpCursor = ({ account: string; slot?: string } | null)[];
+
+export type StateDumpBatch = {
+  accounts: StateDumpAccount[];
+  next?: StateDumpCursor;
+};
+
+export type StatePrunerOptions = {
+  retainedRoots?: number;
+  interval?: number;
+  maxOpsPerSecond?: number;
+  batchSize?: number;
+  markFilterBytes?: number;
+};
+
+export type StatePrunerStats = {
+  cycles: number;
+  marked: number;
+  swept: number;
+  totalSwept: number;
+  lastCycleMs: number;
+  running: boolean;
+};
+
+export type TrieNodeImportOptions = {
+  expected?: (string | Buffer)[];
+  accounts?: boolean;
+  threads?: number;
+  batchSize?: number;
+};
+
+export type TrieNodeImportResult = {
+  imported: number;
+  rejected: number[];
+  missing: string[];
+};
+
+export type Durability = "acknowledged" | "written" | "synced";
+
+export type PrecompileCacheStats = {
+  hits: number;
+  misses: number;
+  evictions: number;
+  entries: number;
+  size: number;
+  capacity: number;
+};
+
+export type CodeCacheStats = {
+  hits: number;
+  misses: number;
+  evictions: number;
+  entries: number;
+  size: number;
+  capacity: number;
+};
+
+export type ArenaStats = {
+  allocations: number;
+  bytes: number;
+  chunkAllocations: number;
+  resets: number;
+};
+
 export declare const init: () => void;
 
+/**
+ * Set the number of bytes the precompiled contract result cache may use (16 MiB by default).
+ * The cache is shared by all instances, 0 disables it.
+ * `estimate_fee` and `identity` are never cached.
+ */
+export declare const setPrecompileCacheSize: (size: number) => void;
+
+/**
+ * Get precompiled contract result cache statistics.
+ */
+export declare const precompileCacheStats: () => PrecompileCacheStats;
+
+/**
+ * Set the number of bytes the contract code cache may use (64 MiB by default).
+ * The cache is shared by all instances, 0 disables it.
+ */
+export declare const setCodeCacheSize: (size: number) => void;
+
+/**
+ * Get contract code cache statistics.
+ */
+export declare const codeCacheStats: () => CodeCacheStats;
+
+/**
+ * Get allocation statistics of the per transaction arenas of all states,
+ * the arenas hold the addresses and storage slots warmed by a transaction.
+ */
+export declare const arenaStats: () => ArenaStats;
+
 export declare class JSEVMBinding {
   /**
    * Construct a new JSEVMBinding object.
-   * @param leveldb - External level db object
+   * @param leveldb - Exposed level db object (`db.exposed`)
    * @param chainID - Blockchain id
    */
   constructor(leveldb: any, chainID: number);
@@ -95,6 +267,16 @@ export declare class JSEVMBinding {
    */
   resetHardfork();
 
+  /**
+   * Set the default budget of `runCall`, `runCalls`, `runTxsStateless`,
+   * `createAccessList` and `traceCall`, nothing is limited by default.
+   * A call that exhausts its budget throws `Execution budget exceeded`
+   * and leaves the state unchanged, whatever gas it was given. `runCalls`
+   * reports it as the error of that call instead.
+   * @param budget - Wall-clock and instruction limits
+   */
+  setCallBudget(budget: CallBudget);
+
   /**
    * Initialize genesis state.
    * @param addresses - An array containing all addresses
@@ -122,6 +304,47 @@ export declare class JSEVMBinding {
     receipt: TransactionReceipt;
   };
 
+  /**
+   * Start recording a witness: every trie node and code the following
+   * transactions read from the state database, each once. Nodes written
+   * meanwhile are left out, executing again writes them as well.
+   */
+  startWitness();
+
+  /**
+   * Stop recording a witness.
+   * @returns The RLP encoded witness, a list of the values read ordered
+   *          by their hash, an empty list if nothing was recorded
+   */
+  stopWitness(): Buffer;
+
+  /**
+   * Execute transactions one after another against a witness, the state
+   * database is neither read nor written. A transaction that reads a node
+   * missing from the witness is stopped there and throws `MissingWitnessNode`.
+   * @param witness - Witness returned by `stopWitness`
+   * @param stateRoot - Previous state root hash
+   * @param header - RLP encoded block header or header object
+   * @param txs - RLP encoded transactions or transaction objects
+   * @param gasUsed - Gas used before the first transaction
+   * @param loader - A function used to load block hash
+   * @param budget - Limits of every transaction, the fields given override the default budget
+   * @returns The outcome of every transaction, in the order of `txs`
+   */
+  runTxsStateless(
+    witness: Buffer,
+    stateRoot: string,
+    header: Buffer | BlockHeader,
+    txs: (Buffer | Transaction)[],
+    gasUsed: string | number,
+    loader: LastBlockHashesLoader,
+    budget?: CallBudget
+  ): {
+    stateRoot: string;
+    result: ExecutionResult;
+    receipt: TransactionReceipt;
+  }[];
+
   /**
    * Execute call.
    * @param stateRoot - Previous state root hash
@@ -129,15 +352,109 @@ export declare class JSEVMBinding {
    * @param tx - RLP encoded transaction or transaction object
    * @param gasUsed - Gas used
    * @param loader - A function used to load block hash
+   * @param snapshot - Exposed level db snapshot (`snapshot.exposed`) to read the state at,
+   *                   the latest state is read if omitted
+   * @param budget - Limits of this call, the fields given override the default budget
    */
   runCall(
     stateRoot: string,
     header: Buffer | BlockHeader,
     tx: Buffer | Transaction,
     gasUsed: string | number,
-    loader: LastBlockHashesLoader
+    loader: LastBlockHashesLoader,
+    snapshot?: any,
+    budget?: CallBudget
   ): string;
 
+  /**
+   * Execute many calls against the same state, nothing is written.
+   * Every call sees the state at `stateRoot`, the accounts read by one
+   * call stay cached for the next one. The calls are executed on a worker
+   * thread, the block hashes are loaded before it starts.
+   * @param stateRoot - Previous state root hash
+   * @param header - RLP encoded block header or header object
+   * @param txs - RLP encoded transactions or transaction objects
+   * @param gasUsed - Gas used
+   * @param loader - A function used to load block hash
+   * @param threads - Number of threads to spread the calls over,
+   *                  0 means one per hardware thread, 1 if omitted
+   * @param snapshot - Exposed level db snapshot (`snapshot.exposed`) to read the state at,
+   *                   the latest state is read if omitted
+   * @param budget - Limits of every call, the fields given override the default budget
+   * @returns The execution results in the order of `txs`, packed into one
+   *          buffer, read them with `unpackCallResults`
+   */
+  runCalls(
+    stateRoot: string,
+    header: Buffer | BlockHeader,
+    txs: (Buffer | Transaction)[],
+    gasUsed: string | number,
+    loader: LastBlockHashesLoader,
+    threads?: number,
+    snapshot?: any,
+    budget?: CallBudget
+  ): Promise<Buffer>;
+
+  /**
+   * Create the access list of a transaction, nothing is written.
+   * The transaction is executed until the accounts and storage keys
+   * its code accesses stop changing. The sender, the recipient and
+   * the precompiled contracts are only listed with the storage keys
+   * accessed on them. The transaction is executed on a worker thread,
+   * closing the level db waits until it's done.
+   * @param stateRoot - Previous state root hash
+   * @param header - RLP encoded block header or header object
+   * @param tx - RLP encoded transaction or transaction object
+   * @param gasUsed - Gas used
+   * @param loader - A function used to load block hash
+   * @param snapshot - Exposed level db snapshot (`snapshot.exposed`) to read the state at,
+   *                   if omitted the state is read at a snapshot taken once
+   *                   the queued commits are written
+   * @param budget - Limits shared by every execution of the transaction,
+   *                 the fields given override the default budget
+   * @returns The access list and the gas the transaction uses with it
+   */
+  createAccessList(
+    stateRoot: string,
+    header: Buffer | BlockHeader,
+    tx: Buffer | Transaction,
+    gasUsed: string | number,
+    loader: LastBlockHashesLoader,
+    snapshot?: any,
+    budget?: CallBudget
+  ): Promise<CreatedAccessList>;
+
+  /**
+   * Trace a call, nothing is written.
+   * The trace is geth compatible JSON, `structLogs` logs every instruction
+   * and `callTracer` writes the tree of call frames. Unlike geth, `callTracer`
+   * reports a STATICCALL made from a static frame as a CALL.
+   * It is passed to `onChunk` in pieces of about `chunkSize` bytes
+   * before `traceCall` returns, concatenated they form one JSON document.
+   * The call is aborted once `onChunk` throws, and the error is rethrown.
+   * @param stateRoot - Previous state root hash
+   * @param header - RLP encoded block header or header object
+   * @param tx - RLP encoded transaction or transaction object
+   * @param gasUsed - Gas used
+   * @param loader - A function used to load block hash
+   * @param options - Trace options
+   * @param onChunk - Called with every chunk of the trace
+   * @param snapshot - Exposed level db snapshot (`snapshot.exposed`) to read the state at,
+   *                   the latest state is read if omitted
+   * @param budget - Limits of this call, the fields given override the default budget
+   */
+  traceCall(
+    stateRoot: string,
+    header: Buffer | BlockHeader,
+    tx: Buffer | Transaction,
+    gasUsed: string | number,
+    loader: LastBlockHashesLoader,
+    options: TraceOptions | undefined,
+    onChunk: (chunk: Buffer) => void,
+    snapshot?: any,
+    budget?: CallBudget
+  ): void;
+
   /**
    * Execute message.
    * @param stateRoot - Previous state root hash
@@ -157,4 +474,97 @@ export declare class JSEVMBinding {
     result: ExecutionResult;
     logs: Log[];
   };
+
+  /**
+   * Dump a batch of accounts of a state on a worker thread.
+   * The keyspace is split into `options.ranges` ranges walked in parallel, the batch
+   * holds the accounts of every range in hashed address order, the ranges in order.
+   * At most `options.storageBatchSize` storage slots are returned, an account whose
+   * storage doesn't fit is returned again with the following slots.
+   * The level db stays open until the batch is dumped.
+   * @param stateRoot - State root hash
+   * @param cursor - Position of every range to start from, the `next` of the previous batch
+   * @param options - Dump options
+   * @param snapshot - Exposed level db snapshot (`snapshot.exposed`) to read the state at,
+   *                   the latest state is read if omitted
+   */
+  dumpState(
+    stateRoot: string | Buffer,
+    cursor?: StateDumpCursor,
+    options?: StateDumpOptions,
+    snapshot?: any
+  ): Promise<StateDumpBatch>;
+
+  /**
+   * Import trie nodes downloaded by state sync, on a worker thread.
+   * If `options.expected` is given, only the requested nodes (or code) are accepted.
+   * The level db stays open until the import is done.
+   * @param nodes - RLP encoded trie nodes or code
+   * @param options - Import options
+   * @returns The number of imported nodes, the indices of rejected nodes
+   *          and the hashes that are still missing (the next frontier)
+   */
+  importTrieNodes(nodes: Buffer[], options?: TrieNodeImportOptions): Promise<TrieNodeImportResult>;
+
+  /**
+   * Set when a commit returns, commits are written by a background thread in order:
+   * - `acknowledged`: once queued, the next execution reads the queued state, a crash may lose it
+   * - `written`: once written to the level db (default)
+   * - `synced`: once written and synced to disk
+   * Closing the level db writes the queued commits first, commits after that throw.
+   * @param durability - Commit durability
+   */
+  setDurability(durability: Durability): void;
+
+  /**
+   * Wait until every commit is written to the level db,
+   * throws if a commit couldn't be written.
+   */
+  flush(): void;
+
+  /**
+   * Start pruning unreachable state in background,
+   * closing the level db stops the pruner.
+   * @param options - Pruner options
+   */
+  startPruner(options?: StatePrunerOptions): void;
+
+  /**
+   * Stop pruning.
+   */
+  stopPruner(): void;
+
+  /**
+   * Retain a state root, usually the state root of every new block.
+   * Only the most recent `retainedRoots` roots are kept.
+   * Nodes imported by `importTrieNodes` are kept until the sync target root is retained.
+   * @param stateRoot - State root hash
+   */
+  retainRoot(stateRoot: string | Buffer): void;
+
+  /**
+   * Get pruner statistics.
+   */
+  prunerStats(): StatePrunerStats;
+
+  /**
+   * Index the logs of a block for `filterLogs`, usually called for every imported block.
+   * Indexing a block number again replaces the block, e.g. after a reorg.
+   * Block numbers are limited to 32 bits, larger numbers throw a `RangeError`.
+   * @param number - Block number
+   * @param blockHash - Block hash
+   * @param transactions - The hash and the receipt logs of every transaction of the block, in order
+   */
+  indexBlock(number: number | bigint, blockHash: string | Buffer, transactions: TransactionLogs[]): void;
+
+  /**
+   * Find the logs of indexed blocks like `eth_getLogs`, blocks that were not indexed are skipped.
+   * `topics[i]` matches any of its topics at position i, null matches any topic.
+   * The index is read on a worker thread, at the blocks indexed when it is called.
+   * Block numbers are limited to 32 bits, larger numbers throw a `RangeError`.
+   * @param fromBlock - First block number
+   * @param toBlock - Last block number (inclusive)
+   * @param filter - Log filter, all logs match if omitted
+   */
+  filterLogs(fromBlock: number | bigint, toBlock: number | bigint, filter?: LogFilter): Promise<LocalisedLog[]>;
 }
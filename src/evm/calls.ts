@@ -0,0 +1,29 @@
+import type { CallResult } from "./binding";
+
+/**
+ * Read the results packed by `runCalls`, little endian:
+ * the number of calls as uint32, then a record per call of the output offset,
+ * the output size and the size of the error message right after the output
+ * as uint32 and the gas used as uint64, then the outputs and error messages.
+ * @param packed - Packed results
+ * @returns The execution results in the order of the calls
+ */
+export function unpackCallResults(packed: Buffer): CallResult[] {
+  const results: CallResult[] = [];
+  const count = packed.readUInt32LE(0);
+  for (let i = 0; i < count; i++) {
+    const record = 4 + i * 20;
+    const offset = packed.readUInt32LE(record);
+    const outputSize = packed.readUInt32LE(record + 4);
+    const errorSize = packed.readUInt32LE(record + 8);
+    const result: CallResult = {
+      gasUsed: String(packed.readBigUInt64LE(record + 12)),
+      output: "0x" + packed.toString("hex", offset, offset + outputSize)
+    };
+    if (errorSize > 0) {
+      result.excepted = { error: packed.toString("utf8", offset + outputSize, offset + outputSize + errorSize) };
+    }
+    results.push(result);
+  }
+  return results;
+}
@@ -0,0 +1,31 @@
+import type { JSEVMBinding, StateDumpAccount, StateDumpCursor, StateDumpOptions } from "./binding";
+
+/**
+ * Iterate over all accounts of a state, every batch holds the accounts of
+ * every range in hashed address order, the ranges in order.
+ * A batch is only dumped when the consumer asks for it,
+ * wrap it with `Readable.from` to get a stream with backpressure.
+ * @param evm - JSEVMBinding instance
+ * @param stateRoot - State root hash
+ * @param options - Dump options
+ * @param cursor - Position of every range to resume from
+ * @param snapshot - Exposed level db snapshot to read the state at, keeps the
+ *                   batches consistent while the state is written or pruned,
+ *                   the generator holds it so it stays readable until the iteration
+ *                   is done, even if the snapshot is released meanwhile
+ */
+export async function* dumpState(
+  evm: JSEVMBinding,
+  stateRoot: string | Buffer,
+  options?: StateDumpOptions,
+  cursor?: StateDumpCursor,
+  snapshot?: any
+): AsyncGenerator<StateDumpAccount[]> {
+  do {
+    const { accounts, next } = await evm.dumpState(stateRoot, cursor, options, snapshot);
+    if (accounts.length > 0) {
+      yield accounts;
+    }
+    cursor = next;
+  } while (cursor !== undefined);
+}
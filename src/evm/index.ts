@@ -1 +1,3 @@
 export * from "./binding";
+export * from "./calls";
+export * from "./dump";
@@ -22,7 +22,7 @@ ChainedBatch.prototype._clear = function () {
 }
 
 ChainedBatch.prototype._write = function (options, callback) {
-  binding.batch_write(this.context, options, callback)
+  this.db._flushWritesAfter(binding.batch_write(this.context, options, callback))
 }
 
 util.inherits(ChainedBatch, AbstractChainedBatch)
@@ -0,0 +1,83 @@
+'use strict'
+
+// Encodes batch operations for batchPacked(). Every operation is a tag byte
+// (0 for del, 1 for put) followed by a varint32 length prefixed key and, for
+// puts, a varint32 length prefixed value. This is the record format of
+// LevelDB's WriteBatch.
+function varintLength (value) {
+  let length = 1
+  while (value >= 0x80) {
+    value >>>= 7
+    length++
+  }
+  return length
+}
+
+function writeVarint (buffer, offset, value) {
+  while (value >= 0x80) {
+    buffer[offset++] = (value & 0x7f) | 0x80
+    value >>>= 7
+  }
+  buffer[offset++] = value
+  return offset
+}
+
+function toBuffer (data) {
+  return Buffer.isBuffer(data) ? data : Buffer.from(String(data))
+}
+
+function encodeBatch (operations) {
+  if (!Array.isArray(operations)) {
+    throw new Error('encodeBatch() requires an array argument')
+  }
+
+  const records = []
+  let size = 0
+
+  for (const op of operations) {
+    if (typeof op !== 'object' || op === null) {
+      throw new Error('batch(array) element must be an object and not `null`')
+    }
+    if (op.type !== 'put' && op.type !== 'del') {
+      throw new Error("`type` must be 'put' or 'del'")
+    }
+    if (op.key == null) {
+      throw new Error('key cannot be `null` or `undefined`')
+    }
+
+    const key = toBuffer(op.key)
+    size += 1 + varintLength(key.length) + key.length
+
+    let value
+    if (op.type === 'put') {
+      if (op.value == null) {
+        throw new Error('value cannot be `null` or `undefined`')
+      }
+      value = toBuffer(op.value)
+      size += varintLength(value.length) + value.length
+    }
+
+    records.push(key, value)
+  }
+
+  const buffer = Buffer.allocUnsafe(size)
+  let offset = 0
+
+  for (let i = 0; i < records.length; i += 2) {
+    const key = records[i]
+    const value = records[i + 1]
+
+    buffer[offset++] = value === undefined ? 0 : 1
+    offset = writeVarint(buffer, offset, key.length)
+    offset += key.copy(buffer, offset)
+
+    if (value !== undefined) {
+      offset = writeVarint(buffer, offset, value.length)
+      offset += value.copy(buffer, offset)
+    }
+  }
+
+  return buffer
+}
+
+module.exports = encodeBatch
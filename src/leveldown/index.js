@@ -4,7 +4,10 @@ const util = require('util')
 const AbstractLevelDOWN = require('abstract-leveldown').AbstractLevelDOWN
 const binding = require('./binding')
 const ChainedBatch = require('./chained-batch')
+const encodeBatch = require('./encode-batch')
 const Iterator = require('./iterator')
+const SharedCache = require('./shared-cache')
+const Snapshot = require('./snapshot')
 
 function LevelDOWN (location) {
   if (!(this instanceof LevelDOWN)) {
@@ -26,13 +29,19 @@ function LevelDOWN (location) {
     errorIfExists: true,
     additionalMethods: {
       approximateSize: true,
-      compactRange: true
+      compactRange: true,
+      batchPacked: true,
+      getCached: true,
+      snapshot: true,
+      cacheStats: true,
+      metrics: true
     }
   })
 
   this.location = location
   this.context = binding.db_init()
   this.exposed = null
+  this._flushTimer = null
 }
 
 util.inherits(LevelDOWN, AbstractLevelDOWN)
@@ -47,6 +56,11 @@ LevelDOWN.prototype._open = function (options, callback) {
 
 LevelDOWN.prototype._close = function (callback) {
   const self = this
+  // db_close() writes the queued writes itself
+  if (this._flushTimer !== null) {
+    clearTimeout(this._flushTimer)
+    this._flushTimer = null
+  }
   binding.db_close(this.context, function (...args) {
     delete self.exposed
     callback && callback(...args)
@@ -61,8 +75,19 @@ LevelDOWN.prototype._serializeValue = function (value) {
   return Buffer.isBuffer(value) ? value : String(value)
 }
 
+// With the `coalesceWrites` option of open(), writes that don't fill a group return
+// the coalesce window in milliseconds. The group is written once it has passed.
+LevelDOWN.prototype._flushWritesAfter = function (delay) {
+  if (delay === undefined || this._flushTimer !== null) return
+  const self = this
+  this._flushTimer = setTimeout(function () {
+    self._flushTimer = null
+    binding.db_flush_writes(self.context)
+  }, delay)
+}
+
 LevelDOWN.prototype._put = function (key, value, options, callback) {
-  binding.db_put(this.context, key, value, options, callback)
+  this._flushWritesAfter(binding.db_put(this.context, key, value, options, callback))
 }
 
 LevelDOWN.prototype._get = function (key, options, callback) {
@@ -73,8 +98,37 @@ LevelDOWN.prototype._getMany = function (keys, options, callback) {
   binding.db_get_many(this.context, keys, options, callback)
 }
 
+// Returns the value if it's in the row cache (see the `rowCacheSize` option of
+// open()) without calling the callback. Otherwise returns undefined and gets the
+// value asynchronously, like get(). Writes made through `exposed` update the row
+// cache as well.
+LevelDOWN.prototype.getCached = function (key, options, callback) {
+  if (typeof options === 'function') {
+    callback = options
+    options = {}
+  }
+
+  if (typeof callback !== 'function') {
+    throw new Error('getCached() requires a callback argument')
+  }
+
+  const err = this._checkKey(key)
+  if (err) {
+    return process.nextTick(callback, err)
+  }
+
+  if (this.status !== 'open') {
+    return process.nextTick(callback, new Error('Database is not open'))
+  }
+
+  options = Object.assign({}, options)
+  options.asBuffer = options.asBuffer !== false
+
+  return binding.db_get_sync_cached(this.context, this._serializeKey(key), options, callback)
+}
+
 LevelDOWN.prototype._del = function (key, options, callback) {
-  binding.db_del(this.context, key, options, callback)
+  this._flushWritesAfter(binding.db_del(this.context, key, options, callback))
 }
 
 LevelDOWN.prototype._clear = function (options, callback) {
@@ -86,7 +140,28 @@ LevelDOWN.prototype._chainedBatch = function () {
 }
 
 LevelDOWN.prototype._batch = function (operations, options, callback) {
-  binding.batch_do(this.context, operations, options, callback)
+  this._flushWritesAfter(binding.batch_do(this.context, operations, options, callback))
+}
+
+LevelDOWN.prototype.batchPacked = function (buffer, options, callback) {
+  if (typeof options === 'function') {
+    callback = options
+    options = {}
+  }
+
+  if (!Buffer.isBuffer(buffer)) {
+    throw new Error('batchPacked() requires a buffer argument, see LevelDOWN.encodeBatch()')
+  }
+
+  if (typeof callback !== 'function') {
+    throw new Error('batchPacked() requires a callback argument')
+  }
+
+  if (this.status !== 'open') {
+    return process.nextTick(callback, new Error('Database is not open'))
+  }
+
+  this._flushWritesAfter(binding.batch_packed(this.context, buffer, typeof options === 'object' && options !== null ? options : {}, callback))
 }
 
 LevelDOWN.prototype.approximateSize = function (start, end, callback) {
@@ -133,6 +208,35 @@ LevelDOWN.prototype.getProperty = function (property) {
   return binding.db_get_property(this.context, property)
 }
 
+// Returns the block cache hits and misses of this database, along with the
+// usage and capacity of its block cache, which may be shared.
+LevelDOWN.prototype.cacheStats = function () {
+  if (this.status !== 'open') {
+    throw new Error('cannot call cacheStats() before open()')
+  }
+
+  return binding.db_cache_stats(this.context)
+}
+
+// Returns latency histograms per op (in microseconds), bytes read and written,
+// block cache hits, likely write stalls, memory usage and per level compaction
+// stats in one cheap call, meant to be polled by a metrics exporter.
+LevelDOWN.prototype.metrics = function () {
+  if (this.status !== 'open') {
+    throw new Error('cannot call metrics() before open()')
+  }
+
+  return binding.db_metrics(this.context)
+}
+
+LevelDOWN.prototype.snapshot = function () {
+  if (this.status !== 'open') {
+    throw new Error('cannot call snapshot() before open()')
+  }
+
+  return new Snapshot(this)
+}
+
 LevelDOWN.prototype._iterator = function (options) {
   if (this.status !== 'open') {
     // Prevent segfault
@@ -156,6 +260,24 @@ LevelDOWN.destroy = function (location, callback) {
   binding.destroy_db(location, callback)
 }
 
+// Moves database work off the libuv thread pool, which is shared with fs, dns
+// and crypto, onto `size` threads owned by the addon. Reads go first, then
+// writes, then background work (clear, approximateSize, compactRange and
+// iterators with the `background` option), which never takes more than
+// `maxBackground` threads. Work that has been queued for `maxWait`
+// milliseconds (100 by default) runs ahead of those priorities, so no class is
+// starved. Applies to the whole process and to work queued from then on, so
+// call it once at startup.
+LevelDOWN.configureThreadPool = function (options) {
+  binding.threadpool_configure(typeof options === 'object' && options !== null ? options : {})
+}
+
+// Returns queue depths and latencies (in microseconds) of the thread pool per
+// priority class, or undefined if configureThreadPool() wasn't called.
+LevelDOWN.threadPoolStats = function () {
+  return binding.threadpool_stats()
+}
+
 LevelDOWN.repair = function (location, callback) {
   if (arguments.length < 2) {
     throw new Error('repair() requires `location` and `callback` arguments')
@@ -170,4 +292,7 @@ LevelDOWN.repair = function (location, callback) {
   binding.repair_db(location, callback)
 }
 
+LevelDOWN.encodeBatch = encodeBatch
+LevelDOWN.SharedCache = SharedCache
+
 module.exports = LevelDOWN
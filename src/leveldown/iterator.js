@@ -3,6 +3,7 @@
 const util = require('util')
 const AbstractIterator = require('abstract-leveldown').AbstractIterator
 const binding = require('./binding')
+const PackedBatch = require('./packed-batch')
 
 function Iterator (db, options) {
   AbstractIterator.call(this, db)
@@ -10,6 +11,13 @@ function Iterator (db, options) {
   this.context = binding.iterator_init(db.context, options)
   this.cache = null
   this.finished = false
+
+  // In packed mode every read returns a single buffer, see PackedBatch
+  this.packed = !!(options && options.packed)
+  this.keyAsBuffer = !options || options.keyAsBuffer !== false
+  this.valueAsBuffer = !options || options.valueAsBuffer !== false
+  this.batch = null
+  this.position = 0
 }
 
 util.inherits(Iterator, AbstractIterator)
@@ -20,11 +28,14 @@ Iterator.prototype._seek = function (target) {
   }
 
   this.cache = null
+  this.batch = null
   binding.iterator_seek(this.context, target)
   this.finished = false
 }
 
 Iterator.prototype._next = function (callback) {
+  if (this.packed) return this._nextPacked(callback)
+
   if (this.cache && this.cache.length) {
     process.nextTick(callback, null, this.cache.pop(), this.cache.pop())
   } else if (this.finished) {
@@ -42,8 +53,68 @@ Iterator.prototype._next = function (callback) {
   return this
 }
 
+Iterator.prototype._nextPacked = function (callback) {
+  if (this.batch && this.position < this.batch.length) {
+    const index = this.position++
+    process.nextTick(callback, null, this.batch.key(index), this.batch.value(index))
+  } else if (this.finished) {
+    process.nextTick(callback)
+  } else {
+    this._readPacked((err) => {
+      if (err) return callback(err)
+      this._nextPacked(callback)
+    })
+  }
+
+  return this
+}
+
+Iterator.prototype._readPacked = function (callback) {
+  binding.iterator_next_packed(this.context, (err, buffer, finished) => {
+    if (err) return callback(err)
+
+    this.batch = new PackedBatch(buffer, this.keyAsBuffer, this.valueAsBuffer)
+    this.position = 0
+    this.finished = finished
+    callback()
+  })
+}
+
+// Yields the entries not read yet as a PackedBatch, or nothing once the
+// iterator is exhausted. Requires the `packed` option.
+Iterator.prototype.nextBatch = function (callback) {
+  if (typeof callback !== 'function') {
+    throw new Error('nextBatch() requires a callback argument')
+  }
+  if (!this.packed) {
+    throw new Error('nextBatch() requires the packed option')
+  }
+
+  if (this._ended) {
+    process.nextTick(callback, new Error('cannot call nextBatch() after end()'))
+  } else if (this._nexting) {
+    process.nextTick(callback, new Error('cannot call nextBatch() before previous next() has completed'))
+  } else if (this.batch && this.position < this.batch.length) {
+    const batch = this.batch.slice(this.position)
+    this.position = this.batch.length
+    process.nextTick(callback, null, batch)
+  } else if (this.finished) {
+    process.nextTick(callback)
+  } else {
+    this._nexting = true
+    this._readPacked((err) => {
+      this._nexting = false
+      if (err) return callback(err)
+      this.nextBatch(callback)
+    })
+  }
+
+  return this
+}
+
 Iterator.prototype._end = function (callback) {
   delete this.cache
+  delete this.batch
   binding.iterator_end(this.context, callback)
 }
 
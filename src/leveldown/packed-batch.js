@@ -0,0 +1,49 @@
+'use strict'
+
+// Reads the entries of a buffer filled by iterator_next_packed(). Every entry is a
+// uint32 key length, the key, a uint32 value length and the value. The entries are
+// followed by a table of uint32 entry offsets and the uint32 number of entries.
+// Integers are little-endian. Keys and values are returned as views of the buffer.
+// The batch starts at entry `start` of the buffer.
+function PackedBatch (buffer, keyAsBuffer, valueAsBuffer, start) {
+  const count = buffer.readUInt32LE(buffer.length - 4)
+
+  this.buffer = buffer
+  this.keyAsBuffer = keyAsBuffer !== false
+  this.valueAsBuffer = valueAsBuffer !== false
+  this.start = start || 0
+  this.length = count - this.start
+  this.table = buffer.length - 4 - count * 4
+}
+
+PackedBatch.prototype.slice = function (start) {
+  return new PackedBatch(this.buffer, this.keyAsBuffer, this.valueAsBuffer, this.start + start)
+}
+
+PackedBatch.prototype._offset = function (index) {
+  if (index < 0 || index >= this.length) {
+    throw new RangeError('index out of range')
+  }
+
+  return this.buffer.readUInt32LE(this.table + (this.start + index) * 4)
+}
+
+PackedBatch.prototype._read = function (offset, asBuffer) {
+  const length = this.buffer.readUInt32LE(offset)
+  const start = offset + 4
+
+  return asBuffer
+    ? this.buffer.subarray(start, start + length)
+    : this.buffer.toString('utf8', start, start + length)
+}
+
+PackedBatch.prototype.key = function (index) {
+  return this._read(this._offset(index), this.keyAsBuffer)
+}
+
+PackedBatch.prototype.value = function (index) {
+  const offset = this._offset(index)
+  return this._read(offset + 4 + this.buffer.readUInt32LE(offset), this.valueAsBuffer)
+}
+
+module.exports = PackedBatch
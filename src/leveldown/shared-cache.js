@@ -0,0 +1,21 @@
+'use strict'
+
+const binding = require('./binding')
+
+// A block cache of `size` bytes for many databases, so cache memory goes to
+// whichever one is busy. Pass it as the `sharedCache` option of open(), the
+// `cacheSize` option is then ignored. Databases keep it alive while open.
+function SharedCache (size) {
+  if (typeof size !== 'number' || size < 0) {
+    throw new Error('SharedCache() requires a size argument')
+  }
+
+  this.context = binding.shared_cache_init(size)
+}
+
+// Returns the bytes used by all databases sharing the cache and its capacity.
+SharedCache.prototype.stats = function () {
+  return binding.shared_cache_stats(this.context)
+}
+
+module.exports = SharedCache
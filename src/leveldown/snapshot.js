@@ -0,0 +1,44 @@
+'use strict'
+
+const binding = require('./binding')
+
+// A point in time view of a database. Pass it as the `snapshot` option of
+// get(), getMany() and iterator() to read many times from the same state.
+// Release it when done, reads that use it go on until they're done.
+function Snapshot (db) {
+  this.context = binding.snapshot_init(db.context)
+  this.released = false
+  this._exposed = null
+}
+
+// The snapshot for native code reading the exposed database, like the EVM
+// binding. Throws once the snapshot is released. The handle keeps the leveldb
+// snapshot until it's garbage collected, unexpose() is called or the db is
+// closed, even if the snapshot is released meanwhile.
+Object.defineProperty(Snapshot.prototype, 'exposed', {
+  get: function () {
+    if (this.released) {
+      throw new Error('snapshot has been released')
+    }
+    if (this._exposed === null) {
+      this._exposed = binding.snapshot_expose(this.context)
+    }
+    return this._exposed
+  }
+})
+
+// Drops the exposed handle of the snapshot. Native calls reading it go on
+// until they're done, later ones fail.
+Snapshot.prototype.unexpose = function () {
+  this._exposed = null
+  binding.snapshot_unexpose(this.context)
+}
+
+Snapshot.prototype.release = function () {
+  if (!this.released) {
+    this.released = true
+    binding.snapshot_release(this.context)
+  }
+}
+
+module.exports = Snapshot
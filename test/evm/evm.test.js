@@ -1,6 +1,6 @@
 const test = require('tape')
 const testCommon = require("../leveldown/common");
-const { JSEVMBinding, init } = require("../../dist");
+const { JSEVMBinding, init, dumpState, setPrecompileCacheSize, precompileCacheStats, arenaStats, setCodeCacheSize, codeCacheStats, unpackCallResults } = require("../../dist");
 
 const accounts = [
   "0xf39Fd6e51aad88F6F4ce6aB8827279cffFb92266",
@@ -44,6 +44,54 @@ function toBuffer(str) {
   }
 }
 
+/**
+ * Run a test against a new level db and evm instance, the level db is closed afterwards.
+ * @param t - Tape test
+ * @param fn - Called with the evm instance, the level db and the genesis state root
+ * @param options - `open`: options to open the level db with,
+ *                  `genesis`: false to leave the state empty,
+ *                  `beforeGenesis`: called with the evm instance before the genesis state is built
+ */
+async function withEvm(t, fn, { open = {}, genesis = true, beforeGenesis } = {}) {
+  const db = testCommon.factory();
+  try {
+    // open leveldb
+    await new Promise((r, j) => {
+      db.open(open, (err) => {
+        err ? j(err) : r();
+      });
+    });
+
+    // init evm binding
+    init();
+
+    // create evm instance
+    const evm = new JSEVMBinding(db.exposed, 23579);
+    if (beforeGenesis) {
+      beforeGenesis(evm);
+    }
+
+    // init genesis state
+    const stateRoot = genesis
+      ? evm.genesis(
+          accounts.concat(precompiles),
+          new Array(accounts.length)
+            .fill("0x21e19e0c9bab2400000")
+            .concat(new Array(precompiles.length).fill("0x00"))
+        )
+      : undefined;
+
+    await fn(evm, db, stateRoot);
+  } finally {
+    // gracefully close leveldb
+    if (db.status === "open") {
+      await new Promise((r) => {
+        db.close(r);
+      });
+    }
+  }
+}
+
 test("should run dump.json succeed", async function(t) {
   const db = testCommon.factory();
   try {
@@ -113,3 +161,1021 @@ test("should run dump.json succeed", async function(t) {
     });
   }
 })
+
+test("should dump state succeed", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    // deploy a contract with a few storage slots
+    const initcode = [1, 2, 3, 4, 5].map((k) => "60" + (k * 16).toString(16) + "600" + k + "55").join("") + "00";
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    stateRoot = evm.runTx(stateRoot, header, { from: accounts[0], nonce: 0, data: toBuffer("0x" + initcode) }, "0x00", () => []).stateRoot;
+
+    // dump the whole state at once
+    const all = await evm.dumpState(stateRoot, undefined, { batchSize: 1000, includeStorage: true });
+    t.equal(all.next, undefined, "should dump all accounts in one batch");
+    t.equal(all.accounts.length, accounts.length + precompiles.length + 1, "should dump all accounts");
+    for (let i = 1; i < all.accounts.length; i++) {
+      t.ok(all.accounts[i - 1].hashedAddress < all.accounts[i].hashedAddress, "accounts should be in hashed address order");
+    }
+    t.ok(all.accounts.some(({ storage }) => storage.length === 5), "should dump the storage");
+
+    // dump the state in small batches with resumable cursors, the ranges are walked in parallel
+    for (const ranges of [16, 256]) {
+      const dumped = new Map();
+      for await (const batch of dumpState(evm, stateRoot, { ranges, threads: 4, batchSize: 3, includeStorage: true, storageBatchSize: 2 })) {
+        t.ok(batch.length <= 3, "batch size should be limited");
+        t.ok(batch.reduce((slots, { storage }) => slots + storage.length, 0) <= 2, "storage should be limited");
+        for (let i = 1; i < batch.length; i++) {
+          t.ok(batch[i - 1].hashedAddress < batch[i].hashedAddress, "a batch should be in hashed address order");
+        }
+        // an account whose storage didn't fit continues in the next batch
+        for (const account of batch) {
+          const previous = dumped.get(account.hashedAddress);
+          if (previous) {
+            t.equal(previous.storageComplete, false, "only incomplete storage should continue");
+            account.storage = previous.storage.concat(account.storage);
+          }
+          dumped.set(account.hashedAddress, account);
+        }
+      }
+      const merged = Array.from(dumped.values()).sort((a, b) => (a.hashedAddress < b.hashedAddress ? -1 : 1));
+      t.deepEqual(merged, all.accounts, "batches should be equal to the full dump");
+    }
+  });
+})
+
+test("should prune state succeed", async function(t) {
+  await withEvm(t, async (evm, db, genesisRoot) => {
+    evm.retainRoot(genesisRoot);
+
+    // execute a few transactions
+    const { dump } = require("./dump.json");
+    let stateRoot = genesisRoot;
+    for (let i = 0; i < 3; i++) {
+      const { blockHeader, tx } = dump[i];
+      stateRoot = evm.runTx(toBuffer(stateRoot), toBuffer(blockHeader.raw), toBuffer(tx.raw), "0x00", () => []).stateRoot;
+      evm.retainRoot(stateRoot);
+    }
+
+    // wait for a prune cycle
+    for (let i = 0; i < 50 && evm.prunerStats().cycles === 0; i++) {
+      await new Promise((r) => setTimeout(r, 100));
+    }
+    const stats = evm.prunerStats();
+    evm.stopPruner();
+
+    t.ok(stats.cycles > 0, "should finish a prune cycle");
+    t.ok(stats.totalSwept > 0, "should delete unreachable nodes");
+    t.ok((await evm.dumpState(stateRoot, undefined, { batchSize: 1000 })).accounts.length >= accounts.length, "latest state should be kept");
+    await evm.dumpState(genesisRoot).then(() => t.fail("genesis state should be pruned"), () => t.pass("genesis state should be pruned"));
+    const marks = (await readKeys(db)).filter((key) => key.toString().startsWith("statePrunerMark"));
+    t.equal(marks.length, 0, "should delete the marker records");
+
+    // closing the level db stops a running pruner
+    evm.startPruner({ retainedRoots: 1, interval: 1 });
+    await new Promise((r) => {
+      db.close(r);
+    });
+    t.equal(evm.prunerStats().cycles, 0, "should stop the pruner");
+  }, {
+    beforeGenesis: (evm) => {
+      // keep the latest state root only, small chunks and filter exercise the on-disk marked set
+      evm.startPruner({ retainedRoots: 1, interval: 1, maxOpsPerSecond: 0, batchSize: 16, markFilterBytes: 64 });
+    }
+  });
+})
+
+test("should keep the state retained while a prune cycle starts", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    evm.retainRoot(stateRoot);
+
+    // retain a new root after every transfer until a few cycles started around the retains
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    const deadline = Date.now() + 10000;
+    let failures = 0;
+    let nonce = 0;
+    while (evm.prunerStats().cycles < 3 && Date.now() < deadline) {
+      const to = "0x" + (nonce + 1).toString(16).padStart(40, "0");
+      stateRoot = evm.runTx(stateRoot, header, { from: accounts[0], nonce: nonce++, to, value: 1 }, "0x00", () => []).stateRoot;
+      evm.retainRoot(stateRoot);
+
+      // a cycle that started before the retain must not delete the new nodes
+      while (evm.prunerStats().running) {
+        await new Promise((r) => setTimeout(r, 1));
+      }
+      try {
+        await evm.dumpState(stateRoot, undefined, { batchSize: 1000 });
+      } catch (err) {
+        failures++;
+      }
+    }
+    const { cycles } = evm.prunerStats();
+    evm.stopPruner();
+
+    t.ok(cycles > 0, "should run prune cycles while retaining roots");
+    t.equal(failures, 0, `should keep the newest root in ${nonce} retains`);
+  }, {
+    beforeGenesis: (evm) => {
+      // a cycle may start after every retained root
+      evm.startPruner({ retainedRoots: 1, interval: 1, maxOpsPerSecond: 0 });
+    }
+  });
+})
+
+function readTrieNodes(db) {
+  return new Promise((resolve, reject) => {
+    const nodes = [];
+    const it = db.iterator();
+    const next = () => {
+      it.next((err, key, value) => {
+        if (err) {
+          return it.end(() => reject(err));
+        }
+        if (key === undefined) {
+          return it.end(() => resolve(nodes));
+        }
+        if (key.length === 32) {
+          nodes.push(value);
+        }
+        next();
+      });
+    };
+    next();
+  });
+}
+
+function readKeys(db) {
+  return new Promise((resolve, reject) => {
+    const keys = [];
+    const it = db.iterator({ values: false });
+    const next = () => {
+      it.next((err, key) => {
+        if (err) {
+          return it.end(() => reject(err));
+        }
+        if (key === undefined) {
+          return it.end(() => resolve(keys));
+        }
+        keys.push(key);
+        next();
+      });
+    };
+    next();
+  });
+}
+
+test("should import trie nodes succeed", async function(t) {
+  await withEvm(t, async (sourceEVM, source, stateRoot) => {
+    const nodes = await readTrieNodes(source);
+
+    await withEvm(t, async (targetEVM, target) => {
+      // only the root is expected, everything else is rejected
+      const first = await targetEVM.importTrieNodes(nodes, { expected: [stateRoot] });
+      t.equal(first.imported, 1, "should import the root node");
+      t.equal(first.rejected.length, nodes.length - 1, "should reject unexpected nodes");
+      t.ok(first.missing.length > 0, "should return the children of the root");
+
+      // import everything else
+      const second = await targetEVM.importTrieNodes(nodes.concat([Buffer.from("invalid")]));
+      t.deepEqual(second.rejected, [nodes.length], "should reject invalid nodes");
+      t.deepEqual(second.missing, [], "should have nothing left to sync");
+      t.deepEqual(await targetEVM.dumpState(stateRoot, undefined, { batchSize: 1000 }), await sourceEVM.dumpState(stateRoot, undefined, { batchSize: 1000 }), "state should be equal");
+
+      // closing waits for a pending import
+      const pending = targetEVM.importTrieNodes(nodes, { expected: [stateRoot] });
+      await new Promise((r) => {
+        target.close(r);
+      });
+      t.equal((await pending).imported, 1, "should import before closing");
+    }, { genesis: false });
+  });
+})
+
+test("should keep imported trie nodes until their root is retained", async function(t) {
+  await withEvm(t, async (sourceEVM, source, genesisRoot) => {
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    const stateRoot = sourceEVM.runTx(genesisRoot, header, { from: accounts[0], nonce: 0, to: accounts[1], value: 1 }, "0x00", () => []).stateRoot;
+    const nodes = await readTrieNodes(source);
+
+    await withEvm(t, async (targetEVM, target, targetRoot) => {
+      t.equal(targetRoot, genesisRoot);
+      t.equal((await targetEVM.importTrieNodes(nodes)).missing.length, 0, "should import the whole state");
+
+      // retaining another root must not release the imported nodes
+      targetEVM.retainRoot(targetRoot);
+      for (let i = 0; i < 50 && targetEVM.prunerStats().cycles === 0; i++) {
+        await new Promise((r) => setTimeout(r, 100));
+      }
+      t.ok(targetEVM.prunerStats().cycles > 0, "should finish a prune cycle");
+      targetEVM.stopPruner();
+      t.deepEqual(await targetEVM.dumpState(stateRoot, undefined, { batchSize: 1000 }), await sourceEVM.dumpState(stateRoot, undefined, { batchSize: 1000 }), "imported state should be kept");
+    }, {
+      beforeGenesis: (evm) => {
+        evm.startPruner({ retainedRoots: 1, interval: 1, maxOpsPerSecond: 0 });
+      }
+    });
+  });
+})
+
+test("should pipeline commits succeed", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    // execute transactions on top of the queued state
+    const { dump } = require("./dump.json");
+    for (let i = 0; i < dump.length; i++) {
+      const { blockHeader, tx } = dump[i];
+      stateRoot = evm.runTx(toBuffer(stateRoot), toBuffer(blockHeader.raw), toBuffer(tx.raw), "0x00", () => []).stateRoot;
+    }
+    const expected = await evm.dumpState(stateRoot, undefined, { batchSize: 1000, includeStorage: true });
+
+    // everything must be in the level db after flushing
+    evm.flush();
+    const reader = new JSEVMBinding(db.exposed, 23579);
+    t.deepEqual(await reader.dumpState(stateRoot, undefined, { batchSize: 1000, includeStorage: true }), expected, "state should be written");
+  }, {
+    beforeGenesis: (evm) => {
+      evm.setDurability("acknowledged");
+    }
+  });
+})
+
+test("should close write queued commits succeed", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    const { dump } = require("./dump.json");
+    const { blockHeader, tx } = dump[0];
+    stateRoot = evm.runTx(toBuffer(stateRoot), toBuffer(blockHeader.raw), toBuffer(tx.raw), "0x00", () => []).stateRoot;
+    const expected = await evm.dumpState(stateRoot, undefined, { batchSize: 1000, includeStorage: true });
+
+    // close without flushing, then reopen
+    await new Promise((r) => {
+      db.close(r);
+    });
+    await new Promise((r, j) => {
+      db.open((err) => {
+        err ? j(err) : r();
+      });
+    });
+
+    // the queued commits were written before closing
+    const reader = new JSEVMBinding(db.exposed, 23579);
+    t.deepEqual(await reader.dumpState(stateRoot, undefined, { batchSize: 1000, includeStorage: true }), expected, "state should be written");
+
+    // the old instance can't write to the closed db
+    t.throws(() => {
+      evm.genesis(accounts, new Array(accounts.length).fill("0x01"));
+      evm.flush();
+    });
+  }, {
+    beforeGenesis: (evm) => {
+      evm.setDurability("acknowledged");
+    }
+  });
+})
+
+test("should read state at snapshot succeed", async function(t) {
+  await withEvm(t, async (evm, db, genesisRoot) => {
+    const options = { batchSize: 1000, includeStorage: true };
+    const genesis = await evm.dumpState(genesisRoot, undefined, options);
+
+    // take a snapshot, then execute transactions
+    const snapshot = db.snapshot();
+    let stateRoot = genesisRoot;
+    const { dump } = require("./dump.json");
+    for (let i = 0; i < dump.length; i++) {
+      const { blockHeader, tx } = dump[i];
+      stateRoot = evm.runTx(toBuffer(stateRoot), toBuffer(blockHeader.raw), toBuffer(tx.raw), "0x00", () => []).stateRoot;
+    }
+    const latest = await evm.dumpState(stateRoot, undefined, options);
+
+    t.deepEqual(await evm.dumpState(genesisRoot, undefined, options, snapshot.exposed), genesis, "should read the state at the snapshot");
+    let atSnapshot;
+    try {
+      atSnapshot = await evm.dumpState(stateRoot, undefined, options, snapshot.exposed);
+    } catch (err) {
+      // the root isn't in the snapshot
+    }
+    t.notDeepEqual(atSnapshot, latest, "later state should not be visible at the snapshot");
+
+    const exposed = snapshot.exposed;
+    t.is(snapshot.exposed, exposed, "should expose one handle per snapshot");
+    snapshot.release();
+    t.throws(() => snapshot.exposed, /released/, "released snapshot should not be exposed");
+    t.deepEqual(await evm.dumpState(genesisRoot, undefined, options, exposed), genesis, "exposed snapshot should outlive its release");
+    snapshot.unexpose();
+    t.throws(() => evm.dumpState(genesisRoot, undefined, options, exposed), /not exposed anymore/, "unexposed snapshot should not be read");
+  });
+})
+
+test("should trace call succeed", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    // deploy the contract
+    const { dump } = require("./dump.json");
+    for (let i = 0; i < 2; i++) {
+      const { blockHeader, tx } = dump[i];
+      stateRoot = evm.runTx(toBuffer(stateRoot), toBuffer(blockHeader.raw), toBuffer(tx.raw), "0x00", () => []).stateRoot;
+    }
+
+    // hash()
+    const header = toBuffer(dump[1].blockHeader.raw);
+    const tx = { gas: 100000, data: toBuffer("0x09bd5a60"), to: "0x5FbDB2315678afecb367f032d93F642f64180aa3" };
+    const expected = evm.runCall(toBuffer(stateRoot), header, tx, "0x00", () => []);
+    const trace = (options) => {
+      const chunks = [];
+      evm.traceCall(toBuffer(stateRoot), header, tx, "0x00", () => [], options, (chunk) => chunks.push(chunk));
+      return chunks;
+    };
+
+    const chunks = trace({ tracer: "callTracer", chunkSize: 16 });
+    t.ok(chunks.length > 1, "should stream the trace in chunks");
+    const calls = JSON.parse(Buffer.concat(chunks).toString());
+    t.equal(calls.type, "CALL", "should trace the top level call");
+    t.equal(calls.to, tx.to.toLowerCase(), "should trace the callee");
+    t.equal(calls.output, expected, "should trace the output");
+    t.ok(BigInt(calls.gasUsed) > 0n, "should trace the gas used");
+
+    const structLogs = JSON.parse(Buffer.concat(trace({ enableMemory: true })).toString());
+    t.equal(structLogs.failed, false, "should not fail");
+    t.equal("0x" + structLogs.returnValue, expected, "should return the output");
+    t.ok(structLogs.structLogs.length > 0, "should log every instruction");
+    t.equal(structLogs.structLogs[0].depth, 1, "should start at depth 1");
+    t.equal(structLogs.structLogs[0].pc, 0, "should start at the first instruction");
+
+    t.throws(() => trace({ tracer: "unknown" }), /unknown tracer/, "should reject unknown tracers");
+    t.throws(
+      () => evm.traceCall(toBuffer(stateRoot), header, tx, "0x00", () => [], { tracer: "callTracer" }, () => {
+        throw new Error("consumer failed");
+      }),
+      /consumer failed/,
+      "should rethrow the error of onChunk"
+    );
+  });
+})
+
+function modpow(base, exp, mod) {
+  if (mod === 0n) {
+    return 0n;
+  }
+  let result = 1n % mod;
+  base %= mod;
+  for (; exp > 0n; exp >>= 1n) {
+    if (exp & 1n) {
+      result = (result * base) % mod;
+    }
+    base = (base * base) % mod;
+  }
+  return result;
+}
+
+function toBigInt(buf) {
+  return buf.length > 0 ? BigInt("0x" + buf.toString("hex")) : 0n;
+}
+
+function lengthWord(n) {
+  const buf = Buffer.alloc(32);
+  buf.writeUInt32BE(n, 28);
+  return buf;
+}
+
+test("should modexp match a reference implementation", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    // deterministic inputs
+    let seed = 0x2565;
+    const random = (length) => {
+      const buf = Buffer.alloc(length);
+      for (let i = 0; i < length; i++) {
+        seed = (seed * 1103515245 + 12345) >>> 0;
+        buf[i] = seed >>> 16;
+      }
+      return buf;
+    };
+
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    const modexp = (base, exp, mod) => {
+      const data = Buffer.concat([lengthWord(base.length), lengthWord(exp.length), lengthWord(mod.length), base, exp, mod]);
+      return evm.runCall(stateRoot, header, { gas: "0xffffffffff", data, to: precompiles[4] }, "0x00", () => []);
+    };
+
+    // odd and even moduli around the limb sizes, including the generic fallback above 4096 bits
+    let failures = 0;
+    let cases = 0;
+    for (const modLength of [1, 8, 9, 31, 32, 33, 64, 128, 256, 512, 513]) {
+      for (let i = 0; i < 8; i++) {
+        const base = random((i * 7) % (2 * modLength + 1));
+        const exp = random(i % 4 === 0 ? 0 : 1 + ((i * 5) % 32));
+        const mod = random(modLength);
+        mod[modLength - 1] = i % 2 ? mod[modLength - 1] | 1 : mod[modLength - 1] & 0xfe;
+        if (i === 6) {
+          mod[0] = 0;
+        }
+
+        const expected = "0x" + modpow(toBigInt(base), toBigInt(exp), toBigInt(mod)).toString(16).padStart(modLength * 2, "0");
+        const output = modexp(base, exp, mod);
+        cases++;
+        if (output !== expected) {
+          failures++;
+          t.fail(`modexp(${base.toString("hex")}, ${exp.toString("hex")}, ${mod.toString("hex")})`);
+        }
+      }
+    }
+    t.equal(failures, 0, `should match in ${cases} cases`);
+
+    t.equal(modexp(Buffer.from([7]), Buffer.from([5]), Buffer.alloc(4)), "0x00000000", "zero modulus should return zero");
+    t.equal(modexp(Buffer.from([7]), Buffer.from([5]), Buffer.from([1])), "0x00", "modulus one should return zero");
+    t.equal(modexp(Buffer.from([7]), Buffer.alloc(0), Buffer.from([0, 5])), "0x0001", "zero exponent should return one");
+  });
+})
+
+test("should cache precompiled contract results", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    const call = (to, data) => evm.runCall(stateRoot, { number: 1 }, { data, to }, "0x00", () => []);
+    const base = Buffer.from(Date.now().toString(16).padStart(16, "0"), "hex");
+    const exp = Buffer.from([3]);
+    const mod = Buffer.from("1fffffffffffffff", "hex");
+    const data = Buffer.concat([lengthWord(base.length), lengthWord(exp.length), lengthWord(mod.length), base, exp, mod]);
+    const expected = "0x" + modpow(toBigInt(base), toBigInt(exp), toBigInt(mod)).toString(16).padStart(mod.length * 2, "0");
+
+    const before = precompileCacheStats();
+    t.equal(call(precompiles[4], data), expected, "should compute modexp");
+    const missed = precompileCacheStats();
+    t.equal(missed.misses, before.misses + 1, "should miss the first time");
+    t.equal(call(precompiles[4], data), expected, "should return the cached modexp");
+    const hit = precompileCacheStats();
+    t.equal(hit.hits, missed.hits + 1, "should hit the second time");
+    t.ok(hit.entries > 0 && hit.size > 0, "should count cached results");
+
+    call(precompiles[1], data);
+    call(precompiles[2], data);
+    call(precompiles[3], data);
+    const uncached = precompileCacheStats();
+    t.equal(uncached.misses, hit.misses, "sha256, ripemd160 and identity should not be cached");
+    t.equal(uncached.hits, hit.hits, "sha256, ripemd160 and identity should not be looked up");
+
+    setPrecompileCacheSize(0);
+    const disabled = precompileCacheStats();
+    t.equal(disabled.capacity, 0, "should disable the cache");
+    t.equal(disabled.entries, 0, "should drop cached results");
+    t.equal(call(precompiles[4], data), expected, "should compute without the cache");
+    t.equal(precompileCacheStats().entries, 0, "should not cache while disabled");
+    setPrecompileCacheSize(16 * 1024 * 1024);
+  });
+})
+
+// alt_bn128 arithmetic on affine points over Fq2, G1 points have no imaginary part
+const fieldModulus = 21888242871839275222246405745257275088696311157297823662689037894645226208583n;
+
+function fq(a) {
+  return ((a % fieldModulus) + fieldModulus) % fieldModulus;
+}
+
+const fq2 = {
+  add: ([a, b], [c, d]) => [fq(a + c), fq(b + d)],
+  sub: ([a, b], [c, d]) => [fq(a - c), fq(b - d)],
+  mul: ([a, b], [c, d]) => [fq(a * c - b * d), fq(a * d + b * c)],
+  inv: ([a, b]) => {
+    const n = modpow(fq(a * a + b * b), fieldModulus - 2n, fieldModulus);
+    return [fq(a * n), fq(-b * n)];
+  },
+  eq: ([a, b], [c, d]) => a === c && b === d
+};
+
+function pointAdd(p1, p2) {
+  if (p1 === null) {
+    return p2;
+  }
+  if (p2 === null) {
+    return p1;
+  }
+  const [x1, y1] = p1;
+  const [x2, y2] = p2;
+  let slope;
+  if (fq2.eq(x1, x2)) {
+    if (!fq2.eq(y1, y2)) {
+      return null;
+    }
+    const x1sq = fq2.mul(x1, x1);
+    slope = fq2.mul(fq2.add(fq2.add(x1sq, x1sq), x1sq), fq2.inv(fq2.add(y1, y1)));
+  } else {
+    slope = fq2.mul(fq2.sub(y2, y1), fq2.inv(fq2.sub(x2, x1)));
+  }
+  const x3 = fq2.sub(fq2.sub(fq2.mul(slope, slope), x1), x2);
+  return [x3, fq2.sub(fq2.mul(slope, fq2.sub(x1, x3)), y1)];
+}
+
+function pointMul(p, k) {
+  let result = null;
+  for (; k > 0n; k >>= 1n) {
+    if (k & 1n) {
+      result = pointAdd(result, p);
+    }
+    p = pointAdd(p, p);
+  }
+  return result;
+}
+
+function pointNeg([x, y]) {
+  return [x, fq2.sub([0n, 0n], y)];
+}
+
+function fqWord(a) {
+  return Buffer.from(a.toString(16).padStart(64, "0"), "hex");
+}
+
+function encodeG1(p) {
+  return p === null ? Buffer.alloc(64) : Buffer.concat([fqWord(p[0][0]), fqWord(p[1][0])]);
+}
+
+function encodeG2(p) {
+  return p === null ? Buffer.alloc(128) : Buffer.concat([p[0][1], p[0][0], p[1][1], p[1][0]].map(fqWord));
+}
+
+const g1 = [[1n, 0n], [2n, 0n]];
+const g2 = [
+  [10857046999023057135944570762232829481370756359578518086990519993285655852781n, 11559732032986387107991004021392285783925812861821192530917403151452391805634n],
+  [8495653923123431417604973247489272438418190587263600148770280649306958101930n, 4082367875863433681332203403145435568316851327593401208105741076214120093531n]
+];
+
+test("should alt_bn128 pairing match the expected results", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    const pairing = (pairs) => {
+      const data = Buffer.concat(pairs.map(([p, q]) => Buffer.concat([encodeG1(p), encodeG2(q)])));
+      return evm.runCall(stateRoot, header, { gas: "0xffffffffff", data, to: precompiles[7] }, "0x00", () => []);
+    };
+    const P = (k) => pointMul(g1, k);
+    const Q = (k) => pointMul(g2, k);
+    const one = "0x" + "00".repeat(31) + "01";
+    const zero = "0x" + "00".repeat(32);
+    const offCurve = [g2[0], fq2.add(g2[1], [1n, 0n])];
+
+    // the expected results follow from e(aP, bQ) = e(P, Q) ^ ab
+    const cases = [
+      ["no pairs", [], one],
+      ["e(P, Q) e(-P, Q)", [[P(1n), Q(1n)], [pointNeg(P(1n)), Q(1n)]], one],
+      ["e(P, 2Q) e(-2P, Q)", [[P(1n), Q(2n)], [pointNeg(P(2n)), Q(1n)]], one],
+      ["e(3P, Q) e(P, 2Q) e(-5P, Q)", [[P(3n), Q(1n)], [P(1n), Q(2n)], [pointNeg(P(5n)), Q(1n)]], one],
+      ["e(3P, 2Q) e(-2P, 3Q) e(P, Q) e(-P, Q)", [[P(3n), Q(2n)], [pointNeg(P(2n)), Q(3n)], [P(1n), Q(1n)], [pointNeg(P(1n)), Q(1n)]], one],
+      ["e(P, Q) e(P, Q)", [[P(1n), Q(1n)], [P(1n), Q(1n)]], zero],
+      ["e(3P, 2Q) e(-P, 5Q)", [[P(3n), Q(2n)], [pointNeg(P(1n)), Q(5n)]], zero],
+      ["e(P, Q)", [[P(1n), Q(1n)]], zero],
+      ["pairs with infinity", [[null, Q(7n)], [P(1n), Q(1n)], [P(9n), null], [pointNeg(P(1n)), Q(1n)]], one],
+      ["G2 point not on the curve", [[P(1n), Q(1n)], [P(1n), offCurve]], "0x"]
+    ];
+
+    // every case runs twice, first with cold then with warm G2 precomputations,
+    // the result cache is disabled so that both runs reach the pairing engine
+    setPrecompileCacheSize(0);
+    for (const round of ["cold", "warm"]) {
+      for (const [name, pairs, expected] of cases) {
+        t.equal(pairing(pairs), expected, `${name} (${round})`);
+      }
+    }
+    setPrecompileCacheSize(16 * 1024 * 1024);
+  });
+})
+
+test("should filter indexed logs", async function(t) {
+  await withEvm(t, async (evm, db) => {
+    const hash = (...parts) => "0x" + require("crypto").createHash("sha256").update(parts.join("/")).digest("hex");
+    const topics = [0, 1, 2, 3, 4].map((i) => hash("topic", i));
+
+    // a few logs in every third block, more than a section so that one section is written
+    const chain = [];
+    const makeBlock = (number, salt) => {
+      const transactions = [];
+      if (number % 3 === 0) {
+        for (let i = 0; i < (number % 4) + 1; i++) {
+          const logs = [];
+          for (let j = 0; j < (number + i) % 3; j++) {
+            const k = number + i + j + salt;
+            logs.push({ address: accounts[k % 4], topics: topics.slice(k % 5, (k % 5) + (k % 3)), data: "0x" + j.toString(16).padStart(2, "0") });
+          }
+          transactions.push({ transactionHash: hash("tx", number, i, salt), logs });
+        }
+      }
+      return { hash: hash("block", number, salt), transactions };
+    };
+    for (let number = 0; number < 4200; number++) {
+      chain[number] = makeBlock(number, 0);
+      evm.indexBlock(number, chain[number].hash, chain[number].transactions);
+    }
+
+    // replace a block of the written section and one of the open section
+    for (const number of [4095, 4110]) {
+      chain[number] = makeBlock(number, 7);
+      evm.indexBlock(number, chain[number].hash, chain[number].transactions);
+    }
+
+    const expected = (from, to, filter) => {
+      const addresses = filter.address === undefined ? [] : [].concat(filter.address).map((a) => a.toLowerCase());
+      const positions = (filter.topics || []).map((p) => (p === null ? [] : [].concat(p)));
+      const logs = [];
+      for (let number = from; number <= to && number < chain.length; number++) {
+        let logIndex = 0;
+        chain[number].transactions.forEach(({ transactionHash, logs: txLogs }, transactionIndex) => {
+          for (const log of txLogs) {
+            const matches =
+              (addresses.length === 0 || addresses.includes(log.address.toLowerCase())) &&
+              positions.every((p, i) => p.length === 0 || (i < log.topics.length && p.includes(log.topics[i])));
+            if (matches) {
+              logs.push({ blockNumber: number, blockHash: chain[number].hash, transactionHash, transactionIndex, logIndex, data: log.data });
+            }
+            logIndex++;
+          }
+        });
+      }
+      return logs;
+    };
+
+    const filters = [
+      [0, 4199, {}],
+      [0, 4199, { address: accounts[1] }],
+      [10, 4150, { address: [accounts[0], accounts[2]] }],
+      [0, 4199, { topics: [topics[2]] }],
+      [100, 4199, { topics: [null, [topics[1], topics[3]]] }],
+      [4000, 4199, { address: accounts[3], topics: [[topics[0], topics[4]]] }],
+      [4090, 4120, {}],
+      [0, 4199, { address: accounts[5] }],
+      [4199, 4300, {}]
+    ];
+    for (const [from, to, filter] of filters) {
+      const logs = (await evm.filterLogs(from, to, filter)).map(({ blockNumber, blockHash, transactionHash, transactionIndex, logIndex, data }) => ({
+        blockNumber,
+        blockHash,
+        transactionHash,
+        transactionIndex,
+        logIndex,
+        data
+      }));
+      t.deepEqual(logs, expected(from, to, filter), `filterLogs(${from}, ${to}, ${JSON.stringify(filter)})`);
+    }
+
+    // the open section is rebuilt from the indexed blocks
+    const reopened = new JSEVMBinding(db.exposed, 23579);
+    t.equal((await reopened.filterLogs(4100, 4199, { address: accounts[2] })).length, expected(4100, 4199, { address: accounts[2] }).length, "should filter after reopening");
+
+    // block numbers are 32 bits, larger ones are rejected instead of wrapping around
+    t.equal((await evm.filterLogs(3n, 3n)).length, expected(3, 3, {}).length, "should take bigint block numbers");
+    t.throws(() => evm.filterLogs(0, 2 ** 32 + 3), /out of range/, "should reject a block number above 32 bits");
+    t.throws(() => evm.filterLogs(0n, 2n ** 64n), /out of range/, "should reject a bigint above 64 bits");
+    t.throws(() => evm.indexBlock(2 ** 32, chain[0].hash, []), /out of range/, "should not index a block number above 32 bits");
+  }, { genesis: false });
+})
+
+test("should create access lists", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    const deploy = (runtime, nonce) => {
+      // copy the runtime code to memory and return it
+      const length = (runtime.length / 2).toString(16).padStart(2, "0");
+      const initcode = "60" + length + "600c600039" + "60" + length + "6000f3";
+      const { stateRoot: root, result } = evm.runTx(stateRoot, header, { from: accounts[0], nonce, data: toBuffer(initcode + runtime) }, "0x00", () => []);
+      stateRoot = root;
+      return result.newAddress;
+    };
+    const staticcall = (address) => "6000600060006000" + "73" + address.substr(2) + "5afa50";
+
+    // reads slots 5 and 7 of its own storage
+    const reader = deploy("600554506007545000", 0);
+    // reads slot 1 of its own storage, calls the reader, reads the balances of another account
+    // and of the caller, calls a precompile
+    const caller = deploy("60015450" + staticcall(reader) + "73" + accounts[3].substr(2) + "3150" + "333150" + staticcall(precompiles[3]) + "00", 1);
+    t.ok(reader && caller, "should deploy the contracts");
+
+    const tx = { from: accounts[1], to: caller, gas: 100000 };
+    const pending = evm.createAccessList(stateRoot, header, tx, "0x00", () => []);
+    t.ok(pending instanceof Promise, "should create the list on a worker thread");
+    const created = await pending;
+    t.equal(created.excepted, undefined, "should succeed");
+    t.equal(created.runs, 2, "should converge after a run with the list");
+    const slot = (n) => "0x" + n.toString(16).padStart(64, "0");
+    const expected = [
+      [reader.toLowerCase(), [slot(5), slot(7)]],
+      [accounts[3].toLowerCase(), []],
+      [caller.toLowerCase(), [slot(1)]],
+    ].sort((a, b) => (a[0] < b[0] ? -1 : 1));
+    t.deepEqual(created.accessList, expected, "should list the accessed accounts and slots, and the recipient's slots");
+    t.ok(BigInt(created.gasUsed) > 21000n, "should return the gas used");
+
+    const again = await evm.createAccessList(stateRoot, header, { ...tx, accessList: created.accessList, chainID: evm.chainID() }, "0x00", () => []);
+    t.equal(again.runs, 1, "should keep a complete list");
+    t.deepEqual(again.accessList, created.accessList, "should return the same list");
+    t.equal(again.gasUsed, created.gasUsed, "should use the same gas");
+
+    evm.setHardfork("istanbul");
+    const rejected = evm.createAccessList(stateRoot, header, tx, "0x00", () => []);
+    // the hardfork is read when the list is requested
+    evm.resetHardfork();
+    await rejected.then(() => t.fail("should need EIP-2930"), (err) => t.ok(/AccessListNotSupported/.test(err.message), "should need EIP-2930"));
+
+    // the db is closed once the pending list is created, it can't be read meanwhile
+    const beforeClose = evm.createAccessList(stateRoot, header, tx, "0x00", () => []);
+    const closed = new Promise((r) => {
+      db.close(r);
+    });
+    t.throws(() => evm.createAccessList(stateRoot, header, tx, "0x00", () => []), /database is not open/, "should not read a closing db");
+    t.deepEqual((await beforeClose).accessList, created.accessList, "should create a list requested before close");
+    await closed;
+  });
+})
+
+test("should run many calls against one state", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    // deploy the contract
+    const { dump } = require("./dump.json");
+    for (let i = 0; i < 2; i++) {
+      const { blockHeader, tx } = dump[i];
+      stateRoot = evm.runTx(toBuffer(stateRoot), toBuffer(blockHeader.raw), toBuffer(tx.raw), "0x00", () => []).stateRoot;
+    }
+
+    // hash() and transfers that would fail on a nonce left over by a previous call
+    const header = toBuffer(dump[1].blockHeader.raw);
+    const hash = { gas: 100000, data: toBuffer("0x09bd5a60"), to: "0x5FbDB2315678afecb367f032d93F642f64180aa3" };
+    const transfer = { from: accounts[1], to: accounts[2], value: "0x3635c9adc5dea00000" };
+    const calls = [];
+    for (let i = 0; i < 64; i++) {
+      calls.push(i % 2 === 0 ? hash : transfer);
+    }
+    calls.push({ ...transfer, nonce: 5 });
+    const expected = evm.runCall(toBuffer(stateRoot), header, hash, "0x00", () => []);
+
+    for (const threads of [undefined, 4, 0]) {
+      let loads = 0;
+      const results = unpackCallResults(await evm.runCalls(toBuffer(stateRoot), header, calls, "0x00", () => (loads++, []), threads));
+      t.equal(results.length, calls.length, "should return a result per call");
+      t.equal(loads, 1, "should load the block hashes once");
+      for (let i = 0; i < 64; i++) {
+        if (results[i].excepted !== undefined || (i % 2 === 0 && results[i].output !== expected)) {
+          t.fail("call " + i + " should see the unchanged state");
+          break;
+        }
+      }
+      t.equal(results[0].output, expected, "should return the output of runCall");
+      t.ok(BigInt(results[0].gasUsed) > 21000n, "should return the gas used");
+      t.equal(results[64].excepted.error, "invalid nonce", "should report an invalid call alone");
+    }
+
+    t.equal(evm.runCall(toBuffer(stateRoot), header, hash, "0x00", () => []), expected, "should not change the state");
+  });
+})
+
+test("should reuse the transaction arena", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    const transfer = (nonce) => {
+      const tx = { from: accounts[0], to: accounts[1 + (nonce % 8)], value: 1, nonce };
+      const { stateRoot: root, result } = evm.runTx(stateRoot, header, tx, "0x00", () => []);
+      stateRoot = root;
+      return result;
+    };
+
+    transfer(0);
+    const before = arenaStats();
+    for (let nonce = 1; nonce <= 32; nonce++) {
+      if (transfer(nonce).excepted !== undefined) {
+        t.fail("transfer " + nonce + " should succeed");
+      }
+    }
+    const after = arenaStats();
+    t.ok(after.allocations > before.allocations, "should allocate the warmed addresses from the arena");
+    t.ok(after.resets >= before.resets + 32, "should reset the arena after every transaction");
+    t.equal(after.chunkAllocations, before.chunkAllocations, "should reuse the memory of the arena");
+
+    // calls discard their changes instead of committing them
+    const calls = new Array(16).fill({ to: accounts[1] });
+    const beforeCalls = arenaStats();
+    await evm.runCalls(stateRoot, header, calls, "0x00", () => []);
+    t.ok(arenaStats().resets >= beforeCalls.resets + 16, "should reset the arena after every call");
+  });
+})
+
+test("should share contract code between transactions", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    // returns its own code size and the code size of the address in calldata
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    const runtime = "38600052600035" + "3b" + "60205260406000f3";
+    const length = (runtime.length / 2).toString(16).padStart(2, "0");
+    const deployTx = { from: accounts[0], data: toBuffer("60" + length + "600c600039" + "60" + length + "6000f3" + runtime) };
+    const deployed = evm.runTx(stateRoot, header, deployTx, "0x00", () => []);
+    stateRoot = deployed.stateRoot;
+    const contract = deployed.result.newAddress;
+
+    const call = () => evm.runCall(stateRoot, header, { to: contract, data: toBuffer(contract.substr(2).padStart(64, "0")) }, "0x00", () => []);
+    const size = (runtime.length / 2).toString(16).padStart(64, "0");
+    const expected = "0x" + size + size;
+
+    const before = codeCacheStats();
+    t.equal(call(), expected, "should read the code sizes");
+    const first = codeCacheStats();
+    t.ok(first.hits > before.hits, "should find the deployed code in the cache");
+    t.equal(first.misses, before.misses, "should not load the deployed code");
+    t.equal(call(), expected, "should read the code sizes again");
+    t.ok(codeCacheStats().hits > first.hits, "should share the code with the next call");
+
+    setCodeCacheSize(0);
+    const disabled = codeCacheStats();
+    t.equal(disabled.capacity, 0, "should disable the cache");
+    t.equal(disabled.entries, 0, "should drop cached code");
+    t.equal(call(), expected, "should load the code without the cache");
+    t.equal(codeCacheStats().entries, 0, "should not cache while disabled");
+    setCodeCacheSize(64 * 1024 * 1024);
+  });
+})
+
+test("should abort calls over budget", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    const deploy = (runtime, nonce) => {
+      const length = (runtime.length / 2).toString(16).padStart(2, "0");
+      const deployTx = { from: accounts[0], nonce, data: toBuffer("60" + length + "600c600039" + "60" + length + "6000f3" + runtime) };
+      const deployed = evm.runTx(stateRoot, header, deployTx, "0x00", () => []);
+      stateRoot = deployed.stateRoot;
+      return deployed.result.newAddress;
+    };
+    // loops forever: JUMPDEST PUSH1 0 JUMP
+    const contract = deploy("5b600056", 0);
+    // calls the loop with all its gas, then stops
+    const caller = deploy("6000600060006000600073" + contract.substr(2) + "5af15000", 1);
+
+    const transfer = () => evm.runTx(stateRoot, header, { from: accounts[0], to: accounts[1], value: "0x01", nonce: 2 }, "0x00", () => []).stateRoot;
+    const expected = transfer();
+
+    const loop = { to: contract, gas: "0xffffffffff" };
+    const budget = { steps: 100000 };
+    t.throws(() => evm.runCall(stateRoot, header, loop, "0x00", () => [], undefined, budget), /Execution budget exceeded/, "should stop after the instruction budget");
+    t.throws(() => evm.runCall(stateRoot, header, loop, "0x00", () => [], undefined, { timeout: 50 }), /Execution budget exceeded/, "should stop after the time budget");
+    t.throws(() => evm.runCall(stateRoot, header, { to: caller, gas: "0xffffffffff" }, "0x00", () => [], undefined, budget), /Execution budget exceeded/, "should abort the caller of a nested frame over budget");
+
+    // runs out of gas after about 20000 instructions, only counted instructions stop it earlier
+    const bounded = { to: contract, gas: 100000 };
+    t.equal(evm.runCall(stateRoot, header, bounded, "0x00", () => [], undefined, { steps: 50000 }), "0x", "should run out of gas within the instruction budget");
+    t.throws(() => evm.runCall(stateRoot, header, bounded, "0x00", () => [], undefined, { steps: 1000 }), /Execution budget exceeded/, "should count every instruction");
+
+    const results = unpackCallResults(await evm.runCalls(stateRoot, header, [loop, { to: accounts[1] }], "0x00", () => [], 1, undefined, budget));
+    t.equal(results[0].excepted.error, "execution budget exceeded", "should report the calls over budget");
+    t.equal(results[1].excepted, undefined, "should run the other calls");
+    await evm.createAccessList(stateRoot, header, loop, "0x00", () => [], undefined, budget).then(
+      () => t.fail("should reject an access list over budget"),
+      (err) => t.ok(/Execution budget exceeded/.test(err.message), "should reject an access list over budget")
+    );
+    t.throws(() => evm.traceCall(stateRoot, header, loop, "0x00", () => [], { tracer: "callTracer" }, () => {}, undefined, budget), /Execution budget exceeded/, "should stop a trace over budget");
+    let chunks = 0;
+    const consume = () => {
+      chunks++;
+      throw new Error("consumer failed");
+    };
+    t.throws(() => evm.traceCall(stateRoot, header, { to: contract, gas: 1000000 }, "0x00", () => [], { chunkSize: 1 }, consume), /consumer failed/, "should rethrow the error of onChunk");
+    t.equal(chunks, 1, "should abort the trace once onChunk throws");
+
+    evm.setCallBudget(budget);
+    t.throws(() => evm.runCall(stateRoot, header, loop, "0x00", () => []), /Execution budget exceeded/, "should apply the default budget");
+    t.equal(unpackCallResults(await evm.runCalls(stateRoot, header, [loop], "0x00", () => []))[0].excepted.error, "execution budget exceeded", "should apply the default budget to many calls");
+    t.equal(evm.runCall(stateRoot, header, { to: accounts[1] }, "0x00", () => []), "0x", "should run calls within the budget");
+    evm.setCallBudget({});
+
+    t.equal(transfer(), expected, "should leave the state unchanged");
+  });
+})
+
+test("should execute against a recorded witness", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    // stores the first calldata word in slot 0
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    const runtime = "600035600055";
+    const length = (runtime.length / 2).toString(16).padStart(2, "0");
+    const deployTx = { from: accounts[0], data: toBuffer("60" + length + "600c600039" + "60" + length + "6000f3" + runtime) };
+    const deployed = evm.runTx(stateRoot, header, deployTx, "0x00", () => []);
+    stateRoot = deployed.stateRoot;
+    const contract = deployed.result.newAddress;
+
+    const txs = [
+      { from: accounts[0], to: accounts[1], value: "0x01", nonce: 1 },
+      { from: accounts[0], to: contract, data: toBuffer("2a".padStart(64, "0")), nonce: 2 }
+    ];
+    evm.startWitness();
+    const first = evm.runTx(stateRoot, header, txs[0], "0x00", () => []);
+    const second = evm.runTx(first.stateRoot, header, txs[1], first.receipt.cumulativeGasUsed, () => []);
+    const witness = evm.stopWitness();
+    t.ok(witness.length > 0, "should record the nodes read");
+
+    const results = evm.runTxsStateless(witness, stateRoot, header, txs, "0x00", () => []);
+    t.equal(results.length, 2, "should execute every transaction");
+    t.equal(results[0].stateRoot, first.stateRoot, "should reach the same state after the transfer");
+    t.equal(results[1].stateRoot, second.stateRoot, "should reach the same state after the call");
+    t.equal(results[1].receipt.cumulativeGasUsed, second.receipt.cumulativeGasUsed, "should use the same gas");
+
+    t.throws(() => evm.runTxsStateless(toBuffer("0xc0"), stateRoot, header, txs, "0x00", () => []), /MissingWitnessNode/, "should fail without the nodes");
+
+    // stores 1 in slot 0, then reads slot 0 and loops forever
+    const looping = "600054505b600456";
+    const loopingLength = (looping.length / 2).toString(16).padStart(2, "0");
+    const deployLooping = { from: accounts[0], nonce: 1, data: toBuffer("6001600055" + "60" + loopingLength + "6011600039" + "60" + loopingLength + "6000f3" + looping) };
+    const deployedLooping = evm.runTx(stateRoot, header, deployLooping, "0x00", () => []);
+    // out of gas before the first instruction, the storage is not read
+    evm.startWitness();
+    evm.runTx(deployedLooping.stateRoot, header, { from: accounts[0], to: deployedLooping.result.newAddress, gas: 21000, nonce: 2 }, "0x00", () => []);
+    const withoutStorage = evm.stopWitness();
+    const endless = { from: accounts[0], to: deployedLooping.result.newAddress, gas: "0xffffffffff", nonce: 2 };
+    t.throws(() => evm.runTxsStateless(withoutStorage, deployedLooping.stateRoot, header, [endless], "0x00", () => []), /MissingWitnessNode/, "should stop at the first missing node");
+    t.equal(evm.stopWitness().toString("hex"), "c0", "should return an empty witness when not recording");
+  });
+})
+
+// the byte strings of an RLP list
+function rlpItems(list) {
+  const header = (buf, offset, short, long) => {
+    const prefix = buf[offset];
+    if (prefix < long) {
+      return [offset + 1, prefix - short];
+    }
+    const bytes = prefix - long + 1;
+    return [offset + 1 + bytes, buf.readUIntBE(offset + 1, bytes)];
+  };
+  const items = [];
+  for (let [offset] = header(list, 0, 0xc0, 0xf8); offset < list.length; ) {
+    if (list[offset] < 0x80) {
+      items.push(list.slice(offset, ++offset));
+      continue;
+    }
+    const [start, length] = header(list, offset, 0x80, 0xb8);
+    items.push(list.slice(start, start + length));
+    offset = start + length;
+  }
+  return items;
+}
+
+// an RLP list of byte strings
+function rlpList(items) {
+  const header = (length, short, long) => {
+    if (length < 56) {
+      return Buffer.from([short + length]);
+    }
+    const hex = length.toString(16);
+    const bytes = Buffer.from(hex.length % 2 ? "0" + hex : hex, "hex");
+    return Buffer.concat([Buffer.from([long + bytes.length - 1]), bytes]);
+  };
+  const payload = Buffer.concat(items.map((item) => (item.length === 1 && item[0] < 0x80 ? item : Buffer.concat([header(item.length, 0x80, 0xb8), item]))));
+  return Buffer.concat([header(payload.length, 0xc0, 0xf8), payload]);
+}
+
+test("should not cache code missing from a witness", async function(t) {
+  await withEvm(t, async (evm, db, stateRoot) => {
+    // returns 42
+    const header = { number: 1, gasLimit: "0xffffffffffff" };
+    const runtime = "602a60005260206000f3";
+    const length = (runtime.length / 2).toString(16).padStart(2, "0");
+    const deployTx = { from: accounts[0], data: toBuffer("60" + length + "600c600039" + "60" + length + "6000f3" + runtime) };
+    const deployed = evm.runTx(stateRoot, header, deployTx, "0x00", () => []);
+    stateRoot = deployed.stateRoot;
+    const contract = deployed.result.newAddress;
+
+    // the code must be loaded from the witness, not from the cache
+    const clearCodeCache = () => {
+      setCodeCacheSize(0);
+      setCodeCacheSize(64 * 1024 * 1024);
+    };
+    const tx = { from: accounts[0], to: contract, nonce: 1 };
+    clearCodeCache();
+    evm.startWitness();
+    evm.runTx(stateRoot, header, tx, "0x00", () => []);
+    const witness = rlpItems(evm.stopWitness());
+    const withoutCode = rlpList(witness.filter((value) => value.toString("hex") !== runtime));
+    t.equal(witness.length - 1, rlpItems(withoutCode).length, "should drop the code from the witness");
+
+    clearCodeCache();
+    t.throws(() => evm.runTxsStateless(withoutCode, stateRoot, header, [tx], "0x00", () => []), /MissingWitnessNode/, "should fail without the code");
+    const expected = "0x" + "2a".padStart(64, "0");
+    t.equal(evm.runCall(stateRoot, header, { to: contract }, "0x00", () => []), expected, "should run the code after the miss");
+  });
+})
+
+test("should keep the row cache in sync with writes through the exposed db", async function(t) {
+  await withEvm(t, async (evm, db, genesisRoot) => {
+    const get = (key) =>
+      new Promise((r, j) => {
+        db.get(key, (err, value) => {
+          err ? j(err) : r(value);
+        });
+      });
+    const stateRoot = toBuffer(genesisRoot);
+    const node = await get(stateRoot);
+
+    // cache a stale row for the root node
+    await new Promise((r, j) => {
+      db.put(stateRoot, "stale", (err) => {
+        err ? j(err) : r();
+      });
+    });
+    t.equal((await get(stateRoot)).toString(), "stale");
+    t.equal(db.getCached(stateRoot, t.fail.bind(t)).toString(), "stale", "should have cached the row");
+
+    // write the node back through the exposed db
+    t.equal((await evm.importTrieNodes([node])).imported, 1);
+    const value = await new Promise((r, j) => {
+      const cached = db.getCached(stateRoot, (err, value) => {
+        err ? j(err) : r(value);
+      });
+      if (cached !== undefined) {
+        r(cached);
+      }
+    });
+    t.ok(value.equals(node), "should not return the stale row");
+  }, { open: { rowCacheSize: 1024 * 1024 } });
+})
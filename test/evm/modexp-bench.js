@@ -0,0 +1,91 @@
+// Measures the modexp precompile on inputs shaped like the EIP-2565 "nagydani" vectors:
+// base and modulus of 64 to 1024 bytes with the exponents 2, 3 and 0x10001.
+// Every call goes through runCall, so the numbers include the cost of a call.
+//
+// Usage: node test/evm/modexp-bench.js [rounds]
+
+const crypto = require("crypto");
+const testCommon = require("../leveldown/common");
+const { JSEVMBinding, init } = require("../../dist");
+
+const ROUNDS = Number(process.argv[2]) || 50;
+
+const modexpAddress = "0x0000000000000000000000000000000000000005";
+const header = { number: 1, gasLimit: "0xffffffffffff" };
+
+function word(n) {
+  const buf = Buffer.alloc(32);
+  buf.writeUInt32BE(n, 28);
+  return buf;
+}
+
+function bytes(seed, length) {
+  const chunks = [];
+  for (let i = 0; chunks.length * 32 < length; i++) {
+    chunks.push(crypto.createHash("sha256").update(seed + ":" + i).digest());
+  }
+  return Buffer.concat(chunks).subarray(0, length);
+}
+
+// EIP-2565 price of the precompile, exponents are at most 32 bytes here.
+function price(length, exp) {
+  const words = BigInt(Math.ceil(length / 8));
+  const e = BigInt("0x" + exp.toString("hex"));
+  const bits = e > 0n ? BigInt(e.toString(2).length - 1) : 0n;
+  const gas = (words * words * (bits > 0n ? bits : 1n)) / 3n;
+  return gas < 200n ? 200n : gas;
+}
+
+const vectors = [];
+[1, 2, 3, 4, 5].forEach((n) => {
+  const length = 32 << n;
+  [
+    ["square", Buffer.from([2])],
+    ["qube", Buffer.from([3])],
+    ["pow0x10001", Buffer.from([1, 0, 1])],
+  ].forEach(([name, exp]) => {
+    const base = bytes("base" + n, length);
+    const mod = bytes("mod" + n, length);
+    mod[0] |= 0x80;
+    mod[length - 1] |= 1;
+    vectors.push({
+      name: `nagydani-${n}-${name}`,
+      gas: price(length, exp),
+      data: Buffer.concat([word(base.length), word(exp.length), word(mod.length), base, exp, mod]),
+    });
+  });
+});
+
+(async function () {
+  const db = testCommon.factory();
+  await new Promise((r, j) => db.open((err) => (err ? j(err) : r())));
+
+  try {
+    init();
+    const evm = new JSEVMBinding(db.exposed, 23579);
+    const stateRoot = evm.genesis([modexpAddress], ["0x00"]);
+
+    console.log("rounds: " + ROUNDS);
+    for (const { name, gas, data } of vectors) {
+      const tx = { gas: "0xffffffffff", data, to: modexpAddress };
+      evm.runCall(stateRoot, header, tx, "0x00", () => []);
+
+      const start = process.hrtime.bigint();
+      for (let i = 0; i < ROUNDS; i++) {
+        evm.runCall(stateRoot, header, tx, "0x00", () => []);
+      }
+      const us = Number(process.hrtime.bigint() - start) / 1e3 / ROUNDS;
+      console.log(
+        name.padEnd(24),
+        us.toFixed(1).padStart(10),
+        "us/call,",
+        gas.toString().padStart(7),
+        "gas,",
+        (Number(gas) / us).toFixed(1).padStart(7),
+        "Mgas/s"
+      );
+    }
+  } finally {
+    await new Promise((r) => db.close(r));
+  }
+})();
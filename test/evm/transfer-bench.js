@@ -0,0 +1,71 @@
+// Measures simple transfers and token-like transfers executed with runTx and counts the
+// allocations of the per transaction arenas. A token transfer reads and writes two storage
+// slots, like an ERC-20 transfer without the checks.
+//
+// Usage: node test/evm/transfer-bench.js [rounds]
+
+const testCommon = require("../leveldown/common");
+const { JSEVMBinding, init, arenaStats } = require("../../dist");
+
+const ROUNDS = Number(process.argv[2]) || 2000;
+
+const sender = "0xf39Fd6e51aad88F6F4ce6aB8827279cffFb92266";
+const header = { number: 1, gasLimit: "0xffffffffffff" };
+
+// balance[caller] -= 1; balance[calldata[0]] += 1
+const tokenRuntime = "33546001900333556000358054600101905500";
+
+function recipient(i) {
+  return "0x" + (i + 1).toString(16).padStart(40, "0");
+}
+
+(async function () {
+  const db = testCommon.factory();
+  await new Promise((r, j) => db.open((err) => (err ? j(err) : r())));
+
+  try {
+    init();
+    const evm = new JSEVMBinding(db.exposed, 23579);
+    let stateRoot = evm.genesis([sender], ["0x21e19e0c9bab2400000"]);
+    let nonce = 0;
+    const run = (tx) => {
+      const { stateRoot: root, result } = evm.runTx(stateRoot, header, { from: sender, nonce: nonce++, ...tx }, "0x00", () => []);
+      stateRoot = root;
+      return result;
+    };
+
+    const length = (tokenRuntime.length / 2).toString(16).padStart(2, "0");
+    const token = run({ data: Buffer.from("60" + length + "600c600039" + "60" + length + "6000f3" + tokenRuntime, "hex") }).newAddress;
+
+    const kinds = [
+      ["transfer", (i) => ({ to: recipient(i % 256), value: 1 })],
+      ["token transfer", (i) => ({ to: token, data: Buffer.from(recipient(i % 256).substr(2).padStart(64, "0"), "hex") })],
+    ];
+
+    console.log("rounds: " + ROUNDS);
+    for (const [name, makeTx] of kinds) {
+      for (let i = 0; i < 16; i++) {
+        run(makeTx(i));
+      }
+
+      const before = arenaStats();
+      const start = process.hrtime.bigint();
+      for (let i = 0; i < ROUNDS; i++) {
+        run(makeTx(i));
+      }
+      const us = Number(process.hrtime.bigint() - start) / 1e3 / ROUNDS;
+      const after = arenaStats();
+      console.log(
+        name.padEnd(16),
+        us.toFixed(1).padStart(8),
+        "us/tx,",
+        ((after.allocations - before.allocations) / ROUNDS).toFixed(1).padStart(6),
+        "arena allocations/tx,",
+        ((after.chunkAllocations - before.chunkAllocations) / ROUNDS).toFixed(3).padStart(7),
+        "heap chunks/tx"
+      );
+    }
+  } finally {
+    await new Promise((r) => db.close(r));
+  }
+})();
@@ -0,0 +1,74 @@
+// Compares writing a batch through batch() with writing the same operations
+// encoded once with LevelDOWN.encodeBatch() through batchPacked().
+//
+// Usage: node test/leveldown/batch-packed-bench.js [operations] [rounds]
+
+const testCommon = require('./common')
+const leveldown = require('../../dist/leveldown')
+const crypto = require('crypto')
+
+const OPERATIONS = Number(process.argv[2]) || 20000
+const ROUNDS = Number(process.argv[3]) || 20
+
+function makeOperations (round) {
+  const operations = []
+  for (let i = 0; i < OPERATIONS; i++) {
+    const key = crypto.createHash('sha256').update(round + ':' + i).digest()
+    if (i % 10 === 9) {
+      operations.push({ type: 'del', key: key })
+    } else {
+      operations.push({ type: 'put', key: key, value: crypto.randomBytes(100) })
+    }
+  }
+  return operations
+}
+
+function measure (name, rounds, write, callback) {
+  let round = 0
+  let mainThreadNs = 0n
+  const start = process.hrtime.bigint()
+
+  const next = function (err) {
+    if (err) return callback(err)
+    if (round === rounds.length) {
+      const ms = Number(process.hrtime.bigint() - start) / 1e6
+      console.log(name.padEnd(22), Math.round(OPERATIONS * rounds.length / ms * 1000).toString().padStart(9), 'ops/s,',
+        (Number(mainThreadNs) / 1e6 / rounds.length).toFixed(2), 'ms on the main thread per batch')
+      return callback()
+    }
+
+    const callStart = process.hrtime.bigint()
+    write(rounds[round++], next)
+    mainThreadNs += process.hrtime.bigint() - callStart
+  }
+  next()
+}
+
+const db = testCommon.factory()
+
+db.open(function (err) {
+  if (err) throw err
+
+  const rounds = []
+  for (let i = 0; i < ROUNDS; i++) rounds.push(makeOperations(i))
+  const encoded = rounds.map(leveldown.encodeBatch)
+
+  console.log('operations: ' + OPERATIONS + ', rounds: ' + ROUNDS)
+
+  measure('batch', rounds, function (operations, callback) {
+    db.batch(operations, callback)
+  }, function (err) {
+    if (err) throw err
+    measure('encodeBatch+packed', rounds, function (operations, callback) {
+      db.batchPacked(leveldown.encodeBatch(operations), callback)
+    }, function (err) {
+      if (err) throw err
+      measure('batchPacked', encoded, function (buffer, callback) {
+        db.batchPacked(buffer, callback)
+      }, function (err) {
+        if (err) throw err
+        db.close(function () {})
+      })
+    })
+  })
+})
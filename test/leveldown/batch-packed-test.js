@@ -0,0 +1,69 @@
+const test = require('tape')
+const concat = require('level-concat-iterator')
+const testCommon = require('./common')
+const leveldown = require('../../dist/leveldown')
+
+test('batchPacked()', function (t) {
+  const db = testCommon.factory()
+
+  t.test('setup', function (t) {
+    db.open(function (err) {
+      t.ifError(err, 'no open error')
+      db.put('c', 'old', t.end.bind(t))
+    })
+  })
+
+  t.test('writes puts and dels', function (t) {
+    const buffer = leveldown.encodeBatch([
+      { type: 'put', key: 'a', value: Buffer.alloc(300, 'a') },
+      { type: 'put', key: Buffer.from('b'), value: '' },
+      { type: 'del', key: 'c' }
+    ])
+
+    db.batchPacked(buffer, function (err) {
+      t.ifError(err, 'no batchPacked error')
+      concat(db.iterator(), function (err, entries) {
+        t.ifError(err, 'no concat error')
+        t.same(entries, [
+          { key: Buffer.from('a'), value: Buffer.alloc(300, 'a') },
+          { key: Buffer.from('b'), value: Buffer.alloc(0) }
+        ])
+        t.end()
+      })
+    })
+  })
+
+  t.test('empty batch', function (t) {
+    db.batchPacked(Buffer.alloc(0), { sync: true }, function (err) {
+      t.ifError(err, 'no batchPacked error')
+      t.end()
+    })
+  })
+
+  t.test('rejects malformed batch without writing', function (t) {
+    const buffer = Buffer.concat([
+      leveldown.encodeBatch([{ type: 'put', key: 'd', value: 'd' }]),
+      Buffer.from([1, 10, 0x64])
+    ])
+
+    db.batchPacked(buffer, function (err) {
+      t.ok(err, 'got error')
+      t.ok(/malformed packed batch/.test(err.message), 'malformed')
+      db.get('d', function (err) {
+        t.ok(err && err.notFound, 'nothing written')
+        t.end()
+      })
+    })
+  })
+
+  t.test('requires a buffer', function (t) {
+    t.throws(function () { db.batchPacked([], function () {}) }, /requires a buffer argument/)
+    t.end()
+  })
+
+  t.test('teardown', function (t) {
+    db.close(t.end.bind(t))
+  })
+
+  t.end()
+})
@@ -0,0 +1,88 @@
+const test = require('tape')
+const concat = require('level-concat-iterator')
+const testCommon = require('./common')
+const leveldown = require('../../dist/leveldown')
+
+;[{ coalesceWindow: 0 }, { coalesceWindow: 2000 }, { coalesceWindow: 2000, coalesceBytes: 64 }].forEach(function (options) {
+  test('coalesced writes with ' + JSON.stringify(options), function (t) {
+    const db = testCommon.factory()
+
+    t.test('setup', function (t) {
+      db.open(Object.assign({ coalesceWrites: true }, options), function (err) {
+        t.ifError(err, 'no open error')
+        t.end()
+      })
+    })
+
+    t.test('every op is called back and written in order', function (t) {
+      const count = 100
+      let pending = 0
+      const called = []
+
+      const done = function (i) {
+        return function (err) {
+          t.ifError(err, 'no error')
+          called.push(i)
+          if (--pending === 0) verify()
+        }
+      }
+
+      for (let i = 0; i < count; i++) {
+        pending++
+        db.put(String(i).padStart(3, '0'), String(i), { sync: i % 10 === 0 }, done(i))
+      }
+      for (let i = 0; i < count; i += 2) {
+        pending++
+        db.del(String(i).padStart(3, '0'), done(count + i))
+      }
+
+      function verify () {
+        t.is(called.length, count + count / 2, 'all callbacks called')
+        concat(db.iterator({ keyAsBuffer: false, valueAsBuffer: false }), function (err, entries) {
+          t.ifError(err, 'no concat error')
+          t.same(entries.map(function (e) { return e.value }),
+            Array.from({ length: count / 2 }, function (_, i) { return String(i * 2 + 1) }))
+          t.end()
+        })
+      }
+    })
+
+    t.test('batches keep their place among puts and dels', function (t) {
+      let pending = 6
+      const done = function (err) {
+        t.ifError(err, 'no error')
+        if (--pending === 0) verify()
+      }
+
+      db.put('order', 'put', done)
+      db.batch([{ type: 'put', key: 'order', value: 'batch' }], done)
+      db.batchPacked(leveldown.encodeBatch([{ type: 'put', key: 'order', value: 'packed' }]), done)
+      db.batch().put('order', 'chained').write(done)
+      db.del('order', done)
+      db.batch([{ type: 'put', key: 'order', value: 'last' }], done)
+
+      function verify () {
+        db.get('order', { asBuffer: false }, function (err, value) {
+          t.ifError(err, 'no get error')
+          t.is(value, 'last', 'writes applied in order')
+          t.end()
+        })
+      }
+    })
+
+    t.test('close waits for queued writes', function (t) {
+      let written = false
+      db.put('last', 'value', function (err) {
+        t.ifError(err, 'no put error')
+        written = true
+      })
+      db.close(function (err) {
+        t.ifError(err, 'no close error')
+        t.ok(written, 'put was written before close')
+        t.end()
+      })
+    })
+
+    t.end()
+  })
+})
@@ -0,0 +1,70 @@
+const make = require('./make')
+
+make('metrics()', function (db, t, done) {
+  const before = db.metrics()
+
+  db.put('foo', 'bar', function (err) {
+    t.ifError(err, 'no put error')
+
+    db.get('foo', function (err) {
+      t.ifError(err, 'no get error')
+
+      const it = db.iterator()
+      it.next(function (err) {
+        t.ifError(err, 'no next error')
+
+        it.end(function (err) {
+          t.ifError(err, 'no end error')
+
+          const metrics = db.metrics()
+          ;['get', 'getMany', 'put', 'del', 'batch', 'iteratorNext'].forEach(function (op) {
+            const latency = metrics.latency[op]
+            t.ok(latency.p50 <= latency.p99 && latency.p99 <= latency.max, op + ' quantiles are ordered')
+          })
+
+          t.is(metrics.latency.put.count, before.latency.put.count + 1, 'put is counted')
+          t.is(metrics.latency.get.count, before.latency.get.count + 1, 'get is counted')
+          t.ok(metrics.latency.iteratorNext.count > before.latency.iteratorNext.count, 'next is counted')
+          t.is(metrics.bytesWritten, before.bytesWritten + 6, 'key and value bytes written')
+          t.ok(metrics.bytesRead >= before.bytesRead + 3, 'value bytes read')
+          t.is(typeof metrics.blockCacheHitRatio, 'number')
+          t.is(typeof metrics.slowWrites, 'number')
+          t.ok(metrics.memoryUsage > 0)
+          t.ok(Array.isArray(metrics.levels))
+          t.is(typeof metrics.level0Files, 'number')
+          done()
+        })
+      })
+    })
+  })
+})
+
+make('metrics() counts getMany once', function (db, t, done) {
+  db.put('foo', 'bar', function (err) {
+    t.ifError(err, 'no put error')
+
+    const before = db.metrics()
+    db.getMany(['foo', 'foo', 'missing'], function (err) {
+      t.ifError(err, 'no getMany error')
+
+      const metrics = db.metrics()
+      t.is(metrics.latency.getMany.count, before.latency.getMany.count + 1, 'getMany is counted')
+      t.is(metrics.latency.get.count, before.latency.get.count, 'keys are not counted as gets')
+      t.is(metrics.bytesRead, before.bytesRead + 6, 'value bytes read')
+      done()
+    })
+  })
+})
+
+make('metrics() parses leveldb.stats', function (db, t, done) {
+  db.compactRange('a', 'z', function (err) {
+    t.ifError(err, 'no compactRange error')
+
+    const levels = db.metrics().levels
+    t.ok(levels.length > 0, 'has compacted levels')
+    levels.forEach(function (level) {
+      t.same(Object.keys(level), ['level', 'files', 'sizeMB', 'timeSec', 'readMB', 'writeMB'])
+    })
+    done()
+  })
+})
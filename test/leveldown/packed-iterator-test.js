@@ -0,0 +1,82 @@
+const concat = require('level-concat-iterator')
+const make = require('./make')
+
+make('packed iterator yields the same entries', function (db, t, done) {
+  concat(db.iterator({ keyAsBuffer: false, valueAsBuffer: false }), function (err, expected) {
+    t.ifError(err, 'no concat error')
+    concat(db.iterator({ packed: true, keyAsBuffer: false, valueAsBuffer: false }), function (err, entries) {
+      t.ifError(err, 'no concat error')
+      t.same(entries, expected)
+      done()
+    })
+  })
+})
+
+make('packed iterator nextBatch()', function (db, t, done) {
+  const it = db.iterator({ packed: true })
+
+  it.next(function (err, key, value) {
+    t.ifError(err, 'no next() error')
+    t.same(key, Buffer.from('one'), 'first entry is read alone')
+
+    it.nextBatch(function (err, batch) {
+      t.ifError(err, 'no nextBatch() error')
+      t.is(batch.length, 2)
+      t.same(batch.key(0), Buffer.from('three'))
+      t.same(batch.value(0), Buffer.from('3'))
+      t.same(batch.key(1), Buffer.from('two'))
+      t.same(batch.value(1), Buffer.from('2'))
+      t.is(batch.key(1).buffer, batch.key(0).buffer, 'entries share one buffer')
+      t.throws(function () { batch.key(2) }, /index out of range/)
+
+      it.nextBatch(function (err, batch) {
+        t.ifError(err, 'no nextBatch() error')
+        t.is(batch, undefined, 'exhausted')
+        it.end(done)
+      })
+    })
+  })
+})
+
+make('packed iterator is bounded by highWaterMark', function (db, t, done) {
+  const it = db.iterator({ packed: true, highWaterMark: 1 })
+  const sizes = []
+
+  it.nextBatch(function loop (err, batch) {
+    t.ifError(err, 'no nextBatch() error')
+    if (batch === undefined) {
+      t.same(sizes, [1, 1, 1])
+      return it.end(done)
+    }
+    sizes.push(batch.length)
+    it.nextBatch(loop)
+  })
+})
+
+make('packed key-only and value-only iterators', function (db, t, done) {
+  const keys = db.iterator({ packed: true, values: false, keyAsBuffer: false, valueAsBuffer: false })
+
+  keys.nextBatch(function (err, batch) {
+    t.ifError(err, 'no nextBatch() error')
+    t.is(batch.key(0), 'one')
+    t.is(batch.value(0), '')
+
+    const values = db.iterator({ packed: true, keys: false, keyAsBuffer: false, valueAsBuffer: false })
+    values.nextBatch(function (err, batch) {
+      t.ifError(err, 'no nextBatch() error')
+      t.is(batch.key(0), '')
+      t.is(batch.value(0), '1')
+
+      keys.end(function (err) {
+        t.ifError(err, 'no end() error')
+        values.end(done)
+      })
+    })
+  })
+})
+
+make('nextBatch() requires the packed option', function (db, t, done) {
+  const it = db.iterator()
+  t.throws(function () { it.nextBatch(function () {}) }, /requires the packed option/)
+  it.end(done)
+})
@@ -0,0 +1,108 @@
+const test = require('tape')
+const testCommon = require('./common')
+
+test('row cache', function (t) {
+  const db = testCommon.factory()
+
+  t.test('setup', function (t) {
+    db.open({ rowCacheSize: 1024 * 1024 }, function (err) {
+      t.ifError(err, 'no open error')
+      db.put('foo', 'bar', t.end.bind(t))
+    })
+  })
+
+  t.test('miss falls back to an async get', function (t) {
+    const value = db.getCached('foo', function (err, value) {
+      t.ifError(err, 'no get error')
+      t.same(value, Buffer.from('bar'))
+      t.end()
+    })
+    t.is(value, undefined, 'nothing returned on a miss')
+  })
+
+  t.test('hit returns the value synchronously', function (t) {
+    t.same(db.getCached('foo', t.fail.bind(t, 'callback called on a hit')), Buffer.from('bar'))
+    t.is(db.getCached('foo', { asBuffer: false }, t.fail.bind(t)), 'bar')
+    t.end()
+  })
+
+  t.test('put invalidates', function (t) {
+    db.put('foo', 'baz', function (err) {
+      t.ifError(err, 'no put error')
+      const value = db.getCached('foo', { asBuffer: false }, function (err, value) {
+        t.ifError(err, 'no get error')
+        t.is(value, 'baz')
+        t.is(db.getCached('foo', { asBuffer: false }, t.fail.bind(t)), 'baz')
+        t.end()
+      })
+      t.is(value, undefined, 'stale value not returned')
+    })
+  })
+
+  t.test('batch invalidates', function (t) {
+    db.batch([{ type: 'put', key: 'foo', value: 'qux' }], function (err) {
+      t.ifError(err, 'no batch error')
+      db.get('foo', { asBuffer: false }, function (err, value) {
+        t.ifError(err, 'no get error')
+        t.is(value, 'qux')
+        t.is(db.getCached('foo', { asBuffer: false }, t.fail.bind(t)), 'qux')
+        t.end()
+      })
+    })
+  })
+
+  t.test('del invalidates', function (t) {
+    db.del('foo', function (err) {
+      t.ifError(err, 'no del error')
+      db.getCached('foo', function (err, value) {
+        t.ok(err && err.notFound, 'not found')
+        t.is(value, undefined)
+        t.end()
+      })
+    })
+  })
+
+  t.test('snapshot reads bypass the cache', function (t) {
+    db.put('snap', 'old', function (err) {
+      t.ifError(err, 'no put error')
+      const snapshot = db.snapshot()
+      db.put('snap', 'new', function (err) {
+        t.ifError(err, 'no put error')
+        db.get('snap', { asBuffer: false }, function (err, value) {
+          t.ifError(err, 'no get error')
+          t.is(value, 'new')
+          const result = db.getCached('snap', { asBuffer: false, snapshot: snapshot }, function (err, value) {
+            t.ifError(err, 'no get error')
+            t.is(value, 'old')
+            snapshot.release()
+            t.end()
+          })
+          t.is(result, undefined, 'snapshot read is async')
+        })
+      })
+    })
+  })
+
+  t.test('teardown', function (t) {
+    db.close(t.end.bind(t))
+  })
+
+  t.end()
+})
+
+test('getCached() without a row cache is always async', function (t) {
+  const db = testCommon.factory()
+
+  db.open(function (err) {
+    t.ifError(err, 'no open error')
+    db.put('foo', 'bar', function (err) {
+      t.ifError(err, 'no put error')
+      const value = db.getCached('foo', { asBuffer: false }, function (err, value) {
+        t.ifError(err, 'no get error')
+        t.is(value, 'bar')
+        t.is(db.getCached('foo', function () { db.close(t.end.bind(t)) }), undefined)
+      })
+      t.is(value, undefined)
+    })
+  })
+})
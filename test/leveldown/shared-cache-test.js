@@ -0,0 +1,84 @@
+const test = require('tape')
+const testCommon = require('./common')
+const leveldown = require('../../dist/leveldown')
+
+test('databases sharing a block cache', function (t) {
+  const cache = new leveldown.SharedCache(4 * 1024 * 1024)
+  const dbs = [testCommon.factory(), testCommon.factory()]
+
+  t.test('setup', function (t) {
+    t.plan(dbs.length * 4)
+
+    dbs.forEach(function (db, i) {
+      db.open({ sharedCache: cache }, function (err) {
+        t.ifError(err, 'no open error')
+        db.put('key', 'value' + i, function (err) {
+          t.ifError(err, 'no put error')
+          // Flush the memtable so reads go through the block cache
+          db.compactRange('a', 'z', function (err) {
+            t.ifError(err, 'no compactRange error')
+            t.ok(db.cacheStats().shared, 'uses the shared cache')
+          })
+        })
+      })
+    })
+  })
+
+  t.test('reads are counted per database', function (t) {
+    const db = dbs[0]
+
+    db.get('key', { asBuffer: false }, function (err, value) {
+      t.ifError(err, 'no get error')
+      t.is(value, 'value0')
+
+      db.get('key', { asBuffer: false }, function (err, value) {
+        t.ifError(err, 'no get error')
+        t.is(value, 'value0')
+
+        const stats = db.cacheStats()
+        t.ok(stats.hits >= 1, 'second read hits the cache')
+        t.ok(stats.misses >= 1, 'first read misses the cache')
+        t.is(stats.capacity, 4 * 1024 * 1024)
+        t.ok(stats.usage > 0)
+
+        t.is(dbs[1].cacheStats().usage, stats.usage, 'usage is shared')
+        t.same(cache.stats(), { usage: stats.usage, capacity: stats.capacity })
+        t.end()
+      })
+    })
+  })
+
+  t.test('teardown', function (t) {
+    t.plan(dbs.length)
+    dbs.forEach(function (db) {
+      db.close(function (err) {
+        t.ifError(err, 'no close error')
+      })
+    })
+  })
+
+  t.end()
+})
+
+test('database with a private block cache', function (t) {
+  const db = testCommon.factory()
+
+  db.open({ cacheSize: 1024 * 1024 }, function (err) {
+    t.ifError(err, 'no open error')
+
+    const stats = db.cacheStats()
+    t.is(stats.shared, false)
+    t.is(stats.capacity, 1024 * 1024)
+    t.is(stats.hits, 0)
+    db.close(t.end.bind(t))
+  })
+})
+
+test('invalid sharedCache option', function (t) {
+  const db = testCommon.factory()
+
+  db.open({ sharedCache: {} }, function (err) {
+    t.is(err && err.message, 'invalid shared cache')
+    t.end()
+  })
+})
@@ -0,0 +1,116 @@
+const test = require('tape')
+const concat = require('level-concat-iterator')
+const testCommon = require('./common')
+
+test('snapshot()', function (t) {
+  const db = testCommon.factory()
+  let snapshot
+
+  t.test('setup', function (t) {
+    db.open(function (err) {
+      t.ifError(err, 'no open error')
+      db.batch([
+        { type: 'put', key: 'a', value: '1' },
+        { type: 'put', key: 'b', value: '1' }
+      ], function (err) {
+        t.ifError(err, 'no batch error')
+        snapshot = db.snapshot()
+        db.batch([
+          { type: 'put', key: 'a', value: '2' },
+          { type: 'del', key: 'b' },
+          { type: 'put', key: 'c', value: '2' }
+        ], t.end.bind(t))
+      })
+    })
+  })
+
+  t.test('get', function (t) {
+    db.get('a', { snapshot: snapshot, asBuffer: false }, function (err, value) {
+      t.ifError(err, 'no get error')
+      t.is(value, '1', 'reads the snapshot')
+      db.get('a', { asBuffer: false }, function (err, value) {
+        t.ifError(err, 'no get error')
+        t.is(value, '2', 'reads the latest value without snapshot')
+        t.end()
+      })
+    })
+  })
+
+  t.test('getMany', function (t) {
+    db.getMany(['a', 'b', 'c'], { snapshot: snapshot, asBuffer: false }, function (err, values) {
+      t.ifError(err, 'no getMany error')
+      t.same(values, ['1', '1', undefined])
+      t.end()
+    })
+  })
+
+  t.test('iterator', function (t) {
+    const it = db.iterator({ snapshot: snapshot, keyAsBuffer: false, valueAsBuffer: false })
+    concat(it, function (err, entries) {
+      t.ifError(err, 'no concat error')
+      t.same(entries, [{ key: 'a', value: '1' }, { key: 'b', value: '1' }])
+      t.end()
+    })
+  })
+
+  t.test('release while an iterator uses it', function (t) {
+    const it = db.iterator({ snapshot: snapshot, keyAsBuffer: false, valueAsBuffer: false })
+    snapshot.release()
+    snapshot.release()
+
+    concat(it, function (err, entries) {
+      t.ifError(err, 'no concat error')
+      t.same(entries, [{ key: 'a', value: '1' }, { key: 'b', value: '1' }], 'iterator keeps reading the snapshot')
+      t.end()
+    })
+  })
+
+  t.test('released snapshot', function (t) {
+    t.throws(function () { db.iterator({ snapshot: snapshot }) }, /snapshot has been released/)
+    t.throws(function () { return snapshot.exposed }, /snapshot has been released/)
+
+    db.get('a', { snapshot: snapshot }, function (err) {
+      t.ok(err && /snapshot has been released/.test(err.message), 'get fails')
+      db.getMany(['a'], { snapshot: snapshot }, function (err) {
+        t.ok(err && /snapshot has been released/.test(err.message), 'getMany fails')
+        t.end()
+      })
+    })
+  })
+
+  t.test('snapshot of another database', function (t) {
+    const other = testCommon.factory()
+    other.open(function (err) {
+      t.ifError(err, 'no open error')
+      const foreign = other.snapshot()
+      db.get('a', { snapshot: foreign }, function (err) {
+        t.ok(err && /another database/.test(err.message), 'get fails')
+        foreign.release()
+        other.close(t.end.bind(t))
+      })
+    })
+  })
+
+  t.test('unexpose', function (t) {
+    const exposedSnapshot = db.snapshot()
+    t.ok(exposedSnapshot.exposed, 'exposes the snapshot')
+    t.is(exposedSnapshot.exposed, exposedSnapshot.exposed, 'exposes one handle')
+    exposedSnapshot.release()
+    exposedSnapshot.unexpose()
+    exposedSnapshot.unexpose()
+    t.throws(function () { return exposedSnapshot.exposed }, /snapshot has been released/)
+    t.end()
+  })
+
+  t.test('close releases open and exposed snapshots', function (t) {
+    db.snapshot()
+    const exposed = db.snapshot().exposed
+    t.ok(exposed, 'exposes the snapshot')
+    db.close(function (err) {
+      t.ifError(err, 'no close error')
+      t.end()
+    })
+  })
+
+  t.end()
+})
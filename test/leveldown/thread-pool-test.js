@@ -0,0 +1,48 @@
+'use strict'
+
+const test = require('tape')
+const fork = require('child_process').fork
+const path = require('path')
+const leveldown = require('../../dist/leveldown')
+
+test('thread pool stats are undefined before configure', function (t) {
+  t.is(leveldown.threadPoolStats(), undefined)
+  t.end()
+})
+
+test('work runs on the thread pool', function (t) {
+  const child = fork(path.join(__dirname, 'thread-pool.js'))
+  const messages = []
+
+  child.on('message', function (m) {
+    messages.push(m)
+    if (m.stats) child.disconnect()
+  })
+
+  child.on('exit', function (code, sig) {
+    t.is(code, 0, 'child exited normally')
+    t.is(sig, null, 'not terminated due to signal')
+
+    t.is(messages[0].reconfigure, 'thread pool is already configured')
+
+    const result = messages[1]
+    t.is(result.value, '42')
+    t.is(result.entries, 100)
+
+    const stats = result.stats
+    t.is(stats.size, 2)
+    t.is(stats.maxBackground, 1)
+    t.is(stats.maxWait, 50)
+    t.ok(stats.write.completed >= 2, 'open and batch ran as writes')
+    t.ok(stats.read.completed >= 1, 'get ran as a read')
+    t.ok(stats.background.completed >= 2, 'iterator and compactRange ran as background work')
+    ;['read', 'write', 'background'].forEach(function (name) {
+      t.is(stats[name].queued, 0, name + ' queue is empty')
+      t.is(typeof stats[name].avgWait, 'number')
+      t.is(typeof stats[name].aged, 'number')
+      t.ok(stats[name].maxWait >= stats[name].avgWait)
+    })
+
+    t.end()
+  })
+})
@@ -0,0 +1,47 @@
+'use strict'
+
+const concat = require('level-concat-iterator')
+const leveldown = require('../../dist/leveldown')
+const testCommon = require('./common')
+
+// Runs in a child process because the thread pool applies to the whole process.
+leveldown.configureThreadPool({ size: 2, maxBackground: 1, maxWait: 50 })
+
+try {
+  leveldown.configureThreadPool({ size: 2 })
+} catch (err) {
+  process.send({ reconfigure: err.message })
+}
+
+const db = testCommon.factory()
+
+db.open(function (err) {
+  if (err) throw err
+
+  const batch = db.batch()
+  for (let i = 0; i < 100; i++) batch.put(String(i).padStart(3, '0'), String(i))
+
+  batch.write(function (err) {
+    if (err) throw err
+
+    db.get('042', { asBuffer: false }, function (err, value) {
+      if (err) throw err
+
+      concat(db.iterator({ background: true }), function (err, entries) {
+        if (err) throw err
+
+        db.compactRange('000', '100', function (err) {
+          if (err) throw err
+
+          const stats = leveldown.threadPoolStats()
+
+          // Leave an iterator nexting, the env cleanup hook must wait for it.
+          const it = db.iterator({ background: true })
+          it.next(function () {})
+
+          process.send({ value: value, entries: entries.length, stats: stats })
+        })
+      })
+    })
+  })
+})
@@ -0,0 +1,110 @@
+// Compares reading values through external buffers (zeroCopy: true, the
+// default) with copying them into fresh buffers (zeroCopy: false).
+//
+// Usage: node --expose-gc test/leveldown/zero-copy-bench.js [entries] [valueSize]
+
+const testCommon = require('./common')
+const crypto = require('crypto')
+
+const ENTRIES = Number(process.argv[2]) || 20000
+const VALUE_SIZE = Number(process.argv[3]) || 1024
+const GET_MANY_SIZE = 100
+
+function key (i) {
+  return 'key' + String(i).padStart(10, '0')
+}
+
+function gc () {
+  if (typeof global.gc !== 'undefined') global.gc()
+}
+
+function fill (db, callback) {
+  const batch = db.batch()
+  for (let i = 0; i < ENTRIES; i++) batch.put(key(i), crypto.randomBytes(VALUE_SIZE))
+  batch.write(callback)
+}
+
+function benchGet (db, callback) {
+  let i = 0
+  const next = function (err) {
+    if (err) return callback(err)
+    if (i === ENTRIES) return callback()
+    db.get(key(i++), next)
+  }
+  next()
+}
+
+function benchGetMany (db, callback) {
+  let i = 0
+  const next = function (err) {
+    if (err) return callback(err)
+    if (i >= ENTRIES) return callback()
+    const keys = []
+    for (let j = 0; j < GET_MANY_SIZE && i < ENTRIES; j++) keys.push(key(i++))
+    db.getMany(keys, next)
+  }
+  next()
+}
+
+function benchIterator (db, callback) {
+  const it = db.iterator()
+  const next = function (err, k) {
+    if (err) return callback(err)
+    if (k === undefined) return it.end(callback)
+    it.next(next)
+  }
+  it.next(next)
+}
+
+function measure (name, db, fn, callback) {
+  gc()
+  const rssBefore = process.memoryUsage().rss
+  let rssPeak = rssBefore
+  const timer = setInterval(function () {
+    rssPeak = Math.max(rssPeak, process.memoryUsage().rss)
+  }, 10)
+  const start = process.hrtime.bigint()
+
+  fn(db, function (err) {
+    clearInterval(timer)
+    if (err) return callback(err)
+
+    const ms = Number(process.hrtime.bigint() - start) / 1e6
+    rssPeak = Math.max(rssPeak, process.memoryUsage().rss)
+    console.log(name.padEnd(10), Math.round(ENTRIES / ms * 1000).toString().padStart(9), 'values/s,',
+      'peak rss +' + Math.round((rssPeak - rssBefore) / 1024 / 1024) + 'M')
+    callback()
+  })
+}
+
+function run (zeroCopy, callback) {
+  const db = testCommon.factory()
+
+  db.open({ zeroCopy: zeroCopy }, function (err) {
+    if (err) return callback(err)
+
+    console.log('zeroCopy: ' + zeroCopy)
+    fill(db, function (err) {
+      if (err) return callback(err)
+      measure('get', db, benchGet, function (err) {
+        if (err) return callback(err)
+        measure('getMany', db, benchGetMany, function (err) {
+          if (err) return callback(err)
+          measure('iterator', db, benchIterator, function (err) {
+            if (err) return callback(err)
+            db.close(callback)
+          })
+        })
+      })
+    })
+  })
+}
+
+console.log('entries: ' + ENTRIES + ', value size: ' + VALUE_SIZE)
+
+run(false, function (err) {
+  if (err) throw err
+  run(true, function (err) {
+    if (err) throw err
+  })
+})
@@ -0,0 +1,68 @@
+const test = require('tape')
+const concat = require('level-concat-iterator')
+const testCommon = require('./common')
+
+const entries = [
+  { key: Buffer.from('a'), value: Buffer.alloc(0) },
+  { key: Buffer.from('b'), value: Buffer.from('short') },
+  { key: Buffer.from('c'), value: Buffer.alloc(64 * 1024, 'c') }
+]
+
+;[true, false].forEach(function (zeroCopy) {
+  test('values are returned intact with zeroCopy: ' + zeroCopy, function (t) {
+    const db = testCommon.factory()
+
+    t.test('setup', function (t) {
+      db.open({ zeroCopy: zeroCopy }, function (err) {
+        t.ifError(err, 'no open error')
+
+        const batch = db.batch()
+        entries.forEach(function (entry) {
+          batch.put(entry.key, entry.value)
+        })
+        batch.write(t.end.bind(t))
+      })
+    })
+
+    t.test('get', function (t) {
+      t.plan(entries.length * 2)
+
+      entries.forEach(function (entry) {
+        db.get(entry.key, function (err, value) {
+          t.ifError(err, 'no get error')
+          t.same(value, entry.value)
+        })
+      })
+    })
+
+    t.test('get as string', function (t) {
+      db.get(entries[1].key, { asBuffer: false }, function (err, value) {
+        t.ifError(err, 'no get error')
+        t.is(value, entries[1].value.toString())
+        t.end()
+      })
+    })
+
+    t.test('getMany', function (t) {
+      db.getMany(entries.map(function (entry) { return entry.key }).concat(Buffer.from('d')), function (err, values) {
+        t.ifError(err, 'no getMany error')
+        t.same(values, entries.map(function (entry) { return entry.value }).concat(undefined))
+        t.end()
+      })
+    })
+
+    t.test('iterator', function (t) {
+      concat(db.iterator(), function (err, result) {
+        t.ifError(err, 'no concat error')
+        t.same(result, entries)
+        t.end()
+      })
+    })
+
+    t.test('teardown', function (t) {
+      db.close(t.end.bind(t))
+    })
+
+    t.end()
+  })
+})